@@ -24,7 +24,12 @@ CREATE OR REPLACE FUNCTION compress_chunk(
     if_not_compressed BOOLEAN = false
 ) RETURNS REGCLASS AS '@MODULE_PATHNAME@', 'ts_compress_chunk' LANGUAGE C STRICT VOLATILE;
 
+-- segment_filter selects the compressed batches to decompress, e.g.
+-- '{"device_id": 3, "time": {">=": "2020-01-01", "<": "2020-01-02"}}'.
+-- Only segmentby and orderby columns can be used. The other batches stay
+-- compressed.
 CREATE OR REPLACE FUNCTION decompress_chunk(
     uncompressed_chunk REGCLASS,
-    if_compressed BOOLEAN = false
-) RETURNS REGCLASS AS '@MODULE_PATHNAME@', 'ts_decompress_chunk' LANGUAGE C STRICT VOLATILE;
+    if_compressed BOOLEAN = false,
+    segment_filter JSONB = NULL
+) RETURNS REGCLASS AS '@MODULE_PATHNAME@', 'ts_decompress_chunk' LANGUAGE C VOLATILE;
@@ -44,6 +44,16 @@ CREATE OR REPLACE FUNCTION remove_compression_policy(hypertable REGCLASS, if_exi
 AS '@MODULE_PATHNAME@', 'ts_policy_compression_remove'
 LANGUAGE C VOLATILE STRICT;
 
+/* chunk pre-creation policy */
+CREATE OR REPLACE FUNCTION add_chunk_precreate_policy(hypertable REGCLASS, chunks_ahead INTEGER = 1, if_not_exists BOOL = false)
+RETURNS INTEGER
+AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreate_add'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE FUNCTION remove_chunk_precreate_policy(hypertable REGCLASS, if_exists BOOL = false) RETURNS VOID
+AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreate_remove'
+LANGUAGE C VOLATILE STRICT;
+
 /* continuous aggregates policy */
 CREATE OR REPLACE FUNCTION add_continuous_aggregate_policy(continuous_aggregate REGCLASS, start_offset "any", end_offset "any", schedule_interval INTERVAL, if_not_exists BOOL = false)
 RETURNS INTEGER
@@ -17,3 +17,7 @@ LANGUAGE C;
 CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_refresh_continuous_aggregate(job_id INTEGER, config JSONB)
 AS '@MODULE_PATHNAME@', 'ts_policy_refresh_cagg_proc'
 LANGUAGE C;
+
+CREATE OR REPLACE PROCEDURE _timescaledb_internal.policy_chunk_precreate(job_id INTEGER, config JSONB)
+AS '@MODULE_PATHNAME@', 'ts_policy_chunk_precreate_proc'
+LANGUAGE C;
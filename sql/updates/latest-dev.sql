@@ -1 +1,9 @@
 
+DROP FUNCTION IF EXISTS decompress_chunk(REGCLASS, BOOLEAN);
+
+INSERT INTO _timescaledb_catalog.compression_algorithm VALUES
+( 5, 1, 'COMPRESSION_ALGORITHM_FOR', 'frame-of-reference'),
+( 6, 1, 'COMPRESSION_ALGORITHM_ALP', 'alp'),
+( 127, 1, 'COMPRESSION_ALGORITHM_AUTO', 'auto')
+ON CONFLICT(id) DO UPDATE SET (version, name, description)
+= (excluded.version, excluded.name, excluded.description);
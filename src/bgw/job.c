@@ -22,6 +22,7 @@
 #include <utils/acl.h>
 #include <utils/elog.h>
 #include <utils/jsonb.h>
+#include <utils/snapmgr.h>
 
 #include "job.h"
 #include "scanner.h"
@@ -35,6 +36,7 @@
 #include "bgw_policy/policy.h"
 #include "scan_iterator.h"
 #include "bgw/scheduler.h"
+#include "bgw/launcher_interface.h"
 
 #include <cross_module_fn.h>
 
@@ -828,6 +830,119 @@ ts_bgw_job_entrypoint(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+TS_FUNCTION_INFO_V1(ts_bgw_compress_chunk_entrypoint);
+
+/*
+ * Entry point of the background workers that a compression policy starts to
+ * compress several chunks in parallel. Each worker compresses a single chunk
+ * in its own transaction.
+ */
+extern Datum
+ts_bgw_compress_chunk_entrypoint(PG_FUNCTION_ARGS)
+{
+	Oid db_oid = DatumGetObjectId(MyBgworkerEntry->bgw_main_arg);
+	Oid user_uid;
+	int32 chunk_id;
+
+	/* Changing this requires changes to ts_bgw_compress_chunk_worker_start */
+	if (sscanf(MyBgworkerEntry->bgw_extra, "%u %d", &user_uid, &chunk_id) != 2)
+		elog(ERROR, "compress chunk entrypoint got invalid bgw_extra");
+
+	BackgroundWorkerBlockSignals();
+	pqsignal(SIGTERM, handle_sigterm);
+	BackgroundWorkerUnblockSignals();
+
+	elog(DEBUG1, "started background worker compressing chunk %d", chunk_id);
+
+	BackgroundWorkerInitializeConnectionByOid(db_oid, user_uid, 0);
+
+	ts_license_enable_module_loading();
+
+	zero_guc("max_parallel_workers_per_gather");
+	zero_guc("max_parallel_workers");
+	zero_guc("max_parallel_maintenance_workers");
+
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	ts_cm_functions->policy_compression_compress_chunk(chunk_id);
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+
+	elog(DEBUG1, "exiting background worker compressing chunk %d", chunk_id);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Start a background worker that compresses the given chunk. The worker counts
+ * against timescaledb.max_background_workers, so this returns NULL if no
+ * worker can be reserved or started, in which case the caller should compress
+ * the chunk itself.
+ */
+BackgroundWorkerHandle *
+ts_bgw_compress_chunk_worker_start(int32 chunk_id)
+{
+	BackgroundWorker worker = {
+		.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION,
+		.bgw_start_time = BgWorkerStart_RecoveryFinished,
+		.bgw_restart_time = BGW_NEVER_RESTART,
+		.bgw_notify_pid = MyProcPid,
+		.bgw_main_arg = ObjectIdGetDatum(MyDatabaseId),
+	};
+	BackgroundWorkerHandle *handle = NULL;
+
+	if (!ts_bgw_worker_reserve())
+		return NULL;
+
+	snprintf(worker.bgw_name, BGW_MAXLEN, "TimescaleDB Compress Chunk %d", chunk_id);
+	StrNCpy(worker.bgw_library_name, ts_extension_get_so_name(), BGW_MAXLEN);
+	StrNCpy(worker.bgw_function_name, "ts_bgw_compress_chunk_entrypoint", BGW_MAXLEN);
+	snprintf(worker.bgw_extra, BGW_EXTRALEN, "%u %d", GetUserId(), chunk_id);
+
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+	{
+		ts_bgw_worker_release();
+		return NULL;
+	}
+
+	return handle;
+}
+
+/*
+ * Wait for the workers started with ts_bgw_compress_chunk_worker_start() to
+ * exit and release their reservations. The reservations are also released if
+ * we are interrupted while waiting.
+ */
+void
+ts_bgw_compress_chunk_workers_wait(List *handles)
+{
+	ListCell *lc;
+	int num_released = 0;
+
+	PG_TRY();
+	{
+		foreach (lc, handles)
+		{
+			BackgroundWorkerHandle *handle = lfirst(lc);
+
+			if (WaitForBackgroundWorkerShutdown(handle) == BGWH_POSTMASTER_DIED)
+				ereport(FATAL,
+						(errcode(ERRCODE_ADMIN_SHUTDOWN),
+						 errmsg("postmaster exited while waiting for compress chunk workers")));
+
+			ts_bgw_worker_release();
+			num_released++;
+		}
+	}
+	PG_CATCH();
+	{
+		for (; num_released < list_length(handles); num_released++)
+			ts_bgw_worker_release();
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
 void
 ts_bgw_job_set_scheduler_test_hook(scheduler_test_hook_type hook)
 {
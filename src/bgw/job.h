@@ -53,6 +53,9 @@ extern TSDLLEXPORT void ts_bgw_job_validate_job_owner(Oid owner);
 extern bool ts_bgw_job_execute(BgwJob *job);
 
 extern TSDLLEXPORT Datum ts_bgw_job_entrypoint(PG_FUNCTION_ARGS);
+extern TSDLLEXPORT Datum ts_bgw_compress_chunk_entrypoint(PG_FUNCTION_ARGS);
+extern TSDLLEXPORT BackgroundWorkerHandle *ts_bgw_compress_chunk_worker_start(int32 chunk_id);
+extern TSDLLEXPORT void ts_bgw_compress_chunk_workers_wait(List *handles);
 extern void ts_bgw_job_set_scheduler_test_hook(scheduler_test_hook_type hook);
 extern void ts_bgw_job_set_job_entrypoint_function_name(char *func_name);
 extern bool ts_bgw_job_run_and_set_next_start(BgwJob *job, job_main_func func, int64 initial_runs,
@@ -14,6 +14,8 @@
 
 #include "annotations.h"
 #include "catalog.h"
+#include "chunk_shared_cache.h"
+#include "dimension_slice_index.h"
 #include "compat.h"
 #include "extension.h"
 #include "hypertable_cache.h"
@@ -57,6 +59,19 @@ cache_invalidate_relcache_all(void)
 {
 	ts_hypertable_cache_invalidate_callback();
 	ts_bgw_job_cache_invalidate_callback();
+	ts_dimension_slice_index_invalidate();
+}
+
+/*
+ * Invalidate all caches, including the shared chunk cache. This is only
+ * needed for events that other backends also receive, since the shared cache
+ * never contains uncommitted state.
+ */
+static inline void
+cache_invalidate_all(void)
+{
+	cache_invalidate_relcache_all();
+	ts_chunk_shared_cache_invalidate_callback();
 }
 
 /*
@@ -70,7 +85,7 @@ cache_invalidate_callback(Datum arg, Oid relid)
 
 	if (ts_extension_invalidate(relid))
 	{
-		cache_invalidate_relcache_all();
+		cache_invalidate_all();
 		return;
 	}
 
@@ -96,8 +111,14 @@ cache_invalidate_callback(Datum arg, Oid relid)
 		if (relid == ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_BGW_JOB))
 			ts_bgw_job_cache_invalidate_callback();
 
+		if (relid == ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_CHUNK))
+		{
+			ts_chunk_shared_cache_invalidate_callback();
+			ts_dimension_slice_index_invalidate();
+		}
+
 		if (relid == InvalidOid)
-			cache_invalidate_relcache_all();
+			cache_invalidate_all();
 	}
 }
 
@@ -143,6 +164,18 @@ cache_invalidate_xact_end(XactEvent event, void *arg)
 			 * backends cannot have the invalid state.
 			 */
 			cache_invalidate_relcache_all();
+			ts_chunk_shared_cache_xact_end(false);
+			break;
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_PARALLEL_COMMIT:
+			ts_chunk_shared_cache_xact_end(true);
+			break;
+		case XACT_EVENT_PREPARE:
+			/*
+			 * Not visible until COMMIT PREPARED, which invalidates the shared
+			 * chunk cache when it commits (see process_utility.c)
+			 */
+			ts_chunk_shared_cache_xact_end(false);
 			break;
 		default:
 			break;
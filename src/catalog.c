@@ -20,6 +20,8 @@
 
 #include "compat.h"
 #include "catalog.h"
+#include "chunk_shared_cache.h"
+#include "dimension_slice_index.h"
 #include "extension.h"
 
 static const TableInfoDef catalog_table_names[_MAX_CATALOG_TABLES + 1] = {
@@ -290,6 +292,7 @@ const static InternalFunctionDef internal_function_definitions[_MAX_INTERNAL_FUN
 static const char *cache_proxy_table_names[_MAX_CACHE_TYPES] = {
 	[CACHE_TYPE_HYPERTABLE] = "cache_inval_hypertable",
 	[CACHE_TYPE_BGW_JOB] = "cache_inval_bgw_job",
+	[CACHE_TYPE_CHUNK] = "cache_inval_chunk",
 };
 
 /* Catalog information for the current database. */
@@ -702,11 +705,38 @@ ts_catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 		case CHUNK_CONSTRAINT:
 		case CHUNK_DATA_NODE:
 		case DIMENSION_SLICE:
+			/*
+			 * The shared chunk cache must not be used by a transaction that
+			 * modifies the chunk metadata, since other backends cannot see
+			 * the changes before commit.
+			 */
+			ts_chunk_shared_cache_mark_modified();
+
+			/* Our own slice changes are visible to us right away */
+			if (table == DIMENSION_SLICE)
+				ts_dimension_slice_index_invalidate();
+
 			if (operation == CMD_UPDATE || operation == CMD_DELETE)
 			{
 				relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
 				CacheInvalidateRelcacheByRelid(relid);
 			}
+
+			/*
+			 * Cached chunks also go stale when a constraint is added to an
+			 * existing chunk. New chunks cannot be cached yet, and new
+			 * dimension slices are always inserted together with the
+			 * constraints of a new chunk, so other inserts do not need an
+			 * invalidation.
+			 */
+			if (operation == CMD_UPDATE || operation == CMD_DELETE || table == CHUNK_CONSTRAINT)
+			{
+				relid = ts_catalog_get_cache_proxy_id(catalog, CACHE_TYPE_CHUNK);
+
+				/* the proxy table does not exist while updating from older versions */
+				if (OidIsValid(relid))
+					CacheInvalidateRelcacheByRelid(relid);
+			}
 			break;
 		case HYPERTABLE:
 		case HYPERTABLE_DATA_NODE:
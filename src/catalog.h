@@ -1178,6 +1178,7 @@ typedef enum CacheType
 {
 	CACHE_TYPE_HYPERTABLE,
 	CACHE_TYPE_BGW_JOB,
+	CACHE_TYPE_CHUNK,
 	_MAX_CACHE_TYPES
 } CacheType;
 
@@ -15,6 +15,7 @@
 #include <commands/defrem.h>
 #include <tcop/tcopprot.h>
 #include <access/htup.h>
+#include <access/heapam.h>
 #include <access/htup_details.h>
 #include <access/xact.h>
 #include <access/reloptions.h>
@@ -31,6 +32,7 @@
 #include <catalog/pg_type.h>
 #include <utils/acl.h>
 #include <utils/timestamp.h>
+#include <utils/snapmgr.h>
 #include <nodes/execnodes.h>
 #include <executor/executor.h>
 #include <access/tupdesc.h>
@@ -38,6 +40,7 @@
 #include "export.h"
 #include "debug_wait.h"
 #include "chunk.h"
+#include "chunk_shared_cache.h"
 #include "chunk_index.h"
 #include "chunk_data_node.h"
 #include "cross_module_fn.h"
@@ -97,6 +100,7 @@ typedef struct ChunkStubScanCtx
 	ChunkStub *stub;
 	Chunk *chunk;
 	bool is_dropped;
+	ScanIterator *iterator; /* Optional scan session for the lookup */
 } ChunkStubScanCtx;
 
 static bool
@@ -1325,17 +1329,46 @@ chunk_create_from_stub(ChunkStubScanCtx *stubctx)
 		.lockmode = AccessShareLock,
 		.scandirection = ForwardScanDirection,
 	};
+	Chunk *cached = stubctx->chunk != NULL ? stubctx->chunk : palloc(sizeof(Chunk));
+	ChunkSharedCacheGeneration generation;
 
 	/*
-	 * Perform an index scan on chunk ID.
+	 * The slices of the stub are already known, so the chunk can come from
+	 * the shared chunk cache without losing any slice locks.
 	 */
-	ScanKeyInit(&scankey[0],
-				Anum_chunk_idx_id,
-				BTEqualStrategyNumber,
-				F_INT4EQ,
-				Int32GetDatum(stubctx->stub->id));
+	if (ts_chunk_shared_cache_get_by_id(stubctx->stub->id, cached))
+	{
+		stubctx->chunk = cached;
+		return cached;
+	}
 
-	num_found = ts_scanner_scan(&scanctx);
+	if (stubctx->chunk == NULL)
+		pfree(cached);
+
+	generation = ts_chunk_shared_cache_begin();
+
+	/*
+	 * Perform an index scan on chunk ID, reusing the scan of the session if
+	 * there is one.
+	 */
+	if (stubctx->iterator != NULL)
+	{
+		ScanIterator *iterator = stubctx->iterator;
+
+		iterator->ctx.data = stubctx;
+		ts_scan_iterator_scan_key_set_argument(iterator, 0, Int32GetDatum(stubctx->stub->id));
+		num_found = ts_scan_iterator_scan_session(iterator);
+	}
+	else
+	{
+		ScanKeyInit(&scankey[0],
+					Anum_chunk_idx_id,
+					BTEqualStrategyNumber,
+					F_INT4EQ,
+					Int32GetDatum(stubctx->stub->id));
+
+		num_found = ts_scanner_scan(&scanctx);
+	}
 
 	Assert(num_found == 0 || num_found == 1);
 
@@ -1349,10 +1382,30 @@ chunk_create_from_stub(ChunkStubScanCtx *stubctx)
 		elog(ERROR, "no chunk found with ID %d", stubctx->stub->id);
 
 	Assert(NULL != stubctx->chunk);
+	ts_chunk_shared_cache_store(stubctx->chunk, generation);
 
 	return stubctx->chunk;
 }
 
+/*
+ * Initialize a scan session to look up many chunks by ID, see
+ * chunk_create_from_stub().
+ */
+static void
+chunk_lookup_session_init(ScanIterator *iterator)
+{
+	*iterator = ts_scan_iterator_create(CHUNK, AccessShareLock, CurrentMemoryContext);
+	iterator->ctx.index = catalog_get_index(ts_catalog_get(), CHUNK, CHUNK_ID_INDEX);
+	iterator->ctx.keepopen = true;
+	iterator->ctx.filter = chunk_tuple_dropped_filter;
+	iterator->ctx.tuple_found = chunk_tuple_found;
+	ts_scan_iterator_scan_key_init(iterator,
+								   Anum_chunk_idx_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(INVALID_CHUNK_ID));
+}
+
 /*
  * Initialize a chunk scan context.
  *
@@ -1388,18 +1441,13 @@ chunk_scan_ctx_destroy(ChunkScanCtx *ctx)
 }
 
 static inline void
-dimension_slice_and_chunk_constraint_join(ChunkScanCtx *scanctx, DimensionVec *vec)
+dimension_slice_and_chunk_constraint_join(ChunkScanCtx *scanctx, List *dimension_vecs)
 {
-	int i;
-
-	for (i = 0; i < vec->num_slices; i++)
-	{
-		/*
-		 * For each dimension slice, find matching constraints. These will be
-		 * saved in the scan context
-		 */
-		ts_chunk_constraint_scan_by_dimension_slice(vec->slices[i], scanctx, CurrentMemoryContext);
-	}
+	/*
+	 * Find the constraints matching the dimension slices of all dimensions in
+	 * one pass. These will be saved in the scan context.
+	 */
+	ts_chunk_constraint_scan_by_dimension_slices(dimension_vecs, scanctx, CurrentMemoryContext);
 }
 
 /*
@@ -1416,6 +1464,7 @@ dimension_slice_and_chunk_constraint_join(ChunkScanCtx *scanctx, DimensionVec *v
 static void
 chunk_point_scan(ChunkScanCtx *scanctx, Point *p, bool lock_slices)
 {
+	List *dimension_vecs = NIL;
 	int i;
 
 	/* Scan all dimensions for slices enclosing the point */
@@ -1432,8 +1481,11 @@ chunk_point_scan(ChunkScanCtx *scanctx, Point *p, bool lock_slices)
 											0,
 											lock_slices ? &tuplock : NULL);
 
-		dimension_slice_and_chunk_constraint_join(scanctx, vec);
+		dimension_vecs = lappend(dimension_vecs, vec);
 	}
+
+	dimension_slice_and_chunk_constraint_join(scanctx, dimension_vecs);
+	list_free(dimension_vecs);
 }
 
 /*
@@ -1454,6 +1506,7 @@ chunk_point_scan(ChunkScanCtx *scanctx, Point *p, bool lock_slices)
 static void
 chunk_collision_scan(ChunkScanCtx *scanctx, Hypercube *cube)
 {
+	List *dimension_vecs = NIL;
 	int i;
 
 	/* Scan all dimensions for colliding slices */
@@ -1466,9 +1519,12 @@ chunk_collision_scan(ChunkScanCtx *scanctx, Hypercube *cube)
 											 slice->fd.range_start,
 											 slice->fd.range_end);
 
-		/* Add the slices to all the chunks they are associated with */
-		dimension_slice_and_chunk_constraint_join(scanctx, vec);
+		dimension_vecs = lappend(dimension_vecs, vec);
 	}
+
+	/* Add the slices to all the chunks they are associated with */
+	dimension_slice_and_chunk_constraint_join(scanctx, dimension_vecs);
+	list_free(dimension_vecs);
 }
 
 /*
@@ -1546,6 +1602,7 @@ chunk_scan_context_add_chunk(ChunkScanCtx *scanctx, ChunkStub *stub)
 	ChunkStubScanCtx stubctx = {
 		.chunk = &data->chunks[data->num_chunks],
 		.stub = stub,
+		.iterator = scanctx->chunk_iterator,
 	};
 
 	Assert(data->num_chunks < data->max_chunks);
@@ -1748,7 +1805,7 @@ chunks_find_all_in_range_limit(Hypertable *ht, Dimension *time_dim, StrategyNumb
 	ctx->early_abort = false;
 
 	/* Scan for chunks that are in range */
-	dimension_slice_and_chunk_constraint_join(ctx, slices);
+	dimension_slice_and_chunk_constraint_join(ctx, list_make1(slices));
 
 	*num_found += hash_get_num_entries(ctx->htab);
 }
@@ -1758,6 +1815,7 @@ append_chunk_common(ChunkScanCtx *scanctx, ChunkStub *stub, Chunk **chunk)
 {
 	ChunkStubScanCtx stubctx = {
 		.stub = stub,
+		.iterator = scanctx->chunk_iterator,
 	};
 
 	*chunk = NULL;
@@ -1824,7 +1882,7 @@ chunk_find_all(Hypertable *ht, List *dimension_vecs, on_chunk_stub_func on_chunk
 			   unsigned int *num_chunks)
 {
 	ChunkScanCtx ctx;
-	ListCell *lc;
+	ScanIterator chunk_iterator;
 	int num_processed;
 
 	/* The scan context will keep the state accumulated during the scan */
@@ -1835,15 +1893,14 @@ chunk_find_all(Hypertable *ht, List *dimension_vecs, on_chunk_stub_func on_chunk
 	ctx.lockmode = lockmode;
 
 	/* Scan all dimensions for slices enclosing the point */
-	foreach (lc, dimension_vecs)
-	{
-		DimensionVec *vec = lfirst(lc);
-
-		dimension_slice_and_chunk_constraint_join(&ctx, vec);
-	}
+	dimension_slice_and_chunk_constraint_join(&ctx, dimension_vecs);
 
+	/* Look up all the chunks found in the same scan session */
+	chunk_lookup_session_init(&chunk_iterator);
+	ctx.chunk_iterator = &chunk_iterator;
 	ctx.data = NULL;
 	num_processed = chunk_scan_ctx_foreach_chunk_stub(&ctx, on_chunk, 0);
+	ts_scan_iterator_close(&chunk_iterator);
 
 	if (NULL != num_chunks)
 		*num_chunks = num_processed;
@@ -1945,6 +2002,7 @@ get_chunks_in_time_range(Hypertable *ht, int64 older_than, int64 newer_than,
 {
 	MemoryContext oldcontext;
 	ChunkScanCtx chunk_scan_ctx;
+	ScanIterator chunk_iterator;
 	Chunk *chunks;
 	ChunkScanCtxAddChunkData data;
 	Dimension *time_dim;
@@ -1986,8 +2044,11 @@ get_chunks_in_time_range(Hypertable *ht, int64 older_than, int64 newer_than,
 	};
 
 	/* Get all the chunks from the context */
+	chunk_lookup_session_init(&chunk_iterator);
+	chunk_scan_ctx.chunk_iterator = &chunk_iterator;
 	chunk_scan_ctx.data = &data;
 	chunk_scan_ctx_foreach_chunk_stub(&chunk_scan_ctx, chunk_scan_context_add_chunk, -1);
+	ts_scan_iterator_close(&chunk_iterator);
 	/*
 	 * only affects ctx.htab Got all the chunk already so can now safely
 	 * destroy the context
@@ -2262,6 +2323,60 @@ ts_chunk_get_by_id(int32 id, bool fail_if_not_found)
 	return chunk_scan_find(CHUNK_ID_INDEX, scankey, 1, CurrentMemoryContext, fail_if_not_found);
 }
 
+/*
+ * Get a chunk by relid for read-only lookups, e.g., during planning.
+ *
+ * The chunk might come from the shared chunk cache, in which case its
+ * dimension slices are not locked, so use ts_chunk_get_by_relid() if the chunk
+ * or its slices could be modified.
+ */
+Chunk *
+ts_chunk_get_by_relid_cached(Oid relid, bool fail_if_not_found)
+{
+	ChunkSharedCacheGeneration generation;
+	Chunk *chunk;
+
+	if (OidIsValid(relid))
+	{
+		chunk = palloc(sizeof(Chunk));
+
+		if (ts_chunk_shared_cache_get_by_relid(relid, chunk))
+			return chunk;
+
+		pfree(chunk);
+	}
+
+	generation = ts_chunk_shared_cache_begin();
+	chunk = ts_chunk_get_by_relid(relid, fail_if_not_found);
+
+	if (chunk != NULL)
+		ts_chunk_shared_cache_store(chunk, generation);
+
+	return chunk;
+}
+
+/*
+ * Get a chunk by ID for read-only lookups. See ts_chunk_get_by_relid_cached().
+ */
+Chunk *
+ts_chunk_get_by_id_cached(int32 id, bool fail_if_not_found)
+{
+	ChunkSharedCacheGeneration generation;
+	Chunk *chunk = palloc(sizeof(Chunk));
+
+	if (ts_chunk_shared_cache_get_by_id(id, chunk))
+		return chunk;
+
+	pfree(chunk);
+	generation = ts_chunk_shared_cache_begin();
+	chunk = ts_chunk_get_by_id(id, fail_if_not_found);
+
+	if (chunk != NULL)
+		ts_chunk_shared_cache_store(chunk, generation);
+
+	return chunk;
+}
+
 /*
  * Number of chunks created after given chunk.
  * If chunk2.id > chunk1.id then chunk2 is created after chunk1
@@ -2838,7 +2953,6 @@ ts_chunk_recreate_all_constraints_for_dimension(Hyperspace *hs, int32 dimension_
 {
 	DimensionVec *slices;
 	ChunkScanCtx chunkctx;
-	int i;
 
 	slices = ts_dimension_slice_scan_by_dimension(dimension_id, 0);
 
@@ -2846,11 +2960,7 @@ ts_chunk_recreate_all_constraints_for_dimension(Hyperspace *hs, int32 dimension_
 		return;
 
 	chunk_scan_ctx_init(&chunkctx, hs, NULL);
-
-	for (i = 0; i < slices->num_slices; i++)
-		ts_chunk_constraint_scan_by_dimension_slice(slices->slices[i],
-													&chunkctx,
-													CurrentMemoryContext);
+	dimension_slice_and_chunk_constraint_join(&chunkctx, list_make1(slices));
 
 	chunk_scan_ctx_foreach_chunk_stub(&chunkctx, chunk_recreate_constraint, 0);
 	chunk_scan_ctx_destroy(&chunkctx);
@@ -3551,12 +3661,36 @@ ts_chunks_in(PG_FUNCTION_ARGS)
 	pg_unreachable();
 }
 
+/*
+ * Check if the chunk table has any rows visible to the snapshot. The table of
+ * a compressed chunk is truncated on compression, so it only has rows after a
+ * partial decompression moved some batches back into it.
+ */
+bool
+ts_chunk_has_uncompressed_rows(Oid chunk_relid, Snapshot snapshot)
+{
+	Relation rel = table_open(chunk_relid, AccessShareLock);
+	TableScanDesc scan;
+	bool has_rows;
+
+	snapshot = RegisterSnapshot(snapshot);
+	scan = table_beginscan(rel, snapshot, 0, NULL);
+	has_rows = heap_getnext(scan, ForwardScanDirection) != NULL;
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+	table_close(rel, AccessShareLock);
+
+	return has_rows;
+}
+
 /* Check if this chunk can be compressed, that it is not dropped and has not
- * already been compressed. */
+ * already been compressed. A compressed chunk with uncompressed rows can be
+ * compressed again. */
 bool
 ts_chunk_can_be_compressed(int32 chunk_id)
 {
 	bool can_be_compressed = false;
+	Oid partial_relid = InvalidOid;
 	ScanIterator iterator = ts_scan_iterator_create(CHUNK, AccessShareLock, CurrentMemoryContext);
 	iterator.ctx.index = catalog_get_index(ts_catalog_get(), CHUNK, CHUNK_ID_INDEX);
 	ts_scan_iterator_scan_key_init(&iterator,
@@ -3576,8 +3710,24 @@ ts_chunk_can_be_compressed(int32 chunk_id)
 		compressed_chunkid_isnull = slot_attisnull(ti->slot, Anum_chunk_compressed_chunk_id);
 		Assert(!dropped_isnull);
 		can_be_compressed = !DatumGetBool(dropped) && compressed_chunkid_isnull;
+
+		if (!DatumGetBool(dropped) && !compressed_chunkid_isnull)
+		{
+			bool isnull;
+			Name schema_name =
+				DatumGetName(slot_getattr(ti->slot, Anum_chunk_schema_name, &isnull));
+			Name table_name = DatumGetName(slot_getattr(ti->slot, Anum_chunk_table_name, &isnull));
+
+			partial_relid = get_relname_relid(NameStr(*table_name),
+											  get_namespace_oid(NameStr(*schema_name), true));
+		}
 	}
 	ts_scan_iterator_close(&iterator);
+
+	/* check for rows outside of the catalog scan to not hold it open */
+	if (OidIsValid(partial_relid) && get_rel_relkind(partial_relid) == RELKIND_RELATION)
+		can_be_compressed = ts_chunk_has_uncompressed_rows(partial_relid, GetLatestSnapshot());
+
 	return can_be_compressed;
 }
 
@@ -10,6 +10,7 @@
 #include <access/htup.h>
 #include <access/tupdesc.h>
 #include <utils/hsearch.h>
+#include <utils/snapshot.h>
 #include <foreign/foreign.h>
 
 #include "export.h"
@@ -87,6 +88,8 @@ typedef struct ChunkScanCtx
 	bool early_abort;
 	LOCKMODE lockmode;
 	void *data;
+	struct ScanIterator *chunk_iterator; /* Optional scan session to look up
+										  * the chunks found */
 } ChunkScanCtx;
 
 /* Returns true if the stub has a full set of constraints, otherwise
@@ -125,6 +128,8 @@ extern TSDLLEXPORT Oid ts_chunk_create_table(Chunk *chunk, Hypertable *ht,
 											 const char *tablespacename);
 extern TSDLLEXPORT Chunk *ts_chunk_get_by_id(int32 id, bool fail_if_not_found);
 extern TSDLLEXPORT Chunk *ts_chunk_get_by_relid(Oid relid, bool fail_if_not_found);
+extern TSDLLEXPORT Chunk *ts_chunk_get_by_id_cached(int32 id, bool fail_if_not_found);
+extern TSDLLEXPORT Chunk *ts_chunk_get_by_relid_cached(Oid relid, bool fail_if_not_found);
 extern bool ts_chunk_exists(const char *schema_name, const char *table_name);
 extern Oid ts_chunk_get_relid(int32 chunk_id, bool missing_ok);
 extern Oid ts_chunk_get_schema_id(int32 chunk_id, bool missing_ok);
@@ -156,6 +161,7 @@ extern TSDLLEXPORT Chunk *ts_chunk_find_or_create_without_cuts(Hypertable *ht, H
 															   bool *created);
 extern TSDLLEXPORT Chunk *ts_chunk_get_compressed_chunk_parent(const Chunk *chunk);
 extern TSDLLEXPORT bool ts_chunk_contains_compressed_data(const Chunk *chunk);
+extern TSDLLEXPORT bool ts_chunk_has_uncompressed_rows(Oid chunk_relid, Snapshot snapshot);
 extern TSDLLEXPORT bool ts_chunk_can_be_compressed(int32 chunk_id);
 extern TSDLLEXPORT Datum ts_chunk_id_from_relid(PG_FUNCTION_ARGS);
 extern TSDLLEXPORT List *ts_chunk_get_chunk_ids_by_hypertable_id(int32 hypertable_id);
@@ -6,6 +6,7 @@
 #include <postgres.h>
 #include <fmgr.h>
 #include <miscadmin.h>
+#include <access/parallel.h>
 #include <executor/executor.h>
 #include <executor/nodeSubplan.h>
 #include <nodes/bitmapset.h>
@@ -72,6 +73,7 @@ static Node *constify_param_mutator(Node *node, void *context);
 static List *constify_restrictinfo_params(PlannerInfo *root, EState *state, List *restrictinfos);
 
 static void initialize_constraints(ChunkAppendState *state, List *initial_rt_indexes);
+static PlanState *chunk_append_init_subplan(ChunkAppendState *state, int i);
 static LWLock *chunk_append_get_lock_pointer(void);
 
 Node *
@@ -92,6 +94,7 @@ ts_chunk_append_state_create(CustomScan *cscan)
 	state->runtime_exclusion = (bool) lsecond_int(settings);
 	state->limit = lthird_int(settings);
 	state->first_partial_plan = lfourth_int(settings);
+	state->lazy_init = (bool) list_nth_int(settings, 4);
 
 	state->filtered_subplans = state->initial_subplans;
 	state->filtered_ri_clauses = state->initial_ri_clauses;
@@ -248,36 +251,81 @@ chunk_append_begin(CustomScanState *node, EState *estate, int eflags)
 	}
 
 	state->subplanstates = palloc0(state->num_subplans * sizeof(PlanState *));
+	state->filtered_plans = palloc(state->num_subplans * sizeof(Plan *));
+	state->eflags = eflags;
 
 	i = 0;
 	foreach (lc, state->filtered_subplans)
-	{
-		/*
-		 * we use an array for the states but put it in custom_ps as well
-		 * so explain and planstate_tree_walker can find it
-		 */
-		state->subplanstates[i] = ExecInitNode(lfirst(lc), estate, eflags);
-		node->custom_ps = lappend(node->custom_ps, state->subplanstates[i]);
+		state->filtered_plans[i++] = lfirst(lc);
 
-		/*
-		 * pass down limit to child nodes
-		 */
-		if (state->limit)
-			ExecSetTupleBound(state->limit, state->subplanstates[i]);
+	/*
+	 * With lazy initialization, the subplans are initialized when they are
+	 * chosen for the first time, so chunks that are excluded at runtime or
+	 * never reached, e.g., because of a LIMIT on an ordered append, never
+	 * have their relations opened and their scans set up. EXPLAIN needs the
+	 * state of all subplans, so it initializes all subplans here. So do plans
+	 * below a Gather, since parallel scans set up their shared state when the
+	 * Gather starts. This is the case even if this node is not parallel-aware,
+	 * e.g., with timescaledb.enable_parallel_chunk_append off, the subplans
+	 * can still be parallel scans. In a parallel worker, the plan is always
+	 * below a Gather.
+	 */
+	if (state->lazy_init &&
+		((eflags & EXEC_FLAG_EXPLAIN_ONLY) || estate->es_instrument != 0 || IsParallelWorker() ||
+		 (node->ss.ps.plan->parallel_safe && estate->es_plannedstmt->parallelModeNeeded)))
+		state->lazy_init = false;
 
-		i++;
+	if (!state->lazy_init)
+	{
+		for (i = 0; i < state->num_subplans; i++)
+			chunk_append_init_subplan(state, i);
 	}
 
 	if (state->runtime_exclusion)
 	{
-		state->params = state->subplanstates[0]->plan->allParam;
+		state->params = state->filtered_plans[0]->allParam;
 		/*
 		 * make sure all params are initialized for runtime exclusion
 		 */
-		node->ss.ps.chgParam = bms_copy(state->subplanstates[0]->plan->allParam);
+		node->ss.ps.chgParam = bms_copy(state->filtered_plans[0]->allParam);
 	}
 }
 
+/*
+ * Initialize the state of a subplan unless it is already initialized.
+ */
+static PlanState *
+chunk_append_init_subplan(ChunkAppendState *state, int i)
+{
+	EState *estate = state->csstate.ss.ps.state;
+	MemoryContext old;
+
+	Assert(i >= 0 && i < state->num_subplans);
+
+	if (state->subplanstates[i] != NULL)
+		return state->subplanstates[i];
+
+	/* Subplans initialized during execution must live as long as the query */
+	old = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	/*
+	 * we use an array for the states but put it in custom_ps as well
+	 * so explain and planstate_tree_walker can find it
+	 */
+	state->subplanstates[i] = ExecInitNode(state->filtered_plans[i], estate, state->eflags);
+	state->csstate.custom_ps = lappend(state->csstate.custom_ps, state->subplanstates[i]);
+
+	/*
+	 * pass down limit to child nodes
+	 */
+	if (state->limit)
+		ExecSetTupleBound(state->limit, state->subplanstates[i]);
+
+	MemoryContextSwitchTo(old);
+
+	return state->subplanstates[i];
+}
+
 /*
  * build bitmap of valid subplans for runtime exclusion
  */
@@ -285,6 +333,7 @@ static void
 initialize_runtime_exclusion(ChunkAppendState *state)
 {
 	ListCell *lc_clauses, *lc_constraints;
+	EState *estate = state->csstate.ss.ps.state;
 	int i = 0;
 
 	PlannerGlobal glob = {
@@ -311,8 +360,7 @@ initialize_runtime_exclusion(ChunkAppendState *state)
 	 */
 	for (i = 0; i < state->num_subplans; i++)
 	{
-		PlanState *ps = state->subplanstates[i];
-		Scan *scan = ts_chunk_append_get_scan_plan(ps->plan);
+		Scan *scan = ts_chunk_append_get_scan_plan(state->filtered_plans[i]);
 		List *restrictinfos = NIL;
 		ListCell *lc;
 
@@ -331,7 +379,7 @@ initialize_runtime_exclusion(ChunkAppendState *state)
 				ri->clause = lfirst(lc);
 				restrictinfos = lappend(restrictinfos, ri);
 			}
-			restrictinfos = constify_restrictinfo_params(&root, ps->state, restrictinfos);
+			restrictinfos = constify_restrictinfo_params(&root, estate, restrictinfos);
 
 			can_exclude = can_exclude_chunk(lfirst(lc_constraints), restrictinfos);
 
@@ -379,7 +427,7 @@ chunk_append_exec(CustomScanState *node)
 			return ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 
 		Assert(state->current >= 0 && state->current < state->num_subplans);
-		subnode = state->subplanstates[state->current];
+		subnode = chunk_append_init_subplan(state, state->current);
 
 		/*
 		 * get a tuple from the subplan
@@ -535,7 +583,8 @@ chunk_append_end(CustomScanState *node)
 
 	for (i = 0; i < state->num_subplans; i++)
 	{
-		ExecEndNode(state->subplanstates[i]);
+		if (state->subplanstates[i] != NULL)
+			ExecEndNode(state->subplanstates[i]);
 	}
 }
 
@@ -550,6 +599,10 @@ chunk_append_rescan(CustomScanState *node)
 
 	for (i = 0; i < state->num_subplans; i++)
 	{
+		/* subplans that are not initialized yet start out fresh anyway */
+		if (state->subplanstates[i] == NULL)
+			continue;
+
 		if (node->ss.ps.chgParam != NULL)
 			UpdateChangedParamSet(state->subplanstates[i], node->ss.ps.chgParam);
 
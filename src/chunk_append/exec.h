@@ -32,7 +32,9 @@ typedef struct ChunkAppendState
 	bool startup_exclusion;
 	bool runtime_exclusion;
 	bool runtime_initialized;
+	bool lazy_init;
 	uint32 limit;
+	int eflags;
 
 	/* list of subplans after planning */
 	List *initial_subplans;
@@ -47,6 +49,8 @@ typedef struct ChunkAppendState
 	List *filtered_constraints;
 	/* list of restrictinfo clauses after startup exclusion */
 	List *filtered_ri_clauses;
+	/* array of the subplans after startup exclusion, for lazy initialization */
+	Plan **filtered_plans;
 
 	/* valid subplans for runtime exclusion */
 	Bitmapset *valid_subplans;
@@ -48,7 +48,8 @@ ts_chunk_append_explain(CustomScanState *node, List *ancestors, ExplainState *es
 	if (state->startup_exclusion)
 		ExplainPropertyInteger("Chunks excluded during startup",
 							   NULL,
-							   list_length(state->initial_subplans) - list_length(node->custom_ps),
+							   list_length(state->initial_subplans) -
+								   list_length(state->filtered_subplans),
 							   es);
 
 	if (state->runtime_exclusion && state->runtime_number_loops > 0)
@@ -94,6 +94,7 @@ ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path
 	List *chunk_rt_indexes = NIL;
 	List *sort_options = NIL;
 	List *custom_private = NIL;
+	List *settings;
 	uint32 limit = 0;
 
 	ChunkAppendPath *capath = (ChunkAppendPath *) path;
@@ -269,10 +270,13 @@ ts_chunk_append_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path
 	if (capath->pushdown_limit && capath->limit_tuples > 0)
 		limit = capath->limit_tuples;
 
-	custom_private = list_make1(list_make4_int(capath->startup_exclusion,
-											   capath->runtime_exclusion,
-											   limit,
-											   capath->first_partial_path));
+	settings = list_make4_int(capath->startup_exclusion,
+							  capath->runtime_exclusion,
+							  limit,
+							  capath->first_partial_path);
+	settings = lappend_int(settings, ts_guc_enable_lazy_chunk_init);
+
+	custom_private = list_make1(settings);
 	custom_private = lappend(custom_private, chunk_ri_clauses);
 	custom_private = lappend(custom_private, chunk_rt_indexes);
 	custom_private = lappend(custom_private, sort_options);
@@ -428,63 +428,156 @@ typedef struct ChunkConstraintScanData
 } ChunkConstraintScanData;
 
 /*
- * Scan for all chunk constraints that match the given slice ID. The chunk
- * constraints are saved in the chunk scan context.
+ * Add a chunk constraint tuple matching the given slice to the chunk scan
+ * context.
+ *
+ * Returns true if the scan should be aborted because a complete chunk was
+ * found and the scan context asks for early abort.
+ */
+static bool
+chunk_scan_ctx_add_constraint(ChunkScanCtx *ctx, TupleInfo *ti, DimensionSlice *slice)
+{
+	Hyperspace *hs = ctx->space;
+	ChunkStub *stub;
+	ChunkScanEntry *entry;
+	bool found;
+	Datum datum = slot_getattr(ti->slot, Anum_chunk_constraint_chunk_id, &found);
+	int32 chunk_id = DatumGetInt32(datum);
+
+	Assert(!slot_attisnull(ti->slot, Anum_chunk_constraint_dimension_slice_id));
+
+	entry = hash_search(ctx->htab, &chunk_id, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		stub = ts_chunk_stub_create(chunk_id, hs->num_dimensions);
+		stub->cube = ts_hypercube_alloc(hs->num_dimensions);
+		entry->stub = stub;
+	}
+	else
+		stub = entry->stub;
+
+	chunk_constraints_add_from_tuple(stub->constraints, ti);
+
+	ts_hypercube_add_slice(stub->cube, slice);
+
+	/* A stub is complete when we've added slices for all its dimensions,
+	 * i.e., a complete hypercube */
+	if (chunk_stub_is_complete(stub, ctx->space))
+	{
+		ctx->num_complete_chunks++;
+
+		if (ctx->early_abort)
+			return true;
+	}
+
+	return false;
+}
+
+static int
+dimension_slice_cmp_id(const void *left, const void *right)
+{
+	const DimensionSlice *left_slice = *((DimensionSlice **) left);
+	const DimensionSlice *right_slice = *((DimensionSlice **) right);
+
+	if (left_slice->fd.id < right_slice->fd.id)
+		return -1;
+	if (left_slice->fd.id > right_slice->fd.id)
+		return 1;
+	return 0;
+}
+
+/*
+ * Scan for all chunk constraints that match any of the slices in the given
+ * dimension vectors. The chunk constraints are saved in the chunk scan
+ * context.
+ *
+ * The dimension slice ID is not the leading column of the index on
+ * chunk_constraint, so a scan for a single slice ID has to go through the
+ * whole index. Instead of one such pass per slice, this does a single ordered
+ * pass over the index and looks up the slice of each constraint in an array
+ * sorted on slice ID. Scan keys on the range of slice IDs filter out the
+ * constraints of other slices on the index tuples, so that only the heap
+ * tuples of constraints in that range are fetched.
  */
 int
-ts_chunk_constraint_scan_by_dimension_slice(DimensionSlice *slice, ChunkScanCtx *ctx,
-											MemoryContext mctx)
+ts_chunk_constraint_scan_by_dimension_slices(List *dimension_vecs, ChunkScanCtx *ctx,
+											 MemoryContext mctx)
 {
 	ScanIterator iterator = ts_scan_iterator_create(CHUNK_CONSTRAINT, AccessShareLock, mctx);
+	DimensionSlice **slices;
+	DimensionSlice key_slice;
+	DimensionSlice *key = &key_slice;
+	int num_slices = 0;
 	int count = 0;
+	ListCell *lc;
+
+	foreach (lc, dimension_vecs)
+		num_slices += ((DimensionVec *) lfirst(lc))->num_slices;
+
+	if (num_slices == 0)
+		return 0;
+
+	slices = palloc(sizeof(DimensionSlice *) * num_slices);
+	num_slices = 0;
+
+	foreach (lc, dimension_vecs)
+	{
+		DimensionVec *vec = lfirst(lc);
+
+		memcpy(slices + num_slices, vec->slices, sizeof(DimensionSlice *) * vec->num_slices);
+		num_slices += vec->num_slices;
+	}
+
+	qsort(slices, num_slices, sizeof(DimensionSlice *), dimension_slice_cmp_id);
+
+	iterator.ctx.index = catalog_get_index(ts_catalog_get(),
+										   CHUNK_CONSTRAINT,
+										   CHUNK_CONSTRAINT_CHUNK_ID_DIMENSION_SLICE_ID_IDX);
+	ts_scan_iterator_scan_key_init(
+		&iterator,
+		Anum_chunk_constraint_chunk_id_dimension_slice_id_idx_dimension_slice_id,
+		BTGreaterEqualStrategyNumber,
+		F_INT4GE,
+		Int32GetDatum(slices[0]->fd.id));
+	ts_scan_iterator_scan_key_init(
+		&iterator,
+		Anum_chunk_constraint_chunk_id_dimension_slice_id_idx_dimension_slice_id,
+		BTLessEqualStrategyNumber,
+		F_INT4LE,
+		Int32GetDatum(slices[num_slices - 1]->fd.id));
 
-	init_scan_by_dimension_slice_id(&iterator, slice->fd.id);
 	ts_scanner_foreach(&iterator)
 	{
-		Hyperspace *hs = ctx->space;
-		ChunkStub *stub;
-		ChunkScanEntry *entry;
-		bool found;
 		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
-		Datum datum = slot_getattr(ti->slot, Anum_chunk_constraint_chunk_id, &found);
-		int32 chunk_id = DatumGetInt32(datum);
+		DimensionSlice **match;
+		bool isnull;
+		Datum slice_id = slot_getattr(ti->slot, Anum_chunk_constraint_dimension_slice_id, &isnull);
 
-		if (slot_attisnull(ts_scan_iterator_slot(&iterator),
-						   Anum_chunk_constraint_dimension_slice_id))
+		if (isnull)
 			continue;
 
-		count++;
+		key_slice.fd.id = DatumGetInt32(slice_id);
+		match = bsearch(&key,
+						slices,
+						num_slices,
+						sizeof(DimensionSlice *),
+						dimension_slice_cmp_id);
 
-		Assert(!slot_attisnull(ti->slot, Anum_chunk_constraint_dimension_slice_id));
+		if (match == NULL)
+			continue;
 
-		entry = hash_search(ctx->htab, &chunk_id, HASH_ENTER, &found);
+		count++;
 
-		if (!found)
+		if (chunk_scan_ctx_add_constraint(ctx, ti, *match))
 		{
-			stub = ts_chunk_stub_create(chunk_id, hs->num_dimensions);
-			stub->cube = ts_hypercube_alloc(hs->num_dimensions);
-			entry->stub = stub;
+			ts_scan_iterator_close(&iterator);
+			break;
 		}
-		else
-			stub = entry->stub;
-
-		chunk_constraints_add_from_tuple(stub->constraints, ti);
-
-		ts_hypercube_add_slice(stub->cube, slice);
+	}
 
-		/* A stub is complete when we've added slices for all its dimensions,
-		 * i.e., a complete hypercube */
-		if (chunk_stub_is_complete(stub, ctx->space))
-		{
-			ctx->num_complete_chunks++;
+	pfree(slices);
 
-			if (ctx->early_abort)
-			{
-				ts_scan_iterator_close(&iterator);
-				break;
-			}
-		}
-	}
 	return count;
 }
 
@@ -39,8 +39,8 @@ extern TSDLLEXPORT ChunkConstraints *ts_chunk_constraints_alloc(int size_hint, M
 extern ChunkConstraints *ts_chunk_constraint_scan_by_chunk_id(int32 chunk_id, Size count_hint,
 															  MemoryContext mctx);
 extern ChunkConstraints *ts_chunk_constraints_copy(ChunkConstraints *constraints);
-extern int ts_chunk_constraint_scan_by_dimension_slice(DimensionSlice *slice, ChunkScanCtx *ctx,
-													   MemoryContext mctx);
+extern int ts_chunk_constraint_scan_by_dimension_slices(List *dimension_vecs, ChunkScanCtx *ctx,
+														MemoryContext mctx);
 extern int ts_chunk_constraint_scan_by_dimension_slice_to_list(DimensionSlice *slice, List **list,
 															   MemoryContext mctx);
 extern int ts_chunk_constraint_scan_by_dimension_slice_id(int32 dimension_slice_id,
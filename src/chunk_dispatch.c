@@ -31,6 +31,7 @@ ts_chunk_dispatch_create(Hypertable *ht, EState *estate, int eflags)
 		ts_subspace_store_init(ht->space, estate->es_query_cxt, ts_guc_max_open_chunks_per_insert);
 	cd->prev_cis = NULL;
 	cd->prev_cis_oid = InvalidOid;
+	dlist_init(&cd->multi_insert_pending);
 
 	return cd;
 }
@@ -99,9 +100,34 @@ ts_chunk_dispatch_get_cmd_type(const ChunkDispatch *dispatch)
 void
 ts_chunk_dispatch_destroy(ChunkDispatch *cd)
 {
+	SubspaceStoreStats stats;
+
+	ts_subspace_store_get_stats(cd->cache, &stats);
+	elog(DEBUG2,
+		 "chunk insert state cache: " INT64_FORMAT " hits, " INT64_FORMAT
+		 " misses, " INT64_FORMAT " evictions",
+		 stats.hits,
+		 stats.misses,
+		 stats.evictions);
 	ts_subspace_store_free(cd->cache);
 }
 
+/*
+ * Insert the tuples buffered for all chunks.
+ */
+void
+ts_chunk_dispatch_flush(ChunkDispatch *dispatch)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &dispatch->multi_insert_pending)
+	{
+		ChunkInsertState *cis = dlist_container(ChunkInsertState, pending_node, iter.cur);
+
+		ts_chunk_insert_state_flush(cis);
+	}
+}
+
 static void
 destroy_chunk_insert_state(void *cis)
 {
@@ -123,9 +149,18 @@ ts_chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *point,
 
 	if (NULL == cis)
 	{
-		Chunk *new_chunk;
+		Chunk *new_chunk = NULL;
 
-		new_chunk = ts_hypertable_get_or_create_chunk(dispatch->hypertable, point);
+		if (NULL != dispatch->on_chunk_create)
+		{
+			new_chunk = ts_hypertable_find_chunk_if_exists(dispatch->hypertable, point);
+
+			if (NULL == new_chunk)
+				dispatch->on_chunk_create(dispatch->on_chunk_create_data);
+		}
+
+		if (NULL == new_chunk)
+			new_chunk = ts_hypertable_get_or_create_chunk(dispatch->hypertable, point);
 
 		if (NULL == new_chunk)
 			elog(ERROR, "no chunk found or created");
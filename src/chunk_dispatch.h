@@ -22,6 +22,8 @@
  * separate from any plan and executor nodes, since it is used both for INSERT
  * and COPY.
  */
+typedef void (*on_chunk_create_func)(void *data);
+
 typedef struct ChunkDispatch
 {
 	/* Link to the executor state for INSERTs. This is not set for COPY path. */
@@ -38,6 +40,20 @@ typedef struct ChunkDispatch
 	ResultRelInfo *hypertable_result_rel_info;
 	ChunkInsertState *prev_cis;
 	Oid prev_cis_oid;
+	/*
+	 * Buffer tuples per chunk and insert them in batches, for chunks that
+	 * allow it. Chunk insert states with buffered tuples are on the pending
+	 * list.
+	 */
+	bool multi_insert;
+	dlist_head multi_insert_pending;
+	/*
+	 * Optional callback that is invoked before a new chunk is created, e.g.,
+	 * so that a distributed insert can finish the requests it has in flight
+	 * on the data node connections that are used to create the chunk.
+	 */
+	on_chunk_create_func on_chunk_create;
+	void *on_chunk_create_data;
 } ChunkDispatch;
 
 typedef struct Point Point;
@@ -46,6 +62,7 @@ typedef void (*on_chunk_changed_func)(ChunkInsertState *state, void *data);
 
 extern ChunkDispatch *ts_chunk_dispatch_create(Hypertable *ht, EState *estate, int eflags);
 extern void ts_chunk_dispatch_destroy(ChunkDispatch *dispatch);
+extern void ts_chunk_dispatch_flush(ChunkDispatch *dispatch);
 extern ChunkInsertState *
 ts_chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *p,
 										 const on_chunk_changed_func on_chunk_changed, void *data);
@@ -9,6 +9,7 @@
 #include <catalog/pg_class.h>
 #include <commands/trigger.h>
 #include <nodes/nodes.h>
+#include <nodes/nodeFuncs.h>
 #include <nodes/extensible.h>
 
 #include "compat.h"
@@ -21,6 +22,13 @@
 #include "hypertable_cache.h"
 #include "dimension.h"
 #include "hypertable.h"
+#include "guc.h"
+
+#if PG12_GE
+#include <optimizer/optimizer.h>
+#else
+#include <optimizer/clauses.h>
+#endif
 
 static void
 chunk_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
@@ -93,6 +101,16 @@ on_chunk_insert_state_changed(ChunkInsertState *cis, void *data)
 }
 #endif /* PG12_GE */
 
+/*
+ * Route the next tuple to its chunk.
+ *
+ * Normally, the tuple is returned to the ModifyTable node, which inserts it
+ * into the chunk set as result relation. In multi-insert mode, tuples going
+ * into chunks that allow it are instead buffered per chunk and inserted in
+ * batches, like COPY does, which saves a lot of per-tuple overhead in the
+ * heap. Only tuples going into other chunks are returned, and all buffers are
+ * flushed once the subplan is done.
+ */
 static TupleTableSlot *
 chunk_dispatch_exec(CustomScanState *node)
 {
@@ -106,51 +124,62 @@ chunk_dispatch_exec(CustomScanState *node)
 	EState *estate = node->ss.ps.state;
 	MemoryContext old;
 
-	/* Get the next tuple from the subplan state node */
-	slot = ExecProcNode(substate);
+	for (;;)
+	{
+		/* Get the next tuple from the subplan state node */
+		slot = ExecProcNode(substate);
 
-	if (TupIsNull(slot))
-		return NULL;
+		if (TupIsNull(slot))
+		{
+			if (dispatch->multi_insert)
+				ts_chunk_dispatch_flush(dispatch);
 
-	/* Reset the per-tuple exprcontext */
-	ResetPerTupleExprContext(estate);
+			return NULL;
+		}
 
-	/* Switch to the executor's per-tuple memory context */
-	old = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+		/* Reset the per-tuple exprcontext */
+		ResetPerTupleExprContext(estate);
 
-	/* Calculate the tuple's point in the N-dimensional hyperspace */
-	point = ts_hyperspace_calculate_point(ht->space, slot);
+		/* Switch to the executor's per-tuple memory context */
+		old = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 
-	/* Save the main table's (hypertable's) ResultRelInfo */
-	if (NULL == dispatch->hypertable_result_rel_info)
-	{
-		Assert(RelationGetRelid(estate->es_result_relation_info->ri_RelationDesc) ==
-			   state->hypertable_relid);
-		dispatch->hypertable_result_rel_info = estate->es_result_relation_info;
-	}
+		/* Calculate the tuple's point in the N-dimensional hyperspace */
+		point = ts_hyperspace_calculate_point(ht->space, slot);
 
-	/* Find or create the insert state matching the point */
-	cis = ts_chunk_dispatch_get_chunk_insert_state(dispatch,
-												   point,
-												   on_chunk_insert_state_changed,
-												   state);
+		/* Save the main table's (hypertable's) ResultRelInfo */
+		if (NULL == dispatch->hypertable_result_rel_info)
+		{
+			Assert(RelationGetRelid(estate->es_result_relation_info->ri_RelationDesc) ==
+				   state->hypertable_relid);
+			dispatch->hypertable_result_rel_info = estate->es_result_relation_info;
+		}
 
-	/*
-	 * Set the result relation in the executor state to the target chunk.
-	 * This makes sure that the tuple gets inserted into the correct
-	 * chunk. Note that since the ModifyTable executor saves and restores
-	 * the es_result_relation_info this has to be updated every time, not
-	 * just when the chunk changes.
-	 */
-	estate->es_result_relation_info = cis->result_relation_info;
+		/* Find or create the insert state matching the point */
+		cis = ts_chunk_dispatch_get_chunk_insert_state(dispatch,
+													   point,
+													   on_chunk_insert_state_changed,
+													   state);
+
+		/*
+		 * Set the result relation in the executor state to the target chunk.
+		 * This makes sure that the tuple gets inserted into the correct
+		 * chunk. Note that since the ModifyTable executor saves and restores
+		 * the es_result_relation_info this has to be updated every time, not
+		 * just when the chunk changes.
+		 */
+		estate->es_result_relation_info = cis->result_relation_info;
 
-	MemoryContextSwitchTo(old);
+		MemoryContextSwitchTo(old);
 
-	/* Convert the tuple to the chunk's rowtype, if necessary */
-	if (cis->hyper_to_chunk_map != NULL)
-		slot = execute_attr_map_slot(cis->hyper_to_chunk_map->attrMap, slot, cis->slot);
+		/* Convert the tuple to the chunk's rowtype, if necessary */
+		if (cis->hyper_to_chunk_map != NULL)
+			slot = execute_attr_map_slot(cis->hyper_to_chunk_map->attrMap, slot, cis->slot);
 
-	return slot;
+		if (!cis->multi_insert)
+			return slot;
+
+		ts_chunk_insert_state_buffer_tuple(cis, slot);
+	}
 }
 
 static void
@@ -262,6 +291,22 @@ setup_tuple_slots_for_on_conflict_handling(ChunkDispatchState *state)
 }
 #endif
 
+/*
+ * Check if a node of the subplan calls volatile functions in its targetlist
+ * or quals. Such a function might read the hypertable and has to see the
+ * rows inserted before it is called, so the rows cannot be buffered. Like
+ * for COPY, nextval() is not considered.
+ */
+static bool
+subplan_contains_volatile_functions(PlanState *ps, void *context)
+{
+	if (contain_volatile_functions_not_nextval((Node *) ps->plan->targetlist) ||
+		contain_volatile_functions_not_nextval((Node *) ps->plan->qual))
+		return true;
+
+	return planstate_tree_walker(ps, subplan_contains_volatile_functions, context);
+}
+
 /*
  * This function is called during the init phase of the INSERT (ModifyTable)
  * plan, and gives the ChunkDispatchState node the access it needs to the
@@ -275,10 +320,25 @@ void
 ts_chunk_dispatch_state_set_parent(ChunkDispatchState *state, ModifyTableState *mtstate)
 {
 	ModifyTable *mt_plan = castNode(ModifyTable, mtstate->ps.plan);
+	ResultRelInfo *rri = mtstate->resultRelInfo;
 
 	/* Inserts on hypertables should always have one subplan */
 	Assert(mtstate->mt_nplans == 1);
 	state->mtstate = mtstate;
 	setup_tuple_slots_for_on_conflict_handling(state);
 	state->arbiter_indexes = mt_plan->arbiterIndexes;
+
+	/*
+	 * Buffered tuples are inserted without going through ModifyTable, so
+	 * multi-insert is only possible for plain inserts that do not need any
+	 * per-tuple processing in the ModifyTable node. Whether a chunk allows
+	 * it is decided when creating its chunk insert state.
+	 */
+	state->dispatch->multi_insert =
+		ts_guc_enable_multi_insert && mtstate->operation == CMD_INSERT && mtstate->canSetTag &&
+		mt_plan->returningLists == NIL && mt_plan->onConflictAction == ONCONFLICT_NONE &&
+		mtstate->mt_transition_capture == NULL && rri->ri_WithCheckOptions == NIL &&
+		rri->ri_FdwRoutine == NULL && !rri->ri_usesFdwDirectModify &&
+		!hypertable_is_distributed(state->dispatch->hypertable) &&
+		!subplan_contains_volatile_functions(linitial(state->cscan_state.custom_ps), NULL);
 }
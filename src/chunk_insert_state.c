@@ -5,6 +5,10 @@
  */
 #include <postgres.h>
 #include <access/attnum.h>
+#include <access/heapam.h>
+#include <commands/trigger.h>
+#include <executor/executor.h>
+#include <executor/nodeModifyTable.h>
 #include <executor/tuptable.h>
 #include <nodes/execnodes.h>
 #include <nodes/nodes.h>
@@ -30,6 +34,7 @@
 #include <optimizer/plancat.h>
 #include <optimizer/planner.h>
 #else
+#include <access/tableam.h>
 #include <optimizer/optimizer.h>
 #endif
 
@@ -634,6 +639,20 @@ ts_chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 												 table_slot_callbacks(resrelinfo->ri_RelationDesc));
 	table_close(parent_rel, AccessShareLock);
 
+	/*
+	 * Tuples can only be buffered for plain tables where inserting a tuple
+	 * has no effects that are visible before the buffer is flushed, which
+	 * BEFORE ROW triggers could observe.
+	 */
+	if (dispatch->multi_insert && chunk->relkind == RELKIND_RELATION &&
+		(resrelinfo->ri_TrigDesc == NULL || !resrelinfo->ri_TrigDesc->trig_insert_before_row))
+	{
+		state->multi_insert = true;
+		state->buffered_slots = palloc0(sizeof(TupleTableSlot *) * CHUNK_MULTI_INSERT_MAX_TUPLES);
+		state->bistate = GetBulkInsertState();
+		state->pending_list = &dispatch->multi_insert_pending;
+	}
+
 	if (chunk->relkind == RELKIND_FOREIGN_TABLE)
 	{
 		RangeTblEntry *rte =
@@ -690,11 +709,130 @@ ts_chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch)
 	return state;
 }
 
+/*
+ * Buffer a tuple for a multi-insert into the chunk.
+ *
+ * The tuple is checked as if it was inserted, but it is only stored in the
+ * chunk, along with its index entries, when the buffer is flushed. The buffer
+ * is flushed here when full.
+ */
+void
+ts_chunk_insert_state_buffer_tuple(ChunkInsertState *state, TupleTableSlot *slot)
+{
+	ResultRelInfo *rri = state->result_relation_info;
+	Relation rel = rri->ri_RelationDesc;
+	TupleTableSlot *buffered;
+	HeapTuple tuple;
+
+	Assert(state->multi_insert);
+	Assert(state->num_buffered < CHUNK_MULTI_INSERT_MAX_TUPLES);
+
+#if PG12_GE
+	/* Compute stored generated columns */
+	if (rel->rd_att->constr && rel->rd_att->constr->has_generated_stored)
+#if PG13_GE
+		ExecComputeStoredGenerated(state->estate, slot, CMD_INSERT);
+#else
+		ExecComputeStoredGenerated(state->estate, slot);
+#endif
+#endif
+
+	if (rel->rd_att->constr)
+		ExecConstraints(rri, slot, state->estate);
+
+	if (NULL == state->buffered_slots[state->num_buffered])
+	{
+		MemoryContext old = MemoryContextSwitchTo(state->mctx);
+
+		state->buffered_slots[state->num_buffered] = table_slot_create(rel, NULL);
+		MemoryContextSwitchTo(old);
+	}
+
+	buffered = ExecCopySlot(state->buffered_slots[state->num_buffered], slot);
+	tuple = ExecFetchSlotHeapTuple(buffered, true, NULL);
+
+	if (state->num_buffered == 0)
+		dlist_push_tail(state->pending_list, &state->pending_node);
+
+	state->num_buffered++;
+	state->buffered_bytes += tuple->t_len;
+
+	if (state->num_buffered >= CHUNK_MULTI_INSERT_MAX_TUPLES ||
+		state->buffered_bytes >= CHUNK_MULTI_INSERT_MAX_BYTES)
+		ts_chunk_insert_state_flush(state);
+}
+
+/*
+ * Insert the buffered tuples into the chunk.
+ *
+ * Like COPY, this inserts all tuples into the heap at once and then adds
+ * their index entries and queues AFTER ROW triggers one tuple at a time.
+ */
+void
+ts_chunk_insert_state_flush(ChunkInsertState *state)
+{
+	ResultRelInfo *rri = state->result_relation_info;
+	EState *estate = state->estate;
+	ResultRelInfo *saved_rri = estate->es_result_relation_info;
+	MemoryContext old;
+	int i;
+
+	if (state->num_buffered == 0)
+		return;
+
+	old = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	table_multi_insert(state->rel,
+					   state->buffered_slots,
+					   state->num_buffered,
+					   estate->es_output_cid,
+					   0,
+					   state->bistate);
+
+	/* Index inserts use the result relation of the executor state */
+	estate->es_result_relation_info = rri;
+
+	for (i = 0; i < state->num_buffered; i++)
+	{
+		TupleTableSlot *slot = state->buffered_slots[i];
+		List *recheck_indexes = NIL;
+
+		if (rri->ri_NumIndices > 0)
+			recheck_indexes = ExecInsertIndexTuplesCompat(slot, estate, false, NULL, NIL);
+
+		/* AFTER ROW INSERT Triggers */
+		if (rri->ri_TrigDesc != NULL && rri->ri_TrigDesc->trig_insert_after_row)
+			ExecARInsertTriggersCompat(estate, rri, slot, recheck_indexes, NULL);
+
+		list_free(recheck_indexes);
+		ExecClearTuple(slot);
+	}
+
+	estate->es_result_relation_info = saved_rri;
+	estate->es_processed += state->num_buffered;
+	MemoryContextSwitchTo(old);
+
+	dlist_delete(&state->pending_node);
+	state->num_buffered = 0;
+	state->buffered_bytes = 0;
+}
+
 extern void
 ts_chunk_insert_state_destroy(ChunkInsertState *state)
 {
 	ResultRelInfo *rri = state->result_relation_info;
 
+	if (state->multi_insert)
+	{
+		int i;
+
+		/* The chunk insert state can be evicted from the cache while in use */
+		ts_chunk_insert_state_flush(state);
+		FreeBulkInsertState(state->bistate);
+
+		for (i = 0; i < CHUNK_MULTI_INSERT_MAX_TUPLES && NULL != state->buffered_slots[i]; i++)
+			ExecDropSingleTupleTableSlot(state->buffered_slots[i]);
+	}
+
 	if (NULL != rri->ri_FdwRoutine && !rri->ri_usesFdwDirectModify &&
 		NULL != rri->ri_FdwRoutine->EndForeignModify)
 		rri->ri_FdwRoutine->EndForeignModify(state->estate, rri);
@@ -10,6 +10,7 @@
 #include <postgres.h>
 #include <funcapi.h>
 #include <access/tupconvert.h>
+#include <lib/ilist.h>
 
 #include "chunk.h"
 #include "cache.h"
@@ -54,11 +55,31 @@ typedef struct ChunkInsertState
 	EState *estate;
 	List *server_id_list; /* foreign server ids of data nodes used for remote inserts */
 	Oid user_id;
+
+	/*
+	 * Tuples buffered for a multi-insert into the chunk, see
+	 * chunk_dispatch_state.c and copy.c. Only used when multi_insert is
+	 * set. A chunk insert state with buffered tuples is on the pending list
+	 * of the chunk dispatch.
+	 */
+	bool multi_insert;
+	TupleTableSlot **buffered_slots;
+	int num_buffered;
+	Size buffered_bytes;
+	struct BulkInsertStateData *bistate;
+	dlist_head *pending_list;
+	dlist_node pending_node;
 } ChunkInsertState;
 
+/* Limits for the tuples buffered per chunk, the same as those used by COPY */
+#define CHUNK_MULTI_INSERT_MAX_TUPLES 1000
+#define CHUNK_MULTI_INSERT_MAX_BYTES 65535
+
 typedef struct ChunkDispatch ChunkDispatch;
 
 extern ChunkInsertState *ts_chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch);
 extern void ts_chunk_insert_state_destroy(ChunkInsertState *state);
+extern void ts_chunk_insert_state_buffer_tuple(ChunkInsertState *state, TupleTableSlot *slot);
+extern void ts_chunk_insert_state_flush(ChunkInsertState *state);
 
 #endif /* TIMESCALEDB_CHUNK_INSERT_STATE_H */
@@ -0,0 +1,624 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <catalog/pg_class.h>
+#include <fmgr.h>
+#include <miscadmin.h>
+#include <storage/lwlock.h>
+
+#include "chunk_shared_cache.h"
+#include "catalog.h"
+#include "chunk.h"
+#include "chunk_constraint.h"
+#include "config.h"
+#include "dimension_slice.h"
+#include "guc.h"
+#include "hypercube.h"
+#include "loader/chunk_cache.h"
+
+/*
+ * Shared chunk metadata cache.
+ *
+ * Planning a query on a hypertable requires the metadata (constraints,
+ * dimension slices and table OID) of every chunk that survives exclusion.
+ * Each backend reads this metadata from the catalog tables on every planning
+ * cycle, which dominates planning time for hypertables with many chunks and
+ * is paid again by every new connection. This cache keeps the metadata of
+ * chunks in shared memory, so that it is read from the catalog once for all
+ * backends.
+ *
+ * The shared memory is reserved by the loader (see loader/chunk_cache.c) and
+ * is formatted here as a fixed-size hash table of chunk entries using open
+ * addressing, keyed on database, catalog and chunk ID, and a second table of
+ * entry positions keyed on the chunk table's OID. When all slots in the probe
+ * window of a chunk are taken, the entry at the chunk's home position is
+ * replaced.
+ *
+ * Invalidation works with a generation number per database. An entry is only
+ * valid if it was stored in the current generation of its database, so
+ * starting a new generation invalidates all chunks of a database at once.
+ * Generations are unique across databases, and the databases using the cache
+ * share a small fixed table of generations; when it is full, the database
+ * invalidated longest ago gives up its slot, which invalidates its chunks.
+ *
+ * Modifications of the chunk metadata send a relcache invalidation on the
+ * cache_inval_chunk proxy table (see cache_invalidate.c), and every backend
+ * of the database starts a new generation when it receives the event after
+ * the modifying transaction commits. The modifying backend also starts one
+ * when it commits, so that stale chunks are not served until the next
+ * invalidation is processed. A backend that read a chunk before the commit
+ * either notices that the generation changed before storing the chunk, or
+ * stores it before processing the invalidation itself, which will then
+ * invalidate the stale entry. A transaction that modifies chunk metadata does
+ * not use the cache at all, since its changes are not visible to other
+ * backends yet.
+ *
+ * Only regular chunks with a limited number of constraints are cached, and
+ * chunks returned from the cache do not lock their dimension slices, so the
+ * cache should only be used for read-only lookups, e.g., during planning.
+ */
+
+#define CHUNK_SHARED_CACHE_MAGIC 0x54534343 /* "TSCC" */
+#define CHUNK_SHARED_CACHE_MAX_CONSTRAINTS 8
+#define CHUNK_SHARED_CACHE_MAX_SLICES 4
+#define CHUNK_SHARED_CACHE_PROBE_WINDOW 8
+#define CHUNK_SHARED_CACHE_MAX_DATABASES 32
+
+typedef struct ChunkSharedCacheDatabase
+{
+	Oid dbid;
+	ChunkSharedCacheGeneration generation;
+} ChunkSharedCacheDatabase;
+
+typedef struct ChunkSharedCacheHeader
+{
+	uint32 magic;
+	char version[NAMEDATALEN];
+	/* Last generation started in any database */
+	ChunkSharedCacheGeneration last_generation;
+	uint32 num_slots;
+	ChunkSharedCacheDatabase databases[CHUNK_SHARED_CACHE_MAX_DATABASES];
+} ChunkSharedCacheHeader;
+
+typedef struct ChunkSharedCacheEntry
+{
+	/* Key */
+	Oid dbid;
+	Oid catalog_id;
+	int32 chunk_id;
+
+	ChunkSharedCacheGeneration generation;
+	FormData_chunk fd;
+	Oid table_id;
+	Oid hypertable_relid;
+	char relkind;
+	int16 num_constraints;
+	int16 num_slices;
+	FormData_chunk_constraint constraints[CHUNK_SHARED_CACHE_MAX_CONSTRAINTS];
+	FormData_dimension_slice slices[CHUNK_SHARED_CACHE_MAX_SLICES];
+} ChunkSharedCacheEntry;
+
+typedef struct ChunkSharedCache
+{
+	LWLock *lock;
+	ChunkSharedCacheHeader *header;
+	ChunkSharedCacheEntry *entries;
+	/* Position + 1 of the entry for a chunk table OID, 0 if empty */
+	uint32 *relid_index;
+} ChunkSharedCache;
+
+static ChunkSharedCache shared_cache;
+static bool shared_cache_attached = false;
+static bool shared_cache_unavailable = false;
+
+/* Set if the current transaction modified chunk metadata */
+static bool xact_modified_chunks = false;
+
+static bool
+chunk_shared_cache_attach(void)
+{
+	TsChunkSharedCacheArea *area;
+	ChunkSharedCacheHeader *header;
+	Size slot_size = sizeof(ChunkSharedCacheEntry) + sizeof(uint32);
+	Size header_size = MAXALIGN(sizeof(ChunkSharedCacheHeader));
+	uint32 num_slots;
+
+	if (shared_cache_attached)
+		return true;
+
+	if (shared_cache_unavailable)
+		return false;
+
+	area = *((TsChunkSharedCacheArea **) find_rendezvous_variable(RENDEZVOUS_CHUNK_SHARED_CACHE));
+
+	/* The loader was not preloaded or the cache is disabled */
+	if (area == NULL || area->size < header_size + slot_size)
+	{
+		shared_cache_unavailable = true;
+		return false;
+	}
+
+	num_slots = (area->size - header_size) / slot_size;
+	header = (ChunkSharedCacheHeader *) area->data;
+
+	LWLockAcquire(area->lock, LW_EXCLUSIVE);
+
+	if (header->magic != CHUNK_SHARED_CACHE_MAGIC)
+	{
+		/* The loader zeroes the memory so all entries are empty */
+		header->magic = CHUNK_SHARED_CACHE_MAGIC;
+		strlcpy(header->version, TIMESCALEDB_VERSION_MOD, NAMEDATALEN);
+		header->last_generation = CHUNK_SHARED_CACHE_INVALID_GENERATION;
+		header->num_slots = num_slots;
+	}
+	else if (strncmp(header->version, TIMESCALEDB_VERSION_MOD, NAMEDATALEN) != 0)
+	{
+		/*
+		 * Another version of the extension, in another database, owns the
+		 * layout of the cache.
+		 */
+		LWLockRelease(area->lock);
+		shared_cache_unavailable = true;
+		return false;
+	}
+
+	LWLockRelease(area->lock);
+
+	shared_cache.lock = area->lock;
+	shared_cache.header = header;
+	shared_cache.entries = (ChunkSharedCacheEntry *) (area->data + header_size);
+	shared_cache.relid_index = (uint32 *) (shared_cache.entries + num_slots);
+	shared_cache_attached = true;
+
+	return true;
+}
+
+static bool
+chunk_shared_cache_usable(void)
+{
+	return ts_guc_enable_shared_chunk_cache && !xact_modified_chunks && chunk_shared_cache_attach();
+}
+
+static inline uint32
+chunk_shared_cache_hash(Oid dbid, Oid catalog_id, uint32 key)
+{
+	uint32 h = key ^ (dbid * 0x9e3779b9U) ^ (catalog_id * 0x85ebca6bU);
+
+	/* murmur3 finalizer */
+	h ^= h >> 16;
+	h *= 0x85ebca6bU;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35U;
+	h ^= h >> 16;
+
+	return h;
+}
+
+/*
+ * Get the current generation of a database, or the invalid generation if the
+ * database has no slot. Requires the lock.
+ */
+static ChunkSharedCacheGeneration
+chunk_shared_cache_db_generation(Oid dbid)
+{
+	int i;
+
+	for (i = 0; i < CHUNK_SHARED_CACHE_MAX_DATABASES; i++)
+	{
+		const ChunkSharedCacheDatabase *db = &shared_cache.header->databases[i];
+
+		if (db->dbid == dbid)
+			return db->generation;
+	}
+
+	return CHUNK_SHARED_CACHE_INVALID_GENERATION;
+}
+
+/*
+ * Start a new generation for a database, which invalidates all its entries. A
+ * database without a slot takes a free one or the one of the database
+ * invalidated longest ago. Requires the lock in exclusive mode.
+ */
+static ChunkSharedCacheGeneration
+chunk_shared_cache_db_new_generation(Oid dbid)
+{
+	ChunkSharedCacheDatabase *db = NULL;
+	int i;
+
+	for (i = 0; i < CHUNK_SHARED_CACHE_MAX_DATABASES; i++)
+	{
+		ChunkSharedCacheDatabase *slot = &shared_cache.header->databases[i];
+
+		if (slot->dbid == dbid)
+		{
+			db = slot;
+			break;
+		}
+
+		/* Free slots have the invalid generation, so they are taken first */
+		if (db == NULL || slot->generation < db->generation)
+			db = slot;
+	}
+
+	db->dbid = dbid;
+	db->generation = ++shared_cache.header->last_generation;
+
+	return db->generation;
+}
+
+/*
+ * Check if an entry, of any database, is valid. Requires the lock.
+ */
+static inline bool
+chunk_shared_cache_entry_is_valid(const ChunkSharedCacheEntry *entry)
+{
+	return entry->generation != CHUNK_SHARED_CACHE_INVALID_GENERATION &&
+		   entry->generation == chunk_shared_cache_db_generation(entry->dbid);
+}
+
+/*
+ * Check if an entry is valid and is for the given chunk in the current
+ * database, whose current generation is passed in.
+ */
+static inline bool
+chunk_shared_cache_entry_matches(const ChunkSharedCacheEntry *entry,
+								 ChunkSharedCacheGeneration generation, Oid catalog_id,
+								 int32 chunk_id)
+{
+	return entry->generation == generation && entry->chunk_id == chunk_id &&
+		   entry->dbid == MyDatabaseId && entry->catalog_id == catalog_id;
+}
+
+static Oid
+chunk_shared_cache_catalog_id(void)
+{
+	/*
+	 * The chunk catalog table is recreated, and chunk IDs start over, when
+	 * the extension is dropped and created again.
+	 */
+	return catalog_get_table_id(ts_catalog_get(), CHUNK);
+}
+
+/*
+ * Find the entry for a chunk ID. Requires the lock in shared mode.
+ */
+static ChunkSharedCacheEntry *
+chunk_shared_cache_find(Oid catalog_id, int32 chunk_id)
+{
+	ChunkSharedCacheGeneration generation = chunk_shared_cache_db_generation(MyDatabaseId);
+	uint32 num_slots = shared_cache.header->num_slots;
+	uint32 pos = chunk_shared_cache_hash(MyDatabaseId, catalog_id, chunk_id) % num_slots;
+	int i;
+
+	if (generation == CHUNK_SHARED_CACHE_INVALID_GENERATION)
+		return NULL;
+
+	for (i = 0; i < CHUNK_SHARED_CACHE_PROBE_WINDOW; i++)
+	{
+		ChunkSharedCacheEntry *entry = &shared_cache.entries[(pos + i) % num_slots];
+
+		if (chunk_shared_cache_entry_matches(entry, generation, catalog_id, chunk_id))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * Build a chunk from a copy of a cache entry. The chunk is allocated by the
+ * caller, everything else on the current memory context.
+ */
+static void
+chunk_shared_cache_entry_to_chunk(const ChunkSharedCacheEntry *entry, Chunk *chunk)
+{
+	int i;
+
+	memset(chunk, 0, sizeof(Chunk));
+	chunk->fd = entry->fd;
+	chunk->relkind = entry->relkind;
+	chunk->table_id = entry->table_id;
+	chunk->hypertable_relid = entry->hypertable_relid;
+
+	chunk->constraints = ts_chunk_constraints_alloc(entry->num_constraints, CurrentMemoryContext);
+
+	for (i = 0; i < entry->num_constraints; i++)
+	{
+		ChunkConstraint *cc = &chunk->constraints->constraints[i];
+
+		cc->fd = entry->constraints[i];
+
+		if (is_dimension_constraint(cc))
+			chunk->constraints->num_dimension_constraints++;
+	}
+
+	chunk->constraints->num_constraints = entry->num_constraints;
+	chunk->cube = ts_hypercube_alloc(entry->num_slices);
+
+	/* Slices are stored in dimension order */
+	for (i = 0; i < entry->num_slices; i++)
+	{
+		const FormData_dimension_slice *fd = &entry->slices[i];
+		DimensionSlice *slice =
+			ts_dimension_slice_create(fd->dimension_id, fd->range_start, fd->range_end);
+
+		slice->fd.id = fd->id;
+		chunk->cube->slices[chunk->cube->num_slices++] = slice;
+	}
+}
+
+/*
+ * Get the current generation of the cache before reading a chunk from the
+ * catalog, to be passed to ts_chunk_shared_cache_store() afterwards.
+ */
+ChunkSharedCacheGeneration
+ts_chunk_shared_cache_begin(void)
+{
+	ChunkSharedCacheGeneration generation;
+
+	if (!chunk_shared_cache_usable())
+		return CHUNK_SHARED_CACHE_INVALID_GENERATION;
+
+	LWLockAcquire(shared_cache.lock, LW_SHARED);
+	generation = chunk_shared_cache_db_generation(MyDatabaseId);
+	LWLockRelease(shared_cache.lock);
+
+	/* First use of the cache in this database */
+	if (generation == CHUNK_SHARED_CACHE_INVALID_GENERATION)
+	{
+		LWLockAcquire(shared_cache.lock, LW_EXCLUSIVE);
+		generation = chunk_shared_cache_db_generation(MyDatabaseId);
+
+		if (generation == CHUNK_SHARED_CACHE_INVALID_GENERATION)
+			generation = chunk_shared_cache_db_new_generation(MyDatabaseId);
+
+		LWLockRelease(shared_cache.lock);
+	}
+
+	return generation;
+}
+
+/*
+ * Add a chunk read from the catalog to the cache, unless the cache was
+ * invalidated since the chunk was read.
+ */
+void
+ts_chunk_shared_cache_store(const Chunk *chunk, ChunkSharedCacheGeneration generation)
+{
+	ChunkSharedCacheEntry new_entry;
+	ChunkSharedCacheEntry *entry = NULL;
+	Oid catalog_id;
+	uint32 num_slots;
+	uint32 pos;
+	int i;
+
+	if (generation == CHUNK_SHARED_CACHE_INVALID_GENERATION || !chunk_shared_cache_usable())
+		return;
+
+	/*
+	 * Foreign table chunks also need the data nodes, and chunks with many
+	 * constraints or dimensions do not fit in an entry.
+	 */
+	if (chunk->fd.dropped || chunk->relkind != RELKIND_RELATION || !OidIsValid(chunk->table_id) ||
+		chunk->constraints == NULL || chunk->cube == NULL ||
+		chunk->constraints->num_constraints > CHUNK_SHARED_CACHE_MAX_CONSTRAINTS ||
+		chunk->cube->num_slices > CHUNK_SHARED_CACHE_MAX_SLICES)
+		return;
+
+	catalog_id = chunk_shared_cache_catalog_id();
+
+	memset(&new_entry, 0, sizeof(new_entry));
+	new_entry.dbid = MyDatabaseId;
+	new_entry.catalog_id = catalog_id;
+	new_entry.chunk_id = chunk->fd.id;
+	new_entry.generation = generation;
+	new_entry.fd = chunk->fd;
+	new_entry.table_id = chunk->table_id;
+	new_entry.hypertable_relid = chunk->hypertable_relid;
+	new_entry.relkind = chunk->relkind;
+	new_entry.num_constraints = chunk->constraints->num_constraints;
+	new_entry.num_slices = chunk->cube->num_slices;
+
+	for (i = 0; i < chunk->constraints->num_constraints; i++)
+		new_entry.constraints[i] = chunk->constraints->constraints[i].fd;
+
+	for (i = 0; i < chunk->cube->num_slices; i++)
+		new_entry.slices[i] = chunk->cube->slices[i]->fd;
+
+	LWLockAcquire(shared_cache.lock, LW_EXCLUSIVE);
+
+	/* Invalidated while the chunk was read, so it might be stale */
+	if (chunk_shared_cache_db_generation(MyDatabaseId) != generation)
+	{
+		LWLockRelease(shared_cache.lock);
+		return;
+	}
+
+	num_slots = shared_cache.header->num_slots;
+	pos = chunk_shared_cache_hash(MyDatabaseId, catalog_id, chunk->fd.id) % num_slots;
+
+	/* Reuse the existing entry of the chunk or the first free slot */
+	for (i = 0; i < CHUNK_SHARED_CACHE_PROBE_WINDOW; i++)
+	{
+		ChunkSharedCacheEntry *slot = &shared_cache.entries[(pos + i) % num_slots];
+
+		if (chunk_shared_cache_entry_matches(slot, generation, catalog_id, chunk->fd.id))
+		{
+			entry = slot;
+			break;
+		}
+
+		if (entry == NULL && !chunk_shared_cache_entry_is_valid(slot))
+			entry = slot;
+	}
+
+	/* No free slot, so evict the chunk at the home position */
+	if (entry == NULL)
+		entry = &shared_cache.entries[pos];
+
+	memcpy(entry, &new_entry, sizeof(ChunkSharedCacheEntry));
+
+	/*
+	 * Index the entry on the chunk table's OID, using a slot that is empty or
+	 * points to an invalid entry or to an entry for the same table.
+	 */
+	pos = chunk_shared_cache_hash(MyDatabaseId, catalog_id, chunk->table_id) % num_slots;
+
+	for (i = 0; i < CHUNK_SHARED_CACHE_PROBE_WINDOW; i++)
+	{
+		uint32 index = shared_cache.relid_index[(pos + i) % num_slots];
+		ChunkSharedCacheEntry *indexed;
+
+		if (index == 0)
+			break;
+
+		indexed = &shared_cache.entries[index - 1];
+
+		if (indexed == entry || !chunk_shared_cache_entry_is_valid(indexed) ||
+			(indexed->table_id == chunk->table_id && indexed->dbid == MyDatabaseId &&
+			 indexed->catalog_id == catalog_id))
+			break;
+	}
+
+	/* No usable slot, so replace the one at the home position */
+	if (i == CHUNK_SHARED_CACHE_PROBE_WINDOW)
+		i = 0;
+
+	shared_cache.relid_index[(pos + i) % num_slots] = (uint32)(entry - shared_cache.entries) + 1;
+
+	LWLockRelease(shared_cache.lock);
+}
+
+/*
+ * Look up a chunk by ID in the cache. The chunk is filled in on success.
+ */
+bool
+ts_chunk_shared_cache_get_by_id(int32 chunk_id, Chunk *chunk)
+{
+	ChunkSharedCacheEntry copy;
+	ChunkSharedCacheEntry *entry;
+	Oid catalog_id;
+
+	if (!chunk_shared_cache_usable())
+		return false;
+
+	catalog_id = chunk_shared_cache_catalog_id();
+
+	LWLockAcquire(shared_cache.lock, LW_SHARED);
+	entry = chunk_shared_cache_find(catalog_id, chunk_id);
+
+	if (entry != NULL)
+		memcpy(&copy, entry, sizeof(ChunkSharedCacheEntry));
+
+	LWLockRelease(shared_cache.lock);
+
+	if (entry == NULL)
+		return false;
+
+	chunk_shared_cache_entry_to_chunk(&copy, chunk);
+
+	return true;
+}
+
+/*
+ * Look up a chunk by the OID of its table in the cache. The chunk is filled
+ * in on success.
+ */
+bool
+ts_chunk_shared_cache_get_by_relid(Oid relid, Chunk *chunk)
+{
+	ChunkSharedCacheEntry copy;
+	ChunkSharedCacheEntry *entry = NULL;
+	ChunkSharedCacheGeneration generation;
+	Oid catalog_id;
+	uint32 num_slots;
+	uint32 pos;
+	int i;
+
+	if (!chunk_shared_cache_usable())
+		return false;
+
+	catalog_id = chunk_shared_cache_catalog_id();
+
+	LWLockAcquire(shared_cache.lock, LW_SHARED);
+	generation = chunk_shared_cache_db_generation(MyDatabaseId);
+	num_slots = shared_cache.header->num_slots;
+	pos = chunk_shared_cache_hash(MyDatabaseId, catalog_id, relid) % num_slots;
+
+	for (i = 0; i < CHUNK_SHARED_CACHE_PROBE_WINDOW; i++)
+	{
+		uint32 index = shared_cache.relid_index[(pos + i) % num_slots];
+		ChunkSharedCacheEntry *indexed;
+
+		if (index == 0)
+			break;
+
+		indexed = &shared_cache.entries[index - 1];
+
+		if (generation != CHUNK_SHARED_CACHE_INVALID_GENERATION &&
+			indexed->generation == generation && indexed->table_id == relid &&
+			indexed->dbid == MyDatabaseId && indexed->catalog_id == catalog_id)
+		{
+			entry = indexed;
+			memcpy(&copy, entry, sizeof(ChunkSharedCacheEntry));
+			break;
+		}
+	}
+
+	LWLockRelease(shared_cache.lock);
+
+	if (entry == NULL)
+		return false;
+
+	chunk_shared_cache_entry_to_chunk(&copy, chunk);
+
+	return true;
+}
+
+/*
+ * Stop using the cache for the rest of the transaction, since it modified
+ * chunk metadata.
+ */
+void
+ts_chunk_shared_cache_mark_modified(void)
+{
+	xact_modified_chunks = true;
+}
+
+/*
+ * Invalidate all entries of the current database, called when receiving an
+ * invalidation event for the chunk metadata.
+ *
+ * Other backends might use the cache even if this one does not, so attach to
+ * the cache regardless of timescaledb.enable_shared_chunk_cache.
+ */
+void
+ts_chunk_shared_cache_invalidate_callback(void)
+{
+	if (!chunk_shared_cache_attach())
+		return;
+
+	LWLockAcquire(shared_cache.lock, LW_EXCLUSIVE);
+
+	/* Nothing is cached for a database without a slot */
+	if (chunk_shared_cache_db_generation(MyDatabaseId) != CHUNK_SHARED_CACHE_INVALID_GENERATION)
+		chunk_shared_cache_db_new_generation(MyDatabaseId);
+
+	LWLockRelease(shared_cache.lock);
+}
+
+/*
+ * Reset the transaction state at the end of a transaction. A committed
+ * transaction that modified chunk metadata invalidates the cache right away,
+ * since its changes are now visible to other backends.
+ */
+void
+ts_chunk_shared_cache_xact_end(bool commit)
+{
+	if (commit && xact_modified_chunks)
+		ts_chunk_shared_cache_invalidate_callback();
+
+	xact_modified_chunks = false;
+}
@@ -0,0 +1,31 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_CHUNK_SHARED_CACHE_H
+#define TIMESCALEDB_CHUNK_SHARED_CACHE_H
+
+#include <postgres.h>
+
+#include "chunk.h"
+
+/*
+ * Generation of the shared chunk cache, used to make sure that a chunk read
+ * from the catalog is only added to the cache if the cache has not been
+ * invalidated while the chunk was being read.
+ */
+typedef uint64 ChunkSharedCacheGeneration;
+
+#define CHUNK_SHARED_CACHE_INVALID_GENERATION 0
+
+extern ChunkSharedCacheGeneration ts_chunk_shared_cache_begin(void);
+extern void ts_chunk_shared_cache_store(const Chunk *chunk, ChunkSharedCacheGeneration generation);
+extern bool ts_chunk_shared_cache_get_by_id(int32 chunk_id, Chunk *chunk);
+extern bool ts_chunk_shared_cache_get_by_relid(Oid relid, Chunk *chunk);
+
+extern void ts_chunk_shared_cache_mark_modified(void);
+extern void ts_chunk_shared_cache_invalidate_callback(void);
+extern void ts_chunk_shared_cache_xact_end(bool commit);
+
+#endif /* TIMESCALEDB_CHUNK_SHARED_CACHE_H */
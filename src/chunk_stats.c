@@ -0,0 +1,318 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <catalog/namespace.h>
+#include <catalog/pg_class.h>
+#include <optimizer/cost.h>
+#include <utils/acl.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/selfuncs.h>
+#include <utils/syscache.h>
+#include <miscadmin.h>
+
+#include "chunk_stats.h"
+#include "catalog.h"
+#include "dimension.h"
+#include "hypertable.h"
+#include "planner.h"
+#include "scan_iterator.h"
+
+/*
+ * Statistics for chunks that have not been analyzed yet.
+ *
+ * A new chunk has no statistics until it is analyzed, typically by
+ * autovacuum. Until then the planner uses default selectivities for its
+ * columns, which often leads to bad plans (e.g., nested loops) for the newest
+ * chunk, even though that is usually the chunk that is queried the most.
+ *
+ * Since the chunks of a hypertable typically hold data with a similar
+ * distribution, we extrapolate the statistics of an unanalyzed chunk from its
+ * newest analyzed sibling: the tuple density of the sibling gives the number
+ * of tuples from the current size of the chunk, and the column statistics of
+ * the sibling (null fraction, n_distinct, most common values and histograms)
+ * stand in for the missing ones.
+ *
+ * The statistics of the open ("time") dimension column are never borrowed:
+ * the sibling covers another time range, so its histogram would make range
+ * restrictions on the chunk look far more selective than they are.
+ */
+
+typedef struct SiblingCandidate
+{
+	int32 chunk_id;
+	NameData schema_name;
+	NameData table_name;
+} SiblingCandidate;
+
+static int
+sibling_candidate_cmp_newest_first(const void *left, const void *right)
+{
+	const SiblingCandidate *l = left;
+	const SiblingCandidate *r = right;
+
+	if (l->chunk_id > r->chunk_id)
+		return -1;
+	if (l->chunk_id < r->chunk_id)
+		return 1;
+	return 0;
+}
+
+/*
+ * Get the pg_class statistics of a relation. Returns false if the relation has
+ * never been analyzed (or vacuumed).
+ */
+static bool
+relation_get_class_stats(Oid relid, BlockNumber *relpages, double *reltuples)
+{
+	HeapTuple tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(relid));
+	Form_pg_class form;
+	bool analyzed;
+
+	*relpages = 0;
+	*reltuples = 0;
+
+	if (!HeapTupleIsValid(tuple))
+		return false;
+
+	form = (Form_pg_class) GETSTRUCT(tuple);
+	analyzed = form->relkind == RELKIND_RELATION && form->relpages > 0 && form->reltuples > 0;
+	*relpages = (BlockNumber) form->relpages;
+	*reltuples = (double) form->reltuples;
+	ReleaseSysCache(tuple);
+
+	return analyzed;
+}
+
+/*
+ * Find the newest analyzed chunk of a hypertable. Chunks with compressed data
+ * are skipped since their statistics describe data that no longer lives in
+ * the chunk's own heap. The result never is the unanalyzed chunk itself, so
+ * it can be shared by all unanalyzed chunks of the hypertable.
+ *
+ * Chunk IDs are allocated from a sequence, so a higher ID means a more
+ * recently created chunk, which is the best guess for a chunk with data
+ * similar to the unanalyzed one.
+ */
+static Oid
+chunk_stats_find_sibling(int32 hypertable_id)
+{
+	ScanIterator iterator = ts_scan_iterator_create(CHUNK, AccessShareLock, CurrentMemoryContext);
+	SiblingCandidate *candidates;
+	int num_candidates = 0;
+	int max_candidates = 16;
+	BlockNumber relpages;
+	double reltuples;
+	int i;
+
+	candidates = palloc(sizeof(SiblingCandidate) * max_candidates);
+	iterator.ctx.index = catalog_get_index(ts_catalog_get(), CHUNK, CHUNK_HYPERTABLE_ID_INDEX);
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_chunk_hypertable_id_idx_hypertable_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(hypertable_id));
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleTableSlot *slot = ts_scan_iterator_slot(&iterator);
+		SiblingCandidate *candidate;
+		bool isnull;
+		Datum value;
+
+		value = slot_getattr(slot, Anum_chunk_dropped, &isnull);
+		Assert(!isnull);
+
+		if (DatumGetBool(value))
+			continue;
+
+		slot_getattr(slot, Anum_chunk_compressed_chunk_id, &isnull);
+
+		if (!isnull)
+			continue;
+
+		if (num_candidates >= max_candidates)
+		{
+			max_candidates *= 2;
+			candidates = repalloc(candidates, sizeof(SiblingCandidate) * max_candidates);
+		}
+
+		candidate = &candidates[num_candidates++];
+		candidate->chunk_id = DatumGetInt32(slot_getattr(slot, Anum_chunk_id, &isnull));
+		namestrcpy(&candidate->schema_name,
+				   NameStr(*DatumGetName(slot_getattr(slot, Anum_chunk_schema_name, &isnull))));
+		namestrcpy(&candidate->table_name,
+				   NameStr(*DatumGetName(slot_getattr(slot, Anum_chunk_table_name, &isnull))));
+	}
+
+	qsort(candidates, num_candidates, sizeof(SiblingCandidate), sibling_candidate_cmp_newest_first);
+
+	for (i = 0; i < num_candidates; i++)
+	{
+		Oid nspid = get_namespace_oid(NameStr(candidates[i].schema_name), true);
+		Oid relid;
+
+		if (!OidIsValid(nspid))
+			continue;
+
+		relid = get_relname_relid(NameStr(candidates[i].table_name), nspid);
+
+		if (OidIsValid(relid) && relation_get_class_stats(relid, &relpages, &reltuples))
+		{
+			pfree(candidates);
+			return relid;
+		}
+	}
+
+	pfree(candidates);
+
+	return InvalidOid;
+}
+
+/*
+ * Get the private planner state of the hypertable that the chunk was expanded
+ * from, or NULL if the chunk is queried directly.
+ */
+static TimescaleDBPrivate *
+chunk_stats_get_hypertable_private(PlannerInfo *root, RelOptInfo *rel, const Hypertable *ht)
+{
+	AppendRelInfo *appinfo;
+	RelOptInfo *parent;
+
+	if (root->append_rel_array == NULL || root->append_rel_array[rel->relid] == NULL)
+		return NULL;
+
+	appinfo = root->append_rel_array[rel->relid];
+
+	if (appinfo->parent_reloid != ht->main_table_relid)
+		return NULL;
+
+	parent = root->simple_rel_array[appinfo->parent_relid];
+
+	return parent == NULL ? NULL : ts_get_private_reloptinfo(parent);
+}
+
+/*
+ * Get the sibling whose statistics are used for an unanalyzed chunk. The
+ * sibling is the same for all chunks of a hypertable, so it is looked up once
+ * per planning cycle and remembered in the hypertable's planner state instead
+ * of scanning all chunks again for every unanalyzed chunk.
+ */
+static Oid
+chunk_stats_get_sibling(PlannerInfo *root, RelOptInfo *rel, const Hypertable *ht)
+{
+	TimescaleDBPrivate *ht_private = chunk_stats_get_hypertable_private(root, rel, ht);
+
+	if (ht_private == NULL)
+		return chunk_stats_find_sibling(ht->fd.id);
+
+	if (!ht_private->stats_sibling_searched)
+	{
+		ht_private->stats_sibling_relid = chunk_stats_find_sibling(ht->fd.id);
+		ht_private->stats_sibling_searched = true;
+	}
+
+	return ht_private->stats_sibling_relid;
+}
+
+/*
+ * Extrapolate the size estimates of an unanalyzed chunk from an analyzed
+ * sibling and remember the sibling so that its column statistics can be used
+ * for the chunk, see ts_chunk_stats_get_relation_stats().
+ *
+ * The planner has already estimated the number of pages of the chunk from the
+ * actual size of the relation, so we only replace the tuple density, which the
+ * planner otherwise guesses from the width of the tuple.
+ */
+void
+ts_chunk_stats_set_rel_estimates(PlannerInfo *root, RelOptInfo *rel, const Hypertable *ht)
+{
+	TimescaleDBPrivate *private = ts_get_private_reloptinfo(rel);
+	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
+	const Dimension *dim;
+	BlockNumber relpages;
+	double reltuples;
+	Oid sibling_relid;
+
+	if (rte->relkind != RELKIND_RELATION ||
+		relation_get_class_stats(rte->relid, &relpages, &reltuples))
+		return;
+
+	/* Only a chunk that was never analyzed or vacuumed has zero relpages */
+	if (relpages > 0)
+		return;
+
+	sibling_relid = chunk_stats_get_sibling(root, rel, ht);
+
+	if (!OidIsValid(sibling_relid) ||
+		!relation_get_class_stats(sibling_relid, &relpages, &reltuples))
+		return;
+
+	if (rel->pages > 0)
+		rel->tuples = clamp_row_est(reltuples / relpages * rel->pages);
+
+	private->stats_relid = sibling_relid;
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (dim != NULL)
+		private->stats_excluded_attno = get_attnum(rte->relid, NameStr(dim->fd.column_name));
+}
+
+/*
+ * Look up the column statistics of an unanalyzed chunk in its analyzed
+ * sibling. Columns are matched by name since the attribute numbers of chunks
+ * can differ, e.g., after dropping columns on the hypertable.
+ *
+ * Returns true if the sibling had statistics for the column, in which case
+ * the statistics tuple is set in vardata.
+ */
+bool
+ts_chunk_stats_get_relation_stats(PlannerInfo *root, RangeTblEntry *rte, AttrNumber attnum,
+								  VariableStatData *vardata)
+{
+	TimescaleDBPrivate *private;
+	AttrNumber sibling_attnum;
+	char *attname;
+	Oid userid;
+
+	if (rte->rtekind != RTE_RELATION || rte->relkind != RELKIND_RELATION || rte->inh ||
+		attnum <= 0 || vardata->rel == NULL)
+		return false;
+
+	private = ts_get_private_reloptinfo(vardata->rel);
+
+	if (private == NULL || !OidIsValid(private->stats_relid) ||
+		attnum == private->stats_excluded_attno)
+		return false;
+
+	attname = get_attname(rte->relid, attnum, true);
+
+	if (attname == NULL)
+		return false;
+
+	sibling_attnum = get_attnum(private->stats_relid, attname);
+
+	if (sibling_attnum == InvalidAttrNumber)
+		return false;
+
+	vardata->statsTuple = SearchSysCache3(STATRELATTINH,
+										  ObjectIdGetDatum(private->stats_relid),
+										  Int16GetDatum(sibling_attnum),
+										  BoolGetDatum(false));
+
+	if (!HeapTupleIsValid(vardata->statsTuple))
+		return false;
+
+	vardata->freefunc = ReleaseSysCache;
+
+	/* Same permission check as the planner does for the chunk's own statistics */
+	userid = OidIsValid(rte->checkAsUser) ? rte->checkAsUser : GetUserId();
+	vardata->acl_ok = pg_class_aclcheck(rte->relid, userid, ACL_SELECT) == ACLCHECK_OK ||
+					  pg_attribute_aclcheck(rte->relid, attnum, userid, ACL_SELECT) == ACLCHECK_OK;
+
+	return true;
+}
@@ -0,0 +1,26 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_CHUNK_STATS_H
+#define TIMESCALEDB_CHUNK_STATS_H
+
+#include <postgres.h>
+#include <utils/selfuncs.h>
+
+#include "compat.h"
+#include "hypertable.h"
+
+#if PG12_GE
+#include <nodes/pathnodes.h>
+#else
+#include <nodes/relation.h>
+#endif
+
+extern void ts_chunk_stats_set_rel_estimates(PlannerInfo *root, RelOptInfo *rel,
+											 const Hypertable *ht);
+extern bool ts_chunk_stats_get_relation_stats(PlannerInfo *root, RangeTblEntry *rte,
+											  AttrNumber attnum, VariableStatData *vardata);
+
+#endif /* TIMESCALEDB_CHUNK_STATS_H */
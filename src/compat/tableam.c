@@ -44,6 +44,27 @@ ts_table_tuple_insert(Relation rel, TupleTableSlot *slot, CommandId cid, int opt
 		pfree(tuple);
 }
 
+void
+ts_table_multi_insert(Relation rel, TupleTableSlot **slots, int nslots, CommandId cid, int options,
+					  struct BulkInsertStateData *bistate)
+{
+	HeapTuple *tuples = palloc(sizeof(HeapTuple) * nslots);
+	int i;
+
+	/*
+	 * Use the tuples owned by the slots, since heap_multi_insert copies the
+	 * resulting ItemPointers back to them and index inserts need those.
+	 */
+	for (i = 0; i < nslots; i++)
+	{
+		tuples[i] = ExecFetchSlotHeapTuple(slots[i], true, NULL);
+		tuples[i]->t_tableOid = RelationGetRelid(rel);
+	}
+
+	heap_multi_insert(rel, tuples, nslots, cid, options, bistate);
+	pfree(tuples);
+}
+
 bool
 ts_table_scan_getnextslot(TableScanDesc scan, const ScanDirection direction, TupleTableSlot *slot)
 {
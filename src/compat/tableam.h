@@ -22,11 +22,14 @@
 #define table_beginscan(rel, snapshot, nkeys, keys) heap_beginscan(rel, snapshot, nkeys, keys)
 #define table_beginscan_catalog(rel, nkeys, keys) heap_beginscan_catalog(rel, nkeys, keys)
 #define table_endscan(scan) heap_endscan(scan)
+#define table_rescan(scan, keys) heap_rescan(scan, keys)
 
 #define table_slot_callbacks(rel) NULL
 #define table_slot_create(rel, reglist) ts_table_slot_create(rel, reglist)
 #define table_tuple_insert(rel, slot, cid, options, bistate)                                       \
 	ts_table_tuple_insert(rel, slot, cid, options, bistate)
+#define table_multi_insert(rel, slots, nslots, cid, options, bistate)                              \
+	ts_table_multi_insert(rel, slots, nslots, cid, options, bistate)
 #define table_scan_getnextslot(scan, direction, slot)                                              \
 	ts_table_scan_getnextslot(scan, direction, slot)
 #define index_getnext_slot(scan, direction, slot) ts_index_getnext_slot(scan, direction, slot)
@@ -34,6 +37,8 @@
 extern TupleTableSlot *ts_table_slot_create(Relation rel, List **reglist);
 extern void ts_table_tuple_insert(Relation rel, TupleTableSlot *slot, CommandId cid, int options,
 								  struct BulkInsertStateData *bistate);
+extern void ts_table_multi_insert(Relation rel, TupleTableSlot **slots, int nslots, CommandId cid,
+								  int options, struct BulkInsertStateData *bistate);
 extern bool ts_table_scan_getnextslot(TableScanDesc scan, const ScanDirection direction,
 									  TupleTableSlot *slot);
 extern bool ts_index_getnext_slot(IndexScanDesc scan, const ScanDirection direction,
@@ -15,6 +15,7 @@
 #include <storage/lmgr.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
+#include <utils/varlena.h>
 #include <parser/parser.h>
 
 #include "compat.h"
@@ -35,6 +36,10 @@ static const WithClauseDefinition compress_hypertable_with_clause_def[] = {
 			 .arg_name = "compress_orderby",
 			 .type_id = TEXTOID,
 		},
+		[CompressAlgorithms] = {
+			 .arg_name = "compress_algorithms",
+			 .type_id = TEXTOID,
+		},
 };
 
 WithClauseResult *
@@ -248,6 +253,66 @@ parse_order_collist(char *inpstr, Hypertable *hypertable)
 	return collist;
 }
 
+static inline void
+throw_algorithms_error(char *algorithms)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_SYNTAX_ERROR),
+			 errmsg("unable to parse compression algorithms option \"%s\"", algorithms),
+			 errhint("The timescaledb.compress_algorithms option must be a set of"
+					 " column:algorithm pairs separated by commas.")));
+}
+
+static CompressedParsedAlgorithm *
+parse_algorithm_item(char *item, char *inpstr)
+{
+	CompressedParsedAlgorithm *col = palloc(sizeof(*col));
+	List *names;
+
+	/* the column name can be quoted like any identifier, the algorithm is
+	 * case-insensitive */
+	if (!SplitIdentifierString(item, ':', &names) || list_length(names) != 2)
+		throw_algorithms_error(inpstr);
+
+	namestrcpy(&col->colname, linitial(names));
+	namestrcpy(&col->algorithm, lsecond(names));
+
+	return col;
+}
+
+static List *
+parse_algorithm_list(char *inpstr)
+{
+	char *rawstring = pstrdup(inpstr);
+	char *item = rawstring;
+	bool in_quotes = false;
+	List *collist = NIL;
+	char *pos;
+
+	if (strlen(inpstr) == 0)
+		return NIL;
+
+	/* split on the commas that are not part of a quoted column name */
+	for (pos = rawstring;; pos++)
+	{
+		if (*pos == '"')
+			in_quotes = !in_quotes;
+		else if (*pos == '\0' || (*pos == ',' && !in_quotes))
+		{
+			bool done = *pos == '\0';
+
+			*pos = '\0';
+			collist = lappend(collist, parse_algorithm_item(item, inpstr));
+
+			if (done)
+				break;
+			item = pos + 1;
+		}
+	}
+
+	return collist;
+}
+
 /* returns List of CompressedParsedCol
  * compress_segmentby = `col1,col2,col3`
  */
@@ -277,3 +342,18 @@ ts_compress_hypertable_parse_order_by(WithClauseResult *parsed_options, Hypertab
 	else
 		return NIL;
 }
+
+/* returns List of CompressedParsedAlgorithm
+ * E.g. timescaledb.compress_algorithms = 'status:for,temperature:alp,reading:auto'
+ */
+List *
+ts_compress_hypertable_parse_algorithms(WithClauseResult *parsed_options)
+{
+	if (parsed_options[CompressAlgorithms].is_default == false)
+	{
+		Datum textarg = parsed_options[CompressAlgorithms].parsed;
+		return parse_algorithm_list(TextDatumGetCString(textarg));
+	}
+	else
+		return NIL;
+}
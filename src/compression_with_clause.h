@@ -18,6 +18,7 @@ typedef enum CompressHypertableOption
 	CompressEnabled = 0,
 	CompressSegmentBy,
 	CompressOrderBy,
+	CompressAlgorithms,
 } CompressHypertableOption;
 
 typedef struct
@@ -28,10 +29,17 @@ typedef struct
 	bool asc;
 } CompressedParsedCol;
 
+typedef struct
+{
+	NameData colname;
+	NameData algorithm;
+} CompressedParsedAlgorithm;
+
 WithClauseResult *ts_compress_hypertable_set_clause_parse(const List *defelems);
 extern TSDLLEXPORT List *ts_compress_hypertable_parse_segment_by(WithClauseResult *parsed_options,
 																 Hypertable *hypertable);
 extern TSDLLEXPORT List *ts_compress_hypertable_parse_order_by(WithClauseResult *parsed_options,
 															   Hypertable *hypertable);
+extern TSDLLEXPORT List *ts_compress_hypertable_parse_algorithms(WithClauseResult *parsed_options);
 
 #endif
@@ -26,6 +26,7 @@
 #include <parser/parse_coerce.h>
 #include <parser/parse_collate.h>
 #include <parser/parse_relation.h>
+#include <rewrite/rewriteHandler.h>
 #include <storage/bufmgr.h>
 #include <storage/smgr.h>
 #include <utils/builtins.h>
@@ -43,9 +44,12 @@
 #include "subspace_store.h"
 #include "compat.h"
 #include "cross_module_fn.h"
+#include "guc.h"
 
 #if PG12_GE
 #include <optimizer/optimizer.h>
+#else
+#include <optimizer/clauses.h>
 #endif
 
 /*
@@ -73,6 +77,7 @@ copy_chunk_state_create(Hypertable *ht, Relation rel, CopyFromFunc from_func, Co
 	ccstate->scandesc = scandesc;
 	ccstate->next_copy_from = from_func;
 	ccstate->where_clause = NULL;
+	ccstate->multi_insert = ts_guc_enable_multi_insert;
 
 	return ccstate;
 }
@@ -247,6 +252,7 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, void (*call
 	estate->es_num_result_relations = 1;
 	estate->es_result_relation_info = resultRelInfo;
 	estate->es_range_table = range_table;
+	estate->es_output_cid = mycid;
 
 #if PG12_GE
 	ExecInitRangeTable(estate, estate->es_range_table);
@@ -279,6 +285,17 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, void (*call
 	bistate = GetBulkInsertState();
 	econtext = GetPerTupleExprContext(estate);
 
+	/*
+	 * Buffer tuples per chunk, unless the WHERE clause could observe the
+	 * tuples that are not inserted yet. The buffered tuples are written in
+	 * batches, which is a lot cheaper than inserting them one at a time.
+	 */
+	ccstate->dispatch->multi_insert = ccstate->multi_insert;
+#if PG12_GE
+	if (ccstate->where_clause != NULL && contain_volatile_functions(ccstate->where_clause))
+		ccstate->dispatch->multi_insert = false;
+#endif
+
 	/* Set up callback to identify error line number.
 	 *
 	 * It is not necessary to add an entry to the error context stack if we do
@@ -370,7 +387,17 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, void (*call
 #endif
 		}
 
-		if (!skip_tuple)
+		if (!skip_tuple && cis->multi_insert)
+		{
+			/*
+			 * Generated columns and constraints are handled when buffering
+			 * the tuple. Errors raised when flushing the buffer, e.g., for
+			 * unique violations, are reported for the current line.
+			 */
+			ts_chunk_insert_state_buffer_tuple(cis, myslot);
+			processed++;
+		}
+		else if (!skip_tuple)
 		{
 			/* Note that PostgreSQL's copy path would check INSTEAD OF
 			 * INSERT/UPDATE/DELETE triggers here, but such triggers can only
@@ -426,6 +453,9 @@ copyfrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht, void (*call
 		estate->es_result_relation_info = resultRelInfo;
 	}
 
+	/* Insert the remaining buffered tuples */
+	ts_chunk_dispatch_flush(ccstate->dispatch);
+
 	estate->es_result_relation_info = ccstate->dispatch->hypertable_result_rel_info;
 
 	/* Done, clean up */
@@ -599,6 +629,39 @@ copy_constraints_and_check(ParseState *pstate, Relation rel, List *attnums)
 	PreventCommandIfParallelMode("COPY FROM");
 }
 
+/*
+ * Check whether COPY evaluates volatile default expressions for the columns
+ * that are not copied. Like in PostgreSQL, tuples are not buffered in that
+ * case, since the expressions could query the hypertable. Sequences are fine,
+ * though.
+ */
+static bool
+copy_has_volatile_defaults(Relation rel, List *attnums)
+{
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	int i;
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		Node *defexpr;
+
+		if (attr->attisdropped || list_member_int(attnums, attr->attnum))
+			continue;
+#if PG12_GE
+		if (attr->attgenerated)
+			continue;
+#endif
+
+		defexpr = build_column_default(rel, attr->attnum);
+
+		if (defexpr != NULL && contain_volatile_functions_not_nextval(defexpr))
+			return true;
+	}
+
+	return false;
+}
+
 void
 timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *processed, Hypertable *ht)
 {
@@ -677,6 +740,9 @@ timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *proces
 	ccstate = copy_chunk_state_create(ht, rel, next_copy_from, cstate, NULL);
 	ccstate->where_clause = where_clause;
 
+	if (copy_has_volatile_defaults(rel, attnums))
+		ccstate->multi_insert = false;
+
 	if (hypertable_is_distributed(ht))
 		*processed = ts_cm_functions->distributed_copy(stmt, ccstate, attnums);
 	else
@@ -30,6 +30,8 @@ typedef struct CopyChunkState
 	CopyState cstate;
 	TableScanDesc scandesc;
 	Node *where_clause;
+	/* Allow buffering tuples per chunk, see copyfrom() */
+	bool multi_insert;
 } CopyChunkState;
 
 extern void timescaledb_DoCopy(const CopyStmt *stmt, const char *queryString, uint64 *processed,
@@ -21,6 +21,9 @@
 	}
 
 /* bgw policy functions */
+CROSSMODULE_WRAPPER(policy_chunk_precreate_add);
+CROSSMODULE_WRAPPER(policy_chunk_precreate_proc);
+CROSSMODULE_WRAPPER(policy_chunk_precreate_remove);
 CROSSMODULE_WRAPPER(policy_compression_add);
 CROSSMODULE_WRAPPER(policy_compression_proc);
 CROSSMODULE_WRAPPER(policy_compression_remove);
@@ -153,6 +156,13 @@ job_execute_default_fn(BgwJob *job)
 	pg_unreachable();
 }
 
+static bool
+policy_compression_compress_chunk_default(int32 chunk_id)
+{
+	error_no_default_fn_community();
+	pg_unreachable();
+}
+
 static bool
 process_compress_table_default(AlterTableCmd *cmd, Hypertable *ht,
 							   WithClauseResult *with_clause_options)
@@ -305,6 +315,9 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.gapfill_timestamptz_time_bucket = error_no_default_fn_pg_community,
 
 	/* bgw policies */
+	.policy_chunk_precreate_add = error_no_default_fn_pg_community,
+	.policy_chunk_precreate_proc = error_no_default_fn_pg_community,
+	.policy_chunk_precreate_remove = error_no_default_fn_pg_community,
 	.policy_compression_add = error_no_default_fn_pg_community,
 	.policy_compression_proc = error_no_default_fn_pg_community,
 	.policy_compression_remove = error_no_default_fn_pg_community,
@@ -323,6 +336,7 @@ TSDLLEXPORT CrossModuleFunctions ts_cm_functions_default = {
 	.job_delete = error_no_default_fn_pg_community,
 	.job_run = error_no_default_fn_pg_community,
 	.job_execute = job_execute_default_fn,
+	.policy_compression_compress_chunk = policy_compression_compress_chunk_default,
 
 	.move_chunk = error_no_default_fn_pg_community,
 	.reorder_chunk = error_no_default_fn_pg_community,
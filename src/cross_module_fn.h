@@ -40,6 +40,9 @@ typedef struct CrossModuleFunctions
 {
 	void (*add_tsl_telemetry_info)(JsonbParseState **parse_state);
 
+	PGFunction policy_chunk_precreate_add;
+	PGFunction policy_chunk_precreate_proc;
+	PGFunction policy_chunk_precreate_remove;
 	PGFunction policy_compression_add;
 	PGFunction policy_compression_proc;
 	PGFunction policy_compression_remove;
@@ -58,6 +61,7 @@ typedef struct CrossModuleFunctions
 	PGFunction job_delete;
 	PGFunction job_run;
 	bool (*job_execute)(BgwJob *job);
+	bool (*policy_compression_compress_chunk)(int32 chunk_id);
 
 	void (*create_upper_paths_hook)(PlannerInfo *, UpperRelationKind, RelOptInfo *, RelOptInfo *,
 									TsRelType input_reltype, Hypertable *ht, void *extra);
@@ -20,6 +20,7 @@
 #include "chunk_constraint.h"
 #include "dimension.h"
 #include "dimension_slice.h"
+#include "dimension_slice_index.h"
 #include "dimension_vector.h"
 #include "hypertable.h"
 #include "scanner.h"
@@ -275,6 +276,31 @@ ts_dimension_slice_scan_limit(int32 dimension_id, int64 coordinate, int limit, S
 	return ts_dimension_vec_sort(&slices);
 }
 
+/*
+ * range_end is stored as exclusive, so add 1 to the value being searched.
+ * Also avoid overflow.
+ */
+static int64
+dimension_slice_range_end_search_value(int64 end_value)
+{
+	if (end_value != PG_INT64_MAX)
+	{
+		end_value++;
+
+		/*
+		 * If getting as input INT64_MAX-1, need to remap the incremented
+		 * value back to INT64_MAX-1
+		 */
+		return REMAP_LAST_COORDINATE(end_value);
+	}
+
+	/*
+	 * The point with INT64_MAX gets mapped to INT64_MAX-1 so incrementing
+	 * that gets you to INT_64MAX
+	 */
+	return PG_INT64_MAX;
+}
+
 static void
 dimension_slice_scan_with_strategies(int32 dimension_id, StrategyNumber start_strategy,
 									 int64 start_value, StrategyNumber end_strategy,
@@ -313,28 +339,7 @@ dimension_slice_scan_with_strategies(int32 dimension_id, StrategyNumber start_st
 
 		Assert(OidIsValid(proc));
 
-		/*
-		 * range_end is stored as exclusive, so add 1 to the value being
-		 * searched. Also avoid overflow
-		 */
-		if (end_value != PG_INT64_MAX)
-		{
-			end_value++;
-
-			/*
-			 * If getting as input INT64_MAX-1, need to remap the incremented
-			 * value back to INT64_MAX-1
-			 */
-			end_value = REMAP_LAST_COORDINATE(end_value);
-		}
-		else
-		{
-			/*
-			 * The point with INT64_MAX gets mapped to INT64_MAX-1 so
-			 * incrementing that gets you to INT_64MAX
-			 */
-			end_value = PG_INT64_MAX;
-		}
+		end_value = dimension_slice_range_end_search_value(end_value);
 
 		ScanKeyInit(&scankey[nkeys++],
 					Anum_dimension_slice_dimension_id_range_start_range_end_idx_range_end,
@@ -364,8 +369,27 @@ ts_dimension_slice_scan_range_limit(int32 dimension_id, StrategyNumber start_str
 									int64 start_value, StrategyNumber end_strategy, int64 end_value,
 									int limit, ScanTupLock *tuplock)
 {
-	DimensionVec *slices = ts_dimension_vec_create(limit > 0 ? limit : DIMENSION_VEC_DEFAULT_SIZE);
+	DimensionVec *slices;
+
+	/*
+	 * Without locking, the slices can be found in the in-memory index of the
+	 * dimension, which avoids a catalog scan, e.g., for every query on a
+	 * hypertable.
+	 */
+	if (tuplock == NULL)
+	{
+		if (end_strategy != InvalidStrategy)
+			end_value = dimension_slice_range_end_search_value(end_value);
+
+		return ts_dimension_slice_index_scan_range(dimension_id,
+												   start_strategy,
+												   start_value,
+												   end_strategy,
+												   end_value,
+												   limit);
+	}
 
+	slices = ts_dimension_vec_create(limit > 0 ? limit : DIMENSION_VEC_DEFAULT_SIZE);
 	dimension_slice_scan_with_strategies(dimension_id,
 										 start_strategy,
 										 start_value,
@@ -972,3 +996,64 @@ ts_dimension_slice_get_chunkid_to_compress(int32 dimension_id, StrategyNumber st
 
 	return chunk_id_ret;
 }
+
+typedef struct ChunksToCompressInfo
+{
+	List *chunk_ids;
+	int limit;
+} ChunksToCompressInfo;
+
+static ScanTupleResult
+dimension_slice_collect_uncompressed_chunks_tuple_found(TupleInfo *ti, void *data)
+{
+	ListCell *lc;
+	ChunksToCompressInfo *info = data;
+	DimensionSlice *slice = dimension_slice_from_slot(ti->slot);
+	List *chunk_ids = NIL;
+
+	ts_chunk_constraint_scan_by_dimension_slice_to_list(slice, &chunk_ids, CurrentMemoryContext);
+
+	foreach (lc, chunk_ids)
+	{
+		int32 chunk_id = lfirst_int(lc);
+
+		if (!list_member_int(info->chunk_ids, chunk_id) && ts_chunk_can_be_compressed(chunk_id))
+		{
+			info->chunk_ids = lappend_int(info->chunk_ids, chunk_id);
+
+			if (list_length(info->chunk_ids) >= info->limit)
+				return SCAN_DONE;
+		}
+	}
+
+	return SCAN_CONTINUE;
+}
+
+/*
+ * Like ts_dimension_slice_get_chunkid_to_compress(), but returns the IDs of up
+ * to limit chunks that have not yet been compressed.
+ */
+List *
+ts_dimension_slice_get_chunkids_to_compress(int32 dimension_id, StrategyNumber start_strategy,
+											int64 start_value, StrategyNumber end_strategy,
+											int64 end_value, int limit)
+{
+	ChunksToCompressInfo info = {
+		.chunk_ids = NIL,
+		.limit = limit,
+	};
+
+	Assert(limit > 0);
+
+	dimension_slice_scan_with_strategies(dimension_id,
+										 start_strategy,
+										 start_value,
+										 end_strategy,
+										 end_value,
+										 &info,
+										 dimension_slice_collect_uncompressed_chunks_tuple_found,
+										 -1,
+										 NULL);
+
+	return info.chunk_ids;
+}
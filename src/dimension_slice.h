@@ -82,6 +82,10 @@ extern TSDLLEXPORT int32 ts_dimension_slice_get_chunkid_to_compress(int32 dimens
 																	int64 start_value,
 																	StrategyNumber end_strategy,
 																	int64 end_value);
+extern TSDLLEXPORT List *
+ts_dimension_slice_get_chunkids_to_compress(int32 dimension_id, StrategyNumber start_strategy,
+											int64 start_value, StrategyNumber end_strategy,
+											int64 end_value, int limit);
 #define dimension_slice_insert(slice) ts_dimension_slice_insert_multi(&(slice), 1)
 
 #define dimension_slice_scan(dimension_id, coordinate, tuplock)                                    \
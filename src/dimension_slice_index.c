@@ -0,0 +1,258 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <utils/hsearch.h>
+#include <utils/inval.h>
+#include <utils/memutils.h>
+
+#include "dimension_slice.h"
+#include "dimension_slice_index.h"
+#include "dimension_vector.h"
+
+/*
+ * In-memory index of the dimension slices of a dimension, used to find the
+ * slices that match the restrictions of a query without scanning the
+ * dimension_slice catalog table on every planning cycle.
+ *
+ * The slices of a dimension are kept in an array sorted on (range_start,
+ * range_end), the same order as the catalog index. Restrictions on
+ * range_start map to a range of the array found through binary search. Since
+ * slices can overlap, e.g., after changing the number of partitions of a
+ * space dimension, range_end is not sorted, so we also keep the running
+ * maximum of range_end. The typical restriction range_end > value then skips
+ * all slices before the first one where the running maximum exceeds the
+ * value, so a lookup takes O(log n + k) for k matching slices when slices
+ * do not overlap.
+ *
+ * The index is built on first use and dropped whenever chunk metadata
+ * changes, which includes new slices and chunks, see cache_invalidate.c.
+ * Pending invalidations are processed on every lookup, so the index is as
+ * current as a scan of the catalog table would be.
+ */
+typedef struct DimensionSliceIndex
+{
+	int32 dimension_id;
+	int32 num_slices;
+	FormData_dimension_slice *slices;
+	int64 *max_range_end;
+} DimensionSliceIndex;
+
+static MemoryContext slice_index_mcxt = NULL;
+static HTAB *slice_indexes = NULL;
+
+static DimensionSliceIndex *
+dimension_slice_index_get(int32 dimension_id)
+{
+	DimensionSliceIndex *index;
+	DimensionVec *vec;
+	MemoryContext old;
+	bool found;
+	int i;
+
+	/*
+	 * Other sessions might have created chunks since the last lookup. The
+	 * invalidation is usually processed when the hypertable is locked at the
+	 * start of a query, but not if the transaction holds the lock already.
+	 */
+	AcceptInvalidationMessages();
+
+	if (slice_indexes == NULL)
+	{
+		HASHCTL hctl = {
+			.keysize = sizeof(int32),
+			.entrysize = sizeof(DimensionSliceIndex),
+		};
+
+		if (slice_index_mcxt == NULL)
+			slice_index_mcxt =
+				AllocSetContextCreate(CacheMemoryContext, "Slice index", ALLOCSET_DEFAULT_SIZES);
+
+		hctl.hcxt = slice_index_mcxt;
+		slice_indexes =
+			hash_create("Slice index", 32, &hctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	index = hash_search(slice_indexes, &dimension_id, HASH_FIND, NULL);
+
+	if (index != NULL)
+		return index;
+
+	/* The scan returns the slices in the order of the catalog index */
+	vec = ts_dimension_slice_scan_by_dimension(dimension_id, 0);
+
+	/*
+	 * Scanning might process invalidation messages, so only add the entry to
+	 * the hash table once the slices are known.
+	 */
+	if (slice_indexes == NULL)
+	{
+		ts_dimension_vec_free(vec);
+		return dimension_slice_index_get(dimension_id);
+	}
+
+	index = hash_search(slice_indexes, &dimension_id, HASH_ENTER, &found);
+	Assert(!found);
+	index->num_slices = vec->num_slices;
+
+	old = MemoryContextSwitchTo(slice_index_mcxt);
+	index->slices = palloc(sizeof(FormData_dimension_slice) * Max(vec->num_slices, 1));
+	index->max_range_end = palloc(sizeof(int64) * Max(vec->num_slices, 1));
+	MemoryContextSwitchTo(old);
+
+	for (i = 0; i < vec->num_slices; i++)
+	{
+		index->slices[i] = vec->slices[i]->fd;
+		index->max_range_end[i] = vec->slices[i]->fd.range_end;
+
+		if (i > 0 && index->max_range_end[i - 1] > index->max_range_end[i])
+			index->max_range_end[i] = index->max_range_end[i - 1];
+	}
+
+	ts_dimension_vec_free(vec);
+
+	return index;
+}
+
+/* Find the first slice with range_start >= value, or > value if inclusive */
+static int32
+dimension_slice_index_bound(const DimensionSliceIndex *index, int64 value, bool inclusive)
+{
+	int32 low = 0;
+	int32 high = index->num_slices;
+
+	while (low < high)
+	{
+		int32 mid = low + (high - low) / 2;
+		int64 start = index->slices[mid].range_start;
+
+		if (start < value || (inclusive && start == value))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/* Find the first slice where the running maximum of range_end is > value, or >= value */
+static int32
+dimension_slice_index_max_end_bound(const DimensionSliceIndex *index, int64 value, bool inclusive)
+{
+	int32 low = 0;
+	int32 high = index->num_slices;
+
+	while (low < high)
+	{
+		int32 mid = low + (high - low) / 2;
+		int64 max_end = index->max_range_end[mid];
+
+		if (max_end < value || (!inclusive && max_end == value))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static bool
+dimension_slice_value_matches(int64 value, StrategyNumber strategy, int64 arg)
+{
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			return value < arg;
+		case BTLessEqualStrategyNumber:
+			return value <= arg;
+		case BTEqualStrategyNumber:
+			return value == arg;
+		case BTGreaterEqualStrategyNumber:
+			return value >= arg;
+		case BTGreaterStrategyNumber:
+			return value > arg;
+		case InvalidStrategy:
+			return true;
+		default:
+			elog(ERROR, "invalid strategy number %d for dimension slice", strategy);
+			pg_unreachable();
+	}
+}
+
+/*
+ * Find the slices of a dimension where range_start matches the start strategy
+ * and value, and range_end the end strategy and value. This is equivalent to
+ * an index scan on the dimension_slice catalog table, except that the slices
+ * are not locked.
+ */
+DimensionVec *
+ts_dimension_slice_index_scan_range(int32 dimension_id, StrategyNumber start_strategy,
+									int64 start_value, StrategyNumber end_strategy,
+									int64 end_value, int limit)
+{
+	DimensionSliceIndex *index = dimension_slice_index_get(dimension_id);
+	DimensionVec *slices = ts_dimension_vec_create(limit > 0 ? limit : DIMENSION_VEC_DEFAULT_SIZE);
+	int32 low = 0;
+	int32 high = index->num_slices;
+	int32 i;
+
+	switch (start_strategy)
+	{
+		case BTLessStrategyNumber:
+			high = dimension_slice_index_bound(index, start_value, false);
+			break;
+		case BTLessEqualStrategyNumber:
+			high = dimension_slice_index_bound(index, start_value, true);
+			break;
+		case BTEqualStrategyNumber:
+			low = dimension_slice_index_bound(index, start_value, false);
+			high = dimension_slice_index_bound(index, start_value, true);
+			break;
+		case BTGreaterEqualStrategyNumber:
+			low = dimension_slice_index_bound(index, start_value, false);
+			break;
+		case BTGreaterStrategyNumber:
+			low = dimension_slice_index_bound(index, start_value, true);
+			break;
+		default:
+			break;
+	}
+
+	/* Skip the slices that all end before the value */
+	if (end_strategy == BTGreaterStrategyNumber)
+		low = Max(low, dimension_slice_index_max_end_bound(index, end_value, false));
+	else if (end_strategy == BTGreaterEqualStrategyNumber)
+		low = Max(low, dimension_slice_index_max_end_bound(index, end_value, true));
+
+	for (i = low; i < high; i++)
+	{
+		const FormData_dimension_slice *fd = &index->slices[i];
+		DimensionSlice *slice;
+
+		if (!dimension_slice_value_matches(fd->range_end, end_strategy, end_value))
+			continue;
+
+		slice = ts_dimension_slice_create(fd->dimension_id, fd->range_start, fd->range_end);
+		slice->fd.id = fd->id;
+		slices = ts_dimension_vec_add_slice(&slices, slice);
+
+		if (limit > 0 && slices->num_slices >= limit)
+			break;
+	}
+
+	return slices;
+}
+
+/*
+ * Drop all slice indexes, called when chunk metadata changes.
+ */
+void
+ts_dimension_slice_index_invalidate(void)
+{
+	if (slice_index_mcxt != NULL)
+		MemoryContextReset(slice_index_mcxt);
+
+	slice_indexes = NULL;
+}
@@ -0,0 +1,21 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_DIMENSION_SLICE_INDEX_H
+#define TIMESCALEDB_DIMENSION_SLICE_INDEX_H
+
+#include <postgres.h>
+#include <access/stratnum.h>
+
+#include "dimension_vector.h"
+
+extern DimensionVec *ts_dimension_slice_index_scan_range(int32 dimension_id,
+														 StrategyNumber start_strategy,
+														 int64 start_value,
+														 StrategyNumber end_strategy,
+														 int64 end_value, int limit);
+extern void ts_dimension_slice_index_invalidate(void);
+
+#endif /* TIMESCALEDB_DIMENSION_SLICE_INDEX_H */
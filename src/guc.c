@@ -47,10 +47,18 @@ bool ts_guc_enable_ordered_append = true;
 bool ts_guc_enable_chunk_append = true;
 bool ts_guc_enable_parallel_chunk_append = true;
 bool ts_guc_enable_runtime_exclusion = true;
+bool ts_guc_enable_lazy_chunk_init = true;
+bool ts_guc_enable_chunk_stats_extrapolation = true;
 bool ts_guc_enable_constraint_exclusion = true;
 bool ts_guc_enable_qual_propagation = true;
 bool ts_guc_enable_cagg_reorder_groupby = true;
 TSDLLEXPORT bool ts_guc_enable_transparent_decompression = true;
+TSDLLEXPORT bool ts_guc_enable_bulk_decompression = true;
+TSDLLEXPORT bool ts_guc_enable_compressed_aggregate_pushdown = true;
+TSDLLEXPORT int ts_guc_compression_policy_workers = 0;
+TSDLLEXPORT bool ts_guc_enable_compression_indexscan = true;
+bool ts_guc_enable_shared_chunk_cache = true;
+bool ts_guc_enable_multi_insert = true;
 bool ts_guc_enable_per_data_node_queries = true;
 bool ts_guc_enable_async_append = true;
 int ts_guc_max_open_chunks_per_insert = 10;
@@ -164,6 +172,30 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_lazy_chunk_init",
+							 "Enable lazy chunk initialization",
+							 "Initialize the scans of chunks in ChunkAppend node only when the "
+							 "chunk is about to be scanned",
+							 &ts_guc_enable_lazy_chunk_init,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_chunk_stats_extrapolation",
+							 "Enable chunk statistics extrapolation",
+							 "Use the statistics of the newest analyzed chunk of a hypertable for "
+							 "chunks that have not been analyzed yet",
+							 &ts_guc_enable_chunk_stats_extrapolation,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_constraint_exclusion",
 							 "Enable constraint exclusion",
 							 "Enable planner constraint exclusion",
@@ -197,6 +229,82 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.enable_bulk_decompression",
+							 "Enable bulk decompression",
+							 "Decompress whole batches of compressed columns at once in "
+							 "transparent decompression instead of value by value",
+							 &ts_guc_enable_bulk_decompression,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compressed_aggregate_pushdown",
+							 "Enable aggregate pushdown into transparent decompression",
+							 "Compute simple aggregates directly from compressed batches "
+							 "instead of aggregating the decompressed tuples",
+							 &ts_guc_enable_compressed_aggregate_pushdown,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_compression_indexscan",
+							 "Enable index scans when compressing chunks",
+							 "Read the rows of a chunk through an index that matches the "
+							 "segmentby and orderby settings instead of sorting the chunk, if "
+							 "the index is correlated with the physical order of the chunk",
+							 &ts_guc_enable_compression_indexscan,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_shared_chunk_cache",
+							 "Enable the shared chunk cache",
+							 "Look up chunk metadata during planning in the cache that is "
+							 "shared across backends instead of reading it from the catalog",
+							 &ts_guc_enable_shared_chunk_cache,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.enable_multi_insert",
+							 "Enable buffered inserts into chunks",
+							 "Buffer the tuples of an INSERT or COPY per chunk and insert "
+							 "them into the chunk in batches",
+							 &ts_guc_enable_multi_insert,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("timescaledb.compression_policy_workers",
+							"Number of background workers a compression policy uses",
+							"The number of chunks a compression policy compresses in parallel, "
+							"each in its own background worker. Setting this to 0 compresses "
+							"one chunk per run in the policy's own worker",
+							&ts_guc_compression_policy_workers,
+							0,
+							0,
+							1000,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable("timescaledb.enable_cagg_reorder_groupby",
 							 "Enable group by reordering",
 							 "Enable group by clause reordering for continuous aggregates",
@@ -18,9 +18,17 @@ extern bool ts_guc_enable_chunk_append;
 extern bool ts_guc_enable_parallel_chunk_append;
 extern bool ts_guc_enable_qual_propagation;
 extern bool ts_guc_enable_runtime_exclusion;
+extern bool ts_guc_enable_lazy_chunk_init;
+extern bool ts_guc_enable_chunk_stats_extrapolation;
 extern bool ts_guc_enable_constraint_exclusion;
 extern bool ts_guc_enable_cagg_reorder_groupby;
 extern TSDLLEXPORT bool ts_guc_enable_transparent_decompression;
+extern TSDLLEXPORT bool ts_guc_enable_bulk_decompression;
+extern TSDLLEXPORT bool ts_guc_enable_compressed_aggregate_pushdown;
+extern TSDLLEXPORT int ts_guc_compression_policy_workers;
+extern TSDLLEXPORT bool ts_guc_enable_compression_indexscan;
+extern bool ts_guc_enable_shared_chunk_cache;
+extern bool ts_guc_enable_multi_insert;
 extern TSDLLEXPORT bool ts_guc_enable_per_data_node_queries;
 extern TSDLLEXPORT bool ts_guc_enable_async_append;
 extern bool ts_guc_restoring;
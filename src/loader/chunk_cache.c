@@ -0,0 +1,79 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <miscadmin.h>
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/guc.h>
+
+#include "loader/chunk_cache.h"
+
+#define CHUNK_CACHE_SHMEM_NAME "ts_chunk_shared_cache_shmem"
+#define CHUNK_CACHE_LWLOCK_TRANCHE_NAME "ts_chunk_shared_cache_lwlock_tranche"
+
+/* size of the shared chunk cache in kB, 0 disables the cache */
+static int ts_guc_shared_chunk_cache_size = 16 * 1024;
+
+static TsChunkSharedCacheArea *chunk_cache_area = NULL;
+
+static Size
+chunk_cache_shmem_size(void)
+{
+	return mul_size(ts_guc_shared_chunk_cache_size, 1024);
+}
+
+void
+ts_chunk_cache_shmem_startup(void)
+{
+	bool found;
+	TsChunkSharedCacheArea **area_pointer;
+	Size size = add_size(MAXALIGN(sizeof(TsChunkSharedCacheArea)), chunk_cache_shmem_size());
+
+	if (ts_guc_shared_chunk_cache_size == 0)
+		return;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+	chunk_cache_area = ShmemInitStruct(CHUNK_CACHE_SHMEM_NAME, size, &found);
+	if (!found)
+	{
+		chunk_cache_area->lock = &(GetNamedLWLockTranche(CHUNK_CACHE_LWLOCK_TRANCHE_NAME))->lock;
+		chunk_cache_area->size = chunk_cache_shmem_size();
+		chunk_cache_area->data =
+			(char *) chunk_cache_area + MAXALIGN(sizeof(TsChunkSharedCacheArea));
+		memset(chunk_cache_area->data, 0, chunk_cache_area->size);
+	}
+	LWLockRelease(AddinShmemInitLock);
+
+	area_pointer =
+		(TsChunkSharedCacheArea **) find_rendezvous_variable(RENDEZVOUS_CHUNK_SHARED_CACHE);
+	*area_pointer = chunk_cache_area;
+}
+
+void
+ts_chunk_cache_shmem_alloc(void)
+{
+	DefineCustomIntVariable("timescaledb.shared_chunk_cache_size",
+							"Size of the shared chunk metadata cache",
+							"Amount of shared memory used to cache chunk metadata across "
+							"backends, set to 0 to disable the cache",
+							&ts_guc_shared_chunk_cache_size,
+							ts_guc_shared_chunk_cache_size,
+							0,
+							MAX_KILOBYTES,
+							PGC_POSTMASTER,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	if (ts_guc_shared_chunk_cache_size == 0)
+		return;
+
+	RequestNamedLWLockTranche(CHUNK_CACHE_LWLOCK_TRANCHE_NAME, 1);
+	RequestAddinShmemSpace(
+		add_size(MAXALIGN(sizeof(TsChunkSharedCacheArea)), chunk_cache_shmem_size()));
+}
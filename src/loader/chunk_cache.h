@@ -0,0 +1,32 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_LOADER_CHUNK_CACHE_H
+#define TIMESCALEDB_LOADER_CHUNK_CACHE_H
+
+#include <postgres.h>
+#include <storage/lwlock.h>
+
+#define RENDEZVOUS_CHUNK_SHARED_CACHE "ts_chunk_shared_cache"
+
+/*
+ * Shared memory area for the chunk metadata cache that is shared across
+ * backends. The loader only reserves the memory and a lock to protect it,
+ * since shared memory can only be set up by a library in
+ * shared_preload_libraries. The layout of the data is owned by the versioned
+ * extension (see chunk_shared_cache.c), which is why this struct must stay the
+ * same across timescaledb versions.
+ */
+typedef struct TsChunkSharedCacheArea
+{
+	LWLock *lock;
+	Size size;
+	char *data;
+} TsChunkSharedCacheArea;
+
+void ts_chunk_cache_shmem_startup(void);
+void ts_chunk_cache_shmem_alloc(void);
+
+#endif /* TIMESCALEDB_LOADER_CHUNK_CACHE_H */
@@ -35,6 +35,7 @@
 #include "loader/bgw_launcher.h"
 #include "loader/bgw_message_queue.h"
 #include "loader/lwlocks.h"
+#include "loader/chunk_cache.h"
 #include "loader/seclabel.h"
 
 /*
@@ -528,6 +529,7 @@ timescale_shmem_startup_hook(void)
 	ts_bgw_counter_shmem_startup();
 	ts_bgw_message_queue_shmem_startup();
 	ts_lwlocks_shmem_startup();
+	ts_chunk_cache_shmem_startup();
 }
 
 static void
@@ -552,6 +554,7 @@ _PG_init(void)
 	ts_bgw_counter_shmem_alloc();
 	ts_bgw_message_queue_alloc();
 	ts_lwlocks_shmem_alloc();
+	ts_chunk_cache_shmem_alloc();
 	ts_bgw_cluster_launcher_register();
 	ts_bgw_counter_setup_gucs();
 	ts_bgw_interface_register_api_version();
@@ -105,7 +105,7 @@ check_for_partialize_function_call(Node *node, PartializeWalkerState *state)
 	return expression_tree_walker(node, check_for_partialize_function_call, state);
 }
 
-bool
+TSDLLEXPORT bool
 has_partialize_function(Query *parse, PartializeAggFixAggref fix_aggref)
 {
 	Oid partialfnoid = InvalidOid;
@@ -61,6 +61,7 @@
 #include "dimension_vector.h"
 #include "func_cache.h"
 #include "chunk.h"
+#include "chunk_stats.h"
 #include "planner.h"
 #include "plan_expand_hypertable.h"
 #include "plan_add_hashagg.h"
@@ -74,6 +75,7 @@ void _planner_fini(void);
 static planner_hook_type prev_planner_hook;
 static set_rel_pathlist_hook_type prev_set_rel_pathlist_hook;
 static get_relation_info_hook_type prev_get_relation_info_hook;
+static get_relation_stats_hook_type prev_get_relation_stats_hook;
 static create_upper_paths_hook_type prev_create_upper_paths_hook;
 static bool contain_param(Node *node);
 static void cagg_reorder_groupby_clause(RangeTblEntry *subq_rte, int rtno, List *outer_sortcl,
@@ -413,7 +415,7 @@ classify_relation(const PlannerInfo *root, const RelOptInfo *rel, Hypertable **p
 				 * reliably identify chunk BASERELs. We should, however, be able
 				 * to identify these in the query preprocessing and cache them
 				 * there if we need to speed this up. */
-				Chunk *chunk = ts_chunk_get_by_relid(rte->relid, false);
+				Chunk *chunk = ts_chunk_get_by_relid_cached(rte->relid, false);
 
 				if (chunk != NULL)
 				{
@@ -881,7 +883,7 @@ timescaledb_get_relation_info_hook(PlannerInfo *root, Oid relation_objectid, boo
 			if (ts_guc_enable_transparent_decompression && TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
 			{
 				RangeTblEntry *chunk_rte = planner_rt_fetch(rel->relid, root);
-				Chunk *chunk = ts_chunk_get_by_relid(chunk_rte->relid, true);
+				Chunk *chunk = ts_chunk_get_by_relid_cached(chunk_rte->relid, true);
 
 				if (chunk->fd.compressed_chunk_id > 0)
 				{
@@ -913,6 +915,10 @@ timescaledb_get_relation_info_hook(PlannerInfo *root, Oid relation_objectid, boo
 					table_close(uncompressed_chunk, NoLock);
 				}
 			}
+
+			if (ts_guc_enable_chunk_stats_extrapolation &&
+				!ts_get_private_reloptinfo(rel)->compressed)
+				ts_chunk_stats_set_rel_estimates(root, rel, ht);
 			break;
 		}
 		case TS_REL_HYPERTABLE_CHILD:
@@ -921,6 +927,24 @@ timescaledb_get_relation_info_hook(PlannerInfo *root, Oid relation_objectid, boo
 	}
 }
 
+/*
+ * Provide column statistics for chunks that have not been analyzed yet, see
+ * chunk_stats.c.
+ */
+static bool
+timescaledb_get_relation_stats_hook(PlannerInfo *root, RangeTblEntry *rte, AttrNumber attnum,
+									VariableStatData *vardata)
+{
+	if (prev_get_relation_stats_hook != NULL &&
+		prev_get_relation_stats_hook(root, rte, attnum, vardata))
+		return true;
+
+	if (!valid_hook_call())
+		return false;
+
+	return ts_chunk_stats_get_relation_stats(root, rte, attnum, vardata);
+}
+
 static bool
 join_involves_hypertable(const PlannerInfo *root, const RelOptInfo *rel)
 {
@@ -1222,6 +1246,8 @@ _planner_init(void)
 
 	prev_get_relation_info_hook = get_relation_info_hook;
 	get_relation_info_hook = timescaledb_get_relation_info_hook;
+	prev_get_relation_stats_hook = get_relation_stats_hook;
+	get_relation_stats_hook = timescaledb_get_relation_stats_hook;
 
 	prev_create_upper_paths_hook = create_upper_paths_hook;
 	create_upper_paths_hook = timescale_create_upper_paths_hook;
@@ -1233,5 +1259,6 @@ _planner_fini(void)
 	planner_hook = prev_planner_hook;
 	set_rel_pathlist_hook = prev_set_rel_pathlist_hook;
 	get_relation_info_hook = prev_get_relation_info_hook;
+	get_relation_stats_hook = prev_get_relation_stats_hook;
 	create_upper_paths_hook = prev_create_upper_paths_hook;
 }
@@ -31,6 +31,13 @@ typedef struct TimescaleDBPrivate
 	List *serverids;
 	Relids server_relids;
 	TsFdwRelationInfo *fdw_relation_info;
+	/* Analyzed sibling chunk whose statistics are used for an unanalyzed chunk */
+	Oid stats_relid;
+	/* Column of the chunk that must not use the sibling's statistics */
+	AttrNumber stats_excluded_attno;
+	/* Newest analyzed chunk of a hypertable, looked up once per planning cycle */
+	bool stats_sibling_searched;
+	Oid stats_sibling_relid;
 } TimescaleDBPrivate;
 
 extern TSDLLEXPORT bool ts_rte_is_hypertable(const RangeTblEntry *rte, bool *isdistributed);
@@ -45,6 +45,7 @@
 #include "catalog.h"
 #include "chunk.h"
 #include "chunk_index.h"
+#include "chunk_shared_cache.h"
 #include "chunk_data_node.h"
 #include "compat.h"
 #include "copy.h"
@@ -3590,6 +3591,25 @@ process_refresh_mat_view_start(ProcessUtilityArgs *args)
 	return DDL_CONTINUE;
 }
 
+/*
+ * The changes of a prepared transaction become visible to other backends
+ * only when COMMIT PREPARED commits, possibly in another backend than the one
+ * that prepared it. It is not known here whether the prepared transaction
+ * modified chunk metadata, so invalidate the shared chunk cache when every
+ * COMMIT PREPARED commits, like for a transaction that modified the chunk
+ * metadata itself.
+ */
+static DDLResult
+process_transaction(ProcessUtilityArgs *args)
+{
+	TransactionStmt *stmt = castNode(TransactionStmt, args->parsetree);
+
+	if (stmt->kind == TRANS_STMT_COMMIT_PREPARED)
+		ts_chunk_shared_cache_mark_modified();
+
+	return DDL_CONTINUE;
+}
+
 /*
  * Handle DDL commands before they have been processed by PostgreSQL.
  */
@@ -3674,6 +3694,10 @@ process_ddl_command_start(ProcessUtilityArgs *args)
 		case T_CreateTableAsStmt:
 			handler = process_create_table_as;
 			break;
+		case T_TransactionStmt:
+			check_read_only = false;
+			handler = process_transaction;
+			break;
 		default:
 			handler = NULL;
 			break;
@@ -75,6 +75,43 @@ void TSDLLEXPORT ts_scan_iterator_scan_key_init(ScanIterator *iterator, AttrNumb
 												StrategyNumber strategy, RegProcedure procedure,
 												Datum argument);
 
+/*
+ * Scan sessions, see scanner.h. With keepopen set in the iterator's
+ * ScannerCtx, every rescan reuses the open relations and scan:
+ *
+ *   ts_scan_iterator_scan_key_set_argument(&iterator, 0, value);
+ *   ts_scan_iterator_rescan(&iterator);
+ *   while (ts_scan_iterator_next(&iterator) != NULL)
+ *       ...
+ *
+ * The session must be ended with `ts_scan_iterator_close`.
+ */
+static inline void
+ts_scan_iterator_scan_key_set_argument(ScanIterator *iterator, int keyno, Datum argument)
+{
+	Assert(keyno >= 0 && keyno < iterator->ctx.nkeys);
+	iterator->scankey[keyno].sk_argument = argument;
+}
+
+static inline void
+ts_scan_iterator_rescan(ScanIterator *iterator)
+{
+	ts_scanner_rescan(&iterator->ctx, &iterator->ictx);
+}
+
+static inline TupleInfo *
+ts_scan_iterator_next(ScanIterator *iterator)
+{
+	iterator->tinfo = ts_scanner_next(&iterator->ctx, &iterator->ictx);
+	return iterator->tinfo;
+}
+
+static inline int
+ts_scan_iterator_scan_session(ScanIterator *iterator)
+{
+	return ts_scanner_scan_session(&iterator->ctx, &iterator->ictx);
+}
+
 /* You must use `ts_scan_iterator_close` if terminating this loop early */
 #define ts_scanner_foreach(scan_iterator)                                                          \
 	for (ts_scanner_start_scan(&(scan_iterator)->ctx, &(scan_iterator)->ictx);                     \
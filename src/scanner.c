@@ -31,6 +31,7 @@ typedef struct Scanner
 	Relation (*openscan)(InternalScannerCtx *ctx);
 	ScanDesc (*beginscan)(InternalScannerCtx *ctx);
 	bool (*getnext)(InternalScannerCtx *ctx);
+	void (*rescan)(InternalScannerCtx *ctx);
 	void (*endscan)(InternalScannerCtx *ctx);
 	void (*closescan)(InternalScannerCtx *ctx);
 } Scanner;
@@ -76,6 +77,12 @@ table_scanner_getnext(InternalScannerCtx *ctx)
 	return success;
 }
 
+static void
+table_scanner_rescan(InternalScannerCtx *ctx)
+{
+	table_rescan(ctx->scan.table_scan, ctx->sctx->scankey);
+}
+
 static void
 table_scanner_endscan(InternalScannerCtx *ctx)
 {
@@ -136,6 +143,16 @@ index_scanner_getnext(InternalScannerCtx *ctx)
 	return success;
 }
 
+static void
+index_scanner_rescan(InternalScannerCtx *ctx)
+{
+	ScannerCtx *sctx = ctx->sctx;
+
+	/* The scan keys were allocated when the scan began */
+	Assert(ctx->scan.index_scan->numberOfKeys == sctx->nkeys);
+	index_rescan(ctx->scan.index_scan, sctx->scankey, sctx->nkeys, NULL, sctx->norderbys);
+}
+
 static void
 index_scanner_endscan(InternalScannerCtx *ctx)
 {
@@ -159,6 +176,7 @@ static Scanner scanners[] = {
 		.openscan = table_scanner_open,
 		.beginscan = table_scanner_beginscan,
 		.getnext = table_scanner_getnext,
+		.rescan = table_scanner_rescan,
 		.endscan = table_scanner_endscan,
 		.closescan = table_scanner_close,
 	},
@@ -166,6 +184,7 @@ static Scanner scanners[] = {
 		.openscan = index_scanner_open,
 		.beginscan = index_scanner_beginscan,
 		.getnext = index_scanner_getnext,
+		.rescan = index_scanner_rescan,
 		.endscan = index_scanner_endscan,
 		.closescan = index_scanner_close,
 	}
@@ -194,6 +213,7 @@ ts_scanner_start_scan(ScannerCtx *ctx, InternalScannerCtx *ictx)
 	Scanner *scanner;
 
 	ictx->sctx = ctx;
+	ictx->ended = false;
 	ictx->closed = false;
 	ictx->registered_snapshot = false;
 
@@ -251,16 +271,42 @@ ts_scanner_limit_reached(ScannerCtx *ctx, InternalScannerCtx *ictx)
 	return ctx->limit > 0 && ictx->tinfo.count >= ctx->limit;
 }
 
+/*
+ * Finish the current scan. Unless the scan should be kept open for a rescan,
+ * this ends the scan and closes the relations.
+ */
+static void
+scanner_finish_scan(ScannerCtx *ctx, InternalScannerCtx *ictx)
+{
+	if (!ctx->keepopen)
+	{
+		ts_scanner_end_scan(ctx, ictx);
+		return;
+	}
+
+	if (ictx->ended)
+		return;
+
+	/* Call post-scan handler, if any. */
+	if (ctx->postscan != NULL)
+		ctx->postscan(ictx->tinfo.count, ctx->data);
+
+	ictx->ended = true;
+}
+
 TSDLLEXPORT void
 ts_scanner_end_scan(ScannerCtx *ctx, InternalScannerCtx *ictx)
 {
-	Scanner *scanner = scanner_ctx_get_scanner(ictx->sctx);
+	Scanner *scanner;
 
-	if (ictx->closed)
+	/* Nothing to do if a scan session was never started */
+	if (ictx->sctx == NULL || ictx->closed)
 		return;
 
+	scanner = scanner_ctx_get_scanner(ictx->sctx);
+
 	/* Call post-scan handler, if any. */
-	if (ictx->sctx->postscan != NULL)
+	if (!ictx->ended && ictx->sctx->postscan != NULL)
 		ictx->sctx->postscan(ictx->tinfo.count, ictx->sctx->data);
 
 	scanner->endscan(ictx);
@@ -330,35 +376,89 @@ ts_scanner_next(ScannerCtx *ctx, InternalScannerCtx *ictx)
 		is_valid = ts_scanner_limit_reached(ctx, ictx) ? false : scanner->getnext(ictx);
 	}
 
-	ts_scanner_end_scan(ctx, ictx);
+	scanner_finish_scan(ctx, ictx);
 
 	return NULL;
 }
 
 /*
- * Perform either a heap or index scan depending on the information in the
- * ScannerCtx. ScannerCtx must be setup by caller with the proper information
- * for the scan, including filters and callbacks for found tuples.
- *
- * Return the number of tuples that were found.
+ * Start a new scan with the current scan keys in a scan session. The first
+ * scan of the session opens the relations and begins the scan, while later
+ * scans reuse them.
  */
-TSDLLEXPORT int
-ts_scanner_scan(ScannerCtx *ctx)
+TSDLLEXPORT void
+ts_scanner_rescan(ScannerCtx *ctx, InternalScannerCtx *ictx)
+{
+	Scanner *scanner = scanner_ctx_get_scanner(ctx);
+
+	Assert(ctx->keepopen);
+
+	if (ictx->sctx == NULL || ictx->closed)
+	{
+		ts_scanner_start_scan(ctx, ictx);
+		return;
+	}
+
+	Assert(ictx->sctx == ctx);
+
+	/* Release any buffer pin held by the slot before repositioning the scan */
+	ExecClearTuple(ictx->tinfo.slot);
+	scanner->rescan(ictx);
+	ictx->tinfo.count = 0;
+	ictx->ended = false;
+
+	/* Call pre-scan handler, if any. */
+	if (ctx->prescan != NULL)
+		ctx->prescan(ctx->data);
+}
+
+static int
+scanner_scan(ScannerCtx *ctx, InternalScannerCtx *ictx)
 {
-	InternalScannerCtx ictx = { 0 };
 	TupleInfo *tinfo;
 
-	for (ts_scanner_start_scan(ctx, &ictx); (tinfo = ts_scanner_next(ctx, &ictx));)
+	while ((tinfo = ts_scanner_next(ctx, ictx)) != NULL)
 	{
 		/* Call tuple_found handler. Abort the scan if the handler wants us to */
 		if (ctx->tuple_found != NULL && ctx->tuple_found(tinfo, ctx->data) == SCAN_DONE)
 		{
-			ts_scanner_end_scan(ctx, &ictx);
+			scanner_finish_scan(ctx, ictx);
 			break;
 		}
 	}
 
-	return ictx.tinfo.count;
+	return ictx->tinfo.count;
+}
+
+/*
+ * Perform either a heap or index scan depending on the information in the
+ * ScannerCtx. ScannerCtx must be setup by caller with the proper information
+ * for the scan, including filters and callbacks for found tuples.
+ *
+ * Return the number of tuples that were found.
+ */
+TSDLLEXPORT int
+ts_scanner_scan(ScannerCtx *ctx)
+{
+	InternalScannerCtx ictx = { 0 };
+
+	Assert(!ctx->keepopen);
+	ts_scanner_start_scan(ctx, &ictx);
+
+	return scanner_scan(ctx, &ictx);
+}
+
+/*
+ * Like ts_scanner_scan(), but runs the scan in the scan session given by the
+ * internal scanner context. The scan is kept open when it finishes, so the
+ * session has to be ended with ts_scanner_end_scan().
+ */
+TSDLLEXPORT int
+ts_scanner_scan_session(ScannerCtx *ctx, InternalScannerCtx *ictx)
+{
+	ts_scanner_rescan(ctx, ictx);
+
+	return scanner_scan(ctx, ictx);
 }
 
 TSDLLEXPORT bool
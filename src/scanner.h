@@ -78,6 +78,9 @@ typedef struct ScannerCtx
 								  * less means no limit */
 	bool want_itup;
 	bool keeplock; /* Keep the table lock after the scan finishes */
+	bool keepopen; /* Keep the relations and the scan open after the scan
+					* finishes, so that it can be rescanned, see
+					* ts_scanner_rescan() */
 	LOCKMODE lockmode;
 	MemoryContext result_mctx; /* The memory context to allocate the result
 								* on */
@@ -145,12 +148,26 @@ typedef struct InternalScannerCtx
 	ScanDesc scan;
 	ScannerCtx *sctx;
 	bool registered_snapshot;
+	bool ended; /* The current scan has finished, but the scan is kept open */
 	bool closed;
 } InternalScannerCtx;
 
 extern TSDLLEXPORT void ts_scanner_start_scan(ScannerCtx *ctx, InternalScannerCtx *ictx);
 extern TSDLLEXPORT void ts_scanner_end_scan(ScannerCtx *ctx, InternalScannerCtx *ictx);
 extern TSDLLEXPORT TupleInfo *ts_scanner_next(ScannerCtx *ctx, InternalScannerCtx *ictx);
+
+/*
+ * Scan sessions run many scans on the same relations and index, e.g., to look
+ * up a set of keys one after the other. With keepopen set in the ScannerCtx,
+ * the relations and the scan stay open when a scan finishes and the next scan
+ * only repositions it with the current scan keys, instead of opening the
+ * relations and beginning a new scan. The number of scan keys must stay the
+ * same across the session, but their arguments can change between scans. A
+ * session ends with ts_scanner_end_scan().
+ */
+extern TSDLLEXPORT void ts_scanner_rescan(ScannerCtx *ctx, InternalScannerCtx *ictx);
+extern TSDLLEXPORT int ts_scanner_scan_session(ScannerCtx *ctx, InternalScannerCtx *ictx);
+
 extern TSDLLEXPORT ItemPointer ts_scanner_get_tuple_tid(TupleInfo *ti);
 extern TSDLLEXPORT HeapTuple ts_scanner_fetch_heap_tuple(const TupleInfo *ti, bool materialize,
 														 bool *should_free);
@@ -4,6 +4,7 @@
  * LICENSE-APACHE for a copy of the license.
  */
 #include <postgres.h>
+#include <lib/ilist.h>
 #include <utils/memutils.h>
 
 #include "dimension.h"
@@ -19,21 +20,40 @@
  * first dimension point to a DimensionVec of the second dimension. This recurses
  * for the N dimensions. The leaf DimensionSlice points to the data being stored.
  *
+ * The leaves are also kept on a list in least-recently-used order, so that
+ * the store can evict the single leaf that was not used for the longest time
+ * when it is full.
+ *
+ * Since inserts usually go into the same subspace as the previous one, e.g.,
+ * when inserting in time order, lookups first check the most recently used
+ * leaf before walking the tree.
  * */
 
 typedef struct SubspaceStoreInternalNode
 {
 	DimensionVec *vector;
-	size_t descendants;
 	bool last_internal_node;
 } SubspaceStoreInternalNode;
 
+typedef struct SubspaceStoreLeaf
+{
+	dlist_node lru_node;
+	void *object;
+	void (*object_free)(void *);
+	/* the slices on the path to the leaf, one per dimension */
+	DimensionSlice *slices[FLEXIBLE_ARRAY_MEMBER];
+} SubspaceStoreLeaf;
+
 typedef struct SubspaceStore
 {
 	MemoryContext mcxt;
 	int16 num_dimensions;
-	/* limit growth of store by  limiting number of slices in first dimension,	0 for no limit */
+	/* limit growth of store by limiting number of leaves, 0 for no limit */
 	int16 max_items;
+	int32 num_items;
+	dlist_head lru;				  /* leaves, most recently used first */
+	SubspaceStoreLeaf *last_leaf; /* the most recently used leaf, if any */
+	SubspaceStoreStats stats;
 	SubspaceStoreInternalNode *origin; /* origin of the tree */
 } SubspaceStore;
 
@@ -43,7 +63,6 @@ subspace_store_internal_node_create(bool last_internal_node)
 	SubspaceStoreInternalNode *node = palloc(sizeof(SubspaceStoreInternalNode));
 
 	node->vector = ts_dimension_vec_create(DIMENSION_VEC_DEFAULT_SIZE);
-	node->descendants = 0;
 	node->last_internal_node = last_internal_node;
 	return node;
 }
@@ -55,25 +74,94 @@ subspace_store_internal_node_free(void *node)
 	pfree(node);
 }
 
-static size_t
-subspace_store_internal_node_descendants(SubspaceStoreInternalNode *node, int index)
+static void
+subspace_store_leaf_free(void *ptr)
+{
+	SubspaceStoreLeaf *leaf = ptr;
+
+	dlist_delete(&leaf->lru_node);
+
+	if (leaf->object_free != NULL)
+		leaf->object_free(leaf->object);
+
+	pfree(leaf);
+}
+
+static int32
+subspace_store_vec_index(DimensionVec *vec, int64 coordinate)
 {
-	DimensionSlice *slice = ts_dimension_vec_get(node->vector, index);
+	DimensionSlice *slice = ts_dimension_vec_find_slice(vec, coordinate);
+	int32 i;
 
-	if (slice == NULL)
-		return 0;
+	Assert(slice != NULL);
 
-	if (node->last_internal_node)
-		return 1;
+	for (i = 0; i < vec->num_slices; i++)
+		if (vec->slices[i] == slice)
+			return i;
+
+	pg_unreachable();
+}
+
+static inline bool
+subspace_store_leaf_contains_point(const SubspaceStoreLeaf *leaf, const Point *target)
+{
+	int i;
+
+	for (i = 0; i < target->cardinality; i++)
+		if (ts_dimension_slice_cmp_coordinate(leaf->slices[i], target->coordinates[i]) != 0)
+			return false;
+
+	return true;
+}
+
+/*
+ * Remove the least recently used leaf from the tree, along with any internal
+ * nodes that become empty as a result.
+ */
+static void
+subspace_store_evict(SubspaceStore *store)
+{
+	SubspaceStoreLeaf *leaf = dlist_tail_element(SubspaceStoreLeaf, lru_node, &store->lru);
+	SubspaceStoreInternalNode **path = palloc(sizeof(*path) * store->num_dimensions);
+	int32 *indexes = palloc(sizeof(*indexes) * store->num_dimensions);
+	SubspaceStoreInternalNode *node = store->origin;
+	int i;
+
+	for (i = 0; i < store->num_dimensions; i++)
+	{
+		path[i] = node;
+		indexes[i] = subspace_store_vec_index(node->vector, leaf->slices[i]->fd.range_start);
+		node = node->vector->slices[indexes[i]]->storage;
+	}
+
+	Assert((void *) node == (void *) leaf);
+
+	if (store->last_leaf == leaf)
+		store->last_leaf = NULL;
+
+	/*
+	 * Removing the leaf slice frees the leaf and its object. Then walk up the
+	 * tree and remove the slices pointing to internal nodes that are empty.
+	 */
+	for (i = store->num_dimensions - 1; i >= 0; i--)
+	{
+		ts_dimension_vec_remove_slice(&path[i]->vector, indexes[i]);
+
+		if (path[i]->vector->num_slices > 0)
+			break;
+	}
 
-	return ((SubspaceStoreInternalNode *) slice->storage)->descendants;
+	store->num_items--;
+	store->stats.evictions++;
+	pfree(path);
+	pfree(indexes);
 }
 
 SubspaceStore *
 ts_subspace_store_init(Hyperspace *space, MemoryContext mcxt, int16 max_items)
 {
 	MemoryContext old = MemoryContextSwitchTo(mcxt);
-	SubspaceStore *sst = palloc(sizeof(SubspaceStore));
+	SubspaceStore *sst = palloc0(sizeof(SubspaceStore));
 
 	/*
 	 * make sure that the first dimension is a time dimension, otherwise the
@@ -85,6 +173,8 @@ ts_subspace_store_init(Hyperspace *space, MemoryContext mcxt, int16 max_items)
 	sst->num_dimensions = space->num_dimensions;
 	/* max_items = 0 is treated as unlimited */
 	sst->max_items = max_items;
+	sst->num_items = 0;
+	dlist_init(&sst->lru);
 	sst->mcxt = mcxt;
 	MemoryContextSwitchTo(old);
 	return sst;
@@ -94,13 +184,28 @@ void
 ts_subspace_store_add(SubspaceStore *store, const Hypercube *hc, void *object,
 					  void (*object_free)(void *))
 {
-	SubspaceStoreInternalNode *node = store->origin;
+	SubspaceStoreInternalNode *node;
+	SubspaceStoreLeaf *leaf;
 	DimensionSlice *last = NULL;
 	MemoryContext old = MemoryContextSwitchTo(store->mcxt);
 	int i;
 
 	Assert(hc->num_slices == store->num_dimensions);
 
+	/*
+	 * Do we have enough space to store the object? Evict before walking the
+	 * tree, since eviction can remove the internal nodes on the path.
+	 */
+	if (store->max_items > 0 && store->num_items >= store->max_items)
+		subspace_store_evict(store);
+
+	Assert(store->max_items == 0 || store->num_items < store->max_items);
+
+	node = store->origin;
+	leaf = palloc(offsetof(SubspaceStoreLeaf, slices) + sizeof(DimensionSlice *) * hc->num_slices);
+	leaf->object = object;
+	leaf->object_free = object_free;
+
 	for (i = 0; i < hc->num_slices; i++)
 	{
 		const DimensionSlice *target = hc->slices[i];
@@ -121,49 +226,9 @@ ts_subspace_store_add(SubspaceStore *store, const Hypercube *hc, void *object,
 			node = last->storage;
 		}
 
-		Assert(store->max_items == 0 || node->descendants <= (size_t) store->max_items);
-
-		/*
-		 * We only call this function on a cache miss, so number of leaves
-		 * will definitely increase see `Assert(last != NULL && last->storage
-		 * == NULL);` at bottom.
-		 */
-		node->descendants += 1;
-
 		Assert(0 == node->vector->num_slices ||
 			   node->vector->slices[0]->fd.dimension_id == target->fd.dimension_id);
 
-		/* Do we have enough space to store the object? */
-		if (store->max_items > 0 && node->descendants > store->max_items)
-		{
-			/*
-			 * Always delete the slice corresponding to the earliest time
-			 * range. In the normal case that inserts are performed in
-			 * time-order this is the one least likely to be reused. (Note
-			 * that we made sure that the first dimension is a time dimension
-			 * when creating the subspace_store). If out-of-order inserts are
-			 * become significant we may wish to change this to something more
-			 * sophisticated like LRU.
-			 */
-			size_t items_removed = subspace_store_internal_node_descendants(node, i);
-
-			/*
-			 * descendants at the root is inclusive of the descendants at the
-			 * children, so if we have an overflow it must be in the time dim
-			 */
-			Assert(i == 0);
-
-			Assert(store->max_items + 1 == node->descendants);
-
-			ts_dimension_vec_remove_slice(&node->vector, i);
-
-			/*
-			 * Note we would have to do this to ancestors if this was not the
-			 * root.
-			 */
-			node->descendants -= items_removed;
-		}
-
 		match = ts_dimension_vec_find_slice(node->vector, target->fd.range_start);
 
 		/* Do we have a slot in this vector for the new object? */
@@ -181,16 +246,22 @@ ts_subspace_store_add(SubspaceStore *store, const Hypercube *hc, void *object,
 			match = copy;
 		}
 
-		Assert(store->max_items == 0 || node->descendants <= (size_t) store->max_items);
-
+		leaf->slices[i] = match;
 		last = match;
 		/* internal slices point to the next SubspaceStoreInternalNode */
 		node = last->storage;
 	}
 
+	/*
+	 * We only call this function on a cache miss, so the number of leaves
+	 * will definitely increase.
+	 */
 	Assert(last != NULL && last->storage == NULL);
-	last->storage = object; /* at the end we store the object */
-	last->storage_free = object_free;
+	last->storage = leaf; /* at the end we store the object */
+	last->storage_free = subspace_store_leaf_free;
+	dlist_push_head(&store->lru, &leaf->lru_node);
+	store->last_leaf = leaf;
+	store->num_items++;
 	MemoryContextSwitchTo(old);
 }
 
@@ -200,20 +271,38 @@ ts_subspace_store_get(SubspaceStore *store, Point *target)
 	int i;
 	DimensionVec *vec = store->origin->vector;
 	DimensionSlice *match = NULL;
+	SubspaceStoreLeaf *leaf;
 
 	Assert(target->cardinality == store->num_dimensions);
 
+	/* The most recently used leaf is already at the head of the LRU list */
+	if (NULL != store->last_leaf && subspace_store_leaf_contains_point(store->last_leaf, target))
+	{
+		store->stats.hits++;
+		return store->last_leaf->object;
+	}
+
 	for (i = 0; i < target->cardinality; i++)
 	{
 		match = ts_dimension_vec_find_slice(vec, target->coordinates[i]);
 
 		if (NULL == match)
+		{
+			store->stats.misses++;
 			return NULL;
+		}
+
+		if (i == target->cardinality - 1)
+			break;
 
 		vec = ((SubspaceStoreInternalNode *) match->storage)->vector;
 	}
 	Assert(match != NULL);
-	return match->storage;
+	leaf = match->storage;
+	dlist_move_head(&store->lru, &leaf->lru_node);
+	store->last_leaf = leaf;
+	store->stats.hits++;
+	return leaf->object;
 }
 
 void
@@ -223,6 +312,12 @@ ts_subspace_store_free(SubspaceStore *store)
 	pfree(store);
 }
 
+void
+ts_subspace_store_get_stats(SubspaceStore *store, SubspaceStoreStats *stats)
+{
+	*stats = store->stats;
+}
+
 MemoryContext
 ts_subspace_store_mcxt(SubspaceStore *store)
 {
@@ -19,6 +19,13 @@ typedef struct Hypercube Hypercube;
 typedef struct Point Point;
 typedef struct SubspaceStore SubspaceStore;
 
+typedef struct SubspaceStoreStats
+{
+	int64 hits;
+	int64 misses;
+	int64 evictions;
+} SubspaceStoreStats;
+
 extern SubspaceStore *ts_subspace_store_init(Hyperspace *space, MemoryContext mcxt,
 											 int16 max_items);
 
@@ -31,6 +38,7 @@ extern void ts_subspace_store_add(SubspaceStore *cache, const Hypercube *hc, voi
  */
 extern void *ts_subspace_store_get(SubspaceStore *cache, Point *target);
 extern void ts_subspace_store_free(SubspaceStore *cache);
+extern void ts_subspace_store_get_stats(SubspaceStore *cache, SubspaceStoreStats *stats);
 extern MemoryContext ts_subspace_store_mcxt(SubspaceStore *cache);
 
 #endif /* TIMESCALEDB_SUBSPACE_STORE_H */
@@ -0,0 +1,32 @@
+# This file and its contents are licensed under the Apache License 2.0.
+# Please see the included NOTICE for copyright information and
+# LICENSE-APACHE for a copy of the license.
+
+# Chunk exclusion finds the dimension slices of a hypertable through an
+# in-memory index in each backend. A chunk created by another session has
+# to be found by the next query once that session commits, also inside a
+# transaction that already used the index.
+
+setup {
+  CREATE TABLE slice_index_t(time int NOT NULL, device int, value float);
+  SELECT create_hypertable('slice_index_t', 'time', chunk_time_interval => 10);
+  INSERT INTO slice_index_t VALUES (1, 1, 1.0);
+}
+
+teardown {
+  DROP TABLE slice_index_t;
+}
+
+session "s1"
+step "s1b"	{ BEGIN; SET TRANSACTION ISOLATION LEVEL READ COMMITTED; }
+step "s1q"	{ SELECT count(*) FROM slice_index_t WHERE time >= 0; }
+step "s1c"	{ COMMIT; }
+
+session "s2"
+step "s2b"	{ BEGIN; }
+step "s2i"	{ INSERT INTO slice_index_t VALUES (15, 1, 2.0); }
+step "s2c"	{ COMMIT; }
+
+permutation "s1q" "s2i" "s1q"
+permutation "s1b" "s1q" "s2i" "s1q" "s1c"
+permutation "s2b" "s2i" "s1q" "s2c" "s1q"
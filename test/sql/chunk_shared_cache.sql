@@ -0,0 +1,85 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION _timescaledb_internal.test_shared_chunk_cache_get(chunk_id INTEGER) RETURNS REGCLASS
+    AS :MODULE_PATHNAME, 'ts_test_chunk_shared_cache_get' LANGUAGE C VOLATILE STRICT;
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+
+-- Show which chunks are in the shared chunk cache
+CREATE VIEW cached_chunks AS
+SELECT id, _timescaledb_internal.test_shared_chunk_cache_get(id) AS cached_table
+FROM _timescaledb_catalog.chunk
+ORDER BY id;
+
+SHOW timescaledb.enable_shared_chunk_cache;
+
+CREATE TABLE cache_test(time timestamptz NOT NULL, temp float);
+SELECT table_name FROM create_hypertable('cache_test', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO cache_test VALUES ('2020-01-01 00:00', 1.0), ('2020-01-02 00:00', 2.0);
+
+-- Nothing is cached yet
+SELECT * FROM cached_chunks;
+
+-- Planning a query on a chunk adds it to the cache
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+SELECT count(*) FROM _timescaledb_internal._hyper_1_2_chunk;
+SELECT * FROM cached_chunks;
+
+-- The cache is not used when it is disabled
+SET timescaledb.enable_shared_chunk_cache TO off;
+SELECT * FROM cached_chunks;
+RESET timescaledb.enable_shared_chunk_cache;
+SELECT * FROM cached_chunks;
+
+-- A transaction that modifies chunk metadata does not use the cache
+BEGIN;
+INSERT INTO cache_test VALUES ('2020-01-03 00:00', 3.0);
+SELECT * FROM cached_chunks;
+ROLLBACK;
+
+-- Committing a change to the chunk metadata invalidates the cache
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+SELECT count(*) FROM _timescaledb_internal._hyper_1_2_chunk;
+SELECT * FROM cached_chunks;
+INSERT INTO cache_test VALUES ('2020-01-03 00:00', 3.0);
+SELECT * FROM cached_chunks;
+
+-- Also when the change is made by a new session that never used the
+-- cache before
+SELECT count(*) FROM _timescaledb_internal._hyper_1_2_chunk;
+SELECT count(*) FROM _timescaledb_internal._hyper_1_4_chunk;
+SELECT * FROM cached_chunks;
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+SELECT drop_chunks('cache_test', older_than => '2020-01-02 00:00'::timestamptz);
+SELECT * FROM cached_chunks;
+
+-- Invalidations in other databases do not affect the cache
+SELECT count(*) FROM _timescaledb_internal._hyper_1_2_chunk;
+SELECT * FROM cached_chunks;
+\set OTHER_DBNAME :TEST_DBNAME _other
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE DATABASE :OTHER_DBNAME;
+\c :OTHER_DBNAME :ROLE_SUPERUSER
+SET client_min_messages TO ERROR;
+CREATE EXTENSION timescaledb;
+CREATE TABLE other_test(time timestamptz NOT NULL, temp float);
+SELECT table_name FROM create_hypertable('other_test', 'time');
+INSERT INTO other_test VALUES ('2020-01-01 00:00', 1.0);
+SELECT count(*) FROM _timescaledb_internal._hyper_1_1_chunk;
+DROP TABLE other_test;
+\c :TEST_DBNAME :ROLE_SUPERUSER
+DROP DATABASE :OTHER_DBNAME;
+SELECT * FROM cached_chunks;
+
+-- The changes of a prepared transaction are not visible until COMMIT
+-- PREPARED, which invalidates the cache
+SELECT count(*) FROM _timescaledb_internal._hyper_1_4_chunk;
+SELECT * FROM cached_chunks;
+BEGIN;
+INSERT INTO cache_test VALUES ('2020-01-04 00:00', 4.0);
+PREPARE TRANSACTION 'cache_test_insert';
+SELECT * FROM cached_chunks;
+COMMIT PREPARED 'cache_test_insert';
+SELECT * FROM cached_chunks;
@@ -0,0 +1,60 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Tests for the statistics of chunks that have not been analyzed yet, which
+-- are taken from the newest analyzed chunk of the hypertable
+
+-- the row estimate of the top plan node of a query
+CREATE FUNCTION estimated_rows(query text) RETURNS int LANGUAGE plpgsql AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+    RETURN substring(line FROM 'rows=(\d+)')::int;
+  END LOOP;
+END
+$$;
+
+CREATE TABLE metrics(time int NOT NULL, device int, value float)
+WITH (autovacuum_enabled = false);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 5000);
+
+-- three chunks with 5000 rows and 10 devices each, only the first one is
+-- analyzed
+INSERT INTO metrics SELECT t, t % 10, t FROM generate_series(0, 14999) t;
+SELECT show_chunks('metrics');
+ANALYZE _timescaledb_internal._hyper_1_1_chunk;
+SELECT relname, relpages > 0 AS has_pages, reltuples FROM pg_class
+WHERE relname LIKE '\_hyper\_1\_%' AND relkind = 'r' ORDER BY relname;
+
+-- The unanalyzed chunks get the tuple density and the column statistics of
+-- the first chunk, so each of the chunks has 500 rows for a device. The
+-- statistics of the sibling are looked up for both chunks at once.
+SELECT estimated_rows('SELECT * FROM metrics WHERE device = 3');
+SELECT estimated_rows('SELECT * FROM _timescaledb_internal._hyper_1_2_chunk');
+SELECT estimated_rows('SELECT * FROM _timescaledb_internal._hyper_1_2_chunk WHERE device = 3');
+
+-- The time column does not use the histogram of the sibling, which would
+-- make every restriction on a newer chunk look far too selective or not at
+-- all. The default selectivities are used instead: 1/3 for a single
+-- inequality and 0.005 for a range.
+SELECT estimated_rows('SELECT * FROM _timescaledb_internal._hyper_1_2_chunk WHERE time < 5500');
+SELECT estimated_rows('SELECT * FROM metrics WHERE time >= 5000 AND time < 5500');
+
+-- without extrapolation, the chunks use the default estimates
+SET timescaledb.enable_chunk_stats_extrapolation TO off;
+SELECT estimated_rows('SELECT * FROM metrics WHERE device = 3') <> 1500 AS differs;
+SELECT estimated_rows('SELECT * FROM _timescaledb_internal._hyper_1_2_chunk WHERE device = 3') <> 500 AS differs;
+RESET timescaledb.enable_chunk_stats_extrapolation;
+
+-- Once analyzed, a chunk uses its own statistics. The last chunk only has
+-- 1000 rows for two devices now, so it has no rows for device 3.
+DELETE FROM metrics WHERE time >= 10000 AND device > 1;
+ANALYZE _timescaledb_internal._hyper_1_3_chunk;
+SELECT estimated_rows('SELECT * FROM _timescaledb_internal._hyper_1_3_chunk WHERE device = 3');
+-- The unanalyzed chunk now uses the statistics of the last chunk, which is
+-- the newest analyzed one, so only the first chunk has rows for device 3.
+SELECT estimated_rows('SELECT * FROM _timescaledb_internal._hyper_1_2_chunk');
+SELECT estimated_rows('SELECT * FROM metrics WHERE device = 3');
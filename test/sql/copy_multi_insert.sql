@@ -0,0 +1,144 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Tests for COPY with buffered multi-inserts into chunks. Every COPY is run
+-- once with timescaledb.enable_multi_insert on, into copy_on, and once with
+-- it off, into copy_off. Both tables have to end up with the same rows.
+
+-- COPY from a file on the server needs a superuser
+\c :TEST_DBNAME :ROLE_SUPERUSER
+SELECT format('%s/results/%s_data.csv', :'TEST_OUTPUT_DIR', :'TEST_BASE_NAME') AS "DATA_FILE" \gset
+
+CREATE FUNCTION visible_rows(tbl text) RETURNS bigint LANGUAGE plpgsql AS
+$$
+DECLARE
+  visible_rows bigint;
+BEGIN
+  EXECUTE format('SELECT count(*) FROM %I', tbl) INTO visible_rows;
+  RETURN visible_rows;
+END
+$$;
+
+CREATE TABLE trigger_log(tbl text, level text, visible_rows bigint);
+
+CREATE FUNCTION log_insert() RETURNS trigger LANGUAGE plpgsql AS
+$$
+BEGIN
+  INSERT INTO trigger_log VALUES (TG_ARGV[0], TG_LEVEL, visible_rows(TG_ARGV[0]));
+  RETURN NULL;
+END
+$$;
+
+CREATE FUNCTION skip_odd() RETURNS trigger LANGUAGE plpgsql AS
+$$
+BEGIN
+  IF NEW.time % 2 = 1 THEN
+    RETURN NULL;
+  END IF;
+  RETURN NEW;
+END
+$$;
+
+-- The chunks are created after dropping a column, so tuples have to be
+-- converted to the rowtype of the chunks.
+CREATE FUNCTION create_metrics(tbl text) RETURNS text LANGUAGE plpgsql AS
+$$
+BEGIN
+  EXECUTE format('CREATE TABLE %I(time int NOT NULL, dropped int, device int, '
+                 'value float CHECK (value >= 0), '
+                 'doubled float GENERATED ALWAYS AS (value * 2) STORED, seen bigint)', tbl);
+  EXECUTE format('ALTER TABLE %I DROP COLUMN dropped', tbl);
+  PERFORM create_hypertable(tbl::regclass, 'time', chunk_time_interval => 2000);
+  EXECUTE format('CREATE UNIQUE INDEX ON %I(time, device)', tbl);
+  RETURN tbl;
+END
+$$;
+
+SELECT create_metrics(tbl) FROM (VALUES ('copy_on'), ('copy_off')) v(tbl);
+
+\set STATE 'SELECT (SELECT count(*) FROM copy_on) AS rows_on, (SELECT count(*) FROM copy_off) AS rows_off, (SELECT count(*) FROM show_chunks(''copy_on'')) AS chunks_on, (SELECT count(*) FROM show_chunks(''copy_off'')) AS chunks_off, (SELECT count(*) FROM ((TABLE copy_on EXCEPT ALL TABLE copy_off) UNION ALL (TABLE copy_off EXCEPT ALL TABLE copy_on)) d) AS differences'
+
+-- COPY across chunks, with 2000 rows per chunk, so the buffer of each chunk
+-- is flushed when full and at the end
+COPY (SELECT t, t % 3, t / 2.0 FROM generate_series(0, 5999) t) TO :'DATA_FILE' (FORMAT csv);
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+COPY copy_on(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+SET timescaledb.enable_multi_insert TO off;
+COPY copy_off(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+\set QUIET on
+:STATE;
+
+-- AFTER ROW and AFTER STATEMENT triggers run at the end of the COPY, after
+-- the buffers are flushed, and see all of its rows, including those in a
+-- new chunk
+CREATE TRIGGER log_row AFTER INSERT ON copy_on FOR EACH ROW EXECUTE FUNCTION log_insert('copy_on');
+CREATE TRIGGER log_row AFTER INSERT ON copy_off FOR EACH ROW EXECUTE FUNCTION log_insert('copy_off');
+CREATE TRIGGER log_statement AFTER INSERT ON copy_on FOR EACH STATEMENT EXECUTE FUNCTION log_insert('copy_on');
+CREATE TRIGGER log_statement AFTER INSERT ON copy_off FOR EACH STATEMENT EXECUTE FUNCTION log_insert('copy_off');
+COPY (SELECT t, 4, t FROM generate_series(6000, 6019) t) TO :'DATA_FILE' (FORMAT csv);
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+COPY copy_on(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+SET timescaledb.enable_multi_insert TO off;
+COPY copy_off(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+\set QUIET on
+SELECT tbl, level, count(*), min(visible_rows), max(visible_rows)
+FROM trigger_log GROUP BY tbl, level ORDER BY tbl, level;
+DROP TRIGGER log_row ON copy_on;
+DROP TRIGGER log_row ON copy_off;
+DROP TRIGGER log_statement ON copy_on;
+DROP TRIGGER log_statement ON copy_off;
+:STATE;
+
+-- Chunks with BEFORE ROW triggers do not buffer tuples, and the skipped rows
+-- are not counted
+CREATE TRIGGER skip_odd BEFORE INSERT ON copy_on FOR EACH ROW EXECUTE FUNCTION skip_odd();
+CREATE TRIGGER skip_odd BEFORE INSERT ON copy_off FOR EACH ROW EXECUTE FUNCTION skip_odd();
+COPY (SELECT t, 4, t FROM generate_series(6020, 6029) t) TO :'DATA_FILE' (FORMAT csv);
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+COPY copy_on(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+SET timescaledb.enable_multi_insert TO off;
+COPY copy_off(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+\set QUIET on
+DROP TRIGGER skip_odd ON copy_on;
+DROP TRIGGER skip_odd ON copy_off;
+:STATE;
+
+-- A volatile default of a column that is not copied can query the
+-- hypertable, so tuples are not buffered and every row sees the rows copied
+-- before it
+ALTER TABLE copy_on ALTER COLUMN seen SET DEFAULT visible_rows('copy_on');
+ALTER TABLE copy_off ALTER COLUMN seen SET DEFAULT visible_rows('copy_off');
+COPY (SELECT t, 4, t FROM generate_series(6030, 6039) t) TO :'DATA_FILE' (FORMAT csv);
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+COPY copy_on(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+SET timescaledb.enable_multi_insert TO off;
+COPY copy_off(time, device, value) FROM :'DATA_FILE' (FORMAT csv);
+\set QUIET on
+ALTER TABLE copy_on ALTER COLUMN seen DROP DEFAULT;
+ALTER TABLE copy_off ALTER COLUMN seen DROP DEFAULT;
+SELECT time, seen FROM copy_on WHERE seen IS NOT NULL ORDER BY time;
+:STATE;
+
+-- The same holds for a volatile WHERE clause, which only keeps the rows
+-- that see all rows copied before them
+COPY (SELECT t, 4, t FROM generate_series(6040, 6049) t) TO :'DATA_FILE' (FORMAT csv);
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+COPY copy_on(time, device, value) FROM :'DATA_FILE' (FORMAT csv) WHERE visible_rows('copy_on') = time - 5;
+SET timescaledb.enable_multi_insert TO off;
+COPY copy_off(time, device, value) FROM :'DATA_FILE' (FORMAT csv) WHERE visible_rows('copy_off') = time - 5;
+\set QUIET on
+RESET timescaledb.enable_multi_insert;
+:STATE;
+
+-- the generated column is computed for every row, and all rows are in the
+-- chunks covering them
+SELECT count(*) FROM copy_on WHERE doubled IS DISTINCT FROM value * 2;
+SELECT count(*) FROM ONLY copy_on;
+SELECT tableoid::regclass AS chunk, count(*), min(time), max(time)
+FROM copy_on GROUP BY tableoid ORDER BY tableoid::regclass::text;
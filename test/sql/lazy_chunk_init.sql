@@ -0,0 +1,84 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Tests for timescaledb.enable_lazy_chunk_init, which makes ChunkAppend
+-- initialize the subplan of a chunk only when the chunk is scanned for the
+-- first time. Every query is run with the setting on and off, and both have
+-- to return the same rows.
+
+\set PREFIX 'EXPLAIN (analyze, costs off, timing off, summary off)'
+
+CREATE TABLE metrics(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 1000);
+INSERT INTO metrics SELECT t, t % 4, t / 2.0 FROM generate_series(0, 3999) t;
+ANALYZE metrics;
+
+CREATE TABLE devices(device int, first_time int);
+INSERT INTO devices VALUES (0, 1500), (1, 2200), (2, 3900), (3, 10000);
+ANALYZE devices;
+
+-- the number of rows of a query, and whether they are the same with and
+-- without lazy initialization
+CREATE FUNCTION compare(query text, OUT rows int, OUT same bool) LANGUAGE plpgsql AS
+$$
+DECLARE
+  stmt text := format('SELECT array_agg(q::text ORDER BY q::text) FROM (%s) q', query);
+  rows_on text[];
+  rows_off text[];
+BEGIN
+  PERFORM set_config('timescaledb.enable_lazy_chunk_init', 'on', true);
+  EXECUTE stmt INTO rows_on;
+  PERFORM set_config('timescaledb.enable_lazy_chunk_init', 'off', true);
+  EXECUTE stmt INTO rows_off;
+  rows := coalesce(cardinality(rows_on), 0);
+  same := rows_on IS NOT DISTINCT FROM rows_off;
+END
+$$;
+
+-- Ordered appends with a LIMIT that stops in the first chunk or in a later
+-- one, runtime exclusion with an initplan, and runtime exclusion on every
+-- rescan of a LATERAL subquery or a correlated subquery, where each loop
+-- scans other chunks.
+SELECT q AS query, c.rows, c.same
+FROM (VALUES ('SELECT * FROM metrics ORDER BY time DESC LIMIT 5'),
+             ('SELECT * FROM metrics ORDER BY time LIMIT 1500'),
+             ('SELECT * FROM metrics WHERE time = (SELECT 2500)'),
+             ('SELECT * FROM metrics WHERE time < (SELECT max(first_time) FROM devices WHERE device < 2)'),
+             ('SELECT d.device, m.time FROM devices d, LATERAL (SELECT time FROM metrics m WHERE m.time >= d.first_time ORDER BY m.time LIMIT 3) m'),
+             ('SELECT d.device, (SELECT count(*) FROM metrics m WHERE m.time < d.first_time) FROM devices d')) v(q),
+     LATERAL compare(q) c;
+
+-- A cursor initializes the subplan of the next chunk in the middle of the
+-- scan, and is closed before the remaining chunks are initialized
+BEGIN;
+DECLARE c CURSOR FOR SELECT time FROM metrics ORDER BY time DESC LIMIT 2500;
+FETCH 2 FROM c;
+MOVE 1000 IN c;
+FETCH 2 FROM c;
+CLOSE c;
+COMMIT;
+
+-- EXPLAIN initializes all subplans, so every chunk is shown, including the
+-- ones that are not executed
+EXPLAIN (costs off) SELECT * FROM metrics ORDER BY time DESC LIMIT 5;
+:PREFIX SELECT * FROM metrics ORDER BY time DESC LIMIT 5;
+:PREFIX SELECT * FROM metrics WHERE time = (SELECT 2500);
+
+-- Parallel scans below a Gather set up their shared state when the Gather
+-- starts, so their subplans are initialized at startup even if ChunkAppend
+-- is not parallel-aware
+SET parallel_setup_cost TO 0;
+SET parallel_tuple_cost TO 0;
+SET min_parallel_table_scan_size TO 0;
+SET max_parallel_workers_per_gather TO 2;
+SET timescaledb.enable_parallel_chunk_append TO off;
+SELECT q AS query, c.rows, c.same
+FROM (VALUES ('SELECT count(*), sum(value) FROM metrics WHERE time < (SELECT 2500)')) v(q),
+     LATERAL compare(q) c;
+SELECT count(*), sum(value) FROM metrics WHERE time < (SELECT 2500);
+RESET timescaledb.enable_parallel_chunk_append;
+RESET max_parallel_workers_per_gather;
+RESET min_parallel_table_scan_size;
+RESET parallel_tuple_cost;
+RESET parallel_setup_cost;
@@ -0,0 +1,152 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+-- Tests for INSERT with buffered multi-inserts into chunks. Every insert is
+-- run once with timescaledb.enable_multi_insert on, into multi_on, and once
+-- with it off, into multi_off. Both tables have to end up with the same rows.
+
+CREATE TABLE source AS
+SELECT t AS time, t % 4 AS device, t / 2.0::float AS value FROM generate_series(0, 5999) t;
+
+CREATE TABLE trigger_log(tbl text, time int, doubled float, visible_rows bigint);
+
+CREATE FUNCTION log_insert() RETURNS trigger LANGUAGE plpgsql AS
+$$
+DECLARE
+  visible_rows bigint;
+BEGIN
+  EXECUTE format('SELECT count(*) FROM %I', TG_ARGV[0]) INTO visible_rows;
+  INSERT INTO trigger_log VALUES (TG_ARGV[0], NEW.time, NEW.doubled, visible_rows);
+  RETURN NEW;
+END
+$$;
+
+CREATE FUNCTION skip_odd() RETURNS trigger LANGUAGE plpgsql AS
+$$
+BEGIN
+  IF NEW.time % 2 = 1 THEN
+    RETURN NULL;
+  END IF;
+  RETURN NEW;
+END
+$$;
+
+-- The chunks are created after dropping a column, so tuples have to be
+-- converted to the rowtype of the chunks.
+CREATE FUNCTION create_metrics(tbl text) RETURNS text LANGUAGE plpgsql AS
+$$
+BEGIN
+  EXECUTE format('CREATE TABLE %I(time int NOT NULL, dropped int, device int, '
+                 'value float CHECK (value >= 0), '
+                 'doubled float GENERATED ALWAYS AS (value * 2) STORED)', tbl);
+  EXECUTE format('ALTER TABLE %I DROP COLUMN dropped', tbl);
+  PERFORM create_hypertable(tbl::regclass, 'time', chunk_time_interval => 2000);
+  EXECUTE format('CREATE UNIQUE INDEX ON %I(time, device)', tbl);
+  RETURN tbl;
+END
+$$;
+
+SELECT create_metrics(tbl) FROM (VALUES ('multi_on'), ('multi_off')) v(tbl);
+
+\set STATE 'SELECT (SELECT count(*) FROM multi_on) AS rows_on, (SELECT count(*) FROM multi_off) AS rows_off, (SELECT count(*) FROM show_chunks(''multi_on'')) AS chunks_on, (SELECT count(*) FROM show_chunks(''multi_off'')) AS chunks_off, (SELECT count(*) FROM ((TABLE multi_on EXCEPT ALL TABLE multi_off) UNION ALL (TABLE multi_off EXCEPT ALL TABLE multi_on)) d) AS differences'
+
+-- INSERT ... SELECT across chunks, with 1500 rows per chunk, so the buffer of
+-- each chunk is flushed once when full and once at the end
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+INSERT INTO multi_on SELECT * FROM source WHERE device < 3 ORDER BY time;
+SET timescaledb.enable_multi_insert TO off;
+INSERT INTO multi_off SELECT * FROM source WHERE device < 3 ORDER BY time;
+\set QUIET on
+:STATE;
+
+-- A unique violation inside a batch, or with an existing row, fails the
+-- insert, and so do constraint violations. None of the rows is inserted.
+\set ON_ERROR_STOP 0
+SET timescaledb.enable_multi_insert TO on;
+INSERT INTO multi_on SELECT * FROM source WHERE device = 3 AND time < 100 UNION ALL SELECT 51, 3, 0;
+INSERT INTO multi_on SELECT * FROM source WHERE device = 3 AND time < 100 UNION ALL SELECT 0, 0, 0;
+INSERT INTO multi_on SELECT * FROM source WHERE device = 3 AND time < 100 UNION ALL SELECT 1, 0, -1;
+SET timescaledb.enable_multi_insert TO off;
+INSERT INTO multi_off SELECT * FROM source WHERE device = 3 AND time < 100 UNION ALL SELECT 51, 3, 0;
+INSERT INTO multi_off SELECT * FROM source WHERE device = 3 AND time < 100 UNION ALL SELECT 0, 0, 0;
+INSERT INTO multi_off SELECT * FROM source WHERE device = 3 AND time < 100 UNION ALL SELECT 1, 0, -1;
+\set ON_ERROR_STOP 1
+:STATE;
+
+-- Switch chunks on every row while only one chunk insert state can be open,
+-- so the buffers are flushed when their chunk insert states are evicted
+SET timescaledb.max_open_chunks_per_insert TO 1;
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+INSERT INTO multi_on SELECT * FROM source WHERE device = 3 ORDER BY time % 2000, time;
+SET timescaledb.enable_multi_insert TO off;
+INSERT INTO multi_off SELECT * FROM source WHERE device = 3 ORDER BY time % 2000, time;
+\set QUIET on
+RESET timescaledb.max_open_chunks_per_insert;
+:STATE;
+
+-- AFTER ROW triggers run at the end of the statement and see all of its rows,
+-- including those in a new chunk
+CREATE TRIGGER log_insert AFTER INSERT ON multi_on FOR EACH ROW EXECUTE FUNCTION log_insert('multi_on');
+CREATE TRIGGER log_insert AFTER INSERT ON multi_off FOR EACH ROW EXECUTE FUNCTION log_insert('multi_off');
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+INSERT INTO multi_on SELECT t, 4, t FROM generate_series(5990, 6009) t;
+SET timescaledb.enable_multi_insert TO off;
+INSERT INTO multi_off SELECT t, 4, t FROM generate_series(5990, 6009) t;
+\set QUIET on
+SELECT tbl, count(*), min(visible_rows), max(visible_rows), count(*) FILTER (WHERE doubled = 2 * time) AS doubled
+FROM trigger_log GROUP BY tbl ORDER BY tbl;
+DROP TRIGGER log_insert ON multi_on;
+DROP TRIGGER log_insert ON multi_off;
+:STATE;
+
+-- Chunks with BEFORE ROW triggers do not buffer tuples, and the skipped rows
+-- are not counted
+CREATE TRIGGER skip_odd BEFORE INSERT ON multi_on FOR EACH ROW EXECUTE FUNCTION skip_odd();
+CREATE TRIGGER skip_odd BEFORE INSERT ON multi_off FOR EACH ROW EXECUTE FUNCTION skip_odd();
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+INSERT INTO multi_on SELECT t, 4, t FROM generate_series(6010, 6019) t;
+SET timescaledb.enable_multi_insert TO off;
+INSERT INTO multi_off SELECT t, 4, t FROM generate_series(6010, 6019) t;
+\set QUIET on
+DROP TRIGGER skip_odd ON multi_on;
+DROP TRIGGER skip_odd ON multi_off;
+RESET timescaledb.enable_multi_insert;
+:STATE;
+
+-- the generated column is computed for every row, and all rows are in the
+-- chunks covering them
+SELECT count(*) FROM multi_on WHERE doubled IS DISTINCT FROM value * 2;
+SELECT * FROM multi_on WHERE time BETWEEN 1998 AND 2001 ORDER BY time, device;
+SELECT count(*) FROM ONLY multi_on;
+SELECT tableoid::regclass AS chunk, count(*), min(time), max(time)
+FROM multi_on GROUP BY tableoid ORDER BY tableoid::regclass::text;
+
+-- A volatile function in the inserted rows or in the WHERE clause might read
+-- the hypertable, and has to see the rows inserted before by the same
+-- statement. Such rows are not buffered.
+CREATE FUNCTION count_rows(tbl text) RETURNS bigint LANGUAGE plpgsql VOLATILE AS
+$$
+DECLARE
+  rows bigint;
+BEGIN
+  EXECUTE format('SELECT count(*) FROM %I', tbl) INTO rows;
+  RETURN rows;
+END
+$$;
+
+\set QUIET off
+SET timescaledb.enable_multi_insert TO on;
+INSERT INTO multi_on SELECT t, 5, count_rows('multi_on') FROM generate_series(6020, 6029) t;
+INSERT INTO multi_on SELECT t, 6, 0 FROM generate_series(6030, 6039) t WHERE count_rows('multi_on') < 6040;
+SET timescaledb.enable_multi_insert TO off;
+INSERT INTO multi_off SELECT t, 5, count_rows('multi_off') FROM generate_series(6020, 6029) t;
+INSERT INTO multi_off SELECT t, 6, 0 FROM generate_series(6030, 6039) t WHERE count_rows('multi_off') < 6040;
+\set QUIET on
+RESET timescaledb.enable_multi_insert;
+SELECT device, count(*), min(value), max(value) FROM multi_on WHERE device IN (5, 6) GROUP BY device ORDER BY device;
+:STATE;
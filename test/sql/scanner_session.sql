@@ -0,0 +1,45 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION _timescaledb_internal.test_scanner_session(start_ids INTEGER[], use_index BOOLEAN, max_tuples INTEGER) RETURNS TEXT[]
+    AS :MODULE_PATHNAME, 'ts_test_scanner_session' LANGUAGE C VOLATILE STRICT;
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+
+-- A scan session runs many scans on the same catalog table, and every scan
+-- after the first one only repositions the open scan with new scan key
+-- arguments. Each scan here finds the chunk IDs from a given ID on.
+CREATE TABLE time_only(time int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('time_only', 'time', chunk_time_interval => 10);
+INSERT INTO time_only SELECT t, t FROM generate_series(0, 49) t;
+
+SELECT _timescaledb_internal.test_scanner_session('{1,3,6,2}', true, 0) AS index_scans,
+       _timescaledb_internal.test_scanner_session('{1,3,6,2}', false, 0) AS table_scans;
+
+-- A scan that stops at its limit does not affect the next scan
+SELECT _timescaledb_internal.test_scanner_session('{1,3,6,2,5}', true, 2) AS index_scans,
+       _timescaledb_internal.test_scanner_session('{1,3,6,2,5}', false, 2) AS table_scans;
+SELECT _timescaledb_internal.test_scanner_session('{5,5,1}', true, 1) AS index_scans,
+       _timescaledb_internal.test_scanner_session('{5,5,1}', false, 1) AS table_scans;
+
+-- a session without scans
+SELECT _timescaledb_internal.test_scanner_session('{}', true, 0);
+
+-- Queries and chunk functions look up all their chunks in one scan session,
+-- here with chunks in two dimensions
+CREATE TABLE metrics(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics', 'time', 'device', 2, chunk_time_interval => 10);
+INSERT INTO metrics SELECT t, d, t FROM generate_series(0, 99) t, generate_series(1, 20) d ORDER BY t;
+
+SELECT count(*) FROM show_chunks('metrics');
+SELECT count(*), min(time), max(time) FROM metrics WHERE time >= 15 AND time < 45;
+SELECT count(*), min(time), max(time) FROM metrics WHERE time >= 15 AND time < 45 AND device = 3;
+SELECT count(*) FROM show_chunks('metrics', older_than => 45, newer_than => 15);
+SELECT count(*) FROM drop_chunks('metrics', older_than => 30);
+SELECT count(*) FROM show_chunks('metrics');
+SELECT count(*), min(time), max(time) FROM metrics;
+
+-- the dropped chunks are not found anymore
+SELECT _timescaledb_internal.test_scanner_session('{1,5,6}', true, 3) AS index_scans,
+       _timescaledb_internal.test_scanner_session('{1,5,6}', false, 3) AS table_scans;
@@ -0,0 +1,64 @@
+-- This file and its contents are licensed under the Apache License 2.0.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-APACHE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION _timescaledb_internal.test_subspace_store_init(hypertable REGCLASS, max_items INTEGER) RETURNS VOID
+    AS :MODULE_PATHNAME, 'ts_test_subspace_store_init' LANGUAGE C VOLATILE STRICT;
+CREATE OR REPLACE FUNCTION _timescaledb_internal.test_subspace_store_get(point BIGINT[]) RETURNS INTEGER
+    AS :MODULE_PATHNAME, 'ts_test_subspace_store_get' LANGUAGE C VOLATILE STRICT;
+CREATE OR REPLACE FUNCTION _timescaledb_internal.test_subspace_store_stats(OUT hits BIGINT, OUT misses BIGINT, OUT evictions BIGINT)
+    AS :MODULE_PATHNAME, 'ts_test_subspace_store_stats' LANGUAGE C VOLATILE STRICT;
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+
+-- A subspace store holds an object for each subspace of a hypertable, e.g.,
+-- the chunk insert state of each chunk that an insert writes to. Looking up a
+-- point returns the number of its object, and a point that is not in the
+-- store gets a new object.
+CREATE TABLE time_only(time int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('time_only', 'time', chunk_time_interval => 10);
+CREATE TABLE time_space(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('time_space', 'time', 'device', 2, chunk_time_interval => 10);
+
+-- A full store evicts the object that was used least recently, which is not
+-- necessarily the one with the earliest time.
+SELECT _timescaledb_internal.test_subspace_store_init('time_only', 3);
+SELECT p AS point, _timescaledb_internal.test_subspace_store_get(p) AS object
+FROM (VALUES ('{1}'::bigint[]), ('{11}'), ('{21}'), ('{5}'), ('{31}'), ('{21}'), ('{1}'),
+             ('{11}'), ('{31}'), ('{21}'), ('{1}')) v(p);
+SELECT * FROM _timescaledb_internal.test_subspace_store_stats();
+
+-- With several dimensions, evicting the last object of a time slice also
+-- removes the time slice, and objects in other space partitions of the same
+-- time slice are kept.
+SELECT _timescaledb_internal.test_subspace_store_init('time_space', 2);
+SELECT p AS point, _timescaledb_internal.test_subspace_store_get(p) AS object
+FROM (VALUES ('{1,0}'::bigint[]), ('{1,2000000000}'), ('{11,0}'), ('{1,2000000000}'),
+             ('{1,0}'), ('{11,2000000000}'), ('{11,0}'), ('{1,0}')) v(p);
+SELECT * FROM _timescaledb_internal.test_subspace_store_stats();
+
+-- Without a limit, nothing is evicted and every point finds the object of
+-- its time slice
+SELECT _timescaledb_internal.test_subspace_store_init('time_only', 0);
+SELECT count(DISTINCT _timescaledb_internal.test_subspace_store_get(ARRAY[t * 10]::bigint[]))
+FROM generate_series(1, 100) t;
+SELECT count(*) FROM generate_series(1, 100) t
+WHERE _timescaledb_internal.test_subspace_store_get(ARRAY[t * 10 + 5]::bigint[]) <> t;
+SELECT * FROM _timescaledb_internal.test_subspace_store_stats();
+
+-- Lookups first check the object that was used last. Points just outside of
+-- its subspace, or in another space partition of the same time slice, have
+-- to find other objects.
+SELECT _timescaledb_internal.test_subspace_store_init('time_space', 0);
+SELECT p AS point, _timescaledb_internal.test_subspace_store_get(p) AS object
+FROM (VALUES ('{10,0}'::bigint[]), ('{19,0}'), ('{20,0}'), ('{19,0}'), ('{19,1073741822}'),
+             ('{19,1073741823}'), ('{10,1073741823}'), ('{20,1073741823}'), ('{20,0}'),
+             ('{9,0}'), ('{9,0}')) v(p);
+SELECT * FROM _timescaledb_internal.test_subspace_store_stats();
+
+-- A store with room for a single object always evicts the object that was
+-- used last, which must not be found afterwards
+SELECT _timescaledb_internal.test_subspace_store_init('time_only', 1);
+SELECT p AS point, _timescaledb_internal.test_subspace_store_get(p) AS object
+FROM (VALUES ('{1}'::bigint[]), ('{1}'), ('{11}'), ('{1}'), ('{11}'), ('{11}')) v(p);
+SELECT * FROM _timescaledb_internal.test_subspace_store_stats();
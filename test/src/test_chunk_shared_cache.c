@@ -0,0 +1,28 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+
+#include <chunk_shared_cache.h>
+
+#include "export.h"
+
+TS_FUNCTION_INFO_V1(ts_test_chunk_shared_cache_get);
+
+/*
+ * Look up a chunk ID in the shared chunk cache, without falling back to the
+ * catalog. Returns the chunk's table, or NULL if the chunk is not cached.
+ */
+Datum
+ts_test_chunk_shared_cache_get(PG_FUNCTION_ARGS)
+{
+	Chunk chunk;
+
+	if (!ts_chunk_shared_cache_get_by_id(PG_GETARG_INT32(0), &chunk))
+		PG_RETURN_NULL();
+
+	PG_RETURN_OID(chunk.table_id);
+}
@@ -0,0 +1,115 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <access/stratnum.h>
+#include <catalog/pg_type.h>
+#include <executor/tuptable.h>
+#include <lib/stringinfo.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/fmgroids.h>
+
+#include <catalog.h>
+#include <scan_iterator.h>
+
+#include "export.h"
+#include "test_utils.h"
+
+TS_FUNCTION_INFO_V1(ts_test_scanner_session);
+
+typedef struct ScannerSessionCounts
+{
+	int prescans;
+	int postscans;
+} ScannerSessionCounts;
+
+static void
+scanner_session_prescan(void *data)
+{
+	ScannerSessionCounts *counts = data;
+
+	counts->prescans++;
+}
+
+static void
+scanner_session_postscan(int num_tuples, void *data)
+{
+	ScannerSessionCounts *counts = data;
+
+	counts->postscans++;
+}
+
+/*
+ * Scan the chunk catalog for the chunk IDs greater than or equal to each of
+ * the given IDs, returning at most max_tuples IDs per scan, or all of them if
+ * max_tuples is 0. All the scans run in one scan session, either on the chunk
+ * ID index or on the table itself.
+ *
+ * Returns one element per scan with the comma-separated IDs that were found.
+ */
+Datum
+ts_test_scanner_session(PG_FUNCTION_ARGS)
+{
+	ArrayType *start_ids = PG_GETARG_ARRAYTYPE_P(0);
+	bool use_index = PG_GETARG_BOOL(1);
+	int32 max_tuples = PG_GETARG_INT32(2);
+	ScanIterator iterator = ts_scan_iterator_create(CHUNK, AccessShareLock, CurrentMemoryContext);
+	ScannerSessionCounts counts = { 0 };
+	Datum *elems;
+	Datum *results;
+	bool *nulls;
+	int nelems;
+	int i;
+
+	if (max_tuples < 0)
+		elog(ERROR, "invalid maximum number of tuples %d", max_tuples);
+
+	deconstruct_array(start_ids, INT4OID, 4, true, 'i', &elems, &nulls, &nelems);
+	results = palloc(sizeof(Datum) * nelems);
+
+	if (use_index)
+		iterator.ctx.index = catalog_get_index(ts_catalog_get(), CHUNK, CHUNK_ID_INDEX);
+
+	iterator.ctx.keepopen = true;
+	iterator.ctx.limit = max_tuples;
+	iterator.ctx.data = &counts;
+	iterator.ctx.prescan = scanner_session_prescan;
+	iterator.ctx.postscan = scanner_session_postscan;
+	ts_scan_iterator_scan_key_init(&iterator,
+								   use_index ? Anum_chunk_idx_id : Anum_chunk_id,
+								   BTGreaterEqualStrategyNumber,
+								   F_INT4GE,
+								   Int32GetDatum(0));
+
+	for (i = 0; i < nelems; i++)
+	{
+		StringInfoData found;
+		TupleInfo *ti;
+
+		initStringInfo(&found);
+		ts_scan_iterator_scan_key_set_argument(&iterator, 0, elems[i]);
+		ts_scan_iterator_rescan(&iterator);
+
+		while ((ti = ts_scan_iterator_next(&iterator)) != NULL)
+		{
+			bool isnull;
+			Datum id = slot_getattr(ti->slot, Anum_chunk_id, &isnull);
+
+			appendStringInfo(&found, "%s%d", found.len > 0 ? "," : "", DatumGetInt32(id));
+		}
+
+		results[i] = CStringGetTextDatum(found.data);
+	}
+
+	/* Every scan of the session is started and finished exactly once */
+	TestAssertInt64Eq(counts.prescans, nelems);
+	TestAssertInt64Eq(counts.postscans, nelems);
+	ts_scan_iterator_close(&iterator);
+	TestAssertInt64Eq(counts.postscans, nelems);
+
+	PG_RETURN_ARRAYTYPE_P(construct_array(results, nelems, TEXTOID, -1, false, 'i'));
+}
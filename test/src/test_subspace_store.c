@@ -0,0 +1,138 @@
+/*
+ * This file and its contents are licensed under the Apache License 2.0.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-APACHE for a copy of the license.
+ */
+#include <postgres.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <access/htup_details.h>
+#include <catalog/pg_type.h>
+#include <utils/array.h>
+#include <utils/memutils.h>
+
+#include <cache.h>
+#include <dimension.h>
+#include <dimension_slice.h>
+#include <hypercube.h>
+#include <hypertable_cache.h>
+#include <subspace_store.h>
+
+#include "export.h"
+
+TS_FUNCTION_INFO_V1(ts_test_subspace_store_init);
+TS_FUNCTION_INFO_V1(ts_test_subspace_store_get);
+TS_FUNCTION_INFO_V1(ts_test_subspace_store_stats);
+
+/*
+ * A subspace store over the dimensions of a hypertable that lives until the
+ * next call to ts_test_subspace_store_init. The objects in the store are
+ * numbered in the order they were added.
+ */
+static MemoryContext test_store_mcxt = NULL;
+static SubspaceStore *test_store = NULL;
+static Oid test_store_relid = InvalidOid;
+static int32 test_store_num_objects = 0;
+
+Datum
+ts_test_subspace_store_init(PG_FUNCTION_ARGS)
+{
+	Oid relid = PG_GETARG_OID(0);
+	int32 max_items = PG_GETARG_INT32(1);
+	Cache *hcache;
+	Hypertable *ht = ts_hypertable_cache_get_cache_and_entry(relid, CACHE_FLAG_NONE, &hcache);
+
+	if (max_items < 0 || max_items > PG_INT16_MAX)
+		elog(ERROR, "invalid maximum number of items %d", max_items);
+
+	if (test_store_mcxt == NULL)
+		test_store_mcxt =
+			AllocSetContextCreate(TopMemoryContext, "Test subspace store", ALLOCSET_DEFAULT_SIZES);
+	else
+		MemoryContextReset(test_store_mcxt);
+
+	test_store = ts_subspace_store_init(ht->space, test_store_mcxt, max_items);
+	test_store_relid = relid;
+	test_store_num_objects = 0;
+	ts_cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Look up the object for a point with one coordinate per dimension, open
+ * dimensions first. On a miss, add a new object for the default slices of
+ * the point. Returns the number of the object.
+ */
+Datum
+ts_test_subspace_store_get(PG_FUNCTION_ARGS)
+{
+	ArrayType *coordinates = PG_GETARG_ARRAYTYPE_P(0);
+	Datum *elems;
+	bool *nulls;
+	int nelems;
+	Point *point;
+	int32 *object;
+	int i;
+
+	if (test_store == NULL)
+		elog(ERROR, "subspace store is not initialized");
+
+	deconstruct_array(coordinates, INT8OID, 8, FLOAT8PASSBYVAL, 'd', &elems, &nulls, &nelems);
+
+	point = palloc0(POINT_SIZE(nelems));
+	point->cardinality = nelems;
+	point->num_coords = nelems;
+
+	for (i = 0; i < nelems; i++)
+		point->coordinates[i] = DatumGetInt64(elems[i]);
+
+	object = ts_subspace_store_get(test_store, point);
+
+	if (object == NULL)
+	{
+		Cache *hcache;
+		Hypertable *ht =
+			ts_hypertable_cache_get_cache_and_entry(test_store_relid, CACHE_FLAG_NONE, &hcache);
+		Hypercube *hc;
+
+		if (nelems != ht->space->num_dimensions)
+			elog(ERROR, "expected %d coordinates", ht->space->num_dimensions);
+
+		hc = ts_hypercube_alloc(nelems);
+
+		for (i = 0; i < nelems; i++)
+			ts_hypercube_add_slice(hc,
+								   ts_dimension_calculate_default_slice(&ht->space->dimensions[i],
+																		point->coordinates[i]));
+
+		object = MemoryContextAlloc(test_store_mcxt, sizeof(int32));
+		*object = ++test_store_num_objects;
+		ts_subspace_store_add(test_store, hc, object, pfree);
+		ts_cache_release(hcache);
+	}
+
+	PG_RETURN_INT32(*object);
+}
+
+Datum
+ts_test_subspace_store_stats(PG_FUNCTION_ARGS)
+{
+	SubspaceStoreStats stats;
+	TupleDesc tupdesc;
+	Datum values[3];
+	bool nulls[3] = { false };
+
+	if (test_store == NULL)
+		elog(ERROR, "subspace store is not initialized");
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "function returning record called in context that cannot accept type record");
+
+	ts_subspace_store_get_stats(test_store, &stats);
+	values[0] = Int64GetDatum(stats.hits);
+	values[1] = Int64GetDatum(stats.misses);
+	values[2] = Int64GetDatum(stats.evictions);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls)));
+}
@@ -0,0 +1,276 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include <postgres.h>
+#include <access/xact.h>
+#include <miscadmin.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+
+#include "bgw/job.h"
+#include "dimension.h"
+#include "chunk_precreate_api.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "time_utils.h"
+#include "utils.h"
+#include "jsonb_utils.h"
+#include "bgw_policy/job.h"
+
+/*
+ * Default scheduled interval for chunk pre-creation jobs is half the chunk
+ * interval, so that the next chunk always exists before it is needed. If this
+ * is non-timestamp based hypertable, then default is 1 day.
+ */
+#define DEFAULT_SCHEDULE_INTERVAL                                                                  \
+	DatumGetIntervalP(DirectFunctionCall3(interval_in, CStringGetDatum("1 day"), InvalidOid, -1))
+
+/* Default max runtime should not be very long. Right now set to 5 minutes */
+#define DEFAULT_MAX_RUNTIME                                                                        \
+	DatumGetIntervalP(DirectFunctionCall3(interval_in, CStringGetDatum("5 min"), InvalidOid, -1))
+
+/* Right now, there is an infinite number of retries for chunk pre-creation jobs */
+#define DEFAULT_MAX_RETRIES -1
+/* Default retry period is currently 5 minutes */
+#define DEFAULT_RETRY_PERIOD                                                                       \
+	DatumGetIntervalP(DirectFunctionCall3(interval_in, CStringGetDatum("5 min"), InvalidOid, -1))
+
+#define POLICY_CHUNK_PRECREATE_PROC_NAME "policy_chunk_precreate"
+#define CONFIG_KEY_HYPERTABLE_ID "hypertable_id"
+#define CONFIG_KEY_CHUNKS_AHEAD "chunks_ahead"
+
+int32
+policy_chunk_precreate_get_hypertable_id(const Jsonb *config)
+{
+	bool found;
+	int32 hypertable_id = ts_jsonb_get_int32_field(config, CONFIG_KEY_HYPERTABLE_ID, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find hypertable_id in config for job")));
+
+	return hypertable_id;
+}
+
+int32
+policy_chunk_precreate_get_chunks_ahead(const Jsonb *config)
+{
+	bool found;
+	int32 chunks_ahead = ts_jsonb_get_int32_field(config, CONFIG_KEY_CHUNKS_AHEAD, &found);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not find %s in config for job", CONFIG_KEY_CHUNKS_AHEAD)));
+
+	return chunks_ahead;
+}
+
+Datum
+policy_chunk_precreate_proc(PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2 || PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_VOID();
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	policy_chunk_precreate_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+
+	PG_RETURN_VOID();
+}
+
+Datum
+policy_chunk_precreate_add(PG_FUNCTION_ARGS)
+{
+	NameData application_name;
+	NameData precreate_chunks_name;
+	NameData proc_name, proc_schema, owner;
+	int32 job_id;
+	Oid ht_oid = PG_GETARG_OID(0);
+	int32 chunks_ahead = PG_GETARG_INT32(1);
+	bool if_not_exists = PG_GETARG_BOOL(2);
+	Interval *default_schedule_interval = DEFAULT_SCHEDULE_INTERVAL;
+	Hypertable *hypertable;
+	Cache *hcache;
+	Dimension *dim;
+	Oid partitioning_type;
+	Oid owner_id;
+	List *jobs;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	if (chunks_ahead < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for parameter %s", CONFIG_KEY_CHUNKS_AHEAD),
+				 errhint("The number of chunks to create ahead must be at least 1.")));
+
+	hypertable = ts_hypertable_cache_get_cache_and_entry(ht_oid, CACHE_FLAG_NONE, &hcache);
+
+	if (hypertable_is_distributed(hypertable))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("chunk pre-creation policies not supported on distributed hypertables")));
+
+	if (TS_HYPERTABLE_IS_INTERNAL_COMPRESSION_TABLE(hypertable))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot add chunk pre-creation policy to compressed hypertable \"%s\"",
+						get_rel_name(ht_oid)),
+				 errhint("Please add the policy to the corresponding uncompressed hypertable "
+						 "instead.")));
+
+	/*
+	 * Chunks are created for every partition of the space dimensions, but
+	 * there is no way to tell which ranges of another open dimension will be
+	 * needed.
+	 */
+	if (hyperspace_get_open_dimension(hypertable->space, 1) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("chunk pre-creation policies not supported on hypertables with more "
+						"than one time dimension")));
+
+	dim = hyperspace_get_open_dimension(hypertable->space, 0);
+	partitioning_type = ts_dimension_get_partition_type(dim);
+
+	if (IS_INTEGER_TYPE(partitioning_type) && !OidIsValid(ts_get_integer_now_func(dim)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("integer_now function not set on hypertable \"%s\"",
+						get_rel_name(ht_oid)),
+				 errhint("Use set_integer_now_func() to set the function that returns the "
+						 "current time of the hypertable.")));
+
+	owner_id = ts_hypertable_permissions_check(ht_oid, GetUserId());
+	ts_bgw_job_validate_job_owner(owner_id);
+
+	/* Make sure that an existing policy doesn't exist on this hypertable */
+	jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_CHUNK_PRECREATE_PROC_NAME,
+													 INTERNAL_SCHEMA_NAME,
+													 hypertable->fd.id);
+
+	if (jobs != NIL)
+	{
+		BgwJob *existing;
+
+		if (!if_not_exists)
+		{
+			ts_cache_release(hcache);
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("chunk pre-creation policy already exists for hypertable \"%s\"",
+							get_rel_name(ht_oid)),
+					 errhint("Set option \"if_not_exists\" to true to avoid error.")));
+		}
+
+		Assert(list_length(jobs) == 1);
+		existing = linitial(jobs);
+		ts_cache_release(hcache);
+
+		if (policy_chunk_precreate_get_chunks_ahead(existing->fd.config) == chunks_ahead)
+		{
+			/* If all arguments are the same, do nothing */
+			ereport(NOTICE,
+					(errmsg("chunk pre-creation policy already exists for hypertable \"%s\", "
+							"skipping",
+							get_rel_name(ht_oid))));
+		}
+		else
+		{
+			ereport(WARNING,
+					(errmsg("chunk pre-creation policy already exists for hypertable \"%s\"",
+							get_rel_name(ht_oid)),
+					 errdetail("A policy already exists with different arguments."),
+					 errhint("Remove the existing policy before adding a new one.")));
+		}
+
+		PG_RETURN_INT32(-1);
+	}
+
+	if (IS_TIMESTAMP_TYPE(partitioning_type))
+		default_schedule_interval = DatumGetIntervalP(
+			ts_internal_to_interval_value(dim->fd.interval_length / 2, INTERVALOID));
+
+	/* insert a new job into jobs table */
+	namestrcpy(&application_name, "Chunk Pre-creation Policy");
+	namestrcpy(&precreate_chunks_name, "precreate_chunks");
+	namestrcpy(&proc_name, POLICY_CHUNK_PRECREATE_PROC_NAME);
+	namestrcpy(&proc_schema, INTERNAL_SCHEMA_NAME);
+	namestrcpy(&owner, GetUserNameFromId(owner_id, false));
+
+	JsonbParseState *parse_state = NULL;
+
+	pushJsonbValue(&parse_state, WJB_BEGIN_OBJECT, NULL);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_HYPERTABLE_ID, hypertable->fd.id);
+	ts_jsonb_add_int32(parse_state, CONFIG_KEY_CHUNKS_AHEAD, chunks_ahead);
+
+	JsonbValue *result = pushJsonbValue(&parse_state, WJB_END_OBJECT, NULL);
+	Jsonb *config = JsonbValueToJsonb(result);
+
+	job_id = ts_bgw_job_insert_relation(&application_name,
+										&precreate_chunks_name,
+										default_schedule_interval,
+										DEFAULT_MAX_RUNTIME,
+										DEFAULT_MAX_RETRIES,
+										DEFAULT_RETRY_PERIOD,
+										&proc_schema,
+										&proc_name,
+										&owner,
+										true,
+										hypertable->fd.id,
+										config);
+
+	ts_cache_release(hcache);
+
+	PG_RETURN_INT32(job_id);
+}
+
+Datum
+policy_chunk_precreate_remove(PG_FUNCTION_ARGS)
+{
+	Oid hypertable_oid = PG_GETARG_OID(0);
+	bool if_exists = PG_GETARG_BOOL(1);
+	Hypertable *ht;
+	Cache *hcache;
+
+	TS_PREVENT_FUNC_IF_READ_ONLY();
+
+	ht = ts_hypertable_cache_get_cache_and_entry(hypertable_oid, CACHE_FLAG_NONE, &hcache);
+
+	List *jobs = ts_bgw_job_find_by_proc_and_hypertable_id(POLICY_CHUNK_PRECREATE_PROC_NAME,
+														   INTERNAL_SCHEMA_NAME,
+														   ht->fd.id);
+
+	ts_cache_release(hcache);
+
+	if (jobs == NIL)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("chunk pre-creation policy not found for hypertable \"%s\"",
+							get_rel_name(hypertable_oid))));
+		else
+		{
+			ereport(NOTICE,
+					(errmsg("chunk pre-creation policy not found for hypertable \"%s\", skipping",
+							get_rel_name(hypertable_oid))));
+			PG_RETURN_VOID();
+		}
+	}
+
+	ts_hypertable_permissions_check(hypertable_oid, GetUserId());
+
+	Assert(list_length(jobs) == 1);
+	BgwJob *job = linitial(jobs);
+
+	ts_bgw_job_delete_by_id(job->fd.id);
+
+	PG_RETURN_VOID();
+}
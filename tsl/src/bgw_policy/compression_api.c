@@ -7,6 +7,7 @@
 #include <postgres.h>
 #include <access/xact.h>
 #include <miscadmin.h>
+#include <nodes/parsenodes.h>
 #include <utils/builtins.h>
 
 #include "bgw/job.h"
@@ -89,7 +90,10 @@ policy_compression_proc(PG_FUNCTION_ARGS)
 
 	TS_PREVENT_FUNC_IF_READ_ONLY();
 
-	policy_compression_execute(PG_GETARG_INT32(0), PG_GETARG_JSONB_P(1));
+	policy_compression_execute(PG_GETARG_INT32(0),
+							   PG_GETARG_JSONB_P(1),
+							   fcinfo->context != NULL && IsA(fcinfo->context, CallContext) &&
+								   !castNode(CallContext, fcinfo->context)->atomic);
 
 	PG_RETURN_VOID();
 }
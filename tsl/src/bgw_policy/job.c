@@ -24,6 +24,7 @@
 #include "bgw/timer.h"
 #include "bgw/job.h"
 #include "bgw/job_stat.h"
+#include "bgw_policy/chunk_precreate_api.h"
 #include "bgw_policy/chunk_stats.h"
 #include "bgw_policy/compression_api.h"
 #include "bgw_policy/continuous_aggregate_api.h"
@@ -40,12 +41,14 @@
 #include "errors.h"
 #include "job.h"
 #include "chunk.h"
+#include "guc.h"
 #include "dimension.h"
 #include "dimension_slice.h"
 #include "dimension_vector.h"
 #include "errors.h"
 #include "job.h"
 #include "reorder.h"
+#include "time_utils.h"
 #include "utils.h"
 
 #define REORDER_SKIP_RECENT_DIM_SLICES_N 3
@@ -126,23 +129,44 @@ get_window_boundary(const Dimension *dim, const Jsonb *config, int64 (*int_gette
 	}
 }
 
-static int32
-get_chunk_to_compress(const Dimension *dim, const Jsonb *config)
+static StrategyNumber
+get_compress_end_value(const Dimension *dim, const Jsonb *config, int64 *end_value)
 {
 	Oid partitioning_type = ts_dimension_get_partition_type(dim);
-	StrategyNumber end_strategy = BTLessStrategyNumber;
-
 	Datum boundary = get_window_boundary(dim,
 										 config,
 										 policy_compression_get_compress_after_int,
 										 policy_compression_get_compress_after_interval);
 
+	*end_value = ts_time_value_to_internal(boundary, partitioning_type);
+	return BTLessStrategyNumber;
+}
+
+static int32
+get_chunk_to_compress(const Dimension *dim, const Jsonb *config)
+{
+	int64 end_value;
+	StrategyNumber end_strategy = get_compress_end_value(dim, config, &end_value);
+
 	return ts_dimension_slice_get_chunkid_to_compress(dim->fd.id,
 													  InvalidStrategy, /*start_strategy*/
 													  -1,			   /*start_value*/
 													  end_strategy,
-													  ts_time_value_to_internal(boundary,
-																				partitioning_type));
+													  end_value);
+}
+
+static List *
+get_chunks_to_compress(const Dimension *dim, const Jsonb *config, int limit)
+{
+	int64 end_value;
+	StrategyNumber end_strategy = get_compress_end_value(dim, config, &end_value);
+
+	return ts_dimension_slice_get_chunkids_to_compress(dim->fd.id,
+													   InvalidStrategy, /*start_strategy*/
+													   -1,				/*start_value*/
+													   end_strategy,
+													   end_value,
+													   limit);
 }
 
 static void
@@ -371,8 +395,137 @@ policy_refresh_cagg_read_and_validate_config(Jsonb *config, PolicyContinuousAggD
 	}
 }
 
+static void
+compress_chunk_and_log(int32 chunk_id)
+{
+	Chunk *chunk = ts_chunk_get_by_id(chunk_id, true);
+
+	tsl_compress_chunk_wrapper(chunk, false);
+
+	elog(LOG,
+		 "completed compressing chunk %s.%s",
+		 NameStr(chunk->fd.schema_name),
+		 NameStr(chunk->fd.table_name));
+}
+
+/*
+ * Compress a batch of chunks in parallel, one background worker per chunk.
+ *
+ * The workers lock their chunks and the catalog, and the deadlock detector
+ * cannot see that we wait for them. So we commit our transaction, which
+ * releases our locks and snapshot, before starting the workers. The caller
+ * has to release its caches before and look up everything it needs again
+ * afterwards.
+ *
+ * Chunks for which no worker could be started are compressed by this process
+ * once the workers have finished. The workers report errors only in their own
+ * log, so check afterwards which chunks actually got compressed. A partially
+ * compressed chunk is recompressed into a new compressed chunk, so a worker
+ * failed if the compressed chunk is missing or still the one it started with.
+ */
+static void
+compress_chunks_in_workers(List *chunk_ids)
+{
+	MemoryContext oldcontext = CurrentMemoryContext;
+	List *handles = NIL;
+	List *worker_chunk_ids = NIL;
+	List *prev_compressed_ids = NIL;
+	List *local_chunk_ids = NIL;
+	ListCell *lc;
+	ListCell *lc_prev;
+	int num_failed = 0;
+
+	foreach (lc, chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), true);
+
+		prev_compressed_ids = lappend_int(prev_compressed_ids, chunk->fd.compressed_chunk_id);
+	}
+
+	while (ActiveSnapshotSet())
+		PopActiveSnapshot();
+
+	CommitTransactionCommand();
+	StartTransactionCommand();
+	MemoryContextSwitchTo(oldcontext);
+
+	foreach (lc, chunk_ids)
+	{
+		int32 chunk_id = lfirst_int(lc);
+		BackgroundWorkerHandle *handle = ts_bgw_compress_chunk_worker_start(chunk_id);
+
+		if (handle == NULL)
+			local_chunk_ids = lappend_int(local_chunk_ids, chunk_id);
+		else
+		{
+			handles = lappend(handles, handle);
+			worker_chunk_ids = lappend_int(worker_chunk_ids, chunk_id);
+		}
+	}
+
+	ts_bgw_compress_chunk_workers_wait(handles);
+
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	foreach (lc, local_chunk_ids)
+	{
+		Chunk *chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+
+		/* the chunk might have been dropped or compressed in the meantime */
+		if (chunk != NULL && tsl_compress_chunk_wrapper(chunk, true))
+			elog(LOG,
+				 "completed compressing chunk %s.%s",
+				 NameStr(chunk->fd.schema_name),
+				 NameStr(chunk->fd.table_name));
+	}
+
+	forboth (lc, chunk_ids, lc_prev, prev_compressed_ids)
+	{
+		Chunk *chunk;
+
+		if (!list_member_int(worker_chunk_ids, lfirst_int(lc)))
+			continue;
+
+		chunk = ts_chunk_get_by_id(lfirst_int(lc), false);
+
+		/* the chunk might have been dropped in the meantime */
+		if (chunk == NULL)
+			continue;
+
+		if (chunk->fd.compressed_chunk_id == INVALID_CHUNK_ID ||
+			chunk->fd.compressed_chunk_id == lfirst_int(lc_prev))
+		{
+			elog(WARNING,
+				 "background worker failed to compress chunk %s.%s",
+				 NameStr(chunk->fd.schema_name),
+				 NameStr(chunk->fd.table_name));
+			num_failed++;
+		}
+		else
+			elog(LOG,
+				 "completed compressing chunk %s.%s",
+				 NameStr(chunk->fd.schema_name),
+				 NameStr(chunk->fd.table_name));
+	}
+
+	PopActiveSnapshot();
+
+	if (num_failed > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("failed to compress %d chunks in background workers", num_failed),
+				 errhint("See the server log for the errors of the background workers.")));
+}
+
+/*
+ * Run the compression policy. With timescaledb.compression_policy_workers
+ * set, a batch of chunks is compressed in background workers. This needs to
+ * commit the transaction, so it is only done if the policy runs in a
+ * non-atomic context outside of a transaction block. Otherwise, one chunk is
+ * compressed by this process.
+ */
 bool
-policy_compression_execute(int32 job_id, Jsonb *config)
+policy_compression_execute(int32 job_id, Jsonb *config, bool nonatomic)
 {
 	int32 chunkid;
 	Dimension *dim;
@@ -380,23 +533,36 @@ policy_compression_execute(int32 job_id, Jsonb *config)
 
 	policy_compression_read_and_validate_config(config, &policy_data);
 	dim = hyperspace_get_open_dimension(policy_data.hypertable->space, 0);
-	chunkid = get_chunk_to_compress(dim, config);
 
-	if (chunkid == INVALID_CHUNK_ID)
-		elog(NOTICE,
-			 "no chunks for hypertable %s.%s that satisfy compress chunk policy",
-			 policy_data.hypertable->fd.schema_name.data,
-			 policy_data.hypertable->fd.table_name.data);
-
-	if (chunkid != INVALID_CHUNK_ID)
+	if (ts_guc_compression_policy_workers > 0 && nonatomic && !IsTransactionBlock() &&
+		!IsSubTransaction())
 	{
-		Chunk *chunk = ts_chunk_get_by_id(chunkid, true);
-		tsl_compress_chunk_wrapper(chunk, false);
-
-		elog(LOG,
-			 "completed compressing chunk %s.%s",
-			 NameStr(chunk->fd.schema_name),
-			 NameStr(chunk->fd.table_name));
+		List *chunk_ids = get_chunks_to_compress(dim, config, ts_guc_compression_policy_workers);
+
+		if (chunk_ids == NIL)
+			elog(NOTICE,
+				 "no chunks for hypertable %s.%s that satisfy compress chunk policy",
+				 policy_data.hypertable->fd.schema_name.data,
+				 policy_data.hypertable->fd.table_name.data);
+		else
+		{
+			ts_cache_release(policy_data.hcache);
+			compress_chunks_in_workers(chunk_ids);
+			policy_compression_read_and_validate_config(config, &policy_data);
+			dim = hyperspace_get_open_dimension(policy_data.hypertable->space, 0);
+		}
+	}
+	else
+	{
+		chunkid = get_chunk_to_compress(dim, config);
+
+		if (chunkid == INVALID_CHUNK_ID)
+			elog(NOTICE,
+				 "no chunks for hypertable %s.%s that satisfy compress chunk policy",
+				 policy_data.hypertable->fd.schema_name.data,
+				 policy_data.hypertable->fd.table_name.data);
+		else
+			compress_chunk_and_log(chunkid);
 	}
 
 	chunkid = get_chunk_to_compress(dim, config);
@@ -409,6 +575,22 @@ policy_compression_execute(int32 job_id, Jsonb *config)
 	return true;
 }
 
+/*
+ * Compress a single chunk in a background worker started by
+ * compress_chunks_in_workers().
+ */
+bool
+policy_compression_compress_chunk(int32 chunk_id)
+{
+	Chunk *chunk = ts_chunk_get_by_id(chunk_id, false);
+
+	/* the chunk might have been dropped since the worker was started */
+	if (chunk == NULL)
+		return false;
+
+	return tsl_compress_chunk_wrapper(chunk, true);
+}
+
 /* Read configuration for compression job from config object. */
 void
 policy_compression_read_and_validate_config(Jsonb *config, PolicyCompressionData *policy_data)
@@ -424,6 +606,157 @@ policy_compression_read_and_validate_config(Jsonb *config, PolicyCompressionData
 	}
 }
 
+/*
+ * Get the current time of the hypertable in the internal time representation
+ * of the open dimension.
+ */
+static int64
+get_open_dimension_now_internal(const Dimension *dim)
+{
+	Oid partitioning_type = ts_dimension_get_partition_type(dim);
+
+	if (IS_INTEGER_TYPE(partitioning_type))
+	{
+		Oid now_func = ts_get_integer_now_func(dim);
+
+		if (!OidIsValid(now_func))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("integer_now function not set on hypertable")));
+
+		return subtract_integer_from_now(0, partitioning_type, now_func);
+	}
+	else
+	{
+		Interval zero = { 0 };
+
+		return ts_time_value_to_internal(subtract_interval_from_now(&zero, partitioning_type),
+										 partitioning_type);
+	}
+}
+
+/*
+ * Create the chunks covering the given time for all partitions of the closed
+ * dimensions, unless they already exist. Returns the number of chunks that
+ * were created.
+ */
+static int
+precreate_chunks_at(Hypertable *ht, int64 time)
+{
+	Hyperspace *hs = ht->space;
+	Point *point = palloc0(POINT_SIZE(hs->num_dimensions));
+	int64 num_partitions = 1;
+	int64 partition;
+	int created = 0;
+	int i;
+
+	point->cardinality = hs->num_dimensions;
+	point->num_coords = hs->num_dimensions;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		if (!IS_OPEN_DIMENSION(&hs->dimensions[i]))
+			num_partitions *= hs->dimensions[i].fd.num_slices;
+	}
+
+	/*
+	 * Enumerate the cartesian product of the partitions of all closed
+	 * dimensions, picking the start of each partition's range as coordinate.
+	 */
+	for (partition = 0; partition < num_partitions; partition++)
+	{
+		int64 remaining = partition;
+
+		for (i = 0; i < hs->num_dimensions; i++)
+		{
+			const Dimension *dim = &hs->dimensions[i];
+
+			if (IS_OPEN_DIMENSION(dim))
+				point->coordinates[i] = time;
+			else
+			{
+				int16 num_slices = dim->fd.num_slices;
+
+				point->coordinates[i] =
+					(remaining % num_slices) * (DIMENSION_SLICE_CLOSED_MAX / num_slices);
+				remaining /= num_slices;
+			}
+		}
+
+		if (ts_hypertable_find_chunk_if_exists(ht, point) == NULL)
+		{
+			ts_hypertable_get_or_create_chunk(ht, point);
+			created++;
+		}
+	}
+
+	pfree(point);
+
+	return created;
+}
+
+bool
+policy_chunk_precreate_execute(int32 job_id, Jsonb *config)
+{
+	PolicyChunkPrecreateData policy_data;
+	Dimension *dim;
+	Oid partitioning_type;
+	int64 time;
+	int created = 0;
+	int32 i;
+
+	policy_chunk_precreate_read_and_validate_config(config, &policy_data);
+	dim = hyperspace_get_open_dimension(policy_data.hypertable->space, 0);
+	partitioning_type = ts_dimension_get_partition_type(dim);
+	time = get_open_dimension_now_internal(dim);
+
+	/*
+	 * Make sure the chunk for the current time exists as well as the given
+	 * number of chunks after it, so that inserts crossing into a new chunk
+	 * interval do not have to create the chunk.
+	 */
+	for (i = 0; i <= policy_data.chunks_ahead; i++)
+	{
+		created += precreate_chunks_at(policy_data.hypertable, time);
+
+		if (time >= ts_time_get_end_or_max(partitioning_type) - dim->fd.interval_length)
+			break;
+
+		time = ts_time_saturating_add(time, dim->fd.interval_length, partitioning_type);
+	}
+
+	ts_cache_release(policy_data.hcache);
+
+	elog(DEBUG1, "job %d completed creating %d chunks ahead", job_id, created);
+	return true;
+}
+
+/* Read configuration for chunk pre-creation job from config object. */
+void
+policy_chunk_precreate_read_and_validate_config(Jsonb *config,
+												PolicyChunkPrecreateData *policy_data)
+{
+	Oid table_relid = ts_hypertable_id_to_relid(policy_chunk_precreate_get_hypertable_id(config));
+	int32 chunks_ahead = policy_chunk_precreate_get_chunks_ahead(config);
+	Cache *hcache;
+	Hypertable *hypertable =
+		ts_hypertable_cache_get_cache_and_entry(table_relid, CACHE_FLAG_NONE, &hcache);
+
+	if (chunks_ahead < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for chunks_ahead in config for job")));
+
+	if (policy_data)
+	{
+		policy_data->hypertable = hypertable;
+		policy_data->chunks_ahead = chunks_ahead;
+		policy_data->hcache = hcache;
+	}
+	else
+		ts_cache_release(hcache);
+}
+
 static void
 job_execute_function(FuncExpr *funcexpr)
 {
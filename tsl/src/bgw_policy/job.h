@@ -40,6 +40,13 @@ typedef struct PolicyCompressionData
 	Cache *hcache;
 } PolicyCompressionData;
 
+typedef struct PolicyChunkPrecreateData
+{
+	Hypertable *hypertable;
+	int32 chunks_ahead;
+	Cache *hcache;
+} PolicyChunkPrecreateData;
+
 /* Reorder function type. Necessary for testing */
 typedef void (*reorder_func)(Oid tableOid, Oid indexOid, bool verbose, Oid wait_id,
 							 Oid destination_tablespace, Oid index_tablespace);
@@ -48,7 +55,9 @@ typedef void (*reorder_func)(Oid tableOid, Oid indexOid, bool verbose, Oid wait_
 extern bool policy_reorder_execute(int32 job_id, Jsonb *config);
 extern bool policy_retention_execute(int32 job_id, Jsonb *config);
 extern bool policy_refresh_cagg_execute(int32 job_id, Jsonb *config);
-extern bool policy_compression_execute(int32 job_id, Jsonb *config);
+extern bool policy_compression_execute(int32 job_id, Jsonb *config, bool nonatomic);
+extern bool policy_compression_compress_chunk(int32 chunk_id);
+extern bool policy_chunk_precreate_execute(int32 job_id, Jsonb *config);
 extern void policy_reorder_read_and_validate_config(Jsonb *config, PolicyReorderData *policy_data);
 extern void policy_retention_read_and_validate_config(Jsonb *config,
 													  PolicyRetentionData *policy_data);
@@ -56,6 +65,8 @@ extern void policy_refresh_cagg_read_and_validate_config(Jsonb *config,
 														 PolicyContinuousAggData *policy_data);
 extern void policy_compression_read_and_validate_config(Jsonb *config,
 														PolicyCompressionData *policy_data);
+extern void policy_chunk_precreate_read_and_validate_config(Jsonb *config,
+															PolicyChunkPrecreateData *policy_data);
 extern bool job_execute(BgwJob *job);
 
 #endif /* TIMESCALEDB_TSL_BGW_POLICY_JOB_H */
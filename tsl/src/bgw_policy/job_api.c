@@ -46,6 +46,8 @@ job_config_check(Name proc_schema, Name proc_name, Jsonb *config)
 		}
 		else if (namestrcmp(proc_name, "policy_refresh_continuous_aggregate") == 0)
 			policy_refresh_cagg_read_and_validate_config(config, NULL);
+		else if (namestrcmp(proc_name, "policy_chunk_precreate") == 0)
+			policy_chunk_precreate_read_and_validate_config(config, NULL);
 	}
 }
 
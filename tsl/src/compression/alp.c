@@ -0,0 +1,657 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include "compression/alp.h"
+
+#include <catalog/pg_type.h>
+#include <libpq/pqformat.h>
+
+#include <math.h>
+
+#include <adts/uint64_vec.h>
+
+#include "compression/compression.h"
+#include "compression/for.h"
+#include "compression/gorilla.h"
+#include "compression/utils.h"
+
+/* 10^18 is the largest power of ten we use, all of them are exact doubles */
+#define ALP_MAX_EXPONENT 18
+
+/* integers up to 2^53 are exact doubles, so we never encode anything larger */
+#define ALP_MAX_ENCODED ((double) (INT64CONST(1) << 53))
+
+/*
+ * Fall back to gorilla if more than 1 in ALP_MAX_EXCEPTION_RATIO values are
+ * exceptions; every exception costs 12 bytes on top of its encoded integer.
+ */
+#define ALP_MAX_EXCEPTION_RATIO 4
+
+static const double alp_exp10[ALP_MAX_EXPONENT + 1] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18,
+};
+
+/*
+ * The compressed data is followed by the exception values (uint64), the rows
+ * of the exceptions (uint32, padded to 8 bytes), and finally the encoded
+ * integers as a frame-of-reference compressed value, which also stores the
+ * NULLs.
+ */
+typedef struct AlpCompressed
+{
+	CompressedDataHeaderFields;
+	uint8 exponent;
+	uint8 padding[2];
+	uint32 num_rows;
+	uint32 num_exceptions;
+} AlpCompressed;
+
+static void
+pg_attribute_unused() assertions(void)
+{
+	AlpCompressed test_val = { { 0 } };
+	/* make sure no padding bytes make it to disk */
+	StaticAssertStmt(sizeof(AlpCompressed) ==
+						 sizeof(test_val.vl_len_) + sizeof(test_val.compression_algorithm) +
+							 sizeof(test_val.exponent) + sizeof(test_val.padding) +
+							 sizeof(test_val.num_rows) + sizeof(test_val.num_exceptions),
+					 "AlpCompressed wrong size");
+	StaticAssertStmt(sizeof(AlpCompressed) == 16, "AlpCompressed wrong size");
+}
+
+typedef struct AlpDecompressionIterator
+{
+	DecompressionIterator base;
+	DecompressionIterator *encoded;
+	const uint64 *exception_values;
+	const uint32 *exception_rows;
+	uint32 num_exceptions;
+	int64 next_exception;
+	int64 row;
+	uint8 exponent;
+} AlpDecompressionIterator;
+
+typedef struct AlpCompressor
+{
+	bool is_float4;
+	/* the bits of all values, 0 for NULLs */
+	uint64_vec values;
+	/* the rows that are NULL, in increasing order */
+	uint64_vec null_rows;
+} AlpCompressor;
+
+typedef struct ExtendedCompressor
+{
+	Compressor base;
+	AlpCompressor *internal;
+	Oid element_type;
+} ExtendedCompressor;
+
+static inline uint64
+alp_decode(int64 encoded, uint8 exponent, bool is_float4)
+{
+	double value = (double) encoded / alp_exp10[exponent];
+
+	if (is_float4)
+		return float_get_bits((float) value);
+
+	return double_get_bits(value);
+}
+
+/*
+ * Try to encode a value as an integer with the given exponent. The decoded
+ * integer must have exactly the same bits as the value, which also rules out
+ * NaN, infinity and -0.0.
+ */
+static inline bool
+alp_encode(uint64 bits, uint8 exponent, bool is_float4, int64 *encoded)
+{
+	double value = is_float4 ? bits_get_float((uint32) bits) : bits_get_double(bits);
+	double scaled = value * alp_exp10[exponent];
+	int64 n;
+
+	if (!(scaled > -ALP_MAX_ENCODED && scaled < ALP_MAX_ENCODED))
+		return false;
+
+	n = (int64) rint(scaled);
+	if (alp_decode(n, exponent, is_float4) != bits)
+		return false;
+
+	*encoded = n;
+	return true;
+}
+
+static void
+alp_compressor_append_float(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = alp_compressor_alloc(extended->element_type);
+
+	alp_compressor_append_value(extended->internal, float_get_bits(DatumGetFloat4(val)));
+}
+
+static void
+alp_compressor_append_double(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = alp_compressor_alloc(extended->element_type);
+
+	alp_compressor_append_value(extended->internal, double_get_bits(DatumGetFloat8(val)));
+}
+
+static void
+alp_compressor_append_null_value(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = alp_compressor_alloc(extended->element_type);
+
+	alp_compressor_append_null(extended->internal);
+}
+
+static void *
+alp_compressor_finish_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	void *compressed;
+
+	if (extended->internal == NULL)
+		return NULL;
+
+	compressed = alp_compressor_finish(extended->internal);
+	pfree(extended->internal);
+	extended->internal = NULL;
+	return compressed;
+}
+
+const Compressor alp_float_compressor = {
+	.append_val = alp_compressor_append_float,
+	.append_null = alp_compressor_append_null_value,
+	.finish = alp_compressor_finish_and_reset,
+};
+
+const Compressor alp_double_compressor = {
+	.append_val = alp_compressor_append_double,
+	.append_null = alp_compressor_append_null_value,
+	.finish = alp_compressor_finish_and_reset,
+};
+
+Compressor *
+alp_compressor_for_type(Oid element_type)
+{
+	ExtendedCompressor *compressor = palloc(sizeof(*compressor));
+	switch (element_type)
+	{
+		case FLOAT4OID:
+			*compressor = (ExtendedCompressor){ .base = alp_float_compressor,
+												.element_type = element_type };
+			return &compressor->base;
+		case FLOAT8OID:
+			*compressor = (ExtendedCompressor){ .base = alp_double_compressor,
+												.element_type = element_type };
+			return &compressor->base;
+		default:
+			elog(ERROR, "invalid type for ALP compressor %d", element_type);
+	}
+
+	pg_unreachable();
+}
+
+AlpCompressor *
+alp_compressor_alloc(Oid element_type)
+{
+	AlpCompressor *compressor = palloc0(sizeof(*compressor));
+
+	if (element_type != FLOAT4OID && element_type != FLOAT8OID)
+		elog(ERROR, "invalid type for ALP compressor %d", element_type);
+
+	compressor->is_float4 = element_type == FLOAT4OID;
+	uint64_vec_init(&compressor->values, CurrentMemoryContext, 0);
+	uint64_vec_init(&compressor->null_rows, CurrentMemoryContext, 0);
+	return compressor;
+}
+
+void
+alp_compressor_append_null(AlpCompressor *compressor)
+{
+	uint64_vec_append(&compressor->null_rows, compressor->values.num_elements);
+	uint64_vec_append(&compressor->values, 0);
+}
+
+void
+alp_compressor_append_value(AlpCompressor *compressor, uint64 val)
+{
+	/* the exponent depends on all values, so buffer them */
+	uint64_vec_append(&compressor->values, val);
+}
+
+static inline bool
+alp_compressor_row_is_null(AlpCompressor *compressor, uint32 row, uint32 *next_null)
+{
+	if (*next_null < compressor->null_rows.num_elements &&
+		*uint64_vec_get(&compressor->null_rows, *next_null) == row)
+	{
+		(*next_null)++;
+		return true;
+	}
+
+	return false;
+}
+
+/* count the values that cannot be encoded with the given exponent */
+static uint32
+alp_count_exceptions(AlpCompressor *compressor, uint8 exponent, uint32 max_exceptions)
+{
+	uint32 num_exceptions = 0;
+	uint32 next_null = 0;
+	uint32 row;
+	int64 encoded;
+
+	for (row = 0; row < compressor->values.num_elements && num_exceptions <= max_exceptions; row++)
+	{
+		if (alp_compressor_row_is_null(compressor, row, &next_null))
+			continue;
+
+		if (!alp_encode(*uint64_vec_get(&compressor->values, row),
+						exponent,
+						compressor->is_float4,
+						&encoded))
+			num_exceptions++;
+	}
+
+	return num_exceptions;
+}
+
+static void *
+alp_compressor_finish_gorilla(AlpCompressor *compressor)
+{
+	GorillaCompressor *gorilla = gorilla_compressor_alloc();
+	uint32 next_null = 0;
+	uint32 row;
+
+	for (row = 0; row < compressor->values.num_elements; row++)
+	{
+		if (alp_compressor_row_is_null(compressor, row, &next_null))
+			gorilla_compressor_append_null(gorilla);
+		else
+			gorilla_compressor_append_value(gorilla, *uint64_vec_get(&compressor->values, row));
+	}
+
+	return gorilla_compressor_finish(gorilla);
+}
+
+void *
+alp_compressor_finish(AlpCompressor *compressor)
+{
+	uint32 num_rows = compressor->values.num_elements;
+	uint32 num_values = num_rows - compressor->null_rows.num_elements;
+	uint32 max_exceptions = num_values / ALP_MAX_EXCEPTION_RATIO;
+	uint32 num_exceptions = PG_UINT32_MAX;
+	uint8 exponent = 0;
+	uint8 e;
+	ForCompressor *for_compressor;
+	ForCompressed *encoded;
+	uint64 *exception_values;
+	uint32 *exception_rows;
+	uint32 exception_index = 0;
+	Size exceptions_size;
+	Size compressed_size;
+	AlpCompressed *compressed;
+	int64 placeholder = 0;
+	uint32 next_null = 0;
+	uint32 row;
+
+	if (num_values == 0)
+		return NULL;
+
+	/* the smallest exponent with the fewest exceptions keeps the integers small */
+	for (e = 0; e <= ALP_MAX_EXPONENT && num_exceptions > 0; e++)
+	{
+		uint32 exceptions = alp_count_exceptions(compressor, e, Min(num_exceptions, num_values));
+
+		if (exceptions < num_exceptions)
+		{
+			num_exceptions = exceptions;
+			exponent = e;
+		}
+	}
+
+	if (num_exceptions > max_exceptions)
+		return alp_compressor_finish_gorilla(compressor);
+
+	exceptions_size = sizeof(uint64) * num_exceptions + MAXALIGN(sizeof(uint32) * num_exceptions);
+	exception_values = palloc0(Max(exceptions_size, 1));
+	exception_rows = (uint32 *) (exception_values + num_exceptions);
+
+	/*
+	 * Exceptions still need an entry among the integers, which should not
+	 * widen their range, so repeat the previous encoded value.
+	 */
+	for_compressor = for_compressor_alloc();
+	for (row = 0; row < num_rows; row++)
+	{
+		uint64 bits = *uint64_vec_get(&compressor->values, row);
+		int64 value;
+
+		if (alp_compressor_row_is_null(compressor, row, &next_null))
+		{
+			for_compressor_append_null(for_compressor);
+			continue;
+		}
+
+		if (alp_encode(bits, exponent, compressor->is_float4, &value))
+			placeholder = value;
+		else
+		{
+			Assert(exception_index < num_exceptions);
+			exception_values[exception_index] = bits;
+			exception_rows[exception_index] = row;
+			exception_index++;
+			value = placeholder;
+		}
+
+		for_compressor_append_value(for_compressor, value);
+	}
+
+	Assert(exception_index == num_exceptions);
+	encoded = for_compressor_finish(for_compressor);
+	Assert(encoded != NULL);
+
+	compressed_size = sizeof(AlpCompressed) + exceptions_size + VARSIZE(encoded);
+
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	compressed = palloc0(compressed_size);
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_ALP;
+	compressed->exponent = exponent;
+	compressed->num_rows = num_rows;
+	compressed->num_exceptions = num_exceptions;
+
+	memcpy(((char *) compressed) + sizeof(AlpCompressed), exception_values, exceptions_size);
+	memcpy(((char *) compressed) + sizeof(AlpCompressed) + exceptions_size,
+		   encoded,
+		   VARSIZE(encoded));
+
+	pfree(exception_values);
+	pfree(encoded);
+
+	return compressed;
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+static inline const uint64 *
+alp_compressed_exception_values(const AlpCompressed *compressed)
+{
+	return (const uint64 *) (((const char *) compressed) + sizeof(AlpCompressed));
+}
+
+static inline const uint32 *
+alp_compressed_exception_rows(const AlpCompressed *compressed)
+{
+	return (const uint32 *) (alp_compressed_exception_values(compressed) +
+							 compressed->num_exceptions);
+}
+
+static inline ForCompressed *
+alp_compressed_encoded(const AlpCompressed *compressed)
+{
+	return (ForCompressed *) (((const char *) compressed) + sizeof(AlpCompressed) +
+							  sizeof(uint64) * compressed->num_exceptions +
+							  MAXALIGN(sizeof(uint32) * compressed->num_exceptions));
+}
+
+static void
+alp_decompression_iterator_init(AlpDecompressionIterator *iter, AlpCompressed *compressed,
+								Oid element_type, bool forward)
+{
+	Datum encoded = PointerGetDatum(alp_compressed_encoded(compressed));
+
+	if (element_type != FLOAT4OID && element_type != FLOAT8OID)
+		elog(ERROR, "invalid type requested from ALP decompression %d", element_type);
+
+	*iter = (AlpDecompressionIterator){
+		.base = {
+			.compression_algorithm = COMPRESSION_ALGORITHM_ALP,
+			.forward = forward,
+			.element_type = element_type,
+			.try_next = forward ? alp_decompression_iterator_try_next_forward :
+								  alp_decompression_iterator_try_next_reverse,
+		},
+		.encoded = forward ? for_decompression_iterator_from_datum_forward(encoded, INT8OID) :
+							 for_decompression_iterator_from_datum_reverse(encoded, INT8OID),
+		.exception_values = alp_compressed_exception_values(compressed),
+		.exception_rows = alp_compressed_exception_rows(compressed),
+		.num_exceptions = compressed->num_exceptions,
+		.next_exception = forward ? 0 : (int64) compressed->num_exceptions - 1,
+		.row = forward ? 0 : (int64) compressed->num_rows - 1,
+		.exponent = compressed->exponent,
+	};
+}
+
+static DecompressResult
+alp_decompression_iterator_try_next(AlpDecompressionIterator *iter)
+{
+	DecompressResult encoded = iter->encoded->try_next(iter->encoded);
+	bool is_float4 = iter->base.element_type == FLOAT4OID;
+	int64 row = iter->row;
+	uint64 bits;
+
+	if (encoded.is_done)
+		return encoded;
+
+	iter->row += iter->base.forward ? 1 : -1;
+
+	if (encoded.is_null)
+		return encoded;
+
+	if (iter->next_exception >= 0 && iter->next_exception < iter->num_exceptions &&
+		iter->exception_rows[iter->next_exception] == row)
+	{
+		bits = iter->exception_values[iter->next_exception];
+		iter->next_exception += iter->base.forward ? 1 : -1;
+	}
+	else
+		bits = alp_decode(DatumGetInt64(encoded.val), iter->exponent, is_float4);
+
+	return (DecompressResult){
+		.val = is_float4 ? Float4GetDatum(bits_get_float((uint32) bits)) :
+						   Float8GetDatum(bits_get_double(bits)),
+	};
+}
+
+DecompressResult
+alp_decompression_iterator_try_next_forward(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_ALP && iter->forward);
+	return alp_decompression_iterator_try_next((AlpDecompressionIterator *) iter);
+}
+
+DecompressResult
+alp_decompression_iterator_try_next_reverse(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_ALP && !iter->forward);
+	return alp_decompression_iterator_try_next((AlpDecompressionIterator *) iter);
+}
+
+DecompressionIterator *
+alp_decompression_iterator_from_datum_forward(Datum alp_compressed, Oid element_type)
+{
+	AlpDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	alp_decompression_iterator_init(iterator,
+									(void *) PG_DETOAST_DATUM(alp_compressed),
+									element_type,
+									true);
+	return &iterator->base;
+}
+
+DecompressionIterator *
+alp_decompression_iterator_from_datum_reverse(Datum alp_compressed, Oid element_type)
+{
+	AlpDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	alp_decompression_iterator_init(iterator,
+									(void *) PG_DETOAST_DATUM(alp_compressed),
+									element_type,
+									false);
+	return &iterator->base;
+}
+
+/*
+ * Bulk decompression of a whole ALP value. The integers are unpacked with the
+ * frame-of-reference bulk decompression, converted to floats in a single
+ * vectorizable pass, and then the exceptions are patched in. The NULL bitmap
+ * of the integers is reused as is.
+ */
+DecompressAllResult *
+alp_decompress_all(Datum compressed_datum, Oid element_type)
+{
+	AlpCompressed *compressed = (AlpCompressed *) PG_DETOAST_DATUM(compressed_datum);
+	const uint64 *exception_values = alp_compressed_exception_values(compressed);
+	const uint32 *exception_rows = alp_compressed_exception_rows(compressed);
+	DecompressAllResult *encoded =
+		for_decompress_all(PointerGetDatum(alp_compressed_encoded(compressed)), INT8OID);
+	const int64 *integers = encoded->values;
+	double divisor = alp_exp10[compressed->exponent];
+	DecompressAllResult *result;
+	int32 num_rows = encoded->num_values;
+	int32 row;
+	uint32 i;
+
+	if (num_rows != (int32) compressed->num_rows)
+		elog(ERROR, "ALP compressed data has the wrong number of rows");
+
+	result = decompress_all_result_create(element_type, num_rows, false);
+	result->validity = encoded->validity;
+
+	switch (element_type)
+	{
+		case FLOAT8OID:
+		{
+			float8 *values = result->values;
+
+			for (row = 0; row < num_rows; row++)
+				values[row] = (double) integers[row] / divisor;
+			for (i = 0; i < compressed->num_exceptions; i++)
+			{
+				if (exception_rows[i] >= (uint32) num_rows)
+					elog(ERROR, "ALP compressed data has an invalid exception");
+				values[exception_rows[i]] = bits_get_double(exception_values[i]);
+			}
+			break;
+		}
+		case FLOAT4OID:
+		{
+			float4 *values = result->values;
+
+			for (row = 0; row < num_rows; row++)
+				values[row] = (float4) ((double) integers[row] / divisor);
+			for (i = 0; i < compressed->num_exceptions; i++)
+			{
+				if (exception_rows[i] >= (uint32) num_rows)
+					elog(ERROR, "ALP compressed data has an invalid exception");
+				values[exception_rows[i]] = bits_get_float((uint32) exception_values[i]);
+			}
+			break;
+		}
+		default:
+			elog(ERROR, "invalid type requested from ALP decompression %d", element_type);
+	}
+
+	pfree(encoded->values);
+	pfree(encoded);
+
+	return result;
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+void
+alp_compressed_send(CompressedDataHeader *header, StringInfo buffer)
+{
+	const AlpCompressed *data = (AlpCompressed *) header;
+	const uint64 *exception_values = alp_compressed_exception_values(data);
+	const uint32 *exception_rows = alp_compressed_exception_rows(data);
+	uint32 i;
+
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_ALP);
+	pq_sendbyte(buffer, data->exponent);
+	pq_sendint32(buffer, data->num_rows);
+	pq_sendint32(buffer, data->num_exceptions);
+	for (i = 0; i < data->num_exceptions; i++)
+	{
+		pq_sendint64(buffer, exception_values[i]);
+		pq_sendint32(buffer, exception_rows[i]);
+	}
+	for_compressed_send((CompressedDataHeader *) alp_compressed_encoded(data), buffer);
+}
+
+Datum
+alp_compressed_recv(StringInfo buffer)
+{
+	uint8 exponent;
+	uint32 num_rows;
+	uint32 num_exceptions;
+	Size exceptions_size;
+	Size compressed_size;
+	uint64 *exception_values;
+	uint32 *exception_rows;
+	ForCompressed *encoded;
+	AlpCompressed *compressed;
+	uint32 i;
+
+	exponent = pq_getmsgbyte(buffer);
+	if (exponent > ALP_MAX_EXPONENT)
+		elog(ERROR, "invalid recv in ALP: bad exponent");
+
+	num_rows = pq_getmsgint(buffer, 4);
+	num_exceptions = pq_getmsgint(buffer, 4);
+	if (num_exceptions > num_rows)
+		elog(ERROR, "invalid recv in ALP: too many exceptions");
+	if (num_exceptions > (buffer->len - buffer->cursor) / (sizeof(uint64) + sizeof(uint32)))
+		elog(ERROR, "invalid recv in ALP: too many exceptions");
+
+	exceptions_size = sizeof(uint64) * num_exceptions + MAXALIGN(sizeof(uint32) * num_exceptions);
+	exception_values = palloc0(Max(exceptions_size, 1));
+	exception_rows = (uint32 *) (exception_values + num_exceptions);
+	for (i = 0; i < num_exceptions; i++)
+	{
+		exception_values[i] = pq_getmsgint64(buffer);
+		exception_rows[i] = pq_getmsgint(buffer, 4);
+		if (exception_rows[i] >= num_rows || (i > 0 && exception_rows[i] <= exception_rows[i - 1]))
+			elog(ERROR, "invalid recv in ALP: bad exception row");
+	}
+
+	/* the encoded integers are sent without the algorithm, as a nested value */
+	encoded = (ForCompressed *) DatumGetPointer(for_compressed_recv(buffer));
+
+	compressed_size = sizeof(AlpCompressed) + exceptions_size + VARSIZE(encoded);
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	compressed = palloc0(compressed_size);
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_ALP;
+	compressed->exponent = exponent;
+	compressed->num_rows = num_rows;
+	compressed->num_exceptions = num_exceptions;
+	memcpy(((char *) compressed) + sizeof(AlpCompressed), exception_values, exceptions_size);
+	memcpy(((char *) compressed) + sizeof(AlpCompressed) + exceptions_size,
+		   encoded,
+		   VARSIZE(encoded));
+
+	PG_RETURN_POINTER(compressed);
+}
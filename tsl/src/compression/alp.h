@@ -0,0 +1,68 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+/*
+ * ALP compresses floats that originate from decimals, e.g. sensor readings with two decimal
+ * places, and is modeled after the paper "ALP: Adaptive Lossless floating-Point Compression" by
+ * Azim Afroozeh et al.
+ *
+ * How it works: such a float is the closest float to n / 10^e for some integer n and a small
+ * exponent e. For every compressed value we pick the exponent e that encodes the most values of
+ * the series exactly, and store the series of integers n = round(value * 10^e) using
+ * frame-of-reference bit-packing, which only needs as many bits as the range of the series.
+ *
+ * A value is only encoded if decoding the integer gives back exactly the same bits, so e.g.
+ * NaN, infinity, -0.0 or values with too many decimal places never lose precision: they are
+ * stored unencoded as exceptions, together with their row. If there are too many exceptions the
+ * data is not decimal-derived and the compressor falls back to the xor encoding of gorilla
+ * instead, so the result can be either an ALP or a gorilla compressed value.
+ *
+ * Decompression is a division of the unpacked integers by 10^e, which the compiler vectorizes,
+ * followed by patching in the exceptions.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_ALP_H
+#define TIMESCALEDB_TSL_COMPRESSION_ALP_H
+
+#include <postgres.h>
+#include <c.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+
+#include "compression/compression.h"
+
+typedef struct AlpCompressor AlpCompressor;
+typedef struct AlpCompressed AlpCompressed;
+typedef struct AlpDecompressionIterator AlpDecompressionIterator;
+
+extern Compressor *alp_compressor_for_type(Oid element_type);
+extern AlpCompressor *alp_compressor_alloc(Oid element_type);
+extern void alp_compressor_append_null(AlpCompressor *compressor);
+extern void alp_compressor_append_value(AlpCompressor *compressor, uint64 val);
+extern void *alp_compressor_finish(AlpCompressor *compressor);
+
+extern DecompressionIterator *alp_decompression_iterator_from_datum_forward(Datum alp_compressed,
+																			  Oid element_type);
+extern DecompressionIterator *alp_decompression_iterator_from_datum_reverse(Datum alp_compressed,
+																			  Oid element_type);
+extern DecompressResult alp_decompression_iterator_try_next_forward(DecompressionIterator *iter);
+extern DecompressResult alp_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
+
+extern DecompressAllResult *alp_decompress_all(Datum compressed, Oid element_type);
+
+extern void alp_compressed_send(CompressedDataHeader *header, StringInfo buffer);
+extern Datum alp_compressed_recv(StringInfo buf);
+
+#define ALP_ALGORITHM_DEFINITION                                                                   \
+	{                                                                                              \
+		.iterator_init_forward = alp_decompression_iterator_from_datum_forward,                    \
+		.iterator_init_reverse = alp_decompression_iterator_from_datum_reverse,                    \
+		.compressed_data_send = alp_compressed_send,                                               \
+		.compressed_data_recv = alp_compressed_recv,                                               \
+		.compressor_for_type = alp_compressor_for_type,                                            \
+		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+		.decompress_all = alp_decompress_all,                                                      \
+	}
+
+#endif
@@ -8,6 +8,7 @@
  *  compress and decompress chunks
  */
 #include <postgres.h>
+#include <access/htup_details.h>
 #include <access/xact.h>
 #include <catalog/dependency.h>
 #include <commands/tablecmds.h>
@@ -16,11 +17,15 @@
 #include <nodes/makefuncs.h>
 #include <nodes/pg_list.h>
 #include <nodes/parsenodes.h>
+#include <storage/bufmgr.h>
 #include <storage/lmgr.h>
 #include <trigger.h>
 #include <utils/builtins.h>
 #include <utils/elog.h>
 #include <utils/fmgrprotos.h>
+#include <utils/inval.h>
+#include <utils/jsonb.h>
+#include <utils/snapmgr.h>
 #include <libpq-fe.h>
 
 #include <remote/dist_commands.h>
@@ -34,6 +39,7 @@
 #include "create.h"
 #include "compress_utils.h"
 #include "compression.h"
+#include "segment_filter.h"
 #include "compat.h"
 #include "scanner.h"
 #include "scan_iterator.h"
@@ -124,6 +130,76 @@ compression_chunk_size_catalog_insert(int32 src_chunk_id, ChunkSize *src_size,
 	table_close(rel, RowExclusiveLock);
 }
 
+/*
+ * Update the compression stats of a chunk after a partial decompression moved
+ * some of its batches back into the uncompressed chunk. The uncompressed
+ * sizes describe the chunk at compression time and are kept as is.
+ */
+static void
+compression_chunk_size_catalog_update_decompressed(int32 src_chunk_id, ChunkSize *compress_size,
+												   CompressionStats *decompressed)
+{
+	ScanIterator iterator =
+		ts_scan_iterator_create(COMPRESSION_CHUNK_SIZE, RowExclusiveLock, CurrentMemoryContext);
+	CatalogSecurityContext sec_ctx;
+
+	iterator.ctx.index =
+		catalog_get_index(ts_catalog_get(), COMPRESSION_CHUNK_SIZE, COMPRESSION_CHUNK_SIZE_PKEY);
+	ts_scan_iterator_scan_key_init(&iterator,
+								   Anum_compression_chunk_size_pkey_chunk_id,
+								   BTEqualStrategyNumber,
+								   F_INT4EQ,
+								   Int32GetDatum(src_chunk_id));
+
+	ts_scanner_foreach(&iterator)
+	{
+		TupleInfo *ti = ts_scan_iterator_tuple_info(&iterator);
+		Datum values[Natts_compression_chunk_size];
+		bool nulls[Natts_compression_chunk_size];
+		bool repl[Natts_compression_chunk_size] = { false };
+		bool should_free;
+		HeapTuple tuple = ts_scan_iterator_fetch_heap_tuple(&iterator, false, &should_free);
+		TupleDesc tupdesc = ts_scan_iterator_tupledesc(&iterator);
+		HeapTuple new_tuple;
+		int off;
+
+		heap_deform_tuple(tuple, tupdesc, values, nulls);
+
+		values[AttrNumberGetAttrOffset(Anum_compression_chunk_size_compressed_heap_size)] =
+			Int64GetDatum(compress_size->heap_size);
+		values[AttrNumberGetAttrOffset(Anum_compression_chunk_size_compressed_toast_size)] =
+			Int64GetDatum(compress_size->toast_size);
+		values[AttrNumberGetAttrOffset(Anum_compression_chunk_size_compressed_index_size)] =
+			Int64GetDatum(compress_size->index_size);
+
+		off = AttrNumberGetAttrOffset(Anum_compression_chunk_size_numrows_pre_compression);
+		if (!nulls[off])
+			values[off] =
+				Int64GetDatum(DatumGetInt64(values[off]) - decompressed->rowcnt_pre_compression);
+		off = AttrNumberGetAttrOffset(Anum_compression_chunk_size_numrows_post_compression);
+		if (!nulls[off])
+			values[off] =
+				Int64GetDatum(DatumGetInt64(values[off]) - decompressed->rowcnt_post_compression);
+
+		repl[AttrNumberGetAttrOffset(Anum_compression_chunk_size_compressed_heap_size)] = true;
+		repl[AttrNumberGetAttrOffset(Anum_compression_chunk_size_compressed_toast_size)] = true;
+		repl[AttrNumberGetAttrOffset(Anum_compression_chunk_size_compressed_index_size)] = true;
+		repl[AttrNumberGetAttrOffset(Anum_compression_chunk_size_numrows_pre_compression)] = true;
+		repl[AttrNumberGetAttrOffset(Anum_compression_chunk_size_numrows_post_compression)] = true;
+
+		new_tuple = heap_modify_tuple(tuple, tupdesc, values, nulls, repl);
+
+		ts_catalog_database_info_become_owner(ts_catalog_database_info_get(), &sec_ctx);
+		ts_catalog_update(ti->scanrel, new_tuple);
+		ts_catalog_restore_user(&sec_ctx);
+		heap_freetuple(new_tuple);
+
+		if (should_free)
+			heap_freetuple(tuple);
+	}
+	ts_scan_iterator_close(&iterator);
+}
+
 static void
 chunk_dml_blocker_trigger_add(Oid relid)
 {
@@ -350,7 +426,7 @@ compress_chunk_impl(Oid hypertable_relid, Oid chunk_relid)
 
 static bool
 decompress_chunk_impl(Oid uncompressed_hypertable_relid, Oid uncompressed_chunk_relid,
-					  bool if_compressed)
+					  bool if_compressed, Jsonb *segment_filter)
 {
 	Cache *hcache;
 	Hypertable *uncompressed_hypertable =
@@ -398,8 +474,42 @@ decompress_chunk_impl(Oid uncompressed_hypertable_relid, Oid uncompressed_chunk_
 					AccessShareLock);
 	LockRelationOid(catalog_get_table_id(ts_catalog_get(), CHUNK), RowExclusiveLock);
 
+	/*
+	 * With a segment filter, only the matching batches are moved back into
+	 * the uncompressed chunk and the chunk stays compressed; queries read
+	 * both parts. Once no batches are left, finish the decompression as
+	 * usual.
+	 */
+	if (segment_filter != NULL)
+	{
+		SegmentFilter *filter =
+			segment_filter_create(compressed_chunk->table_id,
+								  ts_hypertable_compression_get(uncompressed_hypertable->fd.id));
+		CompressionStats decompressed;
+		int64 batches_left;
+
+		segment_filter_add_jsonb(filter, segment_filter);
+		batches_left = decompress_chunk_segments(compressed_chunk->table_id,
+												 uncompressed_chunk->table_id,
+												 filter,
+												 &decompressed);
+		if (batches_left > 0)
+		{
+			ChunkSize compress_size = compute_chunk_size(compressed_chunk->table_id);
+
+			compression_chunk_size_catalog_update_decompressed(uncompressed_chunk->fd.id,
+															   &compress_size,
+															   &decompressed);
+			/* cached plans only scan the compressed chunk, so force a replan */
+			CacheInvalidateRelcacheByRelid(uncompressed_chunk->table_id);
+			ts_cache_release(hcache);
+			return true;
+		}
+	}
+	else
+		decompress_chunk(compressed_chunk->table_id, uncompressed_chunk->table_id);
+
 	chunk_dml_trigger_drop(uncompressed_chunk->table_id);
-	decompress_chunk(compressed_chunk->table_id, uncompressed_chunk->table_id);
 	/* Recreate FK constraints, since they were dropped during compression. */
 	ts_chunk_create_fks(uncompressed_chunk);
 	ts_compression_chunk_size_delete(uncompressed_chunk->fd.id);
@@ -412,11 +522,43 @@ decompress_chunk_impl(Oid uncompressed_hypertable_relid, Oid uncompressed_chunk_
 	return true;
 }
 
+/*
+ * Check if some batches of a compressed chunk have been moved back into the
+ * uncompressed chunk by a partial decompression. The uncompressed chunk is
+ * truncated on compression, so it only has visible rows in that case. Empty
+ * pages left behind once those rows are deleted do not count. The caller
+ * must hold a lock on the chunk.
+ */
+bool
+tsl_compressed_chunk_is_partial(const Chunk *chunk)
+{
+	Assert(chunk->fd.compressed_chunk_id != INVALID_CHUNK_ID);
+
+	return ts_chunk_has_uncompressed_rows(chunk->table_id,
+										  ActiveSnapshotSet() ? GetActiveSnapshot() :
+																GetTransactionSnapshot());
+}
+
+/*
+ * Compress the chunk. A partially decompressed chunk is decompressed fully
+ * and compressed again so that all its rows end up in the compressed chunk.
+ */
 bool
 tsl_compress_chunk_wrapper(Chunk *chunk, bool if_not_compressed)
 {
 	if (chunk->fd.compressed_chunk_id != INVALID_CHUNK_ID)
 	{
+		/* keep concurrent writers out between the check and the recompression */
+		LockRelationOid(chunk->table_id, ShareLock);
+
+		if (ts_chunk_has_uncompressed_rows(chunk->table_id, GetLatestSnapshot()))
+		{
+			decompress_chunk_impl(chunk->hypertable_relid, chunk->table_id, false, NULL);
+			CommandCounterIncrement();
+			compress_chunk_impl(chunk->hypertable_relid, chunk->table_id);
+			return true;
+		}
+
 		ereport((if_not_compressed ? NOTICE : ERROR),
 				(errcode(ERRCODE_DUPLICATE_OBJECT),
 				 errmsg("chunk \"%s\" is already compressed", get_rel_name(chunk->table_id))));
@@ -521,7 +663,14 @@ tsl_decompress_chunk(PG_FUNCTION_ARGS)
 {
 	Oid uncompressed_chunk_id = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
 	bool if_compressed = PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1);
-	Chunk *uncompressed_chunk = ts_chunk_get_by_relid(uncompressed_chunk_id, true);
+	Jsonb *segment_filter = PG_NARGS() < 3 || PG_ARGISNULL(2) ? NULL : PG_GETARG_JSONB_P(2);
+	Chunk *uncompressed_chunk;
+
+	/* the function is not strict because of the optional segment filter */
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	uncompressed_chunk = ts_chunk_get_by_relid(uncompressed_chunk_id, true);
 
 	if (NULL == uncompressed_chunk)
 		elog(ERROR, "unknown chunk id %d", uncompressed_chunk_id);
@@ -536,7 +685,8 @@ tsl_decompress_chunk(PG_FUNCTION_ARGS)
 
 	if (!decompress_chunk_impl(uncompressed_chunk->hypertable_relid,
 							   uncompressed_chunk_id,
-							   if_compressed))
+							   if_compressed,
+							   segment_filter))
 		PG_RETURN_NULL();
 
 	PG_RETURN_OID(uncompressed_chunk_id);
@@ -12,5 +12,6 @@
 extern Datum tsl_compress_chunk(PG_FUNCTION_ARGS);
 extern Datum tsl_decompress_chunk(PG_FUNCTION_ARGS);
 extern bool tsl_compress_chunk_wrapper(Chunk *chunk, bool if_not_compressed);
+extern bool tsl_compressed_chunk_is_partial(const Chunk *chunk);
 
 #endif /* TIMESCALEDB_TSL_COMPRESSION_UTILS_H */
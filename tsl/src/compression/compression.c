@@ -6,19 +6,25 @@
 
 #include "compression/compression.h"
 
+#include <access/genam.h>
 #include <access/heapam.h>
 #include <access/htup_details.h>
 #include <access/multixact.h>
+#include <access/stratnum.h>
 #include <access/xact.h>
 #include <catalog/namespace.h>
+#include <catalog/pg_am.h>
 #include <catalog/pg_attribute.h>
 #include <catalog/pg_type.h>
 #include <catalog/index.h>
+#include <catalog/pg_index.h>
+#include <catalog/pg_statistic.h>
 #include <catalog/heap.h>
 #include <common/base64.h>
 #include <executor/tuptable.h>
 #include <funcapi.h>
 #include <libpq/pqformat.h>
+#include <math.h>
 #include <miscadmin.h>
 #include <storage/predicate.h>
 #include <utils/builtins.h>
@@ -26,6 +32,7 @@
 #include <utils/lsyscache.h>
 #include <utils/memutils.h>
 #include <utils/rel.h>
+#include <utils/relcache.h>
 #include <utils/snapmgr.h>
 #include <utils/syscache.h>
 #include <utils/tuplesort.h>
@@ -36,14 +43,19 @@
 
 #include "compat.h"
 
+#include "alp.h"
 #include "array.h"
 #include "chunk.h"
+#include "compression/utils.h"
 #include "deltadelta.h"
 #include "dictionary.h"
+#include "for.h"
 #include "gorilla.h"
 #include "compression_chunk_size.h"
 #include "create.h"
 #include "custom_type_cache.h"
+#include "guc.h"
+#include "segment_filter.h"
 #include "segment_meta.h"
 
 #define MAX_ROWS_PER_COMPRESSION 1000
@@ -57,17 +69,230 @@ static const CompressionAlgorithmDefinition definitions[_END_COMPRESSION_ALGORIT
 	[COMPRESSION_ALGORITHM_DICTIONARY] = DICTIONARY_ALGORITHM_DEFINITION,
 	[COMPRESSION_ALGORITHM_GORILLA] = GORILLA_ALGORITHM_DEFINITION,
 	[COMPRESSION_ALGORITHM_DELTADELTA] = DELTA_DELTA_ALGORITHM_DEFINITION,
+	[COMPRESSION_ALGORITHM_FOR] = FOR_ALGORITHM_DEFINITION,
+	[COMPRESSION_ALGORITHM_ALP] = ALP_ALGORITHM_DEFINITION,
 };
 
+/* number of rows at the start of a batch that the auto compressor tries every algorithm on */
+#define AUTO_COMPRESSION_SAMPLE_ROWS 100
+
+static Compressor *auto_compressor_for_type(Oid type);
+
 static Compressor *
 compressor_for_algorithm_and_type(CompressionAlgorithms algorithm, Oid type)
 {
+	if (algorithm == COMPRESSION_ALGORITHM_AUTO)
+		return auto_compressor_for_type(type);
+
 	if (algorithm >= _END_COMPRESSION_ALGORITHMS)
 		elog(ERROR, "invalid compression algorithm %d", algorithm);
 
 	return definitions[algorithm].compressor_for_type(type);
 }
 
+bool
+compression_algorithm_supports_type(CompressionAlgorithms algorithm, Oid type)
+{
+	switch (algorithm)
+	{
+		case COMPRESSION_ALGORITHM_ARRAY:
+		case COMPRESSION_ALGORITHM_AUTO:
+			return true;
+		case COMPRESSION_ALGORITHM_DICTIONARY:
+		{
+			TypeCacheEntry *tentry =
+				lookup_type_cache(type, TYPECACHE_EQ_OPR_FINFO | TYPECACHE_HASH_PROC_FINFO);
+			return tentry->hash_proc_finfo.fn_addr != NULL && tentry->eq_opr_finfo.fn_addr != NULL;
+		}
+		case COMPRESSION_ALGORITHM_GORILLA:
+			return type == FLOAT4OID || type == FLOAT8OID || type == INT2OID || type == INT4OID ||
+				   type == INT8OID;
+		case COMPRESSION_ALGORITHM_DELTADELTA:
+		case COMPRESSION_ALGORITHM_FOR:
+			return type == BOOLOID || type == INT2OID || type == INT4OID || type == INT8OID ||
+				   type == DATEOID || type == TIMESTAMPOID || type == TIMESTAMPTZOID;
+		case COMPRESSION_ALGORITHM_ALP:
+			return type == FLOAT4OID || type == FLOAT8OID;
+		default:
+			return false;
+	}
+}
+
+/*********************
+ ** auto compressor **
+ *********************/
+
+/*
+ * The auto compressor buffers the values of a batch, tries every algorithm
+ * that supports the type on the first AUTO_COMPRESSION_SAMPLE_ROWS non-NULL
+ * values, and compresses the whole batch with the algorithm that gave the
+ * smallest result. Ties go to the algorithm that comes first in
+ * CompressionAlgorithms.
+ */
+typedef struct AutoCompressorBatch
+{
+	int32 num_rows;
+	int32 max_rows;
+	Datum *values;
+	bool *nulls;
+} AutoCompressorBatch;
+
+typedef struct AutoCompressor
+{
+	Compressor base;
+	Oid element_type;
+	int16 typlen;
+	bool typbyval;
+	int num_candidates;
+	CompressionAlgorithms candidates[_END_COMPRESSION_ALGORITHMS];
+	/* allocated on first use in the memory context of the batch */
+	AutoCompressorBatch *batch;
+} AutoCompressor;
+
+static AutoCompressorBatch *
+auto_compressor_get_batch(AutoCompressor *compressor)
+{
+	AutoCompressorBatch *batch = compressor->batch;
+
+	if (batch == NULL)
+	{
+		batch = palloc(sizeof(*batch));
+		*batch = (AutoCompressorBatch){
+			.max_rows = MAX_ROWS_PER_COMPRESSION,
+			.values = palloc(sizeof(Datum) * MAX_ROWS_PER_COMPRESSION),
+			.nulls = palloc(sizeof(bool) * MAX_ROWS_PER_COMPRESSION),
+		};
+		compressor->batch = batch;
+	}
+	else if (batch->num_rows == batch->max_rows)
+	{
+		batch->max_rows *= 2;
+		batch->values = repalloc(batch->values, sizeof(Datum) * batch->max_rows);
+		batch->nulls = repalloc(batch->nulls, sizeof(bool) * batch->max_rows);
+	}
+
+	return batch;
+}
+
+static void
+auto_compressor_append_null(Compressor *compressor)
+{
+	AutoCompressorBatch *batch = auto_compressor_get_batch((AutoCompressor *) compressor);
+
+	batch->values[batch->num_rows] = (Datum) 0;
+	batch->nulls[batch->num_rows] = true;
+	batch->num_rows++;
+}
+
+static void
+auto_compressor_append_val(Compressor *compressor, Datum val)
+{
+	AutoCompressor *auto_compressor = (AutoCompressor *) compressor;
+	AutoCompressorBatch *batch = auto_compressor_get_batch(auto_compressor);
+
+	/* the value may point into a slot that is reused for the next row */
+	batch->values[batch->num_rows] =
+		datumCopy(val, auto_compressor->typbyval, auto_compressor->typlen);
+	batch->nulls[batch->num_rows] = false;
+	batch->num_rows++;
+}
+
+/*
+ * Compress the batch with the given algorithm. If max_values is not negative,
+ * only compress that many values and skip the NULLs, which are stored the
+ * same way by most algorithms and so should not influence the choice.
+ */
+static void *
+auto_compressor_compress(AutoCompressor *compressor, CompressionAlgorithms algorithm,
+						 int32 max_values)
+{
+	AutoCompressorBatch *batch = compressor->batch;
+	Compressor *candidate = compressor_for_algorithm_and_type(algorithm, compressor->element_type);
+	void *compressed;
+	int32 num_values = 0;
+	int32 row;
+
+	for (row = 0; row < batch->num_rows && (max_values < 0 || num_values < max_values); row++)
+	{
+		if (!batch->nulls[row])
+		{
+			candidate->append_val(candidate, batch->values[row]);
+			num_values++;
+		}
+		else if (max_values < 0)
+			candidate->append_null(candidate);
+	}
+
+	compressed = candidate->finish(candidate);
+	pfree(candidate);
+	return compressed;
+}
+
+static void *
+auto_compressor_finish(Compressor *compressor)
+{
+	AutoCompressor *auto_compressor = (AutoCompressor *) compressor;
+	AutoCompressorBatch *batch = auto_compressor->batch;
+	CompressionAlgorithms best_algorithm = auto_compressor->candidates[0];
+	Size best_size = 0;
+	void *compressed;
+	int i;
+
+	if (batch == NULL)
+		return NULL;
+
+	for (i = 0; i < auto_compressor->num_candidates && auto_compressor->num_candidates > 1; i++)
+	{
+		CompressionAlgorithms algorithm = auto_compressor->candidates[i];
+		void *sample =
+			auto_compressor_compress(auto_compressor, algorithm, AUTO_COMPRESSION_SAMPLE_ROWS);
+		Size size;
+
+		/* all values are NULL, every algorithm returns NULL */
+		if (sample == NULL)
+			break;
+
+		size = VARSIZE(sample);
+		if (i == 0 || size < best_size)
+		{
+			best_algorithm = algorithm;
+			best_size = size;
+		}
+		pfree(sample);
+	}
+
+	compressed = auto_compressor_compress(auto_compressor, best_algorithm, -1);
+
+	/* the batch is freed together with the memory context of the batch */
+	auto_compressor->batch = NULL;
+	return compressed;
+}
+
+static Compressor *
+auto_compressor_for_type(Oid type)
+{
+	AutoCompressor *compressor = palloc0(sizeof(*compressor));
+	int algorithm;
+
+	compressor->base = (Compressor){
+		.append_null = auto_compressor_append_null,
+		.append_val = auto_compressor_append_val,
+		.finish = auto_compressor_finish,
+	};
+	compressor->element_type = type;
+	get_typlenbyval(type, &compressor->typlen, &compressor->typbyval);
+
+	for (algorithm = COMPRESSION_ALGORITHM_ARRAY; algorithm < _END_COMPRESSION_ALGORITHMS;
+		 algorithm++)
+	{
+		if (compression_algorithm_supports_type(algorithm, type))
+			compressor->candidates[compressor->num_candidates++] = algorithm;
+	}
+
+	Assert(compressor->num_candidates > 0);
+	return &compressor->base;
+}
+
 DecompressionIterator *(*tsl_get_decompression_iterator_init(CompressionAlgorithms algorithm,
 															 bool reverse))(Datum, Oid)
 {
@@ -80,6 +305,224 @@ DecompressionIterator *(*tsl_get_decompression_iterator_init(CompressionAlgorith
 		return definitions[algorithm].iterator_init_forward;
 }
 
+/************************
+ ** bulk decompression **
+ ************************/
+
+/* element width of types that are stored unboxed in a DecompressAllResult, 0 otherwise */
+static int16
+decompress_all_value_bytes(Oid element_type)
+{
+	switch (element_type)
+	{
+		case BOOLOID:
+			return sizeof(bool);
+		case INT2OID:
+			return sizeof(int16);
+		case INT4OID:
+		case DATEOID:
+			return sizeof(int32);
+		case FLOAT4OID:
+			return sizeof(float4);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return sizeof(int64);
+		case FLOAT8OID:
+			return sizeof(float8);
+		default:
+			return 0;
+	}
+}
+
+DecompressAllResult *
+decompress_all_result_create(Oid element_type, int32 num_values, bool has_nulls)
+{
+	DecompressAllResult *result = palloc(sizeof(*result));
+	int16 value_bytes = decompress_all_value_bytes(element_type);
+
+	*result = (DecompressAllResult){
+		.element_type = element_type,
+		.num_values = num_values,
+		.value_bytes = value_bytes,
+		.values = palloc(Max(num_values, 1) * (value_bytes > 0 ? value_bytes : sizeof(Datum))),
+	};
+
+	if (has_nulls)
+	{
+		Size validity_bytes = DECOMPRESS_ALL_VALIDITY_WORDS(num_values) * sizeof(uint64);
+
+		result->validity = palloc(Max(validity_bytes, sizeof(uint64)));
+		memset(result->validity, 0xFF, validity_bytes);
+	}
+
+	return result;
+}
+
+void
+decompress_all_result_set_datum(DecompressAllResult *result, int32 row, Datum val)
+{
+	if (result->value_bytes == 0)
+	{
+		((Datum *) result->values)[row] = val;
+		return;
+	}
+
+	switch (result->element_type)
+	{
+		case BOOLOID:
+			((bool *) result->values)[row] = DatumGetBool(val);
+			break;
+		case INT2OID:
+			((int16 *) result->values)[row] = DatumGetInt16(val);
+			break;
+		case INT4OID:
+		case DATEOID:
+			((int32 *) result->values)[row] = DatumGetInt32(val);
+			break;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			((int64 *) result->values)[row] = DatumGetInt64(val);
+			break;
+		case FLOAT4OID:
+			((float4 *) result->values)[row] = DatumGetFloat4(val);
+			break;
+		case FLOAT8OID:
+			((float8 *) result->values)[row] = DatumGetFloat8(val);
+			break;
+		default:
+			elog(ERROR, "unexpected type %u in bulk decompression result", result->element_type);
+	}
+}
+
+/*
+ * Fill the values of a bulk decompression result from the
+ * DecompressDataInternal representation shared by the integer and float
+ * algorithms: integers are stored as (truncated) 64-bit values and floats as
+ * their IEEE bits. Converting in one tight loop per type keeps the type switch
+ * out of the per-value path.
+ */
+void
+decompress_all_result_fill_from_internal(DecompressAllResult *result,
+										 const DecompressDataInternal *internal)
+{
+	int32 row;
+
+	switch (result->element_type)
+	{
+		case BOOLOID:
+		{
+			bool *values = result->values;
+			for (row = 0; row < result->num_values; row++)
+				values[row] = internal[row] != 0;
+			break;
+		}
+		case INT2OID:
+		{
+			int16 *values = result->values;
+			for (row = 0; row < result->num_values; row++)
+				values[row] = (int16) internal[row];
+			break;
+		}
+		case INT4OID:
+		case DATEOID:
+		{
+			int32 *values = result->values;
+			for (row = 0; row < result->num_values; row++)
+				values[row] = (int32) internal[row];
+			break;
+		}
+		case FLOAT4OID:
+		{
+			float4 *values = result->values;
+			for (row = 0; row < result->num_values; row++)
+				values[row] = bits_get_float((uint32) internal[row]);
+			break;
+		}
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case FLOAT8OID:
+			/* the internal representation already has the right bits */
+			StaticAssertStmt(sizeof(int64) == sizeof(DecompressDataInternal),
+							 "unexpected size of internal decompressed data");
+			if (result->values != (void *) internal)
+				memcpy(result->values, internal, sizeof(int64) * result->num_values);
+			break;
+		default:
+			elog(ERROR, "unexpected type %u in bulk decompression result", result->element_type);
+	}
+}
+
+/*
+ * Generic bulk decompression for algorithms without a specialized
+ * implementation: drain a forward iterator into the result arrays.
+ */
+static DecompressAllResult *
+decompress_all_from_iterator(DecompressionIterator *iter, Oid element_type)
+{
+	int32 capacity = MAX_ROWS_PER_COMPRESSION;
+	int32 num_values = 0;
+	bool has_nulls = false;
+	Datum *datums = palloc(sizeof(*datums) * capacity);
+	bool *nulls = palloc(sizeof(*nulls) * capacity);
+	DecompressAllResult *result;
+	int32 row;
+
+	for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter))
+	{
+		if (num_values >= capacity)
+		{
+			capacity *= 2;
+			datums = repalloc(datums, sizeof(*datums) * capacity);
+			nulls = repalloc(nulls, sizeof(*nulls) * capacity);
+		}
+
+		datums[num_values] = r.val;
+		nulls[num_values] = r.is_null;
+		has_nulls |= r.is_null;
+		num_values++;
+	}
+
+	result = decompress_all_result_create(element_type, num_values, has_nulls);
+
+	for (row = 0; row < num_values; row++)
+	{
+		if (nulls[row])
+			decompress_all_result_set_null(result, row);
+		else
+			decompress_all_result_set_datum(result, row, datums[row]);
+	}
+
+	pfree(datums);
+	pfree(nulls);
+
+	return result;
+}
+
+/*
+ * Decompress all values of a compressed datum at once into flat arrays in the
+ * current memory context. Values are always returned in forward order.
+ */
+DecompressAllResult *
+tsl_decompress_all(Datum compressed, Oid element_type)
+{
+	CompressedDataHeader *header = (CompressedDataHeader *) PG_DETOAST_DATUM(compressed);
+
+	if (header->compression_algorithm >= _END_COMPRESSION_ALGORITHMS)
+		elog(ERROR, "invalid compression algorithm %d", header->compression_algorithm);
+
+	if (definitions[header->compression_algorithm].decompress_all != NULL)
+		return definitions[header->compression_algorithm].decompress_all(PointerGetDatum(header),
+																		  element_type);
+
+	return decompress_all_from_iterator(definitions[header->compression_algorithm]
+											.iterator_init_forward(PointerGetDatum(header),
+																   element_type),
+										element_type);
+}
+
 typedef struct SegmentInfo
 {
 	Datum val;
@@ -134,6 +577,8 @@ typedef struct RowCompressor
 	uint32 rows_compressed_into_current_value;
 	/* a unique monotonically increasing (according to order by) id for each compressed row */
 	int32 sequence_num;
+	/* no row has been appended yet, so there is no current group */
+	bool first_row;
 
 	/* cached arrays used to build the HeapTuple */
 	Datum *compressed_values;
@@ -151,8 +596,12 @@ static void row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompr
 								Relation compressed_table, int num_compression_infos,
 								const ColumnCompressionInfo **column_compression_info,
 								int16 *column_offsets, int16 num_compressed_columns);
+static Relation compress_chunk_find_matching_index(Relation in_rel, int n_keys,
+												   const ColumnCompressionInfo **keys);
 static void row_compressor_append_sorted_rows(RowCompressor *row_compressor,
 											  Tuplesortstate *sorted_rel, TupleDesc sorted_desc);
+static void row_compressor_append_index_scan(RowCompressor *row_compressor, Relation in_rel,
+											 Relation index_rel);
 static void row_compressor_finish(RowCompressor *row_compressor);
 
 /********************
@@ -295,7 +744,12 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 	TupleDesc in_desc = RelationGetDescr(in_rel);
 	TupleDesc out_desc = RelationGetDescr(out_rel);
 
-	Tuplesortstate *sorted_rel = compress_chunk_sort_relation(in_rel, n_keys, keys);
+	/* If an index already returns the rows in compression order, we stream
+	 * them through an index scan instead of sorting the whole chunk. */
+	Relation index_rel = ts_guc_enable_compression_indexscan ?
+							 compress_chunk_find_matching_index(in_rel, n_keys, keys) :
+							 NULL;
+	Tuplesortstate *sorted_rel = NULL;
 
 	RowCompressor row_compressor;
 
@@ -310,11 +764,26 @@ compress_chunk(Oid in_table, Oid out_table, const ColumnCompressionInfo **column
 						in_column_offsets,
 						out_desc->natts);
 
-	row_compressor_append_sorted_rows(&row_compressor, sorted_rel, in_desc);
+	if (index_rel != NULL)
+	{
+		elog(DEBUG1,
+			 "compressing \"%s\" using index scan on \"%s\"",
+			 RelationGetRelationName(in_rel),
+			 RelationGetRelationName(index_rel));
+
+		row_compressor_append_index_scan(&row_compressor, in_rel, index_rel);
+		index_close(index_rel, NoLock);
+	}
+	else
+	{
+		sorted_rel = compress_chunk_sort_relation(in_rel, n_keys, keys);
+		row_compressor_append_sorted_rows(&row_compressor, sorted_rel, in_desc);
+	}
 
 	row_compressor_finish(&row_compressor);
 
-	tuplesort_end(sorted_rel);
+	if (sorted_rel != NULL)
+		tuplesort_end(sorted_rel);
 
 	truncate_relation(in_table);
 
@@ -479,6 +948,210 @@ compress_chunk_populate_sort_info_for_column(Oid table, const ColumnCompressionI
 	ReleaseSysCache(tp);
 }
 
+/*
+ * Check if scanning the index forward returns the rows in the order that
+ * compress_chunk_sort_relation() would sort them into: the leading key
+ * columns of the index have to be the segmentby columns followed by the
+ * orderby columns, with the same operator family, collation, direction and
+ * NULLS placement. Segmentby columns only need to be grouped, but they also
+ * have to be ascending with NULLS LAST like in the sort, so that the batches
+ * are written in the same order either way.
+ */
+static bool
+compress_chunk_index_matches(Relation in_rel, Relation index_rel, int n_keys,
+							 const ColumnCompressionInfo **keys)
+{
+	int n;
+
+	if (index_rel->rd_rel->relam != BTREE_AM_OID || !index_rel->rd_index->indisvalid ||
+		IndexRelationGetNumberOfKeyAttributes(index_rel) < n_keys ||
+		RelationGetIndexPredicate(index_rel) != NIL)
+		return false;
+
+	for (n = 0; n < n_keys; n++)
+	{
+		int16 index_option = index_rel->rd_indoption[n];
+		AttrNumber attno;
+		Oid sort_operator;
+		Oid collation;
+		bool nulls_first;
+		Oid opfamily;
+		Oid opcintype;
+		int16 strategy;
+
+		compress_chunk_populate_sort_info_for_column(RelationGetRelid(in_rel),
+													 keys[n],
+													 &attno,
+													 &sort_operator,
+													 &collation,
+													 &nulls_first);
+
+		/* expression columns have attribute number 0 and never match */
+		if (index_rel->rd_index->indkey.values[n] != attno ||
+			index_rel->rd_indcollation[n] != collation)
+			return false;
+
+		if (!get_ordering_op_properties(sort_operator, &opfamily, &opcintype, &strategy) ||
+			index_rel->rd_opfamily[n] != opfamily)
+			return false;
+
+		if (((index_option & INDOPTION_DESC) != 0) != (strategy == BTGreaterStrategyNumber) ||
+			((index_option & INDOPTION_NULLS_FIRST) != 0) != nulls_first)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Minimum absolute correlation between a key column of the index and the
+ * physical order of the chunk to compress through an index scan. Below that,
+ * the index scan reads the heap in random order, which is slower than
+ * sorting the chunk.
+ */
+#define COMPRESSION_INDEXSCAN_MIN_CORRELATION 0.9
+
+/*
+ * Get the correlation of a column with the physical order of the chunk.
+ * Returns false if the chunk has no correlation statistics for the column.
+ */
+static bool
+compress_chunk_get_correlation(Relation in_rel, AttrNumber attno, float4 *correlation)
+{
+	AttStatsSlot sslot;
+	HeapTuple tuple = SearchSysCache3(STATRELATTINH,
+									  ObjectIdGetDatum(RelationGetRelid(in_rel)),
+									  Int16GetDatum(attno),
+									  BoolGetDatum(false));
+	bool found = false;
+
+	if (!HeapTupleIsValid(tuple))
+		return false;
+
+	if (get_attstatsslot(&sslot,
+						 tuple,
+						 STATISTIC_KIND_CORRELATION,
+						 InvalidOid,
+						 ATTSTATSSLOT_NUMBERS))
+	{
+		if (sslot.nnumbers == 1)
+		{
+			*correlation = sslot.numbers[0];
+			found = true;
+		}
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseSysCache(tuple);
+	return found;
+}
+
+/*
+ * Check if the index returns the rows in about the physical order of the
+ * chunk. This is the case if the chunk is clustered or reordered on the
+ * index, so that the leading index column is correlated, or if the rows of
+ * every segment are stored in about orderby order, so that the leading
+ * orderby column is correlated. The latter is the common case of a chunk
+ * filled in time order, where the index scan reads the heap of each segment
+ * sequentially.
+ *
+ * The chunk is analyzed right before it is compressed, so the statistics are
+ * usually current. Without statistics for the leading orderby column, we
+ * assume that the chunk was filled in time order and use the index.
+ */
+static bool
+compress_chunk_index_is_correlated(Relation in_rel, Relation index_rel, int n_keys,
+								   const ColumnCompressionInfo **keys)
+{
+	int n_segmentby = 0;
+	float4 correlation;
+
+	while (n_segmentby < n_keys && COMPRESSIONCOL_IS_SEGMENT_BY(keys[n_segmentby]))
+		n_segmentby++;
+
+	if (compress_chunk_get_correlation(in_rel,
+									   index_rel->rd_index->indkey.values[0],
+									   &correlation) &&
+		fabs(correlation) >= COMPRESSION_INDEXSCAN_MIN_CORRELATION)
+		return true;
+
+	/* without orderby columns, the rows of a segment are in any order */
+	if (n_segmentby == n_keys)
+		return false;
+
+	if (!compress_chunk_get_correlation(in_rel,
+										index_rel->rd_index->indkey.values[n_segmentby],
+										&correlation))
+		return true;
+
+	return fabs(correlation) >= COMPRESSION_INDEXSCAN_MIN_CORRELATION;
+}
+
+/*
+ * Find an index on the uncompressed chunk that returns the rows in
+ * compression order, e.g., the default (segmentby, time DESC) index, and
+ * that is correlated with the physical order of the chunk. Returns the index
+ * opened with AccessShareLock, or NULL if there is no such index.
+ */
+static Relation
+compress_chunk_find_matching_index(Relation in_rel, int n_keys, const ColumnCompressionInfo **keys)
+{
+	List *index_oids = RelationGetIndexList(in_rel);
+	ListCell *lc;
+
+	foreach (lc, index_oids)
+	{
+		Relation index_rel = index_open(lfirst_oid(lc), AccessShareLock);
+
+		if (compress_chunk_index_matches(in_rel, index_rel, n_keys, keys) &&
+			compress_chunk_index_is_correlated(in_rel, index_rel, n_keys, keys))
+		{
+			list_free(index_oids);
+			return index_rel;
+		}
+
+		index_close(index_rel, AccessShareLock);
+	}
+
+	list_free(index_oids);
+	return NULL;
+}
+
+/*
+ * Get the index that compress_chunk() scans to compress the table, or
+ * InvalidOid if the table is sorted instead.
+ */
+Oid
+compress_chunk_get_index(Oid in_table, const ColumnCompressionInfo **column_compression_info,
+						 int num_compression_infos)
+{
+	int n_keys;
+	const ColumnCompressionInfo **keys;
+	Relation in_rel;
+	Relation index_rel;
+	Oid index_oid = InvalidOid;
+
+	if (!ts_guc_enable_compression_indexscan)
+		return InvalidOid;
+
+	in_rel = table_open(in_table, AccessShareLock);
+	compress_chunk_populate_keys(in_table,
+								 column_compression_info,
+								 num_compression_infos,
+								 &n_keys,
+								 &keys);
+	index_rel = compress_chunk_find_matching_index(in_rel, n_keys, keys);
+
+	if (index_rel != NULL)
+	{
+		index_oid = RelationGetRelid(index_rel);
+		index_close(index_rel, AccessShareLock);
+	}
+
+	table_close(in_rel, AccessShareLock);
+	return index_oid;
+}
+
 /********************
  ** row_compressor **
  ********************/
@@ -543,6 +1216,7 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 		.rowcnt_pre_compression = 0,
 		.num_compressed_rows = 0,
 		.sequence_num = SEQUENCE_NUM_GAP,
+		.first_row = true,
 	};
 
 	memset(row_compressor->compressed_is_null, 1, sizeof(bool) * num_columns_in_compressed_table);
@@ -612,6 +1286,39 @@ row_compressor_init(RowCompressor *row_compressor, TupleDesc uncompressed_tuple_
 	}
 }
 
+/* Append a row; rows must arrive in compression order */
+static void
+row_compressor_append_ordered_slot(RowCompressor *row_compressor, TupleTableSlot *slot,
+								   CommandId mycid)
+{
+	bool changed_groups, compressed_row_is_full;
+	MemoryContext old_ctx;
+	slot_getallattrs(slot);
+	old_ctx = MemoryContextSwitchTo(row_compressor->per_row_ctx);
+
+	/* first time through */
+	if (row_compressor->first_row)
+	{
+		row_compressor_update_group(row_compressor, slot);
+		row_compressor->first_row = false;
+	}
+
+	changed_groups = row_compressor_new_row_is_in_new_group(row_compressor, slot);
+	compressed_row_is_full =
+		row_compressor->rows_compressed_into_current_value >= MAX_ROWS_PER_COMPRESSION;
+	if (compressed_row_is_full || changed_groups)
+	{
+		if (row_compressor->rows_compressed_into_current_value > 0)
+			row_compressor_flush(row_compressor, mycid, changed_groups);
+		if (changed_groups)
+			row_compressor_update_group(row_compressor, slot);
+	}
+
+	row_compressor_append_row(row_compressor, slot);
+	MemoryContextSwitchTo(old_ctx);
+	ExecClearTuple(slot);
+}
+
 static void
 row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate *sorted_rel,
 								  TupleDesc sorted_desc)
@@ -619,7 +1326,6 @@ row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate
 	CommandId mycid = GetCurrentCommandId(true);
 	TupleTableSlot *slot = MakeTupleTableSlotCompat(sorted_desc, TTSOpsMinimalTupleP);
 	bool got_tuple;
-	bool first_iteration = true;
 
 	for (got_tuple = tuplesort_gettupleslot(sorted_rel,
 											true /*=forward*/,
@@ -633,37 +1339,52 @@ row_compressor_append_sorted_rows(RowCompressor *row_compressor, Tuplesortstate
 											slot,
 											NULL /*=abbrev*/))
 	{
-		bool changed_groups, compressed_row_is_full;
-		MemoryContext old_ctx;
-		slot_getallattrs(slot);
-		old_ctx = MemoryContextSwitchTo(row_compressor->per_row_ctx);
+		row_compressor_append_ordered_slot(row_compressor, slot, mycid);
+	}
 
-		/* first time through */
-		if (first_iteration)
-		{
-			row_compressor_update_group(row_compressor, slot);
-			first_iteration = false;
-		}
+	if (row_compressor->rows_compressed_into_current_value > 0)
+		row_compressor_flush(row_compressor, mycid, true);
 
-		changed_groups = row_compressor_new_row_is_in_new_group(row_compressor, slot);
-		compressed_row_is_full =
-			row_compressor->rows_compressed_into_current_value >= MAX_ROWS_PER_COMPRESSION;
-		if (compressed_row_is_full || changed_groups)
-		{
-			if (row_compressor->rows_compressed_into_current_value > 0)
-				row_compressor_flush(row_compressor, mycid, changed_groups);
-			if (changed_groups)
-				row_compressor_update_group(row_compressor, slot);
-		}
+	ExecDropSingleTupleTableSlot(slot);
+}
 
-		row_compressor_append_row(row_compressor, slot);
-		MemoryContextSwitchTo(old_ctx);
-		ExecClearTuple(slot);
+/*
+ * Stream the rows of the uncompressed chunk in index order into the row
+ * compressor. The index must match the compression order, see
+ * compress_chunk_find_matching_index().
+ */
+static void
+row_compressor_append_index_scan(RowCompressor *row_compressor, Relation in_rel,
+								 Relation index_rel)
+{
+	CommandId mycid = GetCurrentCommandId(true);
+	TupleTableSlot *slot =
+		MakeTupleTableSlotCompat(RelationGetDescr(in_rel), TTSOpsBufferHeapTupleP);
+	IndexScanDesc index_scan = index_beginscan(in_rel, index_rel, GetLatestSnapshot(), 0, 0);
+
+	index_rescan(index_scan, NULL, 0, NULL, 0);
+
+	for (;;)
+	{
+#if PG12_LT
+		HeapTuple tuple = index_getnext(index_scan, ForwardScanDirection);
+
+		if (tuple == NULL)
+			break;
+
+		/* the tuple is owned by the index scan, so the slot must not free it */
+		ExecStoreTuple(tuple, slot, InvalidBuffer, false);
+#else
+		if (!index_getnext_slot(index_scan, ForwardScanDirection, slot))
+			break;
+#endif
+		row_compressor_append_ordered_slot(row_compressor, slot, mycid);
 	}
 
 	if (row_compressor->rows_compressed_into_current_value > 0)
 		row_compressor_flush(row_compressor, mycid, true);
 
+	index_endscan(index_scan);
 	ExecDropSingleTupleTableSlot(slot);
 }
 
@@ -1006,6 +1727,9 @@ typedef struct RowDecompressor
 	/* cache memory used to store the decompressed datums/is_null for form_tuple */
 	Datum *decompressed_datums;
 	bool *decompressed_is_nulls;
+
+	/* number of rows written to out_rel so far */
+	int64 rows_decompressed;
 } RowDecompressor;
 
 static PerCompressedColumn *create_per_compressed_column(TupleDesc in_desc, TupleDesc out_desc,
@@ -1018,8 +1742,16 @@ static void row_decompressor_decompress_row(RowDecompressor *row_decompressor);
 static bool per_compressed_col_get_data(PerCompressedColumn *per_compressed_col,
 										Datum *decompressed_datums, bool *decompressed_is_nulls);
 
-void
-decompress_chunk(Oid in_table, Oid out_table)
+/*
+ * Decompress the batches of the compressed chunk in_table that match the
+ * filter into out_table and delete them from in_table. Without a filter, all
+ * batches are decompressed and in_table is left as is. Returns the number of
+ * batches that were not decompressed. If stats is given, it receives the
+ * number of rows and batches that were decompressed.
+ */
+static int64
+decompress_chunk_batches(Oid in_table, Oid out_table, const SegmentFilter *filter,
+						 CompressionStats *stats)
 {
 	/* these locks are taken in the order uncompressed table then compressed table
 	 * for consistency with compress_chunk
@@ -1041,6 +1773,8 @@ decompress_chunk(Oid in_table, Oid out_table)
 	TupleDesc out_desc = RelationGetDescr(out_rel);
 
 	Oid compressed_data_type_oid = ts_custom_type_cache_get(CUSTOM_TYPE_COMPRESSED_DATA)->type_oid;
+	int64 batches_left = 0;
+	int64 batches_decompressed = 0;
 
 	Assert(OidIsValid(compressed_data_type_oid));
 
@@ -1091,18 +1825,39 @@ decompress_chunk(Oid in_table, Oid out_table)
 			old_ctx = MemoryContextSwitchTo(per_compressed_row_ctx);
 
 			heap_deform_tuple(compressed_tuple, in_desc, compressed_datums, compressed_is_nulls);
+
+			if (filter != NULL)
+			{
+				if (!segment_filter_matches(filter, compressed_datums, compressed_is_nulls))
+				{
+					batches_left++;
+					MemoryContextSwitchTo(old_ctx);
+					MemoryContextReset(per_compressed_row_ctx);
+					continue;
+				}
+
+				simple_heap_delete(in_rel, &compressed_tuple->t_self);
+			}
+
 			populate_per_compressed_columns_from_data(decompressor.per_compressed_cols,
 													  in_desc->natts,
 													  compressed_datums,
 													  compressed_is_nulls);
 
 			row_decompressor_decompress_row(&decompressor);
+			batches_decompressed++;
 			MemoryContextSwitchTo(old_ctx);
 			MemoryContextReset(per_compressed_row_ctx);
 		}
 
 		heap_endscan(heapScan);
 		FreeBulkInsertState(decompressor.bistate);
+
+		if (stats != NULL)
+			*stats = (CompressionStats){
+				.rowcnt_pre_compression = decompressor.rows_decompressed,
+				.rowcnt_post_compression = batches_decompressed,
+			};
 	}
 
 	/* Recreate all indexes on out rel, we already have an exclusive lock on it,
@@ -1111,6 +1866,28 @@ decompress_chunk(Oid in_table, Oid out_table)
 
 	table_close(out_rel, NoLock);
 	table_close(in_rel, NoLock);
+
+	return batches_left;
+}
+
+void
+decompress_chunk(Oid in_table, Oid out_table)
+{
+	decompress_chunk_batches(in_table, out_table, NULL, NULL);
+}
+
+/*
+ * Move the batches of the compressed chunk in_table that match the filter
+ * back into the uncompressed chunk out_table, leaving all other batches
+ * compressed. Returns the number of batches that are still compressed and
+ * fills in stats with the number of rows and batches that were moved.
+ */
+int64
+decompress_chunk_segments(Oid in_table, Oid out_table, const SegmentFilter *filter,
+						  CompressionStats *stats)
+{
+	Assert(filter != NULL);
+	return decompress_chunk_batches(in_table, out_table, filter, stats);
 }
 
 static PerCompressedColumn *
@@ -1241,6 +2018,7 @@ row_decompressor_decompress_row(RowDecompressor *row_decompressor)
 						row_decompressor->bistate);
 
 			heap_freetuple(decompressed_tuple);
+			row_decompressor->rows_decompressed++;
 			wrote_data = true;
 		}
 	} while (!is_done);
@@ -1465,6 +2243,9 @@ tsl_compressed_data_out(PG_FUNCTION_ARGS)
 extern CompressionStorage
 compression_get_toast_storage(CompressionAlgorithms algorithm)
 {
+	/* auto may pick array or dictionary, which rely on TOAST compression on top */
+	if (algorithm == COMPRESSION_ALGORITHM_AUTO)
+		return TOAST_STORAGE_EXTENDED;
 	if (algorithm == _INVALID_COMPRESSION_ALGORITHM || algorithm >= _END_COMPRESSION_ALGORITHMS)
 		elog(ERROR, "invalid compression algorithm %d", algorithm);
 	return definitions[algorithm].compressed_data_storage;
@@ -8,6 +8,7 @@
 
 #include <postgres.h>
 #include <c.h>
+#include <catalog/pg_type.h>
 #include <fmgr.h>
 #include <lib/stringinfo.h>
 
@@ -48,9 +49,78 @@ typedef struct DecompressResult
 	bool is_done;
 } DecompressResult;
 
+/*
+ * The result of decompressing a whole compressed value at once (bulk
+ * decompression). Fixed-width by-value types (e.g. int4, float8 or
+ * timestamptz) are stored unboxed in a flat array of their native C type,
+ * everything else is stored as an array of Datums (value_bytes == 0). The
+ * validity bitmap has one bit per value that is set for non-NULL values; it is
+ * NULL if there are no NULL values. Values at NULL positions are undefined.
+ */
+typedef struct DecompressAllResult
+{
+	Oid element_type;
+	int32 num_values;
+	int16 value_bytes;
+	uint64 *validity;
+	void *values;
+} DecompressAllResult;
+
+#define DECOMPRESS_ALL_VALIDITY_WORDS(num_values) (((num_values) + 63) / 64)
+
+static inline bool
+decompress_all_result_is_null(const DecompressAllResult *result, int32 row)
+{
+	Assert(row >= 0 && row < result->num_values);
+	return result->validity != NULL && (result->validity[row / 64] & (1ULL << (row % 64))) == 0;
+}
+
+static inline void
+decompress_all_result_set_null(DecompressAllResult *result, int32 row)
+{
+	Assert(result->validity != NULL);
+	result->validity[row / 64] &= ~(1ULL << (row % 64));
+}
+
+/* Convert a single decompressed value back into a Datum of the element type */
+static inline Datum
+decompress_all_result_get_datum(const DecompressAllResult *result, int32 row)
+{
+	Assert(row >= 0 && row < result->num_values);
+
+	if (result->value_bytes == 0)
+		return ((Datum *) result->values)[row];
+
+	switch (result->element_type)
+	{
+		case BOOLOID:
+			return BoolGetDatum(((bool *) result->values)[row]);
+		case INT2OID:
+			return Int16GetDatum(((int16 *) result->values)[row]);
+		case INT4OID:
+		case DATEOID:
+			return Int32GetDatum(((int32 *) result->values)[row]);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return Int64GetDatum(((int64 *) result->values)[row]);
+		case FLOAT4OID:
+			return Float4GetDatum(((float4 *) result->values)[row]);
+		case FLOAT8OID:
+			return Float8GetDatum(((float8 *) result->values)[row]);
+		default:
+			elog(ERROR, "unexpected type %u in bulk decompression result", result->element_type);
+	}
+
+	pg_unreachable();
+}
+
 /* Forward declaration of ColumnCompressionInfo so we don't need to include catalog.h */
 typedef struct FormData_hypertable_compression ColumnCompressionInfo;
 
+/* Forward declaration of SegmentFilter, see segment_filter.h */
+struct SegmentFilter;
+
 typedef struct Compressor Compressor;
 struct Compressor
 {
@@ -89,6 +159,9 @@ typedef struct CompressionAlgorithmDefinition
 
 	Compressor *(*compressor_for_type)(Oid element_type);
 	CompressionStorage compressed_data_storage;
+
+	/* optional specialized bulk decompression, NULL if the algorithm only has iterators */
+	DecompressAllResult *(*decompress_all)(Datum, Oid element_type);
 } CompressionAlgorithmDefinition;
 
 typedef enum CompressionAlgorithms
@@ -100,6 +173,8 @@ typedef enum CompressionAlgorithms
 	COMPRESSION_ALGORITHM_DICTIONARY,
 	COMPRESSION_ALGORITHM_GORILLA,
 	COMPRESSION_ALGORITHM_DELTADELTA,
+	COMPRESSION_ALGORITHM_FOR,
+	COMPRESSION_ALGORITHM_ALP,
 
 	/* When adding an algorithm also add a static assert statement below */
 	/* end of real values */
@@ -107,6 +182,14 @@ typedef enum CompressionAlgorithms
 	_MAX_NUM_COMPRESSION_ALGORITHMS = 128,
 } CompressionAlgorithms;
 
+/*
+ * Not a real algorithm: only used in the hypertable_compression catalog for
+ * columns that are compressed with whichever of the algorithms above gives the
+ * smallest result on a sample of each batch. The compressed data itself
+ * records the algorithm that was picked.
+ */
+#define COMPRESSION_ALGORITHM_AUTO ((CompressionAlgorithms) 127)
+
 typedef struct CompressionStats
 {
 	int64 rowcnt_pre_compression;
@@ -133,22 +216,40 @@ pg_attribute_unused() assert_num_compression_algorithms_sane(void)
 	StaticAssertStmt(COMPRESSION_ALGORITHM_DICTIONARY == 2, "algorithm index has changed");
 	StaticAssertStmt(COMPRESSION_ALGORITHM_GORILLA == 3, "algorithm index has changed");
 	StaticAssertStmt(COMPRESSION_ALGORITHM_DELTADELTA == 4, "algorithm index has changed");
+	StaticAssertStmt(COMPRESSION_ALGORITHM_FOR == 5, "algorithm index has changed");
+	StaticAssertStmt(COMPRESSION_ALGORITHM_ALP == 6, "algorithm index has changed");
 
 	/* This should change when adding a new algorithm after adding the new algorithm to the assert
 	 * list above. This statement prevents adding a new algorithm without updating the asserts above
 	 */
-	StaticAssertStmt(_END_COMPRESSION_ALGORITHMS == 5,
+	StaticAssertStmt(_END_COMPRESSION_ALGORITHMS == 7,
 					 "number of algorithms have changed, the asserts should be updated");
+
+	StaticAssertStmt(_END_COMPRESSION_ALGORITHMS <= COMPRESSION_ALGORITHM_AUTO,
+					 "real algorithms must not use the index of the auto algorithm");
 }
 
 extern CompressionStorage compression_get_toast_storage(CompressionAlgorithms algo);
+extern bool compression_algorithm_supports_type(CompressionAlgorithms algorithm, Oid type);
 extern CompressionStats compress_chunk(Oid in_table, Oid out_table,
 									   const ColumnCompressionInfo **column_compression_info,
 									   int num_columns);
+extern Oid compress_chunk_get_index(Oid in_table,
+									const ColumnCompressionInfo **column_compression_info,
+									int num_compression_infos);
 extern void decompress_chunk(Oid in_table, Oid out_table);
+extern int64 decompress_chunk_segments(Oid in_table, Oid out_table,
+									   const struct SegmentFilter *filter,
+									   CompressionStats *stats);
 
 extern DecompressionIterator *(*tsl_get_decompression_iterator_init(
 	CompressionAlgorithms algorithm, bool reverse))(Datum, Oid element_type);
+extern DecompressAllResult *decompress_all_result_create(Oid element_type, int32 num_values,
+														 bool has_nulls);
+extern void decompress_all_result_set_datum(DecompressAllResult *result, int32 row, Datum val);
+extern void decompress_all_result_fill_from_internal(DecompressAllResult *result,
+													 const DecompressDataInternal *internal);
+extern DecompressAllResult *tsl_decompress_all(Datum compressed, Oid element_type);
 extern void update_compressed_chunk_relstats(Oid uncompressed_relid, Oid compressed_relid);
 
 #endif
@@ -57,7 +57,7 @@ typedef struct CompressColInfo
 } CompressColInfo;
 
 static void compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols,
-								 List *orderby_cols);
+								 List *orderby_cols, List *algorithm_cols);
 static void compresscolinfo_init_singlecolumn(CompressColInfo *cc, const char *colname, Oid typid);
 static void compresscolinfo_add_catalog_entries(CompressColInfo *compress_cols, int32 htid);
 
@@ -94,17 +94,51 @@ get_default_algorithm_id(Oid typeoid)
 			return COMPRESSION_ALGORITHM_ARRAY;
 
 		default:
-		{
 			/* use dictitionary if possible, otherwise use array */
-			TypeCacheEntry *tentry =
-				lookup_type_cache(typeoid, TYPECACHE_EQ_OPR_FINFO | TYPECACHE_HASH_PROC_FINFO);
-			if (tentry->hash_proc_finfo.fn_addr == NULL || tentry->eq_opr_finfo.fn_addr == NULL)
+			if (!compression_algorithm_supports_type(COMPRESSION_ALGORITHM_DICTIONARY, typeoid))
 				return COMPRESSION_ALGORITHM_ARRAY;
 			return COMPRESSION_ALGORITHM_DICTIONARY;
-		}
 	}
 }
 
+/* the names of the algorithms in the timescaledb.compress_algorithms option */
+static const struct
+{
+	const char *name;
+	CompressionAlgorithms algorithm;
+} compression_algorithm_names[] = {
+	{ "array", COMPRESSION_ALGORITHM_ARRAY },
+	{ "dictionary", COMPRESSION_ALGORITHM_DICTIONARY },
+	{ "gorilla", COMPRESSION_ALGORITHM_GORILLA },
+	{ "deltadelta", COMPRESSION_ALGORITHM_DELTADELTA },
+	{ "for", COMPRESSION_ALGORITHM_FOR },
+	{ "alp", COMPRESSION_ALGORITHM_ALP },
+	{ "auto", COMPRESSION_ALGORITHM_AUTO },
+};
+
+static CompressionAlgorithms
+get_algorithm_id_by_name(const char *name)
+{
+	int i;
+
+	/* "default" picks the algorithm from the column type, as if not specified */
+	if (pg_strcasecmp(name, "default") == 0)
+		return _INVALID_COMPRESSION_ALGORITHM;
+
+	for (i = 0; i < (int) lengthof(compression_algorithm_names); i++)
+	{
+		if (pg_strcasecmp(name, compression_algorithm_names[i].name) == 0)
+			return compression_algorithm_names[i].algorithm;
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("unrecognized compression algorithm \"%s\"", name),
+			 errhint("Valid algorithms are array, dictionary, gorilla, deltadelta, for, alp, auto"
+					 " and default.")));
+	pg_unreachable();
+}
+
 static char *
 compression_column_segment_metadata_name(const FormData_hypertable_compression *fd,
 										 const char *type)
@@ -206,12 +240,13 @@ compresscolinfo_add_metadata_columns(CompressColInfo *cc, Relation uncompressed_
  */
 static void
 compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols,
-					 List *orderby_cols)
+					 List *orderby_cols, List *algorithm_cols)
 {
 	Relation rel;
 	TupleDesc tupdesc;
 	int i, colno, attno;
 	int16 *segorder_colindex;
+	int16 *algorithm_override;
 	int seg_attnolen = 0;
 	ListCell *lc;
 	Oid compresseddata_oid = ts_custom_type_cache_get(CUSTOM_TYPE_COMPRESSED_DATA)->type_oid;
@@ -219,6 +254,7 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 	seg_attnolen = list_length(segmentby_cols);
 	rel = table_open(srctbl_relid, AccessShareLock);
 	segorder_colindex = palloc0(sizeof(int32) * (rel->rd_att->natts));
+	algorithm_override = palloc0(sizeof(int16) * (rel->rd_att->natts));
 	tupdesc = rel->rd_att;
 	i = 1;
 
@@ -270,6 +306,50 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 		segorder_colindex[col_attno - 1] = i++;
 	}
 
+	foreach (lc, algorithm_cols)
+	{
+		CompressedParsedAlgorithm *col = (CompressedParsedAlgorithm *) lfirst(lc);
+		AttrNumber col_attno = get_attnum(rel->rd_id, NameStr(col->colname));
+		CompressionAlgorithms algorithm;
+		Oid atttypid;
+
+		if (col_attno == InvalidAttrNumber)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("column \"%s\" does not exist", NameStr(col->colname)),
+					 errhint("The timescaledb.compress_algorithms option must reference a valid "
+							 "column.")));
+
+		if (segorder_colindex[col_attno - 1] > 0 &&
+			segorder_colindex[col_attno - 1] <= seg_attnolen)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("cannot set a compression algorithm for segment by column \"%s\"",
+							NameStr(col->colname)),
+					 errdetail("Segment by columns are stored uncompressed.")));
+
+		if (algorithm_override[col_attno - 1] != 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("duplicate compression algorithm for column \"%s\"",
+							NameStr(col->colname))));
+
+		algorithm = get_algorithm_id_by_name(NameStr(col->algorithm));
+		atttypid = TupleDescAttr(rel->rd_att, AttrNumberGetAttrOffset(col_attno))->atttypid;
+		if (algorithm == _INVALID_COMPRESSION_ALGORITHM)
+			algorithm = get_default_algorithm_id(atttypid);
+		else if (!compression_algorithm_supports_type(algorithm, atttypid))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("compression algorithm \"%s\" does not support type %s",
+							NameStr(col->algorithm),
+							format_type_be(atttypid)),
+					 errhint("Use a different algorithm for column \"%s\".",
+							 NameStr(col->colname))));
+
+		algorithm_override[col_attno - 1] = algorithm;
+	}
+
 	cc->numcols = 0;
 	cc->col_meta = palloc0(sizeof(FormData_hypertable_compression) * tupdesc->natts);
 	cc->coldeflist = NIL;
@@ -308,7 +388,10 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 		if (attroid == InvalidOid)
 		{
 			attroid = compresseddata_oid; /* default type for column */
-			cc->col_meta[colno].algo_id = get_default_algorithm_id(attr->atttypid);
+			if (algorithm_override[attno] != 0)
+				cc->col_meta[colno].algo_id = algorithm_override[attno];
+			else
+				cc->col_meta[colno].algo_id = get_default_algorithm_id(attr->atttypid);
 		}
 		else
 		{
@@ -321,6 +404,7 @@ compresscolinfo_init(CompressColInfo *cc, Oid srctbl_relid, List *segmentby_cols
 	cc->numcols = colno;
 	compresscolinfo_add_metadata_columns(cc, rel);
 	pfree(segorder_colindex);
+	pfree(algorithm_override);
 	table_close(rel, AccessShareLock);
 }
 
@@ -900,7 +984,8 @@ disable_compression(Hypertable *ht, WithClauseResult *with_clause_options)
 {
 	bool compression_already_enabled = TS_HYPERTABLE_HAS_COMPRESSION_ENABLED(ht);
 	if (!with_clause_options[CompressOrderBy].is_default ||
-		!with_clause_options[CompressSegmentBy].is_default)
+		!with_clause_options[CompressSegmentBy].is_default ||
+		!with_clause_options[CompressAlgorithms].is_default)
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("invalid compression configuration"),
@@ -968,6 +1053,7 @@ tsl_process_compress_table(AlterTableCmd *cmd, Hypertable *ht,
 	Oid ownerid;
 	List *segmentby_cols;
 	List *orderby_cols;
+	List *algorithm_cols;
 	ContinuousAggHypertableStatus caggstat;
 	List *constraint_list = NIL;
 
@@ -1009,7 +1095,12 @@ tsl_process_compress_table(AlterTableCmd *cmd, Hypertable *ht,
 	segmentby_cols = ts_compress_hypertable_parse_segment_by(with_clause_options, ht);
 	orderby_cols = ts_compress_hypertable_parse_order_by(with_clause_options, ht);
 	orderby_cols = add_time_to_order_by_if_not_included(orderby_cols, segmentby_cols, ht);
-	compresscolinfo_init(&compress_cols, ht->main_table_relid, segmentby_cols, orderby_cols);
+	algorithm_cols = ts_compress_hypertable_parse_algorithms(with_clause_options);
+	compresscolinfo_init(&compress_cols,
+						 ht->main_table_relid,
+						 segmentby_cols,
+						 orderby_cols,
+						 algorithm_cols);
 	/* check if we can create a compressed hypertable with existing constraints */
 	constraint_list = validate_existing_constraints(ht, &compress_cols);
 
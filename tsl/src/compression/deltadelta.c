@@ -637,6 +637,87 @@ delta_delta_decompression_iterator_from_datum_reverse(Datum deltadelta_compresse
 	return &iterator->base;
 }
 
+/*
+ * Bulk decompression of a whole deltadelta value. The delta-of-deltas and
+ * the NULL bitmap are unpacked with the bulk simple8b decoder and then summed
+ * up in a single pass, without going through the per-value iterator
+ * interface.
+ */
+DecompressAllResult *
+delta_delta_decompress_all(Datum compressed_datum, Oid element_type)
+{
+	DeltaDeltaCompressed *compressed = (DeltaDeltaCompressed *) PG_DETOAST_DATUM(compressed_datum);
+	const char *data = (char *) &compressed->delta_deltas;
+	Simple8bRleSerialized *deltas = bytes_deserialize_simple8b_and_advance(&data);
+	bool has_nulls = compressed->has_nulls == 1;
+	DecompressAllResult *result;
+	DecompressDataInternal *internal;
+	uint64 *nulls = NULL;
+	uint64 prev_val = 0;
+	uint64 prev_delta = 0;
+	uint32 num_deltas;
+	uint32 num_values;
+	uint32 delta_index = 0;
+	uint32 row;
+
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	num_values = deltas->num_elements;
+	if (has_nulls)
+		nulls = simple8brle_decompress_all(bytes_deserialize_simple8b_and_advance(&data),
+										   &num_values);
+
+	result = decompress_all_result_create(element_type, num_values, has_nulls);
+
+	/* decode all delta-of-deltas at once, then integrate them in a tight loop */
+	internal = simple8brle_decompress_all(deltas, &num_deltas);
+
+	if (!has_nulls)
+	{
+		Assert(num_deltas == num_values);
+		for (row = 0; row < num_values; row++)
+		{
+			prev_delta += zig_zag_decode(internal[row]);
+			prev_val += prev_delta;
+			internal[row] = prev_val;
+		}
+	}
+	else
+	{
+		/*
+		 * There are fewer deltas than rows, so expand them into a buffer with
+		 * one entry per row.
+		 */
+		DecompressDataInternal *expanded = palloc(sizeof(*expanded) * Max(num_values, 1));
+
+		for (row = 0; row < num_values; row++)
+		{
+			if (nulls[row] != 0)
+			{
+				decompress_all_result_set_null(result, row);
+				expanded[row] = 0;
+				continue;
+			}
+
+			if (delta_index >= num_deltas)
+				elog(ERROR, "deltadelta compressed data is missing values");
+
+			prev_delta += zig_zag_decode(internal[delta_index++]);
+			prev_val += prev_delta;
+			expanded[row] = prev_val;
+		}
+
+		pfree(internal);
+		pfree(nulls);
+		internal = expanded;
+	}
+
+	decompress_all_result_fill_from_internal(result, internal);
+	pfree(internal);
+
+	return result;
+}
+
 /**********************************************************************************/
 /**********************************************************************************/
 void
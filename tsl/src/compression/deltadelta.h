@@ -44,6 +44,8 @@ delta_delta_decompression_iterator_try_next_forward(DecompressionIterator *iter)
 extern DecompressResult
 delta_delta_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
 
+extern DecompressAllResult *delta_delta_decompress_all(Datum compressed, Oid element_type);
+
 extern void deltadelta_compressed_send(CompressedDataHeader *header, StringInfo buffer);
 extern Datum deltadelta_compressed_recv(StringInfo buf);
 
@@ -58,6 +60,7 @@ extern Datum tsl_deltadelta_compressor_finish(PG_FUNCTION_ARGS);
 		.compressed_data_recv = deltadelta_compressed_recv,                                        \
 		.compressor_for_type = delta_delta_compressor_for_type,                                    \
 		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+		.decompress_all = delta_delta_decompress_all,                                              \
 	}
 
 #endif
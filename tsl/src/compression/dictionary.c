@@ -342,15 +342,34 @@ dictionary_compressor_finish(DictionaryCompressor *compressor)
 /// Decompressor ///
 ////////////////////
 
+/* decompress the dictionary items stored at data, the tail of compressed, into values */
+static void
+dictionary_decompress_items(const DictionaryCompressed *compressed, const char *data,
+							Datum *values)
+{
+	Size remaining_size = VARSIZE(compressed) - (data - (char *) compressed);
+	DecompressionIterator *dictionary_iterator =
+		array_decompression_iterator_alloc_forward(data,
+												   remaining_size,
+												   compressed->element_type,
+												   /* has_nulls */ false);
+
+	for (int i = 0; i < compressed->num_distinct; i++)
+	{
+		DecompressResult res = array_decompression_iterator_try_next_forward(dictionary_iterator);
+		Assert(!res.is_null);
+		Assert(!res.is_done);
+		values[i] = res.val;
+	}
+	Assert(array_decompression_iterator_try_next_forward(dictionary_iterator).is_done);
+}
+
 static void
 dictionary_decompression_iterator_init(DictionaryDecompressionIterator *iter, const char *data,
 									   bool scan_forward, Oid element_type)
 {
 	const DictionaryCompressed *bitmap = (const DictionaryCompressed *) data;
-	Size total_size = VARSIZE(bitmap);
-	Size remaining_size;
 	Simple8bRleSerialized *s8_bitmap;
-	DecompressionIterator *dictionary_iterator;
 
 	*iter = (DictionaryDecompressionIterator){
 		.base = {
@@ -381,21 +400,7 @@ dictionary_decompression_iterator_init(DictionaryDecompressionIterator *iter, co
 			simple8brle_decompression_iterator_init_reverse(&iter->nulls, s8_null);
 	}
 
-	remaining_size = total_size - (data - (char *) bitmap);
-
-	dictionary_iterator = array_decompression_iterator_alloc_forward(data,
-																	 remaining_size,
-																	 bitmap->element_type,
-																	 /* has_nulls */ false);
-
-	for (int i = 0; i < bitmap->num_distinct; i++)
-	{
-		DecompressResult res = array_decompression_iterator_try_next_forward(dictionary_iterator);
-		Assert(!res.is_null);
-		Assert(!res.is_done);
-		iter->values[i] = res.val;
-	}
-	Assert(array_decompression_iterator_try_next_forward(dictionary_iterator).is_done);
+	dictionary_decompress_items(bitmap, data, iter->values);
 }
 DecompressionIterator *
 tsl_dictionary_decompression_iterator_from_datum_forward(Datum dictionary_compressed,
@@ -499,6 +504,77 @@ dictionary_decompression_iterator_try_next_reverse(DecompressionIterator *iter_b
 	};
 }
 
+/*
+ * Bulk decompression of a whole dictionary value. The dictionary indexes and
+ * the NULL bitmap are unpacked with the bulk simple8b decoder, the dictionary
+ * items are decompressed once into a result of their own, and the values are
+ * then gathered from it by index.
+ */
+DecompressAllResult *
+dictionary_decompress_all(Datum dictionary_compressed, Oid element_type)
+{
+	const DictionaryCompressed *compressed =
+		(const DictionaryCompressed *) PG_DETOAST_DATUM(dictionary_compressed);
+	const char *data = (const char *) compressed + sizeof(DictionaryCompressed);
+	Simple8bRleSerialized *s8_indexes = bytes_deserialize_simple8b_and_advance(&data);
+	bool has_nulls = compressed->has_nulls == 1;
+	DecompressAllResult *items;
+	DecompressAllResult *result;
+	Datum *item_datums;
+	uint64 *indexes;
+	uint64 *nulls = NULL;
+	uint32 num_indexes;
+	uint32 num_values;
+	uint32 index_pos = 0;
+	uint32 row;
+
+	indexes = simple8brle_decompress_all(s8_indexes, &num_indexes);
+	num_values = num_indexes;
+	if (has_nulls)
+		nulls = simple8brle_decompress_all(bytes_deserialize_simple8b_and_advance(&data),
+										   &num_values);
+
+	item_datums = palloc(sizeof(Datum) * Max(compressed->num_distinct, 1));
+	dictionary_decompress_items(compressed, data, item_datums);
+
+	items = decompress_all_result_create(element_type, compressed->num_distinct, false);
+	for (row = 0; row < compressed->num_distinct; row++)
+		decompress_all_result_set_datum(items, row, item_datums[row]);
+
+	result = decompress_all_result_create(element_type, num_values, has_nulls);
+
+	for (row = 0; row < num_values; row++)
+	{
+		uint64 index;
+
+		if (has_nulls && nulls[row] != 0)
+		{
+			decompress_all_result_set_null(result, row);
+			continue;
+		}
+
+		if (index_pos >= num_indexes)
+			elog(ERROR, "dictionary compressed data is missing values");
+
+		index = indexes[index_pos++];
+		if (index >= compressed->num_distinct)
+			elog(ERROR, "invalid dictionary index " UINT64_FORMAT, index);
+
+		if (result->value_bytes == 0)
+			((Datum *) result->values)[row] = ((Datum *) items->values)[index];
+		else
+			memcpy((char *) result->values + row * result->value_bytes,
+				   (char *) items->values + index * items->value_bytes,
+				   result->value_bytes);
+	}
+
+	pfree(indexes);
+	if (nulls != NULL)
+		pfree(nulls);
+
+	return result;
+}
+
 /////////////////////
 /// SQL Functions ///
 /////////////////////
@@ -41,6 +41,9 @@ tsl_dictionary_decompression_iterator_from_datum_reverse(Datum dictionary_compre
 extern DecompressResult
 dictionary_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
 
+extern DecompressAllResult *dictionary_decompress_all(Datum dictionary_compressed,
+													   Oid element_type);
+
 extern void dictionary_compressed_send(CompressedDataHeader *header, StringInfo buffer);
 extern Datum dictionary_compressed_recv(StringInfo buf);
 
@@ -55,6 +58,7 @@ extern Datum tsl_dictionary_compressor_finish(PG_FUNCTION_ARGS);
 		.compressed_data_recv = dictionary_compressed_recv,                                        \
 		.compressor_for_type = dictionary_compressor_for_type,                                     \
 		.compressed_data_storage = TOAST_STORAGE_EXTENDED,                                         \
+		.decompress_all = dictionary_decompress_all,                                               \
 	}
 
 #endif
@@ -0,0 +1,757 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+#include "compression/for.h"
+
+#include <catalog/pg_type.h>
+#include <libpq/pqformat.h>
+#include <utils/date.h>
+#include <utils/timestamp.h>
+
+#include <adts/uint64_vec.h>
+
+#include "compression/compression.h"
+#include "compression/simple8b_rle.h"
+
+typedef struct ForCompressed
+{
+	CompressedDataHeaderFields;
+	uint8 has_nulls; /* 1 if this has a NULLs bitmap after the blocks, 0 otherwise */
+	uint8 bit_width; /* width of every packed value, 0 if all values equal the reference */
+	uint8 padding[1];
+	uint32 num_values; /* number of non-NULL values */
+	uint32 num_blocks;
+	uint64 reference;
+	uint64 blocks[FLEXIBLE_ARRAY_MEMBER];
+} ForCompressed;
+
+static void
+pg_attribute_unused() assertions(void)
+{
+	ForCompressed test_val = { { 0 } };
+	/* make sure no padding bytes make it to disk */
+	StaticAssertStmt(sizeof(ForCompressed) ==
+						 sizeof(test_val.vl_len_) + sizeof(test_val.compression_algorithm) +
+							 sizeof(test_val.has_nulls) + sizeof(test_val.bit_width) +
+							 sizeof(test_val.padding) + sizeof(test_val.num_values) +
+							 sizeof(test_val.num_blocks) + sizeof(test_val.reference),
+					 "ForCompressed wrong size");
+	StaticAssertStmt(sizeof(ForCompressed) == 24, "ForCompressed wrong size");
+}
+
+typedef struct ForDecompressionIterator
+{
+	DecompressionIterator base;
+	const uint64 *blocks;
+	uint64 reference;
+	uint64 mask;
+	uint8 bit_width;
+	uint32 values_per_block;
+	uint32 num_values;
+	int64 next_value;
+	Simple8bRleDecompressionIterator nulls;
+	bool has_nulls;
+} ForDecompressionIterator;
+
+typedef struct ForCompressor
+{
+	uint64_vec values;
+	Simple8bRleCompressor nulls;
+	bool has_nulls;
+	int64 min;
+	int64 max;
+} ForCompressor;
+
+typedef struct ExtendedCompressor
+{
+	Compressor base;
+	ForCompressor *internal;
+} ExtendedCompressor;
+
+/*
+ * Values are packed at one of the simple8b bit widths so that the simple8b
+ * kernels can unpack them, which wastes a few bits per block for some widths.
+ */
+static uint8
+for_bit_width_for_range(uint64 range)
+{
+	uint8 bits = 0;
+	uint8 selector;
+
+	while (bits < 64 && (range >> bits) != 0)
+		bits++;
+
+	if (bits == 0)
+		return 0;
+
+	for (selector = SIMPLE8B_MINCODE; SIMPLE8B_BIT_LENGTH[selector] < bits; selector++)
+		;
+
+	return SIMPLE8B_BIT_LENGTH[selector];
+}
+
+static uint8
+for_selector_for_bit_width(uint8 bit_width)
+{
+	uint8 selector;
+
+	for (selector = SIMPLE8B_MINCODE; selector < SIMPLE8B_RLE_SELECTOR; selector++)
+	{
+		if (SIMPLE8B_BIT_LENGTH[selector] == bit_width)
+			return selector;
+	}
+
+	elog(ERROR, "invalid bit width %d in frame-of-reference compressed data", bit_width);
+	pg_unreachable();
+}
+
+static inline uint32
+for_num_blocks(uint8 bit_width, uint32 num_values)
+{
+	uint32 values_per_block;
+
+	if (bit_width == 0)
+		return 0;
+
+	values_per_block = 64 / bit_width;
+	return (num_values + values_per_block - 1) / values_per_block;
+}
+
+static inline uint64
+for_mask(uint8 bit_width)
+{
+	return bit_width == 64 ? PG_UINT64_MAX : (UINT64CONST(1) << bit_width) - 1;
+}
+
+static void
+for_compressor_append_bool(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetBool(val) ? 1 : 0);
+}
+
+static void
+for_compressor_append_int16(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetInt16(val));
+}
+
+static void
+for_compressor_append_int32(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetInt32(val));
+}
+
+static void
+for_compressor_append_int64(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetInt64(val));
+}
+
+static void
+for_compressor_append_date(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetDateADT(val));
+}
+
+static void
+for_compressor_append_timestamp(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetTimestamp(val));
+}
+
+static void
+for_compressor_append_timestamptz(Compressor *compressor, Datum val)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_value(extended->internal, DatumGetTimestampTz(val));
+}
+
+static void
+for_compressor_append_null_value(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	if (extended->internal == NULL)
+		extended->internal = for_compressor_alloc();
+
+	for_compressor_append_null(extended->internal);
+}
+
+static void *
+for_compressor_finish_and_reset(Compressor *compressor)
+{
+	ExtendedCompressor *extended = (ExtendedCompressor *) compressor;
+	void *compressed;
+
+	if (extended->internal == NULL)
+		return NULL;
+
+	compressed = for_compressor_finish(extended->internal);
+	pfree(extended->internal);
+	extended->internal = NULL;
+	return compressed;
+}
+
+const Compressor for_bool_compressor = {
+	.append_val = for_compressor_append_bool,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+
+const Compressor for_uint16_compressor = {
+	.append_val = for_compressor_append_int16,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+const Compressor for_uint32_compressor = {
+	.append_val = for_compressor_append_int32,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+const Compressor for_uint64_compressor = {
+	.append_val = for_compressor_append_int64,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+
+const Compressor for_date_compressor = {
+	.append_val = for_compressor_append_date,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+
+const Compressor for_timestamp_compressor = {
+	.append_val = for_compressor_append_timestamp,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+
+const Compressor for_timestamptz_compressor = {
+	.append_val = for_compressor_append_timestamptz,
+	.append_null = for_compressor_append_null_value,
+	.finish = for_compressor_finish_and_reset,
+};
+
+Compressor *
+for_compressor_for_type(Oid element_type)
+{
+	ExtendedCompressor *compressor = palloc(sizeof(*compressor));
+	switch (element_type)
+	{
+		case BOOLOID:
+			*compressor = (ExtendedCompressor){ .base = for_bool_compressor };
+			return &compressor->base;
+		case INT2OID:
+			*compressor = (ExtendedCompressor){ .base = for_uint16_compressor };
+			return &compressor->base;
+		case INT4OID:
+			*compressor = (ExtendedCompressor){ .base = for_uint32_compressor };
+			return &compressor->base;
+		case INT8OID:
+			*compressor = (ExtendedCompressor){ .base = for_uint64_compressor };
+			return &compressor->base;
+		case DATEOID:
+			*compressor = (ExtendedCompressor){ .base = for_date_compressor };
+			return &compressor->base;
+		case TIMESTAMPOID:
+			*compressor = (ExtendedCompressor){ .base = for_timestamp_compressor };
+			return &compressor->base;
+		case TIMESTAMPTZOID:
+			*compressor = (ExtendedCompressor){ .base = for_timestamptz_compressor };
+			return &compressor->base;
+		default:
+			elog(ERROR, "invalid type for frame-of-reference compressor %d", element_type);
+	}
+
+	pg_unreachable();
+}
+
+ForCompressor *
+for_compressor_alloc(void)
+{
+	ForCompressor *compressor = palloc0(sizeof(*compressor));
+	uint64_vec_init(&compressor->values, CurrentMemoryContext, 0);
+	simple8brle_compressor_init(&compressor->nulls);
+	compressor->min = PG_INT64_MAX;
+	compressor->max = PG_INT64_MIN;
+	return compressor;
+}
+
+void
+for_compressor_append_null(ForCompressor *compressor)
+{
+	compressor->has_nulls = true;
+	simple8brle_compressor_append(&compressor->nulls, 1);
+}
+
+void
+for_compressor_append_value(ForCompressor *compressor, int64 next_val)
+{
+	/* the width is only known once we have seen all values, so buffer them */
+	uint64_vec_append(&compressor->values, (uint64) next_val);
+	simple8brle_compressor_append(&compressor->nulls, 0);
+
+	if (next_val < compressor->min)
+		compressor->min = next_val;
+	if (next_val > compressor->max)
+		compressor->max = next_val;
+}
+
+static ForCompressed *
+for_from_parts(uint8 bit_width, uint64 reference, uint32 num_values, const uint64 *blocks,
+			   uint32 num_blocks, Simple8bRleSerialized *nulls)
+{
+	uint32 nulls_size = 0;
+	Size blocks_size = sizeof(uint64) * num_blocks;
+	Size compressed_size;
+	ForCompressed *compressed;
+
+	if (nulls != NULL)
+		nulls_size = simple8brle_serialized_total_size(nulls);
+
+	compressed_size = sizeof(ForCompressed) + blocks_size + nulls_size;
+
+	if (!AllocSizeIsValid(compressed_size))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("compressed size exceeds the maximum allowed (%d)", (int) MaxAllocSize)));
+
+	compressed = palloc0(compressed_size);
+	SET_VARSIZE(&compressed->vl_len_, compressed_size);
+
+	compressed->compression_algorithm = COMPRESSION_ALGORITHM_FOR;
+	compressed->has_nulls = nulls_size != 0 ? 1 : 0;
+	compressed->bit_width = bit_width;
+	compressed->num_values = num_values;
+	compressed->num_blocks = num_blocks;
+	compressed->reference = reference;
+
+	if (blocks != NULL)
+		memcpy(compressed->blocks, blocks, blocks_size);
+
+	if (compressed->has_nulls == 1)
+	{
+		Assert(nulls->num_elements > num_values);
+		bytes_serialize_simple8b_and_advance(((char *) compressed->blocks) + blocks_size,
+											 nulls_size,
+											 nulls);
+	}
+
+	return compressed;
+}
+
+void *
+for_compressor_finish(ForCompressor *compressor)
+{
+	Simple8bRleSerialized *nulls = simple8brle_compressor_finish(&compressor->nulls);
+	uint32 num_values = compressor->values.num_elements;
+	uint64 reference = (uint64) compressor->min;
+	uint8 bit_width;
+	uint32 num_blocks;
+	uint64 *blocks = NULL;
+	ForCompressed *compressed;
+
+	if (num_values == 0)
+		return NULL;
+
+	/* unsigned arithmetic, so that a range spanning all of int64 doesn't overflow */
+	bit_width = for_bit_width_for_range((uint64) compressor->max - reference);
+	num_blocks = for_num_blocks(bit_width, num_values);
+
+	if (num_blocks > 0)
+	{
+		uint32 values_per_block = 64 / bit_width;
+		uint32 i;
+
+		blocks = palloc0(sizeof(*blocks) * num_blocks);
+		for (i = 0; i < num_values; i++)
+		{
+			uint64 offset = *uint64_vec_get(&compressor->values, i) - reference;
+			blocks[i / values_per_block] |= offset << ((i % values_per_block) * bit_width);
+		}
+	}
+
+	compressed = for_from_parts(bit_width,
+								reference,
+								num_values,
+								blocks,
+								num_blocks,
+								compressor->has_nulls ? nulls : NULL);
+
+	Assert(compressed->compression_algorithm == COMPRESSION_ALGORITHM_FOR);
+	return compressed;
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+static Simple8bRleSerialized *
+for_compressed_get_nulls(ForCompressed *compressed)
+{
+	const char *data = (char *) &compressed->blocks[compressed->num_blocks];
+
+	Assert(compressed->has_nulls == 1);
+	return bytes_deserialize_simple8b_and_advance(&data);
+}
+
+static void
+for_decompression_iterator_init(ForDecompressionIterator *iter, ForCompressed *compressed,
+								Oid element_type, bool forward)
+{
+	bool has_nulls = compressed->has_nulls == 1;
+
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	*iter = (ForDecompressionIterator){
+		.base = {
+			.compression_algorithm = COMPRESSION_ALGORITHM_FOR,
+			.forward = forward,
+			.element_type = element_type,
+			.try_next = forward ? for_decompression_iterator_try_next_forward :
+								  for_decompression_iterator_try_next_reverse,
+		},
+		.blocks = compressed->blocks,
+		.reference = compressed->reference,
+		.mask = for_mask(compressed->bit_width),
+		.bit_width = compressed->bit_width,
+		.values_per_block = compressed->bit_width == 0 ? 0 : 64 / compressed->bit_width,
+		.num_values = compressed->num_values,
+		.next_value = forward ? 0 : (int64) compressed->num_values - 1,
+		.has_nulls = has_nulls,
+	};
+
+	if (has_nulls)
+	{
+		Simple8bRleSerialized *nulls = for_compressed_get_nulls(compressed);
+
+		if (forward)
+			simple8brle_decompression_iterator_init_forward(&iter->nulls, nulls);
+		else
+			simple8brle_decompression_iterator_init_reverse(&iter->nulls, nulls);
+	}
+}
+
+static inline DecompressResult
+convert_from_internal(DecompressResultInternal res_internal, Oid element_type)
+{
+	if (res_internal.is_done || res_internal.is_null)
+	{
+		return (DecompressResult){
+			.is_done = res_internal.is_done,
+			.is_null = res_internal.is_null,
+		};
+	}
+
+	switch (element_type)
+	{
+		case BOOLOID:
+			return (DecompressResult){
+				.val = BoolGetDatum(res_internal.val),
+			};
+		case INT8OID:
+			return (DecompressResult){
+				.val = Int64GetDatum(res_internal.val),
+			};
+		case INT4OID:
+			return (DecompressResult){
+				.val = Int32GetDatum(res_internal.val),
+			};
+		case INT2OID:
+			return (DecompressResult){
+				.val = Int16GetDatum(res_internal.val),
+			};
+		case DATEOID:
+			return (DecompressResult){
+				.val = DateADTGetDatum(res_internal.val),
+			};
+		case TIMESTAMPTZOID:
+			return (DecompressResult){
+				.val = TimestampTzGetDatum(res_internal.val),
+			};
+		case TIMESTAMPOID:
+			return (DecompressResult){
+				.val = TimestampGetDatum(res_internal.val),
+			};
+		default:
+			elog(ERROR,
+				 "invalid type requested from frame-of-reference decompression %d",
+				 element_type);
+	}
+
+	pg_unreachable();
+}
+
+static inline uint64
+for_get_value(const ForDecompressionIterator *iter, uint32 index)
+{
+	uint64 block;
+
+	if (iter->bit_width == 0)
+		return iter->reference;
+
+	block = iter->blocks[index / iter->values_per_block];
+	return ((block >> ((index % iter->values_per_block) * iter->bit_width)) & iter->mask) +
+		   iter->reference;
+}
+
+static DecompressResultInternal
+for_decompression_iterator_try_next_internal(ForDecompressionIterator *iter)
+{
+	uint64 val;
+
+	/* check for a null value */
+	if (iter->has_nulls)
+	{
+		Simple8bRleDecompressResult result =
+			iter->base.forward ? simple8brle_decompression_iterator_try_next_forward(&iter->nulls) :
+								 simple8brle_decompression_iterator_try_next_reverse(&iter->nulls);
+		if (result.is_done)
+			return (DecompressResultInternal){
+				.is_done = true,
+			};
+
+		if (result.val != 0)
+		{
+			Assert(result.val == 1);
+			return (DecompressResultInternal){
+				.is_null = true,
+			};
+		}
+	}
+
+	if (iter->next_value < 0 || iter->next_value >= iter->num_values)
+		return (DecompressResultInternal){
+			.is_done = true,
+		};
+
+	val = for_get_value(iter, (uint32) iter->next_value);
+	iter->next_value += iter->base.forward ? 1 : -1;
+
+	return (DecompressResultInternal){
+		.val = val,
+	};
+}
+
+DecompressResult
+for_decompression_iterator_try_next_forward(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_FOR && iter->forward);
+	return convert_from_internal(for_decompression_iterator_try_next_internal(
+									 (ForDecompressionIterator *) iter),
+								 iter->element_type);
+}
+
+DecompressResult
+for_decompression_iterator_try_next_reverse(DecompressionIterator *iter)
+{
+	Assert(iter->compression_algorithm == COMPRESSION_ALGORITHM_FOR && !iter->forward);
+	return convert_from_internal(for_decompression_iterator_try_next_internal(
+									 (ForDecompressionIterator *) iter),
+								 iter->element_type);
+}
+
+DecompressionIterator *
+for_decompression_iterator_from_datum_forward(Datum for_compressed, Oid element_type)
+{
+	ForDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	for_decompression_iterator_init(iterator,
+									(void *) PG_DETOAST_DATUM(for_compressed),
+									element_type,
+									true);
+	return &iterator->base;
+}
+
+DecompressionIterator *
+for_decompression_iterator_from_datum_reverse(Datum for_compressed, Oid element_type)
+{
+	ForDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	for_decompression_iterator_init(iterator,
+									(void *) PG_DETOAST_DATUM(for_compressed),
+									element_type,
+									false);
+	return &iterator->base;
+}
+
+/*
+ * Bulk decompression of a whole frame-of-reference value. All blocks are
+ * unpacked at once with the (SIMD) simple8b kernels, the reference is added in
+ * a single vectorizable pass, and NULLs are spread out in place afterwards.
+ */
+DecompressAllResult *
+for_decompress_all(Datum compressed_datum, Oid element_type)
+{
+	ForCompressed *compressed = (ForCompressed *) PG_DETOAST_DATUM(compressed_datum);
+	bool has_nulls = compressed->has_nulls == 1;
+	uint32 num_values = compressed->num_values;
+	uint32 num_rows = num_values;
+	uint64 *nulls = NULL;
+	DecompressAllResult *result;
+	DecompressDataInternal *internal;
+	uint32 buffer_size;
+	uint32 i;
+
+	Assert(compressed->has_nulls == 0 || compressed->has_nulls == 1);
+
+	if (has_nulls)
+		nulls = simple8brle_decompress_all(for_compressed_get_nulls(compressed), &num_rows);
+
+	if (num_rows < num_values)
+		elog(ERROR, "frame-of-reference compressed data has too many values");
+
+	result = decompress_all_result_create(element_type, num_rows, has_nulls);
+
+	/* whole blocks are unpacked, so there may be some extra values at the end */
+	buffer_size = num_rows;
+	if (compressed->bit_width != 0)
+		buffer_size = Max(buffer_size, compressed->num_blocks * (64 / compressed->bit_width));
+	internal = palloc(sizeof(*internal) * Max(buffer_size, 1));
+
+	if (compressed->bit_width == 0)
+	{
+		for (i = 0; i < num_values; i++)
+			internal[i] = compressed->reference;
+	}
+	else
+	{
+		uint64 reference = compressed->reference;
+
+		simple8brle_unpack_blocks(for_selector_for_bit_width(compressed->bit_width),
+								  compressed->blocks,
+								  compressed->num_blocks,
+								  internal);
+
+		for (i = 0; i < num_values; i++)
+			internal[i] += reference;
+	}
+
+	if (has_nulls)
+	{
+		/*
+		 * Move the values to their rows, back to front so that the values
+		 * that are not moved yet are never overwritten.
+		 */
+		int64 value_index = (int64) num_values - 1;
+		int64 row;
+
+		for (row = (int64) num_rows - 1; row >= 0; row--)
+		{
+			if (nulls[row] != 0)
+			{
+				decompress_all_result_set_null(result, row);
+				internal[row] = 0;
+				continue;
+			}
+
+			if (value_index < 0)
+				elog(ERROR, "frame-of-reference compressed data is missing values");
+
+			internal[row] = internal[value_index--];
+		}
+
+		pfree(nulls);
+	}
+
+	decompress_all_result_fill_from_internal(result, internal);
+	pfree(internal);
+
+	return result;
+}
+
+/**********************************************************************************/
+/**********************************************************************************/
+
+void
+for_compressed_send(CompressedDataHeader *header, StringInfo buffer)
+{
+	const ForCompressed *data = (ForCompressed *) header;
+	uint32 i;
+
+	Assert(header->compression_algorithm == COMPRESSION_ALGORITHM_FOR);
+	pq_sendbyte(buffer, data->has_nulls);
+	pq_sendbyte(buffer, data->bit_width);
+	pq_sendint64(buffer, data->reference);
+	pq_sendint32(buffer, data->num_values);
+	pq_sendint32(buffer, data->num_blocks);
+	for (i = 0; i < data->num_blocks; i++)
+		pq_sendint64(buffer, data->blocks[i]);
+	if (data->has_nulls)
+		simple8brle_serialized_send(buffer, for_compressed_get_nulls((ForCompressed *) data));
+}
+
+Datum
+for_compressed_recv(StringInfo buffer)
+{
+	uint8 has_nulls;
+	uint8 bit_width;
+	uint64 reference;
+	uint32 num_values;
+	uint32 num_blocks;
+	uint64 *blocks = NULL;
+	Simple8bRleSerialized *nulls = NULL;
+	ForCompressed *compressed;
+	uint32 i;
+
+	has_nulls = pq_getmsgbyte(buffer);
+	if (has_nulls != 0 && has_nulls != 1)
+		elog(ERROR, "invalid recv in frame-of-reference: bad bool");
+
+	bit_width = pq_getmsgbyte(buffer);
+	if (bit_width != 0)
+		(void) for_selector_for_bit_width(bit_width);
+
+	reference = pq_getmsgint64(buffer);
+	num_values = pq_getmsgint(buffer, 4);
+	num_blocks = pq_getmsgint(buffer, 4);
+	if (num_blocks != for_num_blocks(bit_width, num_values))
+		elog(ERROR, "invalid recv in frame-of-reference: bad number of blocks");
+
+	if (num_blocks > 0)
+	{
+		if (num_blocks > (buffer->len - buffer->cursor) / sizeof(uint64))
+			elog(ERROR, "invalid recv in frame-of-reference: too many blocks");
+
+		blocks = palloc(sizeof(*blocks) * num_blocks);
+		for (i = 0; i < num_blocks; i++)
+			blocks[i] = pq_getmsgint64(buffer);
+	}
+
+	if (has_nulls)
+	{
+		nulls = simple8brle_serialized_recv(buffer);
+		if (nulls->num_elements <= num_values)
+			elog(ERROR, "invalid recv in frame-of-reference: bad NULL bitmap");
+	}
+
+	compressed = for_from_parts(bit_width, reference, num_values, blocks, num_blocks, nulls);
+
+	PG_RETURN_POINTER(compressed);
+}
@@ -0,0 +1,63 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+/*
+ * Frame-of-reference (FOR) is used to encode integers or integer-like objects whose values fall
+ * into a small range but have no correlation between consecutive rows, e.g. status codes or
+ * other enum-like columns. For such data the zigzag encoded delta-of-deltas used by deltadelta
+ * need more bits than the values themselves.
+ *
+ * We store the minimum of all values as the reference and bit-pack the differences between each
+ * value and the reference at a single fixed width, using the smallest of the simple8b bit widths
+ * that fits the largest difference. Values never cross a 64-bit block boundary, so every block
+ * can be unpacked on its own with the same kernels as simple8b, and any value can be located
+ * directly from its index. If all values are equal no blocks are stored at all.
+ *
+ * NULLs are stored as a separate simple8b_rle compressed bitmap, the same way as in deltadelta.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_FOR_H
+#define TIMESCALEDB_TSL_COMPRESSION_FOR_H
+
+#include <postgres.h>
+#include <c.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+
+#include "compression/compression.h"
+
+typedef struct ForCompressor ForCompressor;
+typedef struct ForCompressed ForCompressed;
+typedef struct ForDecompressionIterator ForDecompressionIterator;
+
+extern Compressor *for_compressor_for_type(Oid element_type);
+extern ForCompressor *for_compressor_alloc(void);
+extern void for_compressor_append_null(ForCompressor *compressor);
+extern void for_compressor_append_value(ForCompressor *compressor, int64 next_val);
+extern void *for_compressor_finish(ForCompressor *compressor);
+
+extern DecompressionIterator *for_decompression_iterator_from_datum_forward(Datum for_compressed,
+																			  Oid element_type);
+extern DecompressionIterator *for_decompression_iterator_from_datum_reverse(Datum for_compressed,
+																			  Oid element_type);
+extern DecompressResult for_decompression_iterator_try_next_forward(DecompressionIterator *iter);
+extern DecompressResult for_decompression_iterator_try_next_reverse(DecompressionIterator *iter);
+
+extern DecompressAllResult *for_decompress_all(Datum compressed, Oid element_type);
+
+extern void for_compressed_send(CompressedDataHeader *header, StringInfo buffer);
+extern Datum for_compressed_recv(StringInfo buf);
+
+#define FOR_ALGORITHM_DEFINITION                                                                   \
+	{                                                                                              \
+		.iterator_init_forward = for_decompression_iterator_from_datum_forward,                    \
+		.iterator_init_reverse = for_decompression_iterator_from_datum_reverse,                    \
+		.compressed_data_send = for_compressed_send,                                               \
+		.compressed_data_recv = for_compressed_recv,                                               \
+		.compressor_for_type = for_compressor_for_type,                                            \
+		.compressed_data_storage = TOAST_STORAGE_EXTERNAL,                                         \
+		.decompress_all = for_decompress_all,                                                      \
+	}
+
+#endif
@@ -589,10 +589,10 @@ compressed_gorilla_data_init_from_datum(CompressedGorillaData *data, Datum goril
 												  gorilla_compressed));
 }
 
-DecompressionIterator *
-gorilla_decompression_iterator_from_datum_forward(Datum gorilla_compressed, Oid element_type)
+static void
+gorilla_decompression_iterator_init_forward(GorillaDecompressionIterator *iterator,
+											Datum gorilla_compressed, Oid element_type)
 {
-	GorillaDecompressionIterator *iterator = palloc(sizeof(*iterator));
 	iterator->base.compression_algorithm = COMPRESSION_ALGORITHM_GORILLA;
 	iterator->base.forward = true;
 	iterator->base.element_type = element_type;
@@ -613,7 +613,13 @@ gorilla_decompression_iterator_from_datum_forward(Datum gorilla_compressed, Oid
 	if (iterator->has_nulls)
 		simple8brle_decompression_iterator_init_forward(&iterator->nulls,
 														iterator->gorilla_data.nulls);
+}
 
+DecompressionIterator *
+gorilla_decompression_iterator_from_datum_forward(Datum gorilla_compressed, Oid element_type)
+{
+	GorillaDecompressionIterator *iterator = palloc(sizeof(*iterator));
+	gorilla_decompression_iterator_init_forward(iterator, gorilla_compressed, element_type);
 	return &iterator->base;
 }
 
@@ -727,6 +733,109 @@ gorilla_decompression_iterator_try_next_forward(DecompressionIterator *iter_base
 								 iter_base->element_type);
 }
 
+/*
+ * Bulk decompression of a whole gorilla value. The simple8b-encoded tags,
+ * xor lengths and NULL bitmap are unpacked up front with the bulk simple8b
+ * decoder, so that the main loop only has to read the leading zeros and xors
+ * from their bit arrays, and the whole batch is converted from the internal
+ * representation at the end.
+ */
+DecompressAllResult *
+gorilla_decompress_all(Datum gorilla_compressed, Oid element_type)
+{
+	CompressedGorillaData gorilla_data;
+	BitArrayIterator leading_zeros;
+	BitArrayIterator xors;
+	DecompressAllResult *result;
+	DecompressDataInternal *internal;
+	uint64 *tag0s;
+	uint64 *tag1s;
+	uint64 *num_bits_used;
+	uint64 *nulls = NULL;
+	uint32 num_tag0s;
+	uint32 num_tag1s;
+	uint32 num_num_bits_used;
+	uint32 num_values;
+	uint32 tag0_index = 0;
+	uint32 tag1_index = 0;
+	uint32 num_bits_used_index = 0;
+	uint64 prev_val = 0;
+	uint8 prev_leading_zeroes = 0;
+	uint8 prev_xor_bits_used = 0;
+	uint32 row;
+
+	compressed_gorilla_data_init_from_datum(&gorilla_data, gorilla_compressed);
+
+	tag0s = simple8brle_decompress_all(gorilla_data.tag0s, &num_tag0s);
+	tag1s = simple8brle_decompress_all(gorilla_data.tag1s, &num_tag1s);
+	num_bits_used =
+		simple8brle_decompress_all(gorilla_data.num_bits_used_per_xor, &num_num_bits_used);
+	bit_array_iterator_init(&leading_zeros, &gorilla_data.leading_zeros);
+	bit_array_iterator_init(&xors, &gorilla_data.xors);
+
+	num_values = num_tag0s;
+	if (gorilla_data.nulls != NULL)
+		nulls = simple8brle_decompress_all(gorilla_data.nulls, &num_values);
+
+	result = decompress_all_result_create(element_type, num_values, nulls != NULL);
+
+	/* 64-bit types are decoded in place, everything else is narrowed afterwards */
+	if (result->value_bytes == sizeof(DecompressDataInternal))
+		internal = result->values;
+	else
+		internal = palloc(sizeof(*internal) * Max(num_values, 1));
+
+	for (row = 0; row < num_values; row++)
+	{
+		if (nulls != NULL && nulls[row] != 0)
+		{
+			decompress_all_result_set_null(result, row);
+			internal[row] = 0;
+			continue;
+		}
+
+		if (tag0_index >= num_tag0s)
+			elog(ERROR, "gorilla compressed data is missing values");
+
+		if (tag0s[tag0_index++] != 0)
+		{
+			uint64 xor ;
+
+			if (tag1_index >= num_tag1s)
+				elog(ERROR, "gorilla compressed data is missing values");
+
+			if (tag1s[tag1_index++] != 0)
+			{
+				/* get new xor sizes */
+				if (num_bits_used_index >= num_num_bits_used)
+					elog(ERROR, "gorilla compressed data is missing values");
+
+				prev_leading_zeroes = bit_array_iter_next(&leading_zeros, BITS_PER_LEADING_ZEROS);
+				prev_xor_bits_used = num_bits_used[num_bits_used_index++];
+			}
+
+			xor = bit_array_iter_next(&xors, prev_xor_bits_used);
+			if (prev_leading_zeroes + prev_xor_bits_used < 64)
+				xor <<= 64 - (prev_leading_zeroes + prev_xor_bits_used);
+			prev_val ^= xor;
+		}
+
+		internal[row] = prev_val;
+	}
+
+	decompress_all_result_fill_from_internal(result, internal);
+
+	if ((void *) internal != result->values)
+		pfree(internal);
+	pfree(tag0s);
+	pfree(tag1s);
+	pfree(num_bits_used);
+	if (nulls != NULL)
+		pfree(nulls);
+
+	return result;
+}
+
 /****************************************
  *** reversed  DecompressionIterator  ***
  ****************************************/
@@ -0,0 +1,420 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Selection of compressed batches by segmentby values and orderby ranges,
+ * used to decompress only part of a compressed chunk.
+ */
+#include <postgres.h>
+#include <access/attnum.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <fmgr.h>
+#include <utils/builtins.h>
+#include <utils/jsonb.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/typcache.h>
+
+#include "compat.h"
+#include "compression/create.h"
+#include "compression/segment_filter.h"
+#include "hypertable_compression.h"
+
+typedef struct SegmentFilterCondition
+{
+	bool is_segmentby;
+	/* the segmentby column, or the min metadata column of an orderby column */
+	AttrNumber attno;
+	/* the max metadata column of an orderby column */
+	AttrNumber max_attno;
+	StrategyNumber strategy;
+	Datum value;
+	FmgrInfo *cmp;
+	Oid collation;
+} SegmentFilterCondition;
+
+struct SegmentFilter
+{
+	Oid compressed_relid;
+	List *column_compression_info;
+	List *conditions;
+};
+
+SegmentFilter *
+segment_filter_create(Oid compressed_relid, List *column_compression_info)
+{
+	SegmentFilter *filter = palloc0(sizeof(SegmentFilter));
+
+	filter->compressed_relid = compressed_relid;
+	filter->column_compression_info = column_compression_info;
+	return filter;
+}
+
+static FormData_hypertable_compression *
+segment_filter_find_column(List *column_compression_info, const char *column_name)
+{
+	ListCell *lc;
+
+	foreach (lc, column_compression_info)
+	{
+		FormData_hypertable_compression *column = lfirst(lc);
+
+		if (namestrcmp(&column->attname, column_name) == 0)
+			return column;
+	}
+
+	return NULL;
+}
+
+/* Only segmentby and orderby columns have the per-batch values we filter on */
+bool
+segment_filter_column_is_supported(List *column_compression_info, const char *column_name)
+{
+	FormData_hypertable_compression *column =
+		segment_filter_find_column(column_compression_info, column_name);
+
+	return column != NULL &&
+		   (column->segmentby_column_index > 0 || column->orderby_column_index > 0);
+}
+
+static AttrNumber
+segment_filter_get_attnum(const SegmentFilter *filter, const char *column_name)
+{
+	AttrNumber attno = get_attnum(filter->compressed_relid, column_name);
+
+	if (attno == InvalidAttrNumber)
+		elog(ERROR,
+			 "column \"%s\" not found in compressed chunk \"%s\"",
+			 column_name,
+			 get_rel_name(filter->compressed_relid));
+
+	return attno;
+}
+
+/*
+ * Add a condition "column <strategy> value". The value must be of the type of
+ * the column.
+ */
+void
+segment_filter_add_condition(SegmentFilter *filter, const char *column_name,
+							 StrategyNumber strategy, Datum value)
+{
+	FormData_hypertable_compression *column =
+		segment_filter_find_column(filter->column_compression_info, column_name);
+	SegmentFilterCondition *cond = palloc0(sizeof(SegmentFilterCondition));
+	TypeCacheEntry *tce;
+	Oid typid;
+	int32 typmod;
+
+	Assert(strategy >= BTLessStrategyNumber && strategy <= BTGreaterStrategyNumber);
+
+	if (!segment_filter_column_is_supported(filter->column_compression_info, column_name))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot filter compressed segments on column \"%s\"", column_name),
+				 errhint("Only segmentby and orderby columns can be used in a segment filter.")));
+
+	cond->is_segmentby = column->segmentby_column_index > 0;
+	if (cond->is_segmentby)
+		cond->attno = segment_filter_get_attnum(filter, column_name);
+	else
+	{
+		cond->attno =
+			segment_filter_get_attnum(filter, compression_column_segment_min_name(column));
+		cond->max_attno =
+			segment_filter_get_attnum(filter, compression_column_segment_max_name(column));
+	}
+
+	get_atttypetypmodcoll(filter->compressed_relid, cond->attno, &typid, &typmod, &cond->collation);
+	tce = lookup_type_cache(typid, TYPECACHE_CMP_PROC_FINFO);
+
+	if (!OidIsValid(tce->cmp_proc))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),
+				 errmsg("could not identify a comparison function for type %s",
+						format_type_be(typid))));
+
+	cond->cmp = &tce->cmp_proc_finfo;
+	cond->strategy = strategy;
+	cond->value = value;
+	filter->conditions = lappend(filter->conditions, cond);
+}
+
+static StrategyNumber
+segment_filter_strategy_from_name(const char *name)
+{
+	if (strcmp(name, "<") == 0)
+		return BTLessStrategyNumber;
+	if (strcmp(name, "<=") == 0)
+		return BTLessEqualStrategyNumber;
+	if (strcmp(name, "=") == 0)
+		return BTEqualStrategyNumber;
+	if (strcmp(name, ">=") == 0)
+		return BTGreaterEqualStrategyNumber;
+	if (strcmp(name, ">") == 0)
+		return BTGreaterStrategyNumber;
+
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("invalid operator \"%s\" in segment filter", name),
+			 errhint("Valid operators are <, <=, =, >= and >.")));
+	pg_unreachable();
+}
+
+/* Convert a JSON scalar into a datum of the column's type using its input function */
+static Datum
+segment_filter_value_from_jsonb(const SegmentFilter *filter, const char *column_name,
+								const JsonbValue *jvalue)
+{
+	FormData_hypertable_compression *column =
+		segment_filter_find_column(filter->column_compression_info, column_name);
+	AttrNumber attno;
+	Oid typid;
+	int32 typmod;
+	Oid collation;
+	Oid infunc;
+	Oid typioparam;
+	char *str;
+
+	switch (jvalue->type)
+	{
+		case jbvString:
+			str = pnstrdup(jvalue->val.string.val, jvalue->val.string.len);
+			break;
+		case jbvNumeric:
+			str = DatumGetCString(
+				DirectFunctionCall1(numeric_out, NumericGetDatum(jvalue->val.numeric)));
+			break;
+		case jbvBool:
+			str = jvalue->val.boolean ? "true" : "false";
+			break;
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("invalid value for column \"%s\" in segment filter", column_name),
+					 errhint("Use a string, number or boolean value.")));
+			pg_unreachable();
+	}
+
+	/* the type of the original column, also for the min/max metadata of orderby columns */
+	if (column == NULL)
+		attno = InvalidAttrNumber;
+	else if (column->segmentby_column_index > 0)
+		attno = get_attnum(filter->compressed_relid, column_name);
+	else
+		attno = get_attnum(filter->compressed_relid, compression_column_segment_min_name(column));
+
+	if (attno == InvalidAttrNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot filter compressed segments on column \"%s\"", column_name),
+				 errhint("Only segmentby and orderby columns can be used in a segment filter.")));
+
+	get_atttypetypmodcoll(filter->compressed_relid, attno, &typid, &typmod, &collation);
+	getTypeInputInfo(typid, &infunc, &typioparam);
+
+	return OidInputFunctionCall(infunc, str, typioparam, typmod);
+}
+
+/*
+ * Add the conditions of a JSON object that maps column names to either a
+ * value, to select batches with that value, or to an object that maps
+ * comparison operators to values, e.g.:
+ *
+ *   {"device_id": 3, "time": {">=": "2020-01-01", "<": "2020-01-02"}}
+ */
+void
+segment_filter_add_jsonb(SegmentFilter *filter, Jsonb *conditions)
+{
+	JsonbIterator *it;
+	JsonbIteratorToken tok;
+	JsonbValue v;
+	char *column_name = NULL;
+
+	if (!JB_ROOT_IS_OBJECT(conditions) || JB_ROOT_IS_SCALAR(conditions))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("segment filter must be a JSON object")));
+
+	it = JsonbIteratorInit(&conditions->root);
+
+	while ((tok = JsonbIteratorNext(&it, &v, true)) != WJB_DONE)
+	{
+		if (tok == WJB_KEY)
+			column_name = pnstrdup(v.val.string.val, v.val.string.len);
+		else if (tok == WJB_VALUE && v.type == jbvBinary)
+		{
+			JsonbIterator *range_it = JsonbIteratorInit(v.val.binary.data);
+			JsonbIteratorToken range_tok;
+			JsonbValue range_v;
+			StrategyNumber strategy = InvalidStrategy;
+			int num_conditions = 0;
+
+			while ((range_tok = JsonbIteratorNext(&range_it, &range_v, true)) != WJB_DONE)
+			{
+				if (range_tok == WJB_BEGIN_ARRAY)
+					ereport(ERROR,
+							(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+							 errmsg("invalid condition for column \"%s\" in segment filter",
+									column_name),
+							 errhint("Use a value or an object of operators and values.")));
+				else if (range_tok == WJB_KEY)
+				{
+					char *name = pnstrdup(range_v.val.string.val, range_v.val.string.len);
+
+					strategy = segment_filter_strategy_from_name(name);
+				}
+				else if (range_tok == WJB_VALUE)
+				{
+					segment_filter_add_condition(filter,
+												 column_name,
+												 strategy,
+												 segment_filter_value_from_jsonb(filter,
+																				 column_name,
+																				 &range_v));
+					num_conditions++;
+				}
+			}
+
+			/* an empty object would match every segment of the chunk */
+			if (num_conditions == 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("empty condition for column \"%s\" in segment filter", column_name),
+						 errhint("Use a value or an object of operators and values.")));
+		}
+		else if (tok == WJB_VALUE)
+			segment_filter_add_condition(filter,
+										 column_name,
+										 BTEqualStrategyNumber,
+										 segment_filter_value_from_jsonb(filter, column_name, &v));
+	}
+
+	if (filter->conditions == NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("segment filter must have at least one condition")));
+}
+
+static inline bool
+segment_filter_strategy_holds(StrategyNumber strategy, int32 cmp)
+{
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			return cmp < 0;
+		case BTLessEqualStrategyNumber:
+			return cmp <= 0;
+		case BTEqualStrategyNumber:
+			return cmp == 0;
+		case BTGreaterEqualStrategyNumber:
+			return cmp >= 0;
+		case BTGreaterStrategyNumber:
+			return cmp > 0;
+		default:
+			elog(ERROR, "invalid strategy %d in segment filter", strategy);
+			pg_unreachable();
+	}
+}
+
+static inline int32
+segment_filter_compare(const SegmentFilterCondition *cond, Datum value)
+{
+	return DatumGetInt32(FunctionCall2Coll(cond->cmp, cond->collation, value, cond->value));
+}
+
+/*
+ * Check if the compressed batch with the given values can contain rows
+ * matching the filter. The conditions are strict, so NULL segmentby values
+ * and batches that only contain NULLs in an orderby column never match.
+ */
+bool
+segment_filter_matches(const SegmentFilter *filter, const Datum *values, const bool *nulls)
+{
+	ListCell *lc;
+
+	foreach (lc, filter->conditions)
+	{
+		SegmentFilterCondition *cond = lfirst(lc);
+		int min_off = AttrNumberGetAttrOffset(cond->attno);
+		int max_off;
+		int32 min_cmp;
+		int32 max_cmp;
+
+		if (cond->is_segmentby)
+		{
+			if (nulls[min_off] ||
+				!segment_filter_strategy_holds(cond->strategy,
+											   segment_filter_compare(cond, values[min_off])))
+				return false;
+			continue;
+		}
+
+		max_off = AttrNumberGetAttrOffset(cond->max_attno);
+		if (nulls[min_off] || nulls[max_off])
+			return false;
+
+		min_cmp = segment_filter_compare(cond, values[min_off]);
+		max_cmp = segment_filter_compare(cond, values[max_off]);
+
+		/* some value in [min, max] can satisfy the condition */
+		switch (cond->strategy)
+		{
+			case BTLessStrategyNumber:
+				if (min_cmp >= 0)
+					return false;
+				break;
+			case BTLessEqualStrategyNumber:
+				if (min_cmp > 0)
+					return false;
+				break;
+			case BTEqualStrategyNumber:
+				if (min_cmp > 0 || max_cmp < 0)
+					return false;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				if (max_cmp < 0)
+					return false;
+				break;
+			case BTGreaterStrategyNumber:
+				if (max_cmp <= 0)
+					return false;
+				break;
+			default:
+				elog(ERROR, "invalid strategy %d in segment filter", cond->strategy);
+		}
+	}
+
+	return true;
+}
+
+/* Check if any batch of the compressed chunk matches the filter */
+bool
+segment_filter_has_match(const SegmentFilter *filter)
+{
+	Relation rel = table_open(filter->compressed_relid, AccessShareLock);
+	TupleDesc desc = RelationGetDescr(rel);
+	Datum *values = palloc(sizeof(Datum) * desc->natts);
+	bool *nulls = palloc(sizeof(bool) * desc->natts);
+	TableScanDesc scan = table_beginscan(rel, GetTransactionSnapshot(), 0, NULL);
+	HeapTuple tuple;
+	bool found = false;
+
+	while (!found && (tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		heap_deform_tuple(tuple, desc, values, nulls);
+		found = segment_filter_matches(filter, values, nulls);
+	}
+
+	table_endscan(scan);
+	table_close(rel, NoLock);
+	pfree(values);
+	pfree(nulls);
+
+	return found;
+}
@@ -0,0 +1,33 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+#ifndef TIMESCALEDB_TSL_COMPRESSION_SEGMENT_FILTER_H
+#define TIMESCALEDB_TSL_COMPRESSION_SEGMENT_FILTER_H
+
+#include <postgres.h>
+#include <access/stratnum.h>
+#include <nodes/pg_list.h>
+#include <utils/jsonb.h>
+
+/*
+ * A segment filter selects the batches (rows) of a compressed chunk that can
+ * contain rows matching a set of conditions. Conditions on segmentby columns
+ * are checked against the segmentby values of a batch, conditions on orderby
+ * columns against the min/max metadata of a batch. A batch matches if it
+ * matches all conditions.
+ */
+typedef struct SegmentFilter SegmentFilter;
+
+extern SegmentFilter *segment_filter_create(Oid compressed_relid, List *column_compression_info);
+extern bool segment_filter_column_is_supported(List *column_compression_info,
+											   const char *column_name);
+extern void segment_filter_add_condition(SegmentFilter *filter, const char *column_name,
+										 StrategyNumber strategy, Datum value);
+extern void segment_filter_add_jsonb(SegmentFilter *filter, Jsonb *conditions);
+extern bool segment_filter_matches(const SegmentFilter *filter, const Datum *values,
+								   const bool *nulls);
+extern bool segment_filter_has_match(const SegmentFilter *filter);
+
+#endif
@@ -149,6 +149,24 @@ simple8brle_decompression_iterator_try_next_forward(Simple8bRleDecompressionIter
 static inline Simple8bRleDecompressResult
 simple8brle_decompression_iterator_try_next_reverse(Simple8bRleDecompressionIterator *iter);
 
+/*
+ * Bulk decompression of all elements at once, see simple8b_rle_bulk.c.
+ * Bit-packed blocks are always unpacked in full, so the output buffer needs
+ * room for one block's worth of values past the last element.
+ */
+static inline uint32
+simple8brle_decompress_all_buffer_size(const Simple8bRleSerialized *compressed)
+{
+	return compressed->num_elements + SIMPLE8B_MAX_VALUES_PER_SLOT;
+}
+
+extern uint32 simple8brle_decompress_all_buf(const Simple8bRleSerialized *compressed,
+											 uint64 *out);
+extern uint64 *simple8brle_decompress_all(const Simple8bRleSerialized *compressed,
+										  uint32 *num_elements);
+extern void simple8brle_unpack_blocks(uint8 selector, const uint64 *blocks, uint32 num_blocks,
+									  uint64 *out);
+
 static inline void simple8brle_serialized_send(StringInfo buffer,
 											   const Simple8bRleSerialized *data);
 static inline char *bytes_serialize_simple8b_and_advance(char *dest, size_t expected_size,
@@ -0,0 +1,377 @@
+/*
+ * This file and its contents are licensed under the Timescale License.
+ * Please see the included NOTICE for copyright information and
+ * LICENSE-TIMESCALE for a copy of the license.
+ */
+
+/*
+ * Bulk decoding of simple8b RLE data.
+ *
+ * The decompression iterators in simple8b_rle.h decode one element at a time,
+ * which means a selector lookup, a shift and a mask, as well as a check for the
+ * end of the current block, for every value. When we know we want all values,
+ * e.g. for the delta-of-deltas of a deltadelta batch, we can instead decode
+ * whole blocks at once: every bit-packing selector gets its own kernel with a
+ * compile-time constant bit width and element count, which the compiler fully
+ * unrolls, and RLE blocks become a simple fill.
+ *
+ * On x86-64 with GCC-compatible compilers we additionally build AVX2 variants
+ * of the kernels for the selectors that pack at least four values per block,
+ * which use per-lane variable shifts to unpack four values per instruction.
+ * The implementation is picked at runtime on first use, the same way
+ * PostgreSQL picks its CRC-32C implementation. SSE4 has no per-lane variable
+ * 64-bit shifts, so there is no SSE variant; the unrolled scalar kernels are
+ * used as the fallback instead.
+ */
+#include <postgres.h>
+
+#include "compression/simple8b_rle.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SIMPLE8B_USE_AVX2_WITH_RUNTIME_CHECK 1
+#include <immintrin.h>
+#endif
+
+/* scalar kernels, one per bit-packing selector */
+#define SIMPLE8B_DEFINE_UNPACK_SCALAR(BITS)                                                        \
+	static inline void simple8brle_unpack_scalar_##BITS(uint64 data, uint64 *restrict out)        \
+	{                                                                                              \
+		const uint64 mask = (UINT64CONST(1) << (BITS)) - 1;                                        \
+		int i;                                                                                     \
+                                                                                                   \
+		for (i = 0; i < 64 / (BITS); i++)                                                          \
+			out[i] = (data >> (i * (BITS))) & mask;                                                \
+	}
+
+SIMPLE8B_DEFINE_UNPACK_SCALAR(1)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(2)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(3)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(4)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(5)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(6)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(7)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(8)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(10)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(12)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(16)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(21)
+SIMPLE8B_DEFINE_UNPACK_SCALAR(32)
+
+static inline void
+simple8brle_unpack_block_scalar(uint8 selector, uint64 data, uint64 *restrict out)
+{
+	switch (selector)
+	{
+		case 1:
+			simple8brle_unpack_scalar_1(data, out);
+			break;
+		case 2:
+			simple8brle_unpack_scalar_2(data, out);
+			break;
+		case 3:
+			simple8brle_unpack_scalar_3(data, out);
+			break;
+		case 4:
+			simple8brle_unpack_scalar_4(data, out);
+			break;
+		case 5:
+			simple8brle_unpack_scalar_5(data, out);
+			break;
+		case 6:
+			simple8brle_unpack_scalar_6(data, out);
+			break;
+		case 7:
+			simple8brle_unpack_scalar_7(data, out);
+			break;
+		case 8:
+			simple8brle_unpack_scalar_8(data, out);
+			break;
+		case 9:
+			simple8brle_unpack_scalar_10(data, out);
+			break;
+		case 10:
+			simple8brle_unpack_scalar_12(data, out);
+			break;
+		case 11:
+			simple8brle_unpack_scalar_16(data, out);
+			break;
+		case 12:
+			simple8brle_unpack_scalar_21(data, out);
+			break;
+		case 13:
+			simple8brle_unpack_scalar_32(data, out);
+			break;
+		case 14:
+			out[0] = data;
+			break;
+		default:
+			elog(ERROR, "invalid simple8b selector %d", selector);
+	}
+}
+
+/*
+ * Decode all blocks of the compressed data into out, which must have room for
+ * num_elements + SIMPLE8B_MAX_VALUES_PER_SLOT values since bit-packed blocks
+ * are always unpacked in full.
+ */
+static pg_attribute_always_inline uint32
+simple8brle_decompress_all_impl(const Simple8bRleSerialized *compressed, uint64 *restrict out,
+								void (*unpack_block)(uint8, uint64, uint64 *restrict))
+{
+	uint32 num_selector_slots =
+		simple8brle_num_selector_slots_for_num_blocks(compressed->num_blocks);
+	const uint64 *selectors = compressed->slots;
+	const uint64 *blocks = compressed->slots + num_selector_slots;
+	uint32 num_elements = compressed->num_elements;
+	uint32 decoded = 0;
+	uint32 block_index;
+
+	for (block_index = 0; block_index < compressed->num_blocks && decoded < num_elements;
+		 block_index++)
+	{
+		uint8 selector = (selectors[block_index / SIMPLE8B_SELECTORS_PER_SELECTOR_SLOT] >>
+						  ((block_index % SIMPLE8B_SELECTORS_PER_SELECTOR_SLOT) *
+						   SIMPLE8B_BITS_PER_SELECTOR)) &
+						 ((1 << SIMPLE8B_BITS_PER_SELECTOR) - 1);
+		uint64 data = blocks[block_index];
+
+		if (simple8brle_selector_is_rle(selector))
+		{
+			uint64 value = simple8brle_rledata_value(data);
+			uint32 count = Min(simple8brle_rledata_repeatcount(data), num_elements - decoded);
+			uint32 i;
+
+			for (i = 0; i < count; i++)
+				out[decoded + i] = value;
+
+			decoded += count;
+		}
+		else
+		{
+			unpack_block(selector, data, out + decoded);
+			decoded += SIMPLE8B_NUM_ELEMENTS[selector];
+		}
+	}
+
+	if (decoded < num_elements)
+		elog(ERROR, "simple8b compressed data is missing values");
+
+	return num_elements;
+}
+
+static uint32
+simple8brle_decompress_all_scalar(const Simple8bRleSerialized *compressed, uint64 *restrict out)
+{
+	return simple8brle_decompress_all_impl(compressed, out, simple8brle_unpack_block_scalar);
+}
+
+static void
+simple8brle_unpack_blocks_scalar(uint8 selector, const uint64 *blocks, uint32 num_blocks,
+								 uint64 *restrict out)
+{
+	uint32 values_per_block = SIMPLE8B_NUM_ELEMENTS[selector];
+	uint32 i;
+
+	for (i = 0; i < num_blocks; i++)
+		simple8brle_unpack_block_scalar(selector, blocks[i], out + i * values_per_block);
+}
+
+#ifdef SIMPLE8B_USE_AVX2_WITH_RUNTIME_CHECK
+
+/*
+ * AVX2 kernels: broadcast the block into all four lanes and shift every lane
+ * by a different multiple of the bit width, unpacking four values at a time.
+ */
+#define SIMPLE8B_DEFINE_UNPACK_AVX2(BITS)                                                          \
+	static __attribute__((target("avx2"))) void                                                    \
+	simple8brle_unpack_avx2_##BITS(uint64 data, uint64 *restrict out)                              \
+	{                                                                                              \
+		const uint64 mask = (UINT64CONST(1) << (BITS)) - 1;                                        \
+		const __m256i vmask = _mm256_set1_epi64x((int64) mask);                                    \
+		const __m256i vdata = _mm256_set1_epi64x((int64) data);                                    \
+		const __m256i step = _mm256_set1_epi64x(4 * (BITS));                                       \
+		__m256i shifts = _mm256_setr_epi64x(0, (BITS), 2 * (BITS), 3 * (BITS));                    \
+		int i;                                                                                     \
+                                                                                                   \
+		for (i = 0; i < ((64 / (BITS)) & ~3); i += 4)                                              \
+		{                                                                                          \
+			_mm256_storeu_si256((__m256i *) &out[i],                                               \
+								_mm256_and_si256(_mm256_srlv_epi64(vdata, shifts), vmask));        \
+			shifts = _mm256_add_epi64(shifts, step);                                               \
+		}                                                                                          \
+                                                                                                   \
+		for (i = (64 / (BITS)) & ~3; i < 64 / (BITS); i++)                                         \
+			out[i] = (data >> (i * (BITS))) & mask;                                                \
+	}
+
+SIMPLE8B_DEFINE_UNPACK_AVX2(1)
+SIMPLE8B_DEFINE_UNPACK_AVX2(2)
+SIMPLE8B_DEFINE_UNPACK_AVX2(3)
+SIMPLE8B_DEFINE_UNPACK_AVX2(4)
+SIMPLE8B_DEFINE_UNPACK_AVX2(5)
+SIMPLE8B_DEFINE_UNPACK_AVX2(6)
+SIMPLE8B_DEFINE_UNPACK_AVX2(7)
+SIMPLE8B_DEFINE_UNPACK_AVX2(8)
+SIMPLE8B_DEFINE_UNPACK_AVX2(10)
+SIMPLE8B_DEFINE_UNPACK_AVX2(12)
+SIMPLE8B_DEFINE_UNPACK_AVX2(16)
+
+static __attribute__((target("avx2"))) void
+simple8brle_unpack_block_avx2(uint8 selector, uint64 data, uint64 *restrict out)
+{
+	switch (selector)
+	{
+		case 1:
+			simple8brle_unpack_avx2_1(data, out);
+			break;
+		case 2:
+			simple8brle_unpack_avx2_2(data, out);
+			break;
+		case 3:
+			simple8brle_unpack_avx2_3(data, out);
+			break;
+		case 4:
+			simple8brle_unpack_avx2_4(data, out);
+			break;
+		case 5:
+			simple8brle_unpack_avx2_5(data, out);
+			break;
+		case 6:
+			simple8brle_unpack_avx2_6(data, out);
+			break;
+		case 7:
+			simple8brle_unpack_avx2_7(data, out);
+			break;
+		case 8:
+			simple8brle_unpack_avx2_8(data, out);
+			break;
+		case 9:
+			simple8brle_unpack_avx2_10(data, out);
+			break;
+		case 10:
+			simple8brle_unpack_avx2_12(data, out);
+			break;
+		case 11:
+			simple8brle_unpack_avx2_16(data, out);
+			break;
+		default:
+			/* fewer than four values per block, nothing to gain from AVX2 */
+			simple8brle_unpack_block_scalar(selector, data, out);
+			break;
+	}
+}
+
+static __attribute__((target("avx2"))) uint32
+simple8brle_decompress_all_avx2(const Simple8bRleSerialized *compressed, uint64 *restrict out)
+{
+	return simple8brle_decompress_all_impl(compressed, out, simple8brle_unpack_block_avx2);
+}
+
+static __attribute__((target("avx2"))) void
+simple8brle_unpack_blocks_avx2(uint8 selector, const uint64 *blocks, uint32 num_blocks,
+							   uint64 *restrict out)
+{
+	uint32 values_per_block = SIMPLE8B_NUM_ELEMENTS[selector];
+	uint32 i;
+
+	for (i = 0; i < num_blocks; i++)
+		simple8brle_unpack_block_avx2(selector, blocks[i], out + i * values_per_block);
+}
+
+static uint32 simple8brle_decompress_all_choose(const Simple8bRleSerialized *compressed,
+												uint64 *restrict out);
+static void simple8brle_unpack_blocks_choose(uint8 selector, const uint64 *blocks,
+											 uint32 num_blocks, uint64 *restrict out);
+
+static uint32 (*simple8brle_decompress_all_impl_ptr)(const Simple8bRleSerialized *compressed,
+													 uint64 *restrict out) =
+	simple8brle_decompress_all_choose;
+
+static void (*simple8brle_unpack_blocks_impl_ptr)(uint8 selector, const uint64 *blocks,
+												  uint32 num_blocks, uint64 *restrict out) =
+	simple8brle_unpack_blocks_choose;
+
+/* pick the implementations on first use and remember them for later calls */
+static void
+simple8brle_bulk_choose_impl(void)
+{
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+	{
+		simple8brle_decompress_all_impl_ptr = simple8brle_decompress_all_avx2;
+		simple8brle_unpack_blocks_impl_ptr = simple8brle_unpack_blocks_avx2;
+	}
+	else
+	{
+		simple8brle_decompress_all_impl_ptr = simple8brle_decompress_all_scalar;
+		simple8brle_unpack_blocks_impl_ptr = simple8brle_unpack_blocks_scalar;
+	}
+}
+
+static uint32
+simple8brle_decompress_all_choose(const Simple8bRleSerialized *compressed, uint64 *restrict out)
+{
+	simple8brle_bulk_choose_impl();
+	return simple8brle_decompress_all_impl_ptr(compressed, out);
+}
+
+static void
+simple8brle_unpack_blocks_choose(uint8 selector, const uint64 *blocks, uint32 num_blocks,
+								 uint64 *restrict out)
+{
+	simple8brle_bulk_choose_impl();
+	simple8brle_unpack_blocks_impl_ptr(selector, blocks, num_blocks, out);
+}
+
+#else
+
+static uint32 (*simple8brle_decompress_all_impl_ptr)(const Simple8bRleSerialized *compressed,
+													 uint64 *restrict out) =
+	simple8brle_decompress_all_scalar;
+
+static void (*simple8brle_unpack_blocks_impl_ptr)(uint8 selector, const uint64 *blocks,
+												  uint32 num_blocks, uint64 *restrict out) =
+	simple8brle_unpack_blocks_scalar;
+
+#endif /* SIMPLE8B_USE_AVX2_WITH_RUNTIME_CHECK */
+
+/*
+ * Decompress all elements of the simple8b RLE data into out, which must have
+ * room for at least simple8brle_decompress_all_buffer_size() elements.
+ * Returns the number of elements.
+ */
+uint32
+simple8brle_decompress_all_buf(const Simple8bRleSerialized *compressed, uint64 *out)
+{
+	if (compressed->num_elements == 0)
+		return 0;
+
+	return simple8brle_decompress_all_impl_ptr(compressed, out);
+}
+
+/*
+ * Decompress all elements of the simple8b RLE data into a newly palloc'ed
+ * buffer in the current memory context.
+ */
+uint64 *
+simple8brle_decompress_all(const Simple8bRleSerialized *compressed, uint32 *num_elements)
+{
+	uint64 *out = palloc(sizeof(uint64) * simple8brle_decompress_all_buffer_size(compressed));
+
+	*num_elements = simple8brle_decompress_all_buf(compressed, out);
+	return out;
+}
+
+/*
+ * Unpack blocks that are all bit-packed with the same selector, e.g. by a
+ * codec that packs its values at a single fixed width, using the same kernels
+ * as the simple8b decoder. The output needs room for
+ * num_blocks * SIMPLE8B_NUM_ELEMENTS[selector] values.
+ */
+void
+simple8brle_unpack_blocks(uint8 selector, const uint64 *blocks, uint32 num_blocks, uint64 *out)
+{
+	Assert(selector >= SIMPLE8B_MINCODE && selector < SIMPLE8B_RLE_SELECTOR);
+	simple8brle_unpack_blocks_impl_ptr(selector, blocks, num_blocks, out);
+}
@@ -30,6 +30,7 @@
 #include "fdw/deparse.h"
 #include "remote/utils.h"
 #include "remote/dist_txn.h"
+#include "remote/dist_copy.h"
 #include "remote/async.h"
 #include "data_node_dispatch.h"
 #include "remote/data_format.h"
@@ -119,22 +120,46 @@ typedef struct DataNodeDispatchPath
  *   the replica store need not be returned, so using a separate prepared
  *   statement without RETURNING for the replica store would save bandwidth.
  *
- * - Better asynchronous behavior. When reading tuples, a flush happens as
- *   soon as a tuple store is filled instead of continuing to fill until more
- *   stores can be flushed. Further, after flushing tuples for a data node, the
- *   code immediately waits for a response instead of doing other work while
- *   waiting.
+ * Pipelined flushing
+ * ==================
  *
- * - Currently, there is one "global" state machine for the
- *   DataNodeDispatchState executor node. Turning this into per-node state
- *   machines might make the code more asynchronous and/or amenable to
- *   parallel mode support.
+ * The "global" state machine above is only needed when there is a RETURNING
+ * clause, since the inserted tuples are then returned before more tuples are
+ * read. Without a RETURNING clause, every data node flushes independently of
+ * the others so that the insert rate is not bounded by the slowest round trip
+ * to a data node. Each data node then has its own state:
  *
- * - COPY instead of INSERT. When there's no RETURNING clause, it is more
- *   efficient to COPY data rather than using a prepared statement.
+ * IDLE: the data node has no request in flight and tuples are added to its
+ * store. Once the store reaches FLUSH_THRESHOLD, the batch is sent and the
+ * node moves to FLUSHING, while reading continues with the next tuple.
  *
- * - Binary instead of text format. Send tuples in binary format instead of
- *   text to save bandwidth and reduce latency.
+ * FLUSHING: the data node has a batch in flight. The responses of all
+ * flushing nodes are collected with an AsyncRequestSet: by polling each time
+ * a batch is sent, and by waiting when a node fills its store before its
+ * previous batch completed, since a connection can only have one request in
+ * flight. When its request completes, the node moves back to IDLE.
+ *
+ * Thus, full batches are sent in READ state and the FLUSH state is not used.
+ * LAST_FLUSH sends the remaining tuples of all nodes and waits for all
+ * requests to complete.
+ *
+ * Requests in flight would block any other use of the data node connections
+ * while reading tuples. Therefore, all requests are completed before a new
+ * chunk is created on the data nodes, and flushing is not pipelined if the
+ * subplan reads from data nodes, e.g., INSERT ... SELECT from a distributed
+ * hypertable.
+ *
+ * COPY instead of INSERT
+ * ======================
+ *
+ * When there is neither a RETURNING nor an ON CONFLICT clause, and all
+ * columns can be sent in binary format, tuples are sent with binary COPY
+ * instead of a prepared INSERT statement. This avoids converting every value
+ * to a statement parameter and does not limit the batch size by the maximum
+ * number of parameters in a statement. In FLUSH and LAST_FLUSH states, a
+ * "COPY ... FROM STDIN" command is sent to each data node to flush and the
+ * batch is streamed to the data node once the data node is ready to receive
+ * it.
  */
 typedef enum DispatchState
 {
@@ -166,6 +191,10 @@ typedef struct DataNodeDispatchState
 	int replication_factor;  /* > 1 if we replicate tuples across data nodes */
 	StmtParams *stmt_params; /* Parameters to send with statement. Format can be binary or text */
 	int flush_threshold;	 /* Batch size used for this dispatch state */
+	bool use_copy;			 /* Send tuples with binary COPY instead of INSERT */
+	bool pipelined;			 /* Flush data nodes independently, see above */
+	FmgrInfo *copy_out_functions; /* Binary output functions for COPY */
+	MemoryContext copy_row_mcxt;  /* Memory context for converting a COPY row */
 	TupleTableSlot *batch_slot; /* Slot used for sending tuples to data
 								 * nodes. Note that this needs to be a
 								 * MinimalTuple slot, so we cannot use the
@@ -184,7 +213,8 @@ enum CustomScanPrivateIndex
 	CustomScanPrivateDeparsedInsertStmt,
 	CustomScanPrivateSetProcessed,
 	CustomScanPrivateUserId,
-	CustomScanPrivateFlushThreshold
+	CustomScanPrivateFlushThreshold,
+	CustomScanPrivateUseCopy,
 };
 
 #define HAS_RETURNING(sds) ((sds)->stmt.returning != NULL)
@@ -221,6 +251,10 @@ typedef struct DataNodeState
 										* during the FLUSH or LAST_FLUSH states */
 	int next_tuple;					   /* The next tuple to return in the RETURNING state */
 	TupleTableSlot *slot;
+	StringInfoData copy_data; /* Batch of tuples in binary COPY format that is
+							   * sent once the data node is ready for it */
+	AsyncRequest *pending_req; /* Request in flight when pipelined flushing,
+								* NULL if the data node is idle */
 } DataNodeState;
 
 #define NUM_STORED_TUPLES(ss)                                                                      \
@@ -242,10 +276,14 @@ data_node_state_init(DataNodeState *ss, DataNodeDispatchState *sds, TSConnection
 
 	ss->conn = remote_dist_txn_get_connection(id, REMOTE_TXN_USE_PREP_STMT);
 	ss->pstmt = NULL;
+	ss->pending_req = NULL;
 	ss->next_tuple = 0;
 	ss->num_tuples_sent = 0;
 	ss->num_tuples_inserted = 0;
 
+	if (sds->use_copy)
+		initStringInfo(&ss->copy_data);
+
 	MemoryContextSwitchTo(old);
 }
 
@@ -293,6 +331,9 @@ data_node_state_close(DataNodeState *ss)
 		tuplestore_end(ss->replica_tupstore);
 }
 
+static bool planstate_uses_data_nodes(PlanState *ps, void *context);
+static void on_chunk_create(void *data);
+
 static void
 data_node_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
 {
@@ -329,6 +370,7 @@ data_node_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
 	sds->userid = intVal(list_nth(cscan->custom_private, CustomScanPrivateUserId));
 	sds->set_processed = intVal(list_nth(cscan->custom_private, CustomScanPrivateSetProcessed));
 	sds->flush_threshold = intVal(list_nth(cscan->custom_private, CustomScanPrivateFlushThreshold));
+	sds->use_copy = intVal(list_nth(cscan->custom_private, CustomScanPrivateUseCopy));
 
 	sds->mcxt = mcxt;
 	sds->nodestates = hash_create("DataNodeDispatch tuple stores",
@@ -339,12 +381,33 @@ data_node_dispatch_begin(CustomScanState *node, EState *estate, int eflags)
 	deparsed_insert_stmt_from_list(&sds->stmt,
 								   list_nth(cscan->custom_private,
 											CustomScanPrivateDeparsedInsertStmt));
-	/* Setup output functions to generate string values for each target attribute */
-	sds->stmt_params = stmt_params_create(sds->target_attrs, false, tupdesc, sds->flush_threshold);
+	if (sds->use_copy)
+	{
+		sds->copy_out_functions = remote_copy_get_binary_out_functions(tupdesc, sds->target_attrs);
+		sds->copy_row_mcxt =
+			AllocSetContextCreate(mcxt, "DataNodeDispatch COPY row", ALLOCSET_DEFAULT_SIZES);
+	}
+	else
+	{
+		/* Setup output functions to generate string values for each target attribute */
+		sds->stmt_params =
+			stmt_params_create(sds->target_attrs, false, tupdesc, sds->flush_threshold);
+	}
 
 	if (HAS_RETURNING(sds))
 		sds->tupfactory = tuplefactory_create_for_rel(rel, sds->stmt.retrieved_attrs);
 
+	sds->pipelined = !HAS_RETURNING(sds) && !planstate_uses_data_nodes(ps, NULL);
+
+	if (sds->pipelined)
+	{
+		ChunkDispatchState *cds = (ChunkDispatchState *) ps;
+
+		Assert(ts_chunk_dispatch_is_state(ps));
+		cds->dispatch->on_chunk_create = on_chunk_create;
+		cds->dispatch->on_chunk_create_data = sds;
+	}
+
 	/* The tuplestores that hold batches of tuples only allow MinimalTuples so
 	 * we need a dedicated slot for getting tuples from the stores since the
 	 * CustomScan's ScanTupleSlot is a VirtualTuple. */
@@ -430,13 +493,71 @@ prepare_data_node_insert_stmt(DataNodeDispatchState *sds, TSConnection *conn, in
 	return async_request_wait_prepared_statement(req);
 }
 
+static void
+append_copy_data_from_store(DataNodeDispatchState *sds, DataNodeState *ss,
+							Tuplestorestate *tupstore)
+{
+	TupleTableSlot *slot = sds->batch_slot;
+
+	while (tuplestore_gettupleslot(tupstore, true /* forward */, false /* copy */, slot))
+	{
+		MemoryContext old = MemoryContextSwitchTo(sds->copy_row_mcxt);
+
+		slot_getallattrs(slot);
+		remote_copy_append_binary_row(&ss->copy_data,
+									  slot->tts_values,
+									  slot->tts_isnull,
+									  sds->target_attrs,
+									  sds->copy_out_functions);
+		MemoryContextSwitchTo(old);
+		MemoryContextReset(sds->copy_row_mcxt);
+		ss->num_tuples_sent++;
+	}
+}
+
+/*
+ * Send a batch of tuples to a data node using binary COPY.
+ *
+ * The tuples are converted into a buffer and the COPY command is sent, but
+ * the data is only sent once the data node responds that it is ready to
+ * receive it, see await_all_responses(). This way, the COPY commands for all
+ * data nodes to flush are in flight at the same time.
+ */
+static AsyncRequest *
+send_copy_batch_to_data_node(DataNodeDispatchState *sds, DataNodeState *ss)
+{
+	AsyncRequest *req;
+
+	Assert(!HAS_RETURNING(sds));
+
+	resetStringInfo(&ss->copy_data);
+	remote_copy_append_binary_header(&ss->copy_data);
+	append_copy_data_from_store(sds, ss, ss->primary_tupstore);
+
+	if (NULL != ss->replica_tupstore)
+		append_copy_data_from_store(sds, ss, ss->replica_tupstore);
+
+	remote_copy_append_binary_trailer(&ss->copy_data);
+	Assert(ss->num_tuples_sent == NUM_STORED_TUPLES(ss));
+
+	req = async_request_send(ss->conn, sds->sql_stmt);
+	Assert(NULL != req);
+	async_request_attach_user_data(req, ss);
+
+	sds->num_tuples += tuplestore_tuple_count(ss->primary_tupstore);
+	data_node_state_clear_primary_store(ss);
+	data_node_state_clear_replica_store(ss);
+
+	return req;
+}
+
 /*
  * Send a batch of tuples to a data node.
  *
  * All stored tuples for the given data node are sent on the node's
- * connection. If in FLUSH state (i.e., sending a predefined amount of
- * tuples), use a prepared statement, or construct a custom statement if in
- * LAST_FLUSH state.
+ * connection. If sending a full batch (i.e., a predefined amount of tuples),
+ * use a prepared statement, or construct a custom statement for the partial
+ * batch in LAST_FLUSH state.
  *
  * If there's a RETURNING clause, we reset the read pointer for the store,
  * since the original tuples need to be returned along with the
@@ -451,12 +572,16 @@ send_batch_to_data_node(DataNodeDispatchState *sds, DataNodeState *ss)
 	const char *sql_stmt;
 	int response_type = FORMAT_TEXT;
 
-	Assert(sds->state == SD_FLUSH || sds->state == SD_LAST_FLUSH);
+	Assert(sds->state == SD_FLUSH || sds->state == SD_LAST_FLUSH ||
+		   (sds->pipelined && sds->state == SD_READ));
 	Assert(NUM_STORED_TUPLES(ss) <= sds->flush_threshold);
 	Assert(NUM_STORED_TUPLES(ss) > 0);
 
 	ss->num_tuples_sent = 0;
 
+	if (sds->use_copy)
+		return send_copy_batch_to_data_node(sds, ss);
+
 	while (
 		tuplestore_gettupleslot(ss->primary_tupstore, true /* forward */, false /* copy */, slot))
 	{
@@ -487,32 +612,24 @@ send_batch_to_data_node(DataNodeDispatchState *sds, DataNodeState *ss)
 		response_type = FORMAT_BINARY;
 
 	/* Send tuples */
-	switch (sds->state)
+	if (ss->num_tuples_sent == sds->flush_threshold)
 	{
-		case SD_FLUSH:
-			/* Lazy initialize the prepared statement */
-			if (NULL == ss->pstmt)
-				ss->pstmt =
-					prepare_data_node_insert_stmt(sds,
-												  ss->conn,
-												  stmt_params_total_values(sds->stmt_params));
-			Assert(ss->num_tuples_sent == sds->flush_threshold);
-			req = async_request_send_prepared_stmt_with_params(ss->pstmt,
-															   sds->stmt_params,
-															   response_type);
-			break;
-		case SD_LAST_FLUSH:
-			sql_stmt = deparsed_insert_stmt_get_sql(&sds->stmt,
-													stmt_params_converted_tuples(sds->stmt_params));
-			Assert(sql_stmt != NULL);
-			Assert(ss->num_tuples_sent < sds->flush_threshold);
-			req =
-				async_request_send_with_params(ss->conn, sql_stmt, sds->stmt_params, response_type);
-			break;
-		default:
-			elog(ERROR, "unexpected data node dispatch state %s", state_names[sds->state]);
-			Assert(false);
-			break;
+		/* Lazy initialize the prepared statement */
+		if (NULL == ss->pstmt)
+			ss->pstmt = prepare_data_node_insert_stmt(sds,
+													  ss->conn,
+													  stmt_params_total_values(sds->stmt_params));
+		req = async_request_send_prepared_stmt_with_params(ss->pstmt,
+														   sds->stmt_params,
+														   response_type);
+	}
+	else
+	{
+		Assert(sds->state == SD_LAST_FLUSH);
+		sql_stmt = deparsed_insert_stmt_get_sql(&sds->stmt,
+												stmt_params_converted_tuples(sds->stmt_params));
+		Assert(sql_stmt != NULL);
+		req = async_request_send_with_params(ss->conn, sql_stmt, sds->stmt_params, response_type);
 	}
 
 	Assert(NULL != req);
@@ -596,6 +713,66 @@ flush_data_nodes(DataNodeDispatchState *sds)
 	return reqset;
 }
 
+/*
+ * Handle a response to a batch sent to a data node.
+ *
+ * In case of RETURNING, the response is added to the list of results.
+ *
+ * Returns true if the response is the result of the batch, or false if the
+ * data node is ready to receive COPY data. In the latter case, the data is
+ * sent and the result of the COPY follows as a separate response.
+ */
+static bool
+handle_batch_response(DataNodeDispatchState *sds, AsyncResponseResult *rsp, List **results)
+{
+	DataNodeState *ss = async_response_result_get_user_data(rsp);
+	PGresult *res = async_response_result_get_pg_result(rsp);
+	ExecStatusType status = PQresultStatus(res);
+	bool report_error = true;
+
+	switch (status)
+	{
+		case PGRES_COPY_IN:
+			Assert(sds->use_copy);
+			async_response_result_close(rsp);
+			remote_copy_send_data_and_end(ss->conn, &ss->copy_data);
+			resetStringInfo(&ss->copy_data);
+			return false;
+		case PGRES_TUPLES_OK:
+			if (!HAS_RETURNING(sds))
+				break;
+
+			Assert(NULL != results);
+			*results = lappend(*results, rsp);
+			ss->num_tuples_inserted = PQntuples(res);
+			Assert(sds->stmt.do_nothing || (ss->num_tuples_inserted == ss->num_tuples_sent));
+			report_error = false;
+			break;
+		case PGRES_COMMAND_OK:
+			if (HAS_RETURNING(sds))
+				break;
+
+			ss->num_tuples_inserted = atoi(PQcmdTuples(res));
+			async_response_result_close(rsp);
+			Assert(sds->stmt.do_nothing || (ss->num_tuples_inserted == ss->num_tuples_sent));
+			report_error = false;
+			break;
+		default:
+			break;
+	}
+
+	if (report_error)
+		async_response_report_error((AsyncResponse *) rsp, ERROR);
+
+	/* Unless there is an ON CONFLICT clause, the number of tuples
+	 * returned should greater than zero and be the same as the number of
+	 * tuples sent.  */
+	Assert(sds->stmt.do_nothing || ss->num_tuples_inserted > 0);
+	ss->next_tuple = 0;
+
+	return true;
+}
+
 /*
  * Wait for responses from data nodes after INSERT.
  *
@@ -610,47 +787,180 @@ await_all_responses(DataNodeDispatchState *sds, AsyncRequestSet *reqset)
 	sds->next_tuple = 0;
 
 	while ((rsp = async_request_set_wait_any_result(reqset)))
+		handle_batch_response(sds, rsp, &results);
+
+	return results;
+}
+
+/*
+ * Complete the request of a data node after its result has been handled so
+ * that the connection can be used again. This consumes the end of the
+ * response, which normally arrives together with the result.
+ */
+static void
+data_node_state_finish_request(DataNodeState *ss)
+{
+	AsyncRequestSet *reqset = async_request_set_create();
+	AsyncResponse *rsp;
+
+	Assert(NULL != ss->pending_req);
+	async_request_set_add(reqset, ss->pending_req);
+	rsp = async_request_set_wait_any_response(reqset);
+
+	if (NULL != rsp)
+	{
+		async_response_close(rsp);
+		elog(ERROR, "unexpected response when inserting on data node");
+	}
+
+	pfree(reqset);
+	ss->pending_req = NULL;
+}
+
+/*
+ * Handle the responses to the batches in flight when flushing is pipelined.
+ *
+ * If wait_for is set, wait until that data node is idle. Otherwise, wait
+ * until all data nodes are idle, or, if poll is true, only handle the
+ * responses that have already arrived.
+ */
+static void
+await_pipelined_responses(DataNodeDispatchState *sds, DataNodeState *wait_for, bool poll)
+{
+	Assert(sds->pipelined);
+
+	while (NULL == wait_for || NULL != wait_for->pending_req)
 	{
-		DataNodeState *ss = async_response_result_get_user_data(rsp);
-		PGresult *res = async_response_result_get_pg_result(rsp);
-		ExecStatusType status = PQresultStatus(res);
-		bool report_error = true;
+		AsyncRequestSet *reqset = NULL;
+		AsyncResponse *rsp;
+		DataNodeState *ss;
+		HASH_SEQ_STATUS hseq;
 
-		switch (status)
+		hash_seq_init(&hseq, sds->nodestates);
+
+		for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
 		{
-			case PGRES_TUPLES_OK:
-				if (!HAS_RETURNING(sds))
-					break;
-
-				results = lappend(results, rsp);
-				ss->num_tuples_inserted = PQntuples(res);
-				Assert(sds->stmt.do_nothing || (ss->num_tuples_inserted == ss->num_tuples_sent));
-				report_error = false;
-				break;
-			case PGRES_COMMAND_OK:
-				if (HAS_RETURNING(sds))
-					break;
+			if (NULL != ss->pending_req)
+			{
+				if (NULL == reqset)
+					reqset = async_request_set_create();
 
-				ss->num_tuples_inserted = atoi(PQcmdTuples(res));
-				async_response_result_close(rsp);
-				Assert(sds->stmt.do_nothing || (ss->num_tuples_inserted == ss->num_tuples_sent));
-				report_error = false;
-				break;
-			default:
-				break;
+				async_request_set_add(reqset, ss->pending_req);
+			}
 		}
 
-		if (report_error)
-			async_response_report_error((AsyncResponse *) rsp, ERROR);
+		/* All data nodes are idle */
+		if (NULL == reqset)
+			break;
+
+		rsp = async_request_set_wait_any_response_deadline(reqset,
+														   (poll && NULL == wait_for) ?
+															   GetCurrentTimestamp() :
+															   TS_NO_TIMEOUT);
+		pfree(reqset);
+
+		/* Requests are completed as soon as their result is handled, so there
+		 * is always a response unless polling */
+		Assert(NULL != rsp);
+
+		if (async_response_get_type(rsp) == RESPONSE_TIMEOUT)
+		{
+			Assert(poll);
+			async_response_close(rsp);
+			break;
+		}
+
+		if (async_response_get_type(rsp) != RESPONSE_RESULT)
+			async_response_report_error(rsp, ERROR);
+
+		ss = async_response_result_get_user_data((AsyncResponseResult *) rsp);
 
-		/* Unless there is an ON CONFLICT clause, the number of tuples
-		 * returned should greater than zero and be the same as the number of
-		 * tuples sent.  */
-		Assert(sds->stmt.do_nothing || ss->num_tuples_inserted > 0);
-		ss->next_tuple = 0;
+		if (handle_batch_response(sds, (AsyncResponseResult *) rsp, NULL))
+			data_node_state_finish_request(ss);
 	}
+}
 
-	return results;
+/*
+ * Send the batch of a data node when flushing is pipelined. Since a
+ * connection can only have one request in flight, first wait for the data
+ * node's previous batch, if any.
+ */
+static void
+flush_data_node_pipelined(DataNodeDispatchState *sds, DataNodeState *ss)
+{
+	if (NULL != ss->pending_req)
+		await_pipelined_responses(sds, ss, false);
+
+	ss->pending_req = send_batch_to_data_node(sds, ss);
+
+	/* Handle the responses that already arrived, e.g., to start sending COPY
+	 * data to data nodes that are ready for it */
+	await_pipelined_responses(sds, NULL, true);
+}
+
+/*
+ * Flush the remaining tuples of all data nodes when flushing is pipelined and
+ * wait for all batches to complete.
+ */
+static void
+flush_data_nodes_pipelined(DataNodeDispatchState *sds)
+{
+	List *nodes = NIL;
+	ListCell *lc;
+	DataNodeState *ss;
+	HASH_SEQ_STATUS hseq;
+
+	Assert(sds->state == SD_LAST_FLUSH);
+
+	hash_seq_init(&hseq, sds->nodestates);
+
+	for (ss = hash_seq_search(&hseq); ss != NULL; ss = hash_seq_search(&hseq))
+	{
+		if (should_flush_data_node(sds, ss))
+			nodes = lappend(nodes, ss);
+	}
+
+	foreach (lc, nodes)
+	{
+		ss = lfirst(lc);
+
+		if (NULL != ss->pending_req)
+			await_pipelined_responses(sds, ss, false);
+
+		ss->pending_req = send_batch_to_data_node(sds, ss);
+	}
+
+	await_pipelined_responses(sds, NULL, false);
+	list_free(nodes);
+}
+
+/*
+ * Complete all batches in flight before a new chunk is created, since
+ * creating the chunk on the data nodes uses the same connections.
+ */
+static void
+on_chunk_create(void *data)
+{
+	DataNodeDispatchState *sds = data;
+
+	await_pipelined_responses(sds, NULL, false);
+}
+
+/*
+ * Check if a plan reads from data nodes, in which case it needs the data node
+ * connections while tuples are being read.
+ */
+static bool
+planstate_uses_data_nodes(PlanState *ps, void *context)
+{
+	if (IsA(ps, ForeignScanState))
+		return true;
+
+	if (IsA(ps, CustomScanState) &&
+		strcmp(castNode(CustomScanState, ps)->methods->CustomName, "DataNodeScanState") == 0)
+		return true;
+
+	return planstate_tree_walker(ps, planstate_uses_data_nodes, context);
 }
 
 /*
@@ -723,9 +1033,15 @@ handle_read(DataNodeDispatchState *sds)
 					tuplestore_puttupleslot(ss->replica_tupstore, slot);
 
 				/* Once one data node has reached the batch size, we stop
-				 * reading. */
-				if (sds->state != SD_FLUSH && NUM_STORED_TUPLES(ss) >= sds->flush_threshold)
-					data_node_dispatch_set_state(sds, SD_FLUSH);
+				 * reading, unless flushing is pipelined in which case the
+				 * batch is sent right away. */
+				if (NUM_STORED_TUPLES(ss) >= sds->flush_threshold)
+				{
+					if (sds->pipelined)
+						flush_data_node_pipelined(sds, ss);
+					else if (sds->state != SD_FLUSH)
+						data_node_dispatch_set_state(sds, SD_FLUSH);
+				}
 
 				primary_data_node = false;
 			}
@@ -753,6 +1069,14 @@ handle_flush(DataNodeDispatchState *sds)
 
 	Assert(sds->state == SD_FLUSH || sds->state == SD_LAST_FLUSH);
 
+	if (sds->pipelined)
+	{
+		Assert(sds->state == SD_LAST_FLUSH);
+		flush_data_nodes_pipelined(sds);
+		data_node_dispatch_set_state(sds, SD_RETURNING);
+		return;
+	}
+
 	reqset = flush_data_nodes(sds);
 
 	if (NULL != reqset)
@@ -993,7 +1317,8 @@ data_node_dispatch_explain(CustomScanState *node, List *ancestors, ExplainState
 	if (es->verbose)
 	{
 		const char *explain_sql =
-			deparsed_insert_stmt_get_sql_explain(&sds->stmt, sds->flush_threshold);
+			sds->use_copy ? sds->sql_stmt :
+							deparsed_insert_stmt_get_sql_explain(&sds->stmt, sds->flush_threshold);
 
 		ExplainPropertyText("Remote SQL", explain_sql, es);
 	}
@@ -1068,6 +1393,7 @@ plan_remote_insert(PlannerInfo *root, DataNodeDispatchPath *sdpath)
 	bool do_nothing = false;
 	Oid userid;
 	int flush_threshold;
+	bool use_copy;
 
 	/*
 	 * Core code already has some lock on each rel being planned, so we can
@@ -1113,21 +1439,37 @@ plan_remote_insert(PlannerInfo *root, DataNodeDispatchPath *sdpath)
 						do_nothing,
 						returning_list);
 
-	/* Set suitable flush threshold value that takes into account the max number
-	 * of prepared statement arguments */
-	flush_threshold =
-		stmt_params_validate_num_tuples(list_length(target_attrs), TUPSTORE_FLUSH_THRESHOLD);
+	/* COPY can be used when nothing needs to be returned from the data nodes
+	 * and there is no conflict handling. Since a binary COPY needs every
+	 * value in binary format, all columns must have binary output
+	 * functions. */
+	use_copy = NIL == returning_list && !do_nothing && ts_guc_enable_connection_binary_data &&
+			   remote_copy_supports_binary(RelationGetDescr(rel), target_attrs);
 
-	sql = deparsed_insert_stmt_get_sql(&stmt, flush_threshold);
+	if (use_copy)
+	{
+		/* There is no limit on the number of parameters with COPY */
+		flush_threshold = TUPSTORE_FLUSH_THRESHOLD;
+		sql = remote_copy_deparse_binary_cmd(rel, target_attrs);
+	}
+	else
+	{
+		/* Set suitable flush threshold value that takes into account the max
+		 * number of prepared statement arguments */
+		flush_threshold =
+			stmt_params_validate_num_tuples(list_length(target_attrs), TUPSTORE_FLUSH_THRESHOLD);
+		sql = deparsed_insert_stmt_get_sql(&stmt, flush_threshold);
+	}
 
 	table_close(rel, NoLock);
 
 	return lcons(makeString((char *) sql),
-				 list_make5(target_attrs,
-							deparsed_insert_stmt_to_list(&stmt),
-							makeInteger(sdpath->mtpath->canSetTag),
-							makeInteger(userid),
-							makeInteger(flush_threshold)));
+				 lappend(list_make5(target_attrs,
+									deparsed_insert_stmt_to_list(&stmt),
+									makeInteger(sdpath->mtpath->canSetTag),
+									makeInteger(userid),
+									makeInteger(flush_threshold)),
+						 makeInteger(use_copy)));
 }
 
 static Plan *
@@ -6,6 +6,7 @@
 #include <postgres.h>
 #include <fmgr.h>
 
+#include "bgw_policy/chunk_precreate_api.h"
 #include "bgw_policy/compression_api.h"
 #include "bgw_policy/continuous_aggregate_api.h"
 #include "bgw_policy/retention_api.h"
@@ -87,6 +88,9 @@ CrossModuleFunctions tsl_cm_functions = {
 	.set_rel_pathlist_query = tsl_set_rel_pathlist_query,
 
 	/* bgw policies */
+	.policy_chunk_precreate_add = policy_chunk_precreate_add,
+	.policy_chunk_precreate_proc = policy_chunk_precreate_proc,
+	.policy_chunk_precreate_remove = policy_chunk_precreate_remove,
 	.policy_compression_add = policy_compression_add,
 	.policy_compression_proc = policy_compression_proc,
 	.policy_compression_remove = policy_compression_remove,
@@ -105,6 +109,7 @@ CrossModuleFunctions tsl_cm_functions = {
 	.job_delete = job_delete,
 	.job_run = job_run,
 	.job_execute = job_execute,
+	.policy_compression_compress_chunk = policy_compression_compress_chunk,
 
 	/* gapfill */
 	.gapfill_marker = gapfill_marker,
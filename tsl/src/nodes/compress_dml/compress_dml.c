@@ -6,22 +6,30 @@
 
 #include <postgres.h>
 #include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
 
 #include "compat.h"
 #include "chunk.h"
 #include "hypertable.h"
 #include "hypertable_compression.h"
 #include "compress_dml.h"
+#include "compression/compress_utils.h"
+#include "compression/segment_filter.h"
 #include "utils.h"
 
 /*Path, Plan and State node for processing dml on compressed chunks
  * For now, this just blocks updates/deletes on compressed chunks
- * since trigger based approach does not work
+ * since trigger based approach does not work. On partially decompressed
+ * chunks, updates/deletes are allowed if they cannot touch any batch that is
+ * still compressed.
  */
 
-static Path *compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid);
+static Path *compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid, bool is_partial,
+											List *segment_conditions);
 static Plan *compress_chunk_dml_plan_create(PlannerInfo *root, RelOptInfo *relopt,
 											CustomPath *best_path, List *tlist, List *clauses,
 											List *custom_plans);
@@ -66,19 +74,64 @@ compress_chunk_dml_rescan(CustomScanState *node)
 {
 }
 
+/*
+ * Check if any batch that is still compressed can contain rows matching the
+ * conditions of the statement on segmentby and orderby columns.
+ */
+static bool
+compress_chunk_dml_touches_compressed_batches(CompressChunkDmlState *state)
+{
+	Chunk *chunk = ts_chunk_get_by_relid(state->chunk_relid, true);
+	Chunk *compressed_chunk = ts_chunk_get_by_id(chunk->fd.compressed_chunk_id, true);
+	SegmentFilter *filter =
+		segment_filter_create(compressed_chunk->table_id,
+							  ts_hypertable_compression_get(chunk->fd.hypertable_id));
+	ListCell *lc;
+
+	foreach (lc, state->segment_conditions)
+	{
+		List *condition = lfirst(lc);
+
+		segment_filter_add_condition(filter,
+									 strVal(linitial(condition)),
+									 intVal(lsecond(condition)),
+									 castNode(Const, lthird(condition))->constvalue);
+	}
+
+	return segment_filter_has_match(filter);
+}
+
 /* we cannot update/delete rows if we have a compressed chunk. so
  * throw an error. Note this subplan will return 0 tuples as the chunk is empty
  * and all rows are saved in the compressed chunk.
+ * If the chunk is partially decompressed, the subplan scans the decompressed
+ * rows and we only throw an error if the statement could also affect rows
+ * that are still compressed.
  */
 static TupleTableSlot *
 compress_chunk_dml_exec(CustomScanState *node)
 {
 	CompressChunkDmlState *state = (CompressChunkDmlState *) node;
 	Oid chunk_relid = state->chunk_relid;
-	elog(ERROR,
-		 "cannot update/delete rows from chunk \"%s\" as it is compressed",
-		 get_rel_name(chunk_relid));
-	return NULL;
+
+	if (!state->is_partial)
+		elog(ERROR,
+			 "cannot update/delete rows from chunk \"%s\" as it is compressed",
+			 get_rel_name(chunk_relid));
+
+	if (!state->checked)
+	{
+		if (compress_chunk_dml_touches_compressed_batches(state))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot update/delete rows from chunk \"%s\" as it is compressed",
+							get_rel_name(chunk_relid)),
+					 errhint("Decompress the affected segments with decompress_chunk() and a "
+							 "segment_filter first.")));
+		state->checked = true;
+	}
+
+	return ExecProcNode(linitial(node->custom_ps));
 }
 
 static void
@@ -90,7 +143,8 @@ compress_chunk_dml_end(CustomScanState *node)
 }
 
 static Path *
-compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid)
+compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid, bool is_partial,
+							   List *segment_conditions)
 {
 	CompressChunkDmlPath *path = (CompressChunkDmlPath *) palloc0(sizeof(CompressChunkDmlPath));
 
@@ -103,6 +157,8 @@ compress_chunk_dml_path_create(Path *subpath, Oid chunk_relid)
 	path->cpath.methods = &compress_chunk_dml_path_methods;
 	path->cpath.custom_paths = list_make1(subpath);
 	path->chunk_relid = chunk_relid;
+	path->is_partial = is_partial;
+	path->segment_conditions = segment_conditions;
 
 	return &path->cpath.path;
 }
@@ -121,7 +177,9 @@ compress_chunk_dml_plan_create(PlannerInfo *root, RelOptInfo *relopt, CustomPath
 	cscan->scan.scanrelid = relopt->relid;
 	cscan->scan.plan.targetlist = tlist;
 	cscan->custom_scan_tlist = NIL;
-	cscan->custom_private = list_make1_oid(cdpath->chunk_relid);
+	cscan->custom_private = list_make3(list_make1_oid(cdpath->chunk_relid),
+									   makeInteger(cdpath->is_partial),
+									   cdpath->segment_conditions);
 	return &cscan->scan.plan;
 }
 
@@ -131,14 +189,96 @@ compress_chunk_dml_state_create(CustomScan *scan)
 	CompressChunkDmlState *state;
 
 	state = (CompressChunkDmlState *) newNode(sizeof(CompressChunkDmlState), T_CustomScanState);
-	state->chunk_relid = linitial_oid(scan->custom_private);
+	state->chunk_relid = linitial_oid(linitial(scan->custom_private));
+	state->is_partial = intVal(lsecond(scan->custom_private));
+	state->segment_conditions = lthird(scan->custom_private);
 	state->cscan_state.methods = &compress_chunk_dml_state_methods;
 	return (Node *) state;
 }
 
+/*
+ * Extract the conditions "column <op> constant" on segmentby and orderby
+ * columns from the restrictions of the chunk. Other restrictions are ignored,
+ * which can only make the check for affected compressed batches more
+ * conservative.
+ */
+static List *
+compress_chunk_dml_segment_conditions(RelOptInfo *rel, Chunk *chunk)
+{
+	List *column_compression_info = ts_hypertable_compression_get(chunk->fd.hypertable_id);
+	List *conditions = NIL;
+	ListCell *lc;
+
+	foreach (lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *ri = lfirst(lc);
+		OpExpr *op;
+		Expr *left;
+		Expr *right;
+		Var *var;
+		Const *value;
+		Oid opno;
+		TypeCacheEntry *tce;
+		int strategy;
+		char *column_name;
+
+		if (!IsA(ri->clause, OpExpr) || list_length(castNode(OpExpr, ri->clause)->args) != 2)
+			continue;
+
+		op = castNode(OpExpr, ri->clause);
+		opno = op->opno;
+		left = linitial(op->args);
+		right = lsecond(op->args);
+
+		if (IsA(right, Var) && IsA(left, Const))
+		{
+			Expr *tmp = left;
+
+			left = right;
+			right = tmp;
+			opno = get_commutator(opno);
+		}
+
+		if (!IsA(left, Var) || !IsA(right, Const) || !OidIsValid(opno))
+			continue;
+
+		var = castNode(Var, left);
+		value = castNode(Const, right);
+
+		if ((Index) var->varno != rel->relid || var->varattno <= 0 || value->constisnull ||
+			value->consttype != var->vartype || op->inputcollid != var->varcollid)
+			continue;
+
+		column_name = get_attname(chunk->table_id, var->varattno, false);
+		if (!segment_filter_column_is_supported(column_compression_info, column_name))
+			continue;
+
+		tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+		strategy = OidIsValid(tce->btree_opf) ? get_op_opfamily_strategy(opno, tce->btree_opf) : 0;
+		if (strategy == 0)
+			continue;
+
+		conditions =
+			lappend(conditions,
+					list_make3(makeString(column_name), makeInteger(strategy), copyObject(value)));
+	}
+
+	return conditions;
+}
+
 Path *
 compress_chunk_dml_generate_paths(Path *subpath, Chunk *chunk)
 {
+	bool is_partial;
+
 	Assert(chunk->fd.compressed_chunk_id > 0);
-	return compress_chunk_dml_path_create(subpath, chunk->table_id);
+
+	is_partial = tsl_compressed_chunk_is_partial(chunk);
+	return compress_chunk_dml_path_create(subpath,
+										  chunk->table_id,
+										  is_partial,
+										  is_partial ?
+											  compress_chunk_dml_segment_conditions(subpath->parent,
+																					chunk) :
+											  NIL);
 }
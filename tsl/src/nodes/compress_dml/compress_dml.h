@@ -16,12 +16,20 @@ typedef struct CompressChunkDmlPath
 {
 	CustomPath cpath;
 	Oid chunk_relid;
+	/* some batches of the chunk have been decompressed by a partial decompression */
+	bool is_partial;
+	/* conditions of the statement on segmentby and orderby columns, as
+	 * (column name, strategy, Const) lists */
+	List *segment_conditions;
 } CompressChunkDmlPath;
 
 typedef struct CompressChunkDmlState
 {
 	CustomScanState cscan_state;
 	Oid chunk_relid;
+	bool is_partial;
+	bool checked;
+	List *segment_conditions;
 } CompressChunkDmlState;
 
 Path *compress_chunk_dml_generate_paths(Path *subpath, Chunk *chunk);
@@ -30,6 +30,7 @@
 
 #include "hypertable_compression.h"
 #include "import/planner.h"
+#include "compression/compress_utils.h"
 #include "compression/create.h"
 #include "nodes/decompress_chunk/decompress_chunk.h"
 #include "nodes/decompress_chunk/planner.h"
@@ -268,7 +269,7 @@ build_compressed_scan_pathkeys(SortInfo *sort_info, PlannerInfo *root, List *chu
 	sort_info->compressed_pathkeys = compressed_pathkeys;
 }
 
-static DecompressChunkPath *
+DecompressChunkPath *
 copy_decompress_chunk_path(DecompressChunkPath *src)
 {
 	DecompressChunkPath *dst = palloc(sizeof(DecompressChunkPath));
@@ -277,6 +278,13 @@ copy_decompress_chunk_path(DecompressChunkPath *src)
 	return dst;
 }
 
+bool
+ts_is_decompress_chunk_path(Path *path)
+{
+	return IsA(path, CustomPath) &&
+		   castNode(CustomPath, path)->methods == &decompress_chunk_path_methods;
+}
+
 static CompressionInfo *
 build_compressioninfo(PlannerInfo *root, Hypertable *ht, RelOptInfo *chunk_rel)
 {
@@ -328,6 +336,46 @@ cost_decompress_chunk(Path *path, Path *compressed_path)
 	path->rows = compressed_path->rows * DECOMPRESS_CHUNK_BATCH_SIZE;
 }
 
+/*
+ * After a partial decompression, part of the data of a compressed chunk is
+ * stored in the uncompressed chunk, so combine the DecompressChunk path with
+ * a scan of the uncompressed chunk, keeping the sort order if there is one.
+ */
+static Path *
+decompress_chunk_add_uncompressed_part(PlannerInfo *root, RelOptInfo *chunk_rel,
+									   Path *decompress_path, Path *uncompressed_path)
+{
+	if (uncompressed_path == NULL)
+		return decompress_path;
+
+	if (decompress_path->pathkeys != NIL)
+	{
+		Path *sort_path = (Path *) create_sort_path(root,
+													chunk_rel,
+													uncompressed_path,
+													decompress_path->pathkeys,
+													-1.0);
+
+		return (Path *) create_merge_append_path(root,
+												 chunk_rel,
+												 list_make2(decompress_path, sort_path),
+												 decompress_path->pathkeys,
+												 NULL,
+												 NIL);
+	}
+
+	return (Path *) create_append_path_compat(root,
+											  chunk_rel,
+											  list_make2(decompress_path, uncompressed_path),
+											  NIL,
+											  NIL,
+											  NULL,
+											  0,
+											  false,
+											  NIL,
+											  -1);
+}
+
 void
 ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hypertable *ht,
 								   Chunk *chunk)
@@ -336,6 +384,7 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 	RelOptInfo *hypertable_rel;
 	ListCell *lc;
 	double new_row_estimate;
+	Path *uncompressed_path = NULL;
 
 	CompressionInfo *info = build_compressioninfo(root, ht, chunk_rel);
 	Index ht_index;
@@ -359,6 +408,9 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 	chunk_rel->pathlist = NIL;
 	chunk_rel->partial_pathlist = NIL;
 
+	if (tsl_compressed_chunk_is_partial(chunk))
+		uncompressed_path = create_seqscan_path(root, chunk_rel, NULL, 0);
+
 	/* add RangeTblEntry and RelOptInfo for compressed chunk */
 	decompress_chunk_add_plannerinfo(root, info, chunk, chunk_rel, sort_info.needs_sequence_num);
 	compressed_rel = info->compressed_rel;
@@ -368,6 +420,8 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 	pushdown_quals(root, chunk_rel, compressed_rel, info->hypertable_compression_info);
 	set_baserel_size_estimates(root, compressed_rel);
 	new_row_estimate = compressed_rel->rows * DECOMPRESS_CHUNK_BATCH_SIZE;
+	if (uncompressed_path != NULL)
+		new_row_estimate += uncompressed_path->rows;
 	/* adjust the parent's estimate by the diff of new and old estimate */
 	hypertable_rel->rows += (new_row_estimate - chunk_rel->rows);
 	chunk_rel->rows = new_row_estimate;
@@ -393,6 +447,10 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 			 bms_is_member(ht_index, child_path->param_info->ppi_req_outer)))
 			continue;
 
+		/* the scan of the uncompressed part is not parameterized */
+		if (uncompressed_path != NULL && child_path->param_info != NULL)
+			continue;
+
 		path = decompress_chunk_path_create(root, info, 0, child_path);
 
 		/* If we can push down the sort below the DecompressChunk node, we set the pathkeys of the
@@ -427,18 +485,26 @@ ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *chunk_rel, Hyp
 						  -1);
 				cost_decompress_chunk(&dcpath->cpath.path, &sort_path);
 			}
-			add_path(chunk_rel, &dcpath->cpath.path);
+			add_path(chunk_rel,
+					 decompress_chunk_add_uncompressed_part(root,
+															chunk_rel,
+															&dcpath->cpath.path,
+															uncompressed_path));
 		}
 
 		/* this has to go after the path is copied for the ordered path since path can get freed in
 		 * add_path */
-		add_path(chunk_rel, &path->cpath.path);
+		add_path(chunk_rel,
+				 decompress_chunk_add_uncompressed_part(root,
+														chunk_rel,
+														&path->cpath.path,
+														uncompressed_path));
 	}
 	/* the chunk_rel now owns the paths, remove them from the compressed_rel so they can't be freed
 	 * if it's planned */
 	compressed_rel->pathlist = NIL;
-	/* create parallel paths */
-	if (compressed_rel->consider_parallel)
+	/* create parallel paths, but only if all data is compressed */
+	if (compressed_rel->consider_parallel && uncompressed_path == NULL)
 	{
 		foreach (lc, compressed_rel->partial_pathlist)
 		{
@@ -907,7 +973,7 @@ decompress_chunk_add_plannerinfo(PlannerInfo *root, CompressionInfo *info, Chunk
 {
 	ListCell *lc;
 	Index compressed_index = root->simple_rel_array_size;
-	Chunk *compressed_chunk = ts_chunk_get_by_id(chunk->fd.compressed_chunk_id, true);
+	Chunk *compressed_chunk = ts_chunk_get_by_id_cached(chunk->fd.compressed_chunk_id, true);
 	Oid compressed_relid = compressed_chunk->table_id;
 	RelOptInfo *compressed_rel;
 
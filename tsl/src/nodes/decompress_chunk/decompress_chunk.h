@@ -50,10 +50,17 @@ typedef struct DecompressChunkPath
 	List *compressed_pathkeys;
 	bool needs_sequence_num;
 	bool reverse;
+	/*
+	 * the path computes the partial aggregates in its pathtarget directly
+	 * from the compressed batches instead of returning tuples
+	 */
+	bool partial_aggregation;
 } DecompressChunkPath;
 
 void ts_decompress_chunk_generate_paths(PlannerInfo *root, RelOptInfo *rel, Hypertable *ht,
 										Chunk *chunk);
+bool ts_is_decompress_chunk_path(Path *path);
+DecompressChunkPath *copy_decompress_chunk_path(DecompressChunkPath *src);
 
 FormData_hypertable_compression *get_column_compressioninfo(List *hypertable_compression_info,
 															char *column_name);
@@ -5,7 +5,9 @@
  */
 
 #include <postgres.h>
+#include <math.h>
 #include <miscadmin.h>
+#include <access/stratnum.h>
 #include <access/sysattr.h>
 #include <executor/executor.h>
 #include <nodes/bitmapset.h>
@@ -15,10 +17,12 @@
 #include <rewrite/rewriteManip.h>
 #include <utils/builtins.h>
 #include <utils/datum.h>
+#include <utils/lsyscache.h>
 #include <utils/memutils.h>
 #include <utils/typcache.h>
 
 #include "compat.h"
+#include "guc.h"
 #include "compression/array.h"
 #include "compression/compression.h"
 #include "nodes/decompress_chunk/decompress_chunk.h"
@@ -32,6 +36,7 @@ typedef enum DecompressChunkColumnType
 	COMPRESSED_COLUMN,
 	COUNT_COLUMN,
 	SEQUENCE_NUM_COLUMN,
+	SEGMENT_META_COLUMN,
 } DecompressChunkColumnType;
 
 typedef struct DecompressChunkColumnState
@@ -41,6 +46,7 @@ typedef struct DecompressChunkColumnState
 	AttrNumber attno;
 	union
 	{
+		/* also holds the value of segment meta columns */
 		struct
 		{
 			Datum value;
@@ -50,10 +56,52 @@ typedef struct DecompressChunkColumnState
 		struct
 		{
 			DecompressionIterator *iterator;
+			/* all values of the batch when using bulk decompression */
+			DecompressAllResult *values;
 		} compressed;
 	};
 } DecompressChunkColumnState;
 
+/*
+ * A "column op constant" qual on a compressed column that is evaluated
+ * directly on the bulk decompressed values of a whole batch, producing a
+ * selection bitmap before any tuples are formed. Integer columns are compared
+ * as int64 and float columns as float8, which is exact for all the same-family
+ * operators we accept.
+ */
+typedef struct VectorQual
+{
+	/* index into DecompressChunkState.columns */
+	int column_index;
+	StrategyNumber strategy;
+	bool is_float;
+	union
+	{
+		int64 i;
+		float8 f;
+	} constvalue;
+} VectorQual;
+
+/*
+ * A partial aggregate computed directly from the batches. Counts, integer
+ * sums and integer min/max are accumulated as int64, float aggregates as
+ * float8.
+ */
+typedef struct DecompressChunkAggregate
+{
+	DecompressChunkAggKind kind;
+	/* index into DecompressChunkState.columns, -1 for count(*) */
+	int column_index;
+	/* type of the aggregated column */
+	Oid typid;
+	bool isnull;
+	union
+	{
+		int64 i;
+		float8 f;
+	} value;
+} DecompressChunkAggregate;
+
 typedef struct DecompressChunkState
 {
 	CustomScanState csstate;
@@ -63,10 +111,23 @@ typedef struct DecompressChunkState
 
 	bool initialized;
 	bool reverse;
+	bool bulk_decompression;
 	int hypertable_id;
 	Oid chunk_relid;
 	List *hypertable_compression_info;
 	int counter;
+	/* number of rows in the current batch */
+	int batch_rows;
+	/* quals evaluated on the bulk decompressed values and their result */
+	List *vector_quals;
+	uint64 *selection;
+	/*
+	 * partial aggregates the node computes instead of returning tuples, NIL
+	 * for a regular scan, and the compressed columns they need
+	 */
+	List *aggregates;
+	Bitmapset *aggregate_columns;
+	bool aggregates_done;
 	MemoryContext per_batch_context;
 } DecompressChunkState;
 
@@ -75,6 +136,8 @@ static void decompress_chunk_begin(CustomScanState *node, EState *estate, int ef
 static void decompress_chunk_end(CustomScanState *node);
 static void decompress_chunk_rescan(CustomScanState *node);
 static TupleTableSlot *decompress_chunk_create_tuple(DecompressChunkState *state);
+static TupleTableSlot *decompress_chunk_create_tuple_bulk(DecompressChunkState *state);
+static TupleTableSlot *decompress_chunk_exec_aggregates(DecompressChunkState *state);
 
 static CustomExecMethods decompress_chunk_state_methods = {
 	.BeginCustomScan = decompress_chunk_begin,
@@ -99,6 +162,23 @@ decompress_chunk_state_create(CustomScan *cscan)
 	state->reverse = lthird_int(settings);
 	state->varattno_map = lsecond(cscan->custom_private);
 
+	/* the node computes partial aggregates, see decompress_chunk_plan_create */
+	if (list_length(cscan->custom_private) > 2)
+	{
+		ListCell *lc;
+
+		foreach (lc, lthird(cscan->custom_private))
+		{
+			List *spec = lfirst(lc);
+			DecompressChunkAggregate *agg = palloc0(sizeof(DecompressChunkAggregate));
+
+			agg->kind = linitial_int(spec);
+			agg->column_index = lsecond_int(spec);
+			agg->typid = lthird_int(spec);
+			state->aggregates = lappend(state->aggregates, agg);
+		}
+	}
+
 	return (Node *) state;
 }
 
@@ -113,7 +193,8 @@ static void
 initialize_column_state(DecompressChunkState *state)
 {
 	ScanState *ss = (ScanState *) state;
-	TupleDesc desc = ss->ss_ScanTupleSlot->tts_tupleDescriptor;
+	/* not the scan slot, which holds the partial aggregates when aggregating */
+	TupleDesc desc = RelationGetDescr(ss->ss_currentRelation);
 	ListCell *lc;
 	int i;
 
@@ -154,6 +235,9 @@ initialize_column_state(DecompressChunkState *state)
 				case DECOMPRESS_CHUNK_SEQUENCE_NUM_ID:
 					column->type = SEQUENCE_NUM_COLUMN;
 					break;
+				case DECOMPRESS_CHUNK_SEGMENT_META_ID:
+					column->type = SEGMENT_META_COLUMN;
+					break;
 				default:
 					elog(ERROR, "Invalid column attno \"%d\"", column->attno);
 					break;
@@ -209,6 +293,326 @@ constify_tableoid(List *node, Index chunk_index, Oid chunk_relid)
 	return (List *) constify_tableoid_walker((Node *) node, &ctx);
 }
 
+/*
+ * Check whether expr is a comparison between a column and a constant that we
+ * can evaluate on the bulk decompressed values, and fill in qual and the
+ * column if so. The column index of qual is not set here. A scanrelid of 0
+ * accepts columns of any relation.
+ */
+static bool
+vector_qual_parse(Expr *expr, Index scanrelid, VectorQual *qual, Var **column_var)
+{
+	OpExpr *opexpr;
+	Expr *leftop, *rightop;
+	Var *var;
+	Const *constant;
+	Oid opno;
+	TypeCacheEntry *tce;
+
+	if (!IsA(expr, OpExpr))
+		return false;
+
+	opexpr = castNode(OpExpr, expr);
+	if (list_length(opexpr->args) != 2)
+		return false;
+
+	leftop = linitial(opexpr->args);
+	rightop = lsecond(opexpr->args);
+	opno = opexpr->opno;
+
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		var = castNode(Var, leftop);
+		constant = castNode(Const, rightop);
+	}
+	else if (IsA(leftop, Const) && IsA(rightop, Var))
+	{
+		var = castNode(Var, rightop);
+		constant = castNode(Const, leftop);
+		opno = get_commutator(opno);
+	}
+	else
+		return false;
+
+	if (!OidIsValid(opno) || (scanrelid != 0 && var->varno != scanrelid) ||
+		var->varattno <= 0 || constant->constisnull)
+		return false;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(tce->btree_opf))
+		return false;
+
+	qual->strategy = get_op_opfamily_strategy(opno, tce->btree_opf);
+	if (qual->strategy == InvalidStrategy)
+		return false;
+
+	*column_var = var;
+
+	switch (var->vartype)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			/* cross-type integer operators compare the values exactly */
+			qual->is_float = false;
+			switch (constant->consttype)
+			{
+				case INT2OID:
+					qual->constvalue.i = DatumGetInt16(constant->constvalue);
+					break;
+				case INT4OID:
+					qual->constvalue.i = DatumGetInt32(constant->constvalue);
+					break;
+				case INT8OID:
+					qual->constvalue.i = DatumGetInt64(constant->constvalue);
+					break;
+				default:
+					return false;
+			}
+			break;
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			/* cross-type datetime operators involve conversions, so only same-type */
+			if (constant->consttype != var->vartype)
+				return false;
+
+			qual->is_float = false;
+			if (var->vartype == DATEOID)
+				qual->constvalue.i = DatumGetInt32(constant->constvalue);
+			else
+				qual->constvalue.i = DatumGetInt64(constant->constvalue);
+			break;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			qual->is_float = true;
+			switch (constant->consttype)
+			{
+				case FLOAT4OID:
+					qual->constvalue.f = DatumGetFloat4(constant->constvalue);
+					break;
+				case FLOAT8OID:
+					qual->constvalue.f = DatumGetFloat8(constant->constvalue);
+					break;
+				default:
+					return false;
+			}
+
+			/* NaN sorts above all other values in PostgreSQL, unlike in C */
+			if (isnan(qual->constvalue.f))
+				return false;
+			break;
+		default:
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Check whether expr is a qual the executor evaluates on the bulk decompressed
+ * values, and return the attribute number of the column it refers to. The
+ * planner uses this to decide whether all quals of a chunk can be evaluated
+ * on the batches.
+ */
+bool
+decompress_chunk_is_vector_qual(Expr *expr, Index scanrelid, AttrNumber *attno)
+{
+	VectorQual qual;
+	Var *var;
+
+	if (!vector_qual_parse(expr, scanrelid, &qual, &var))
+		return false;
+
+	*attno = var->varattno;
+	return true;
+}
+
+/*
+ * Check whether expr is a comparison between a compressed column and a
+ * constant that we can evaluate on the bulk decompressed values, and fill in
+ * qual if so.
+ */
+static bool
+vector_qual_from_expr(DecompressChunkState *state, Expr *expr, Index scanrelid, VectorQual *qual)
+{
+	Var *var;
+	int i;
+
+	if (!vector_qual_parse(expr, scanrelid, qual, &var))
+		return false;
+
+	for (i = 0; i < state->num_columns; i++)
+	{
+		if (state->columns[i].type == COMPRESSED_COLUMN &&
+			state->columns[i].attno == var->varattno)
+		{
+			qual->column_index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Move the quals that can be evaluated on the bulk decompressed values out of
+ * quals and return the remaining ones.
+ */
+static List *
+decompress_chunk_init_vector_quals(DecompressChunkState *state, List *quals, Index scanrelid)
+{
+	List *remaining = NIL;
+	ListCell *lc;
+
+	foreach (lc, quals)
+	{
+		VectorQual *qual = palloc0(sizeof(VectorQual));
+
+		if (vector_qual_from_expr(state, lfirst(lc), scanrelid, qual))
+			state->vector_quals = lappend(state->vector_quals, qual);
+		else
+		{
+			pfree(qual);
+			remaining = lappend(remaining, lfirst(lc));
+		}
+	}
+
+	return remaining;
+}
+
+/*
+ * Comparison loop of a vector qual: the rows of every 64-row word are
+ * compared into a bitmask that is ANDed into the selection. The greater-than
+ * comparisons are written as negated less-than comparisons so that NaN
+ * values, which PostgreSQL sorts above everything else, pass them.
+ */
+#define VECTOR_QUAL_LOOP(CTYPE, DOMAIN, CONDITION)                                                 \
+	do                                                                                             \
+	{                                                                                              \
+		const CTYPE *values = result->values;                                                      \
+		int32 word;                                                                                \
+                                                                                                   \
+		for (word = 0; word < DECOMPRESS_ALL_VALIDITY_WORDS(result->num_values); word++)           \
+		{                                                                                          \
+			int32 num_rows = Min(64, result->num_values - word * 64);                              \
+			uint64 bits = 0;                                                                       \
+			int32 i;                                                                               \
+                                                                                                   \
+			for (i = 0; i < num_rows; i++)                                                         \
+			{                                                                                      \
+				DOMAIN value = values[word * 64 + i];                                              \
+				bits |= ((uint64) (CONDITION)) << i;                                               \
+			}                                                                                      \
+                                                                                                   \
+			selection[word] &= bits;                                                               \
+		}                                                                                          \
+	} while (0)
+
+#define VECTOR_QUAL_DEFINE(NAME, CTYPE, DOMAIN)                                                    \
+	static void NAME(const DecompressAllResult *result,                                            \
+					 StrategyNumber strategy,                                                      \
+					 DOMAIN constvalue,                                                            \
+					 uint64 *restrict selection)                                                   \
+	{                                                                                              \
+		switch (strategy)                                                                          \
+		{                                                                                          \
+			case BTLessStrategyNumber:                                                             \
+				VECTOR_QUAL_LOOP(CTYPE, DOMAIN, value < constvalue);                               \
+				break;                                                                             \
+			case BTLessEqualStrategyNumber:                                                        \
+				VECTOR_QUAL_LOOP(CTYPE, DOMAIN, value <= constvalue);                              \
+				break;                                                                             \
+			case BTEqualStrategyNumber:                                                            \
+				VECTOR_QUAL_LOOP(CTYPE, DOMAIN, value == constvalue);                              \
+				break;                                                                             \
+			case BTGreaterEqualStrategyNumber:                                                     \
+				VECTOR_QUAL_LOOP(CTYPE, DOMAIN, !(value < constvalue));                            \
+				break;                                                                             \
+			case BTGreaterStrategyNumber:                                                          \
+				VECTOR_QUAL_LOOP(CTYPE, DOMAIN, !(value <= constvalue));                           \
+				break;                                                                             \
+			default:                                                                               \
+				elog(ERROR, "invalid strategy %d for vector qual", strategy);                      \
+		}                                                                                          \
+	}
+
+VECTOR_QUAL_DEFINE(vector_qual_int16, int16, int64)
+VECTOR_QUAL_DEFINE(vector_qual_int32, int32, int64)
+VECTOR_QUAL_DEFINE(vector_qual_int64, int64, int64)
+VECTOR_QUAL_DEFINE(vector_qual_float4, float4, float8)
+VECTOR_QUAL_DEFINE(vector_qual_float8, float8, float8)
+
+/*
+ * Evaluate the vector quals on the current batch. Rows that fail any of them
+ * are cleared in the selection bitmap and skipped when forming tuples.
+ */
+static void
+compute_batch_selection(DecompressChunkState *state)
+{
+	int num_words = DECOMPRESS_ALL_VALIDITY_WORDS(state->batch_rows);
+	bool any_selected = false;
+	ListCell *lc;
+	int i;
+
+	state->selection = palloc(sizeof(uint64) * Max(num_words, 1));
+	memset(state->selection, 0xFF, sizeof(uint64) * num_words);
+
+	foreach (lc, state->vector_quals)
+	{
+		VectorQual *qual = lfirst(lc);
+		DecompressAllResult *result = state->columns[qual->column_index].compressed.values;
+
+		/* all values of the column are NULL in this batch, which no comparison passes */
+		if (result == NULL)
+		{
+			memset(state->selection, 0, sizeof(uint64) * num_words);
+			break;
+		}
+
+		switch (result->element_type)
+		{
+			case INT2OID:
+				vector_qual_int16(result, qual->strategy, qual->constvalue.i, state->selection);
+				break;
+			case INT4OID:
+			case DATEOID:
+				vector_qual_int32(result, qual->strategy, qual->constvalue.i, state->selection);
+				break;
+			case INT8OID:
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				vector_qual_int64(result, qual->strategy, qual->constvalue.i, state->selection);
+				break;
+			case FLOAT4OID:
+				vector_qual_float4(result, qual->strategy, qual->constvalue.f, state->selection);
+				break;
+			case FLOAT8OID:
+				vector_qual_float8(result, qual->strategy, qual->constvalue.f, state->selection);
+				break;
+			default:
+				elog(ERROR, "unexpected type %u for vector qual", result->element_type);
+		}
+
+		/* comparison operators are strict, so NULLs never pass */
+		if (result->validity != NULL)
+		{
+			for (i = 0; i < num_words; i++)
+				state->selection[i] &= result->validity[i];
+		}
+	}
+
+	for (i = 0; i < num_words; i++)
+		any_selected |= state->selection[i] != 0;
+
+	/* skip the batch entirely if no row passed the quals */
+	if (!any_selected)
+	{
+		InstrCountFiltered1(state, state->batch_rows);
+		state->counter = 0;
+	}
+}
+
 /*
  * Complete initialization of the supplied CustomScanState.
  *
@@ -246,9 +650,47 @@ decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
 	}
 
 	state->hypertable_compression_info = ts_hypertable_compression_get(state->hypertable_id);
+	state->bulk_decompression = ts_guc_enable_bulk_decompression;
 
 	initialize_column_state(state);
 
+	if (state->aggregates != NIL)
+	{
+		/*
+		 * Aggregates are always computed from the bulk decompressed batches.
+		 * The quals are not adjusted by setrefs since they are private to the
+		 * node, so we can't check their varno, but they can only refer to the
+		 * chunk anyway.
+		 */
+		ListCell *lc;
+
+		state->bulk_decompression = true;
+		if (decompress_chunk_init_vector_quals(state, lfourth(cscan->custom_private), 0) != NIL)
+			elog(ERROR, "unsupported qual for aggregation in DecompressChunk");
+
+		foreach (lc, state->aggregates)
+		{
+			DecompressChunkAggregate *agg = lfirst(lc);
+
+			if (agg->column_index >= 0 &&
+				state->columns[agg->column_index].type == COMPRESSED_COLUMN)
+				state->aggregate_columns =
+					bms_add_member(state->aggregate_columns, agg->column_index);
+		}
+
+		foreach (lc, state->vector_quals)
+			state->aggregate_columns = bms_add_member(state->aggregate_columns,
+													  ((VectorQual *) lfirst(lc))->column_index);
+	}
+	else if (state->bulk_decompression)
+	{
+		List *remaining =
+			decompress_chunk_init_vector_quals(state, cscan->scan.plan.qual, cscan->scan.scanrelid);
+
+		if (state->vector_quals != NIL)
+			state->csstate.ss.ps.qual = ExecInitQual(remaining, (PlanState *) state);
+	}
+
 	node->custom_ps = lappend(node->custom_ps, ExecInitNode(compressed_scan, estate, eflags));
 
 	state->per_batch_context = AllocSetContextCreate(CurrentMemoryContext,
@@ -264,6 +706,7 @@ initialize_batch(DecompressChunkState *state, TupleTableSlot *slot)
 	int i;
 	MemoryContext old_context = MemoryContextSwitchTo(state->per_batch_context);
 	MemoryContextReset(state->per_batch_context);
+	state->selection = NULL;
 
 	for (i = 0; i < state->num_columns; i++)
 	{
@@ -274,7 +717,19 @@ initialize_batch(DecompressChunkState *state, TupleTableSlot *slot)
 			case COMPRESSED_COLUMN:
 			{
 				value = slot_getattr(slot, AttrOffsetGetAttrNumber(i), &isnull);
-				if (!isnull)
+				column->compressed.iterator = NULL;
+				column->compressed.values = NULL;
+
+				if (isnull)
+					break;
+
+				if (state->bulk_decompression)
+				{
+					/* values are always decompressed in forward order, reverse
+					 * scans read the result arrays back to front instead */
+					column->compressed.values = tsl_decompress_all(value, column->typid);
+				}
+				else
 				{
 					CompressedDataHeader *header = (CompressedDataHeader *) PG_DETOAST_DATUM(value);
 
@@ -283,9 +738,6 @@ initialize_batch(DecompressChunkState *state, TupleTableSlot *slot)
 															state->reverse)(PointerGetDatum(header),
 																			column->typid);
 				}
-				else
-					column->compressed.iterator = NULL;
-
 				break;
 			}
 			case SEGMENTBY_COLUMN:
@@ -304,6 +756,7 @@ initialize_batch(DecompressChunkState *state, TupleTableSlot *slot)
 				Assert(!isnull);
 				break;
 			case SEQUENCE_NUM_COLUMN:
+			case SEGMENT_META_COLUMN:
 				/*
 				 * nothing to do here for sequence number
 				 * we only needed this for sorting in node below
@@ -311,6 +764,24 @@ initialize_batch(DecompressChunkState *state, TupleTableSlot *slot)
 				break;
 		}
 	}
+
+	state->batch_rows = state->counter;
+
+	if (state->bulk_decompression)
+	{
+		for (i = 0; i < state->num_columns; i++)
+		{
+			DecompressChunkColumnState *column = &state->columns[i];
+
+			if (column->type == COMPRESSED_COLUMN && column->compressed.values != NULL &&
+				column->compressed.values->num_values != state->batch_rows)
+				elog(ERROR, "compressed column out of sync with batch counter");
+		}
+
+		if (state->vector_quals != NIL)
+			compute_batch_selection(state);
+	}
+
 	state->initialized = true;
 	MemoryContextSwitchTo(old_context);
 }
@@ -326,9 +797,22 @@ decompress_chunk_exec(CustomScanState *node)
 
 	ResetExprContext(econtext);
 
+	if (state->aggregates != NIL)
+	{
+		TupleTableSlot *slot = decompress_chunk_exec_aggregates(state);
+
+		if (TupIsNull(slot) || !node->ss.ps.ps_ProjInfo)
+			return slot;
+
+		econtext->ecxt_scantuple = slot;
+		return ExecProject(node->ss.ps.ps_ProjInfo);
+	}
+
 	while (true)
 	{
-		TupleTableSlot *slot = decompress_chunk_create_tuple(state);
+		TupleTableSlot *slot = state->bulk_decompression ?
+								   decompress_chunk_create_tuple_bulk(state) :
+								   decompress_chunk_create_tuple(state);
 
 		if (TupIsNull(slot))
 			return NULL;
@@ -353,6 +837,7 @@ static void
 decompress_chunk_rescan(CustomScanState *node)
 {
 	((DecompressChunkState *) node)->initialized = false;
+	((DecompressChunkState *) node)->aggregates_done = false;
 	ExecReScan(linitial(node->custom_ps));
 }
 
@@ -445,6 +930,7 @@ decompress_chunk_create_tuple(DecompressChunkState *state)
 					break;
 				}
 				case SEQUENCE_NUM_COLUMN:
+				case SEGMENT_META_COLUMN:
 					/*
 					 * nothing to do here for sequence number
 					 * we only needed this for sorting in node below
@@ -464,3 +950,507 @@ decompress_chunk_create_tuple(DecompressChunkState *state)
 		return slot;
 	}
 }
+
+/*
+ * Create generated tuple from the bulk decompressed values of the current
+ * batch. All compressed columns of the batch have been decompressed into flat
+ * arrays when the batch was initialized, so filling a row is just indexing
+ * into those arrays.
+ */
+static TupleTableSlot *
+decompress_chunk_create_tuple_bulk(DecompressChunkState *state)
+{
+	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
+	int row;
+	int i;
+
+	while (true)
+	{
+		if (!state->initialized)
+		{
+			TupleTableSlot *subslot = ExecProcNode(linitial(state->csstate.custom_ps));
+
+			if (TupIsNull(subslot))
+				return NULL;
+
+			initialize_batch(state, subslot);
+		}
+
+		if (state->counter <= 0)
+		{
+			state->initialized = false;
+			continue;
+		}
+
+		row = state->reverse ? state->counter - 1 : state->batch_rows - state->counter;
+		state->counter--;
+
+		/* rows that failed the vector quals are never materialized */
+		if (state->selection != NULL &&
+			(state->selection[row / 64] & (UINT64CONST(1) << (row % 64))) == 0)
+		{
+			InstrCountFiltered1(state, 1);
+			continue;
+		}
+
+		break;
+	}
+
+	ExecClearTuple(slot);
+
+	for (i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+		AttrNumber attr;
+
+		switch (column->type)
+		{
+			case COMPRESSED_COLUMN:
+			{
+				DecompressAllResult *values = column->compressed.values;
+				attr = AttrNumberGetAttrOffset(column->attno);
+
+				if (values == NULL || decompress_all_result_is_null(values, row))
+					slot->tts_isnull[attr] = true;
+				else
+				{
+					slot->tts_values[attr] = decompress_all_result_get_datum(values, row);
+					slot->tts_isnull[attr] = false;
+				}
+				break;
+			}
+			case SEGMENTBY_COLUMN:
+				attr = AttrNumberGetAttrOffset(column->attno);
+				slot->tts_values[attr] = column->segmentby.value;
+				slot->tts_isnull[attr] = column->segmentby.isnull;
+				break;
+			case COUNT_COLUMN:
+			case SEQUENCE_NUM_COLUMN:
+			case SEGMENT_META_COLUMN:
+				/* the batch counter has already been advanced above */
+				break;
+		}
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	return slot;
+}
+
+/*
+ * Aggregation mode: the node computes the partial aggregates of the chunk
+ * directly from the batches and returns a single tuple with them, so neither
+ * the tuples nor, for count(*) and min/max from segment metadata, the column
+ * values have to be materialized.
+ */
+
+/* float comparison that sorts NaN above all other values like PostgreSQL does */
+static inline bool
+aggregate_float_lt(float8 a, float8 b)
+{
+	if (isnan(a))
+		return false;
+
+	return isnan(b) || a < b;
+}
+
+static inline void
+aggregate_value_int(DecompressChunkAggregate *agg, int64 value)
+{
+	switch (agg->kind)
+	{
+		case DECOMPRESS_CHUNK_AGG_SUM:
+			agg->value.i = agg->isnull ? value : agg->value.i + value;
+			break;
+		case DECOMPRESS_CHUNK_AGG_MIN:
+			if (agg->isnull || value < agg->value.i)
+				agg->value.i = value;
+			break;
+		case DECOMPRESS_CHUNK_AGG_MAX:
+			if (agg->isnull || value > agg->value.i)
+				agg->value.i = value;
+			break;
+		default:
+			elog(ERROR, "unexpected aggregate kind %d", agg->kind);
+	}
+
+	agg->isnull = false;
+}
+
+static inline void
+aggregate_value_float(DecompressChunkAggregate *agg, float8 value)
+{
+	switch (agg->kind)
+	{
+		case DECOMPRESS_CHUNK_AGG_SUM:
+		{
+			float8 sum;
+
+			if (agg->isnull)
+				sum = value;
+			else if (agg->typid == FLOAT4OID)
+				/* sum(float4) adds in single precision */
+				sum = (float4) ((float4) agg->value.f + (float4) value);
+			else
+				sum = agg->value.f + value;
+
+			/* same check as float4pl and float8pl */
+			if (isinf(sum) && !isinf(agg->value.f) && !isinf(value))
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("value out of range: overflow")));
+
+			agg->value.f = sum;
+			break;
+		}
+		case DECOMPRESS_CHUNK_AGG_MIN:
+			if (agg->isnull || aggregate_float_lt(value, agg->value.f))
+				agg->value.f = value;
+			break;
+		case DECOMPRESS_CHUNK_AGG_MAX:
+			if (agg->isnull || aggregate_float_lt(agg->value.f, value))
+				agg->value.f = value;
+			break;
+		default:
+			elog(ERROR, "unexpected aggregate kind %d", agg->kind);
+	}
+
+	agg->isnull = false;
+}
+
+/* rows of the given 64-row word of the batch that are selected and not NULL */
+static inline uint64
+batch_row_mask(const DecompressChunkState *state, const uint64 *validity, int32 word)
+{
+	int32 num_rows = Min(64, state->batch_rows - word * 64);
+	uint64 mask = num_rows == 64 ? ~UINT64CONST(0) : (UINT64CONST(1) << num_rows) - 1;
+
+	if (state->selection != NULL)
+		mask &= state->selection[word];
+	if (validity != NULL)
+		mask &= validity[word];
+
+	return mask;
+}
+
+static int64
+count_batch_rows(const DecompressChunkState *state, const uint64 *validity)
+{
+	int64 count = 0;
+	int32 word;
+
+	if (state->selection == NULL && validity == NULL)
+		return state->batch_rows;
+
+	for (word = 0; word < DECOMPRESS_ALL_VALIDITY_WORDS(state->batch_rows); word++)
+	{
+		uint64 mask;
+
+		for (mask = batch_row_mask(state, validity, word); mask != 0; mask &= mask - 1)
+			count++;
+	}
+
+	return count;
+}
+
+/*
+ * Accumulation loop over the selected non-NULL values of a bulk decompressed
+ * column.
+ */
+#define AGGREGATE_VALUES_DEFINE(NAME, CTYPE, ACCUMULATE)                                           \
+	static void NAME(DecompressChunkState *state,                                                  \
+					 DecompressChunkAggregate *agg,                                                \
+					 const DecompressAllResult *result)                                            \
+	{                                                                                              \
+		const CTYPE *values = result->values;                                                      \
+		int32 word;                                                                                \
+                                                                                                   \
+		for (word = 0; word < DECOMPRESS_ALL_VALIDITY_WORDS(state->batch_rows); word++)            \
+		{                                                                                          \
+			uint64 rows = batch_row_mask(state, result->validity, word);                           \
+			int32 i;                                                                               \
+                                                                                                   \
+			for (i = 0; rows != 0; i++, rows >>= 1)                                                \
+			{                                                                                      \
+				if (rows & 1)                                                                      \
+					ACCUMULATE(agg, values[word * 64 + i]);                                        \
+			}                                                                                      \
+		}                                                                                          \
+	}
+
+AGGREGATE_VALUES_DEFINE(aggregate_values_int16, int16, aggregate_value_int)
+AGGREGATE_VALUES_DEFINE(aggregate_values_int32, int32, aggregate_value_int)
+AGGREGATE_VALUES_DEFINE(aggregate_values_int64, int64, aggregate_value_int)
+AGGREGATE_VALUES_DEFINE(aggregate_values_float4, float4, aggregate_value_float)
+AGGREGATE_VALUES_DEFINE(aggregate_values_float8, float8, aggregate_value_float)
+
+/*
+ * Aggregate a segmentby or segment meta value that stands for the given
+ * number of rows.
+ */
+static void
+aggregate_repeated_value(DecompressChunkAggregate *agg, Datum value, int64 rows)
+{
+	int64 i;
+
+	switch (agg->typid)
+	{
+		case FLOAT4OID:
+		case FLOAT8OID:
+		{
+			float8 f = agg->typid == FLOAT4OID ? DatumGetFloat4(value) : DatumGetFloat8(value);
+
+			if (agg->kind != DECOMPRESS_CHUNK_AGG_SUM)
+				rows = 1;
+
+			for (i = 0; i < rows; i++)
+				aggregate_value_float(agg, f);
+			break;
+		}
+		case INT2OID:
+			aggregate_value_int(agg,
+								agg->kind == DECOMPRESS_CHUNK_AGG_SUM ?
+									DatumGetInt16(value) * rows :
+									DatumGetInt16(value));
+			break;
+		case INT4OID:
+		case DATEOID:
+			aggregate_value_int(agg,
+								agg->kind == DECOMPRESS_CHUNK_AGG_SUM ?
+									DatumGetInt32(value) * rows :
+									DatumGetInt32(value));
+			break;
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			/* no sum for these types */
+			aggregate_value_int(agg, DatumGetInt64(value));
+			break;
+		default:
+			elog(ERROR, "unexpected type %u for aggregation in DecompressChunk", agg->typid);
+	}
+}
+
+static void
+aggregate_batch(DecompressChunkState *state, TupleTableSlot *subslot)
+{
+	ListCell *lc;
+	Datum value;
+	bool isnull;
+	int i;
+
+	state->selection = NULL;
+	state->batch_rows = 0;
+
+	for (i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+
+		switch (column->type)
+		{
+			case COMPRESSED_COLUMN:
+				column->compressed.iterator = NULL;
+				column->compressed.values = NULL;
+
+				/* only decompress the columns we actually look at */
+				if (!bms_is_member(i, state->aggregate_columns))
+					break;
+
+				value = slot_getattr(subslot, AttrOffsetGetAttrNumber(i), &isnull);
+				if (!isnull)
+					column->compressed.values = tsl_decompress_all(value, column->typid);
+				break;
+			case SEGMENTBY_COLUMN:
+			case SEGMENT_META_COLUMN:
+				value = slot_getattr(subslot, AttrOffsetGetAttrNumber(i), &isnull);
+				column->segmentby.value = isnull ? (Datum) 0 : value;
+				column->segmentby.isnull = isnull;
+				break;
+			case COUNT_COLUMN:
+				value = slot_getattr(subslot, AttrOffsetGetAttrNumber(i), &isnull);
+				/* count column should never be NULL */
+				Assert(!isnull);
+				state->batch_rows = DatumGetInt32(value);
+				break;
+			case SEQUENCE_NUM_COLUMN:
+				break;
+		}
+	}
+
+	for (i = 0; i < state->num_columns; i++)
+	{
+		DecompressChunkColumnState *column = &state->columns[i];
+
+		if (column->type == COMPRESSED_COLUMN && column->compressed.values != NULL &&
+			column->compressed.values->num_values != state->batch_rows)
+			elog(ERROR, "compressed column out of sync with batch counter");
+	}
+
+	if (state->vector_quals != NIL)
+	{
+		state->counter = state->batch_rows;
+		compute_batch_selection(state);
+
+		/* no row of the batch passed the quals */
+		if (state->counter == 0)
+			return;
+	}
+
+	foreach (lc, state->aggregates)
+	{
+		DecompressChunkAggregate *agg = lfirst(lc);
+		DecompressChunkColumnState *column;
+		DecompressAllResult *result;
+
+		if (agg->kind == DECOMPRESS_CHUNK_AGG_COUNT_STAR)
+		{
+			agg->value.i += count_batch_rows(state, NULL);
+			continue;
+		}
+
+		column = &state->columns[agg->column_index];
+
+		if (column->type != COMPRESSED_COLUMN)
+		{
+			int64 rows = count_batch_rows(state, NULL);
+
+			if (column->segmentby.isnull || rows == 0)
+				continue;
+
+			if (agg->kind == DECOMPRESS_CHUNK_AGG_COUNT)
+				agg->value.i += rows;
+			else
+				aggregate_repeated_value(agg, column->segmentby.value, rows);
+			continue;
+		}
+
+		/* all values of the column are NULL in this batch */
+		result = column->compressed.values;
+		if (result == NULL)
+			continue;
+
+		if (agg->kind == DECOMPRESS_CHUNK_AGG_COUNT)
+		{
+			agg->value.i += count_batch_rows(state, result->validity);
+			continue;
+		}
+
+		switch (result->element_type)
+		{
+			case INT2OID:
+				aggregate_values_int16(state, agg, result);
+				break;
+			case INT4OID:
+			case DATEOID:
+				aggregate_values_int32(state, agg, result);
+				break;
+			case INT8OID:
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				aggregate_values_int64(state, agg, result);
+				break;
+			case FLOAT4OID:
+				aggregate_values_float4(state, agg, result);
+				break;
+			case FLOAT8OID:
+				aggregate_values_float8(state, agg, result);
+				break;
+			default:
+				elog(ERROR,
+					 "unexpected type %u for aggregation in DecompressChunk",
+					 result->element_type);
+		}
+	}
+}
+
+/* the partial aggregate as a Datum of its transition type */
+static Datum
+aggregate_result_datum(DecompressChunkAggregate *agg)
+{
+	if (agg->kind == DECOMPRESS_CHUNK_AGG_COUNT_STAR || agg->kind == DECOMPRESS_CHUNK_AGG_COUNT)
+		return Int64GetDatum(agg->value.i);
+
+	switch (agg->typid)
+	{
+		case INT2OID:
+			/* sum(int2) and sum(int4) have a bigint transition type */
+			if (agg->kind == DECOMPRESS_CHUNK_AGG_SUM)
+				return Int64GetDatum(agg->value.i);
+			return Int16GetDatum((int16) agg->value.i);
+		case INT4OID:
+			if (agg->kind == DECOMPRESS_CHUNK_AGG_SUM)
+				return Int64GetDatum(agg->value.i);
+			return Int32GetDatum((int32) agg->value.i);
+		case DATEOID:
+			return Int32GetDatum((int32) agg->value.i);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return Int64GetDatum(agg->value.i);
+		case FLOAT4OID:
+			return Float4GetDatum((float4) agg->value.f);
+		case FLOAT8OID:
+			return Float8GetDatum(agg->value.f);
+		default:
+			elog(ERROR, "unexpected type %u for aggregation in DecompressChunk", agg->typid);
+	}
+
+	pg_unreachable();
+}
+
+/*
+ * Aggregate all batches of the chunk and return the partial aggregates as a
+ * single tuple.
+ */
+static TupleTableSlot *
+decompress_chunk_exec_aggregates(DecompressChunkState *state)
+{
+	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
+	ListCell *lc;
+	int i;
+
+	if (state->aggregates_done)
+		return NULL;
+
+	foreach (lc, state->aggregates)
+	{
+		DecompressChunkAggregate *agg = lfirst(lc);
+
+		/* counts start at zero, everything else is NULL without input rows */
+		agg->isnull = agg->kind != DECOMPRESS_CHUNK_AGG_COUNT_STAR &&
+					  agg->kind != DECOMPRESS_CHUNK_AGG_COUNT;
+		agg->value.i = 0;
+	}
+
+	while (true)
+	{
+		TupleTableSlot *subslot = ExecProcNode(linitial(state->csstate.custom_ps));
+		MemoryContext old_context;
+
+		if (TupIsNull(subslot))
+			break;
+
+		old_context = MemoryContextSwitchTo(state->per_batch_context);
+		MemoryContextReset(state->per_batch_context);
+		aggregate_batch(state, subslot);
+		MemoryContextSwitchTo(old_context);
+	}
+
+	state->aggregates_done = true;
+
+	ExecClearTuple(slot);
+
+	i = 0;
+	foreach (lc, state->aggregates)
+	{
+		DecompressChunkAggregate *agg = lfirst(lc);
+
+		slot->tts_isnull[i] = agg->isnull;
+		slot->tts_values[i] = agg->isnull ? (Datum) 0 : aggregate_result_datum(agg);
+		i++;
+	}
+
+	ExecStoreVirtualTuple(slot);
+
+	return slot;
+}
@@ -8,10 +8,23 @@
 #define TIMESCALEDB_DECOMPRESS_CHUNK_EXEC_H
 
 #include <postgres.h>
+#include <nodes/primnodes.h>
 
 #define DECOMPRESS_CHUNK_COUNT_ID -9
 #define DECOMPRESS_CHUNK_SEQUENCE_NUM_ID -10
+#define DECOMPRESS_CHUNK_SEGMENT_META_ID -11
+
+/* aggregates DecompressChunk can compute directly from the compressed batches */
+typedef enum DecompressChunkAggKind
+{
+	DECOMPRESS_CHUNK_AGG_COUNT_STAR,
+	DECOMPRESS_CHUNK_AGG_COUNT,
+	DECOMPRESS_CHUNK_AGG_SUM,
+	DECOMPRESS_CHUNK_AGG_MIN,
+	DECOMPRESS_CHUNK_AGG_MAX,
+} DecompressChunkAggKind;
 
 extern Node *decompress_chunk_state_create(CustomScan *cscan);
+extern bool decompress_chunk_is_vector_qual(Expr *expr, Index scanrelid, AttrNumber *attno);
 
 #endif /* TIMESCALEDB_DECOMPRESS_CHUNK_EXEC_H */
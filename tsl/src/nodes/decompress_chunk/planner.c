@@ -6,29 +6,33 @@
 
 #include <postgres.h>
 #include <access/sysattr.h>
+#include <catalog/pg_aggregate.h>
 #include <catalog/pg_namespace.h>
 #include <catalog/pg_operator.h>
 #include <nodes/bitmapset.h>
 #include <nodes/extensible.h>
 #include <nodes/makefuncs.h>
 #include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
 #include <optimizer/restrictinfo.h>
 #include <optimizer/tlist.h>
 #include <parser/parsetree.h>
 #include <utils/builtins.h>
+#include <utils/lsyscache.h>
 #include <utils/typcache.h>
 
 #include "compat.h"
 #if PG12_LT
-#include <optimizer/clauses.h>
-#include <optimizer/pathnode.h>
 #include <optimizer/placeholder.h>
 #include <optimizer/planmain.h>
 #include <optimizer/prep.h>
 #include <optimizer/subselect.h>
 #include <optimizer/var.h>
 #else
+#include <optimizer/appendinfo.h>
 #include <optimizer/optimizer.h>
 #endif
 
@@ -40,6 +44,8 @@
 #include "import/planner.h"
 #include "guc.h"
 #include "custom_type_cache.h"
+#include "plan_partialize.h"
+#include "utils.h"
 
 static CustomScanMethods decompress_chunk_plan_methods = {
 	.CustomName = "DecompressChunk",
@@ -280,6 +286,206 @@ clause_has_compressed_attrs(Node *node, void *context)
 	return expression_tree_walker(node, clause_has_compressed_attrs, context);
 }
 
+/*
+ * Check whether aggref is an aggregate DecompressChunk can compute by itself,
+ * which is count(*) or count, sum, min or max of a plain column of relation
+ * relid, and return the kind of aggregate and the column.
+ */
+static bool
+classify_aggref(Aggref *aggref, Index relid, DecompressChunkAggKind *kind, Var **var)
+{
+	TargetEntry *arg;
+	char *name;
+
+	if (aggref->aggorder != NIL || aggref->aggdistinct != NIL || aggref->aggfilter != NULL ||
+		aggref->aggkind != AGGKIND_NORMAL || aggref->agglevelsup != 0 ||
+		get_func_namespace(aggref->aggfnoid) != PG_CATALOG_NAMESPACE)
+		return false;
+
+	name = get_func_name(aggref->aggfnoid);
+	*var = NULL;
+
+	if (aggref->aggstar)
+	{
+		*kind = DECOMPRESS_CHUNK_AGG_COUNT_STAR;
+		return strcmp(name, "count") == 0;
+	}
+
+	if (list_length(aggref->args) != 1)
+		return false;
+
+	arg = linitial_node(TargetEntry, aggref->args);
+	if (!IsA(arg->expr, Var))
+		return false;
+
+	*var = castNode(Var, arg->expr);
+	if ((*var)->varno != relid || (*var)->varattno <= 0 || (*var)->varlevelsup != 0)
+		return false;
+
+	if (strcmp(name, "count") == 0)
+	{
+		*kind = DECOMPRESS_CHUNK_AGG_COUNT;
+		return true;
+	}
+
+	if (strcmp(name, "sum") == 0)
+	{
+		/* sum(int8) has a numeric transition state, so we only do the plain ones */
+		*kind = DECOMPRESS_CHUNK_AGG_SUM;
+		switch ((*var)->vartype)
+		{
+			case INT2OID:
+			case INT4OID:
+			case FLOAT4OID:
+			case FLOAT8OID:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	if (strcmp(name, "min") == 0)
+		*kind = DECOMPRESS_CHUNK_AGG_MIN;
+	else if (strcmp(name, "max") == 0)
+		*kind = DECOMPRESS_CHUNK_AGG_MAX;
+	else
+		return false;
+
+	switch ((*var)->vartype)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Add the segment meta min or max column of var to the compressed scan
+ * target list and return its index, or -1 if the column has no segment
+ * metadata because it is not an orderby column.
+ */
+static int
+add_segment_meta_column(DecompressChunkPath *path, List **scan_tlist, Var *var, bool max)
+{
+	CompressionInfo *info = path->info;
+	char *attname = get_attname(info->chunk_rte->relid, var->varattno, false);
+	FormData_hypertable_compression *ht_info =
+		get_column_compressioninfo(info->hypertable_compression_info, attname);
+	char *meta_name;
+	AttrNumber meta_attno;
+	Oid typid, collid;
+	int32 typmod;
+	Var *meta_var;
+
+	if (ht_info->orderby_column_index <= 0)
+		return -1;
+
+	meta_name = max ? compression_column_segment_max_name(ht_info) :
+					  compression_column_segment_min_name(ht_info);
+	meta_attno = get_attnum(info->compressed_rte->relid, meta_name);
+	if (meta_attno == InvalidAttrNumber)
+		elog(ERROR, "lookup failed for column \"%s\"", meta_name);
+
+	get_atttypetypmodcoll(info->compressed_rte->relid, meta_attno, &typid, &typmod, &collid);
+	meta_var = makeVar(info->compressed_rel->relid, meta_attno, typid, typmod, collid, 0);
+	path->varattno_map = lappend_int(path->varattno_map, DECOMPRESS_CHUNK_SEGMENT_META_ID);
+	*scan_tlist =
+		lappend(*scan_tlist,
+				makeTargetEntry((Expr *) meta_var, list_length(*scan_tlist) + 1, NULL, false));
+
+	return list_length(*scan_tlist) - 1;
+}
+
+/*
+ * Build the description of the partial aggregates in tlist for the executor,
+ * a list of (kind, column index, argument type) triples where the column
+ * index refers to the compressed scan target list. When every row of a batch
+ * is aggregated, min and max of orderby columns are taken from the segment
+ * metadata instead of decompressing the column.
+ */
+static List *
+build_aggregate_list(DecompressChunkPath *path, List *tlist, List **scan_tlist,
+					 bool use_segment_meta)
+{
+	List *aggregates = NIL;
+	ListCell *lc;
+
+	foreach (lc, tlist)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+		DecompressChunkAggKind kind;
+		Var *var;
+		int column_index = -1;
+		Oid typid = InvalidOid;
+
+		if (!IsA(tle->expr, Aggref) ||
+			!classify_aggref(castNode(Aggref, tle->expr),
+							 path->info->chunk_rel->relid,
+							 &kind,
+							 &var))
+			elog(ERROR, "unsupported aggregate for DecompressChunk");
+
+		if (var != NULL)
+		{
+			typid = var->vartype;
+
+			if (use_segment_meta &&
+				(kind == DECOMPRESS_CHUNK_AGG_MIN || kind == DECOMPRESS_CHUNK_AGG_MAX))
+				column_index = add_segment_meta_column(path,
+													   scan_tlist,
+													   var,
+													   kind == DECOMPRESS_CHUNK_AGG_MAX);
+
+			if (column_index < 0)
+			{
+				ListCell *lc_attno;
+				int i = 0;
+
+				foreach (lc_attno, path->varattno_map)
+				{
+					if (lfirst_int(lc_attno) == var->varattno)
+					{
+						column_index = i;
+						break;
+					}
+					i++;
+				}
+
+				if (column_index < 0)
+					elog(ERROR, "aggregated column not found in compressed scan");
+			}
+		}
+
+		aggregates = lappend(aggregates, list_make3_int(kind, column_index, typid));
+	}
+
+	return aggregates;
+}
+
+/*
+ * Check whether the executor can evaluate qual on the bulk decompressed
+ * values, which it requires for every qual when DecompressChunk computes
+ * aggregates. This has to be a vector qual on a compressed column. Quals on
+ * segmentby columns that are left on the chunk don't qualify, since those
+ * columns are not decompressed.
+ */
+static bool
+is_aggregation_qual(CompressionInfo *info, Expr *qual)
+{
+	AttrNumber attno;
+
+	return decompress_chunk_is_vector_qual(qual, info->chunk_rel->relid, &attno) &&
+		   !bms_is_member(attno, info->chunk_segmentby_attnos);
+}
+
 Plan *
 decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path, List *tlist,
 							 List *clauses, List *custom_plans)
@@ -289,6 +495,8 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 	Scan *compressed_scan = linitial(custom_plans);
 	Path *compressed_path = linitial(path->custom_paths);
 	List *settings;
+	List *aggregates = NIL;
+	List *vector_quals = NIL;
 
 	Assert(list_length(custom_plans) == 1);
 	Assert(list_length(path->custom_paths) == 1);
@@ -357,6 +565,33 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 		(List *) replace_compressed_vars((Node *) cscan->scan.plan.qual, dcpath->info);
 
 	compressed_scan->plan.targetlist = build_scan_tlist(dcpath);
+
+	if (dcpath->partial_aggregation)
+	{
+		ListCell *lc;
+
+		/*
+		 * The partial aggregates form the scan tuple of the node. The quals
+		 * are all vector quals that are evaluated on the batches, so we hand
+		 * them to the executor separately instead of as the node qual.
+		 */
+		aggregates = build_aggregate_list(dcpath,
+										  tlist,
+										  &compressed_scan->plan.targetlist,
+										  cscan->scan.plan.qual == NIL);
+
+		foreach (lc, cscan->scan.plan.qual)
+		{
+			/* checked when creating the path, the executor can't do anything else */
+			if (!is_aggregation_qual(dcpath->info, lfirst(lc)))
+				elog(ERROR, "unsupported qual for aggregation in DecompressChunk");
+		}
+
+		vector_quals = cscan->scan.plan.qual;
+		cscan->scan.plan.qual = NIL;
+		cscan->custom_scan_tlist = tlist;
+	}
+
 	if (!pathkeys_contained_in(dcpath->compressed_pathkeys, compressed_path->pathkeys))
 	{
 		List *compressed_pks = dcpath->compressed_pathkeys;
@@ -375,7 +610,178 @@ decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *pat
 	settings = list_make3_int(dcpath->info->hypertable_id,
 							  dcpath->info->chunk_rte->relid,
 							  dcpath->reverse);
-	cscan->custom_private = list_make2(settings, dcpath->varattno_map);
+	if (dcpath->partial_aggregation)
+		cscan->custom_private =
+			list_make4(settings, dcpath->varattno_map, aggregates, vector_quals);
+	else
+		cscan->custom_private = list_make2(settings, dcpath->varattno_map);
 
 	return &cscan->scan.plan;
 }
+
+/*
+ * Create a DecompressChunk path that computes the partial aggregates of target
+ * directly from the compressed batches of the chunk, or return NULL if the
+ * path can't do that. Every qual that is left on the chunk has to be a vector
+ * qual, so the rows can be filtered without forming tuples.
+ */
+static Path *
+decompress_chunk_agg_path_create(DecompressChunkPath *path, PathTarget *target)
+{
+	CompressionInfo *info = path->info;
+	Path *compressed_path = linitial(path->cpath.custom_paths);
+	DecompressChunkPath *agg_path;
+	ListCell *lc;
+
+	if (path->cpath.path.param_info != NULL || path->cpath.path.parallel_workers > 0)
+		return NULL;
+
+	/* these become the quals of the plan, see decompress_chunk_plan_create */
+	foreach (lc, info->chunk_rel->baserestrictinfo)
+	{
+		if (!is_aggregation_qual(info, lfirst_node(RestrictInfo, lc)->clause))
+			return NULL;
+	}
+
+	foreach (lc, target->exprs)
+	{
+		DecompressChunkAggKind kind;
+		Var *var;
+
+		if (!IsA(lfirst(lc), Aggref) ||
+			!classify_aggref(lfirst(lc), info->chunk_rel->relid, &kind, &var))
+			return NULL;
+	}
+
+	agg_path = copy_decompress_chunk_path(path);
+	agg_path->partial_aggregation = true;
+	agg_path->reverse = false;
+	agg_path->needs_sequence_num = false;
+	agg_path->compressed_pathkeys = NIL;
+	agg_path->cpath.path.pathkeys = NIL;
+	agg_path->cpath.path.pathtarget = target;
+
+	/* every batch is still read but no tuple is formed, and we return a single row */
+	agg_path->cpath.path.rows = 1;
+	agg_path->cpath.path.total_cost =
+		compressed_path->total_cost + compressed_path->rows * cpu_tuple_cost;
+	agg_path->cpath.path.startup_cost = agg_path->cpath.path.total_cost;
+
+	return &agg_path->cpath.path;
+}
+
+/*
+ * Add a path for an aggregate query without GROUP BY on a hypertable that
+ * computes partial aggregates for each chunk and combines them on top of the
+ * Append, like partitionwise aggregation does. Compressed chunks compute
+ * their partials in the DecompressChunk node directly from the batches: the
+ * count column for count(*), the segment metadata for min and max of orderby
+ * columns and bulk decompressed values otherwise. Other chunks get a regular
+ * partial Agg node.
+ */
+void
+decompress_chunk_add_agg_pushdown_paths(PlannerInfo *root, RelOptInfo *input_rel,
+										RelOptInfo *output_rel)
+{
+	Query *parse = root->parse;
+	PathTarget *target = root->upper_targets[UPPERREL_GROUP_AGG];
+	PathTarget *partial_target;
+	AggClauseCosts agg_partial_costs;
+	AggClauseCosts agg_final_costs;
+	AppendPath *append = NULL;
+	Path *append_path;
+	List *subpaths = NIL;
+	bool pushed_down = false;
+	ListCell *lc;
+
+	if (!parse->hasAggs || parse->groupClause != NIL || parse->groupingSets != NIL ||
+		input_rel->relid == 0)
+		return;
+
+	/* partialize_agg turns all aggregate paths into partial ones later on */
+	if (has_partialize_function(parse, TS_DO_NOT_FIX_AGGREF))
+		return;
+
+	foreach (lc, input_rel->pathlist)
+	{
+		Path *path = lfirst(lc);
+
+		if (IsA(path, ProjectionPath))
+			path = castNode(ProjectionPath, path)->subpath;
+
+		if (IsA(path, AppendPath) && path->param_info == NULL)
+		{
+			append = castNode(AppendPath, path);
+			break;
+		}
+	}
+
+	if (append == NULL || append->subpaths == NIL)
+		return;
+
+	partial_target = ts_make_partial_grouping_target(root, target);
+
+	MemSet(&agg_partial_costs, 0, sizeof(AggClauseCosts));
+	MemSet(&agg_final_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs(root,
+						 (Node *) partial_target->exprs,
+						 AGGSPLIT_INITIAL_SERIAL,
+						 &agg_partial_costs);
+	get_agg_clause_costs(root, (Node *) target->exprs, AGGSPLIT_FINAL_DESERIAL, &agg_final_costs);
+	get_agg_clause_costs(root, parse->havingQual, AGGSPLIT_FINAL_DESERIAL, &agg_final_costs);
+
+	foreach (lc, append->subpaths)
+	{
+		Path *subpath = lfirst(lc);
+		AppendRelInfo *appinfo = ts_get_appendrelinfo(root, subpath->parent->relid, true);
+		PathTarget *child_target;
+		Path *child_path = NULL;
+
+		if (appinfo == NULL || appinfo->parent_relid != input_rel->relid)
+			return;
+
+		child_target = copy_pathtarget(partial_target);
+		child_target->exprs =
+			(List *) adjust_appendrel_attrs(root, (Node *) child_target->exprs, 1, &appinfo);
+
+		if (ts_is_decompress_chunk_path(subpath))
+			child_path =
+				decompress_chunk_agg_path_create((DecompressChunkPath *) subpath, child_target);
+
+		if (child_path != NULL)
+			pushed_down = true;
+		else
+			child_path = (Path *) create_agg_path(root,
+												  output_rel,
+												  subpath,
+												  child_target,
+												  AGG_PLAIN,
+												  AGGSPLIT_INITIAL_SERIAL,
+												  NIL,
+												  NIL,
+												  &agg_partial_costs,
+												  1);
+
+		subpaths = lappend(subpaths, child_path);
+	}
+
+	/* without any compressed chunk this is just a more expensive plain aggregate */
+	if (!pushed_down)
+		return;
+
+	append_path = (Path *)
+		create_append_path_compat(root, output_rel, subpaths, NIL, NIL, NULL, 0, false, NIL, -1);
+	append_path->pathtarget = partial_target;
+
+	add_path(output_rel,
+			 (Path *) create_agg_path(root,
+									  output_rel,
+									  append_path,
+									  target,
+									  AGG_PLAIN,
+									  AGGSPLIT_FINAL_DESERIAL,
+									  NIL,
+									  (List *) parse->havingQual,
+									  &agg_final_costs,
+									  1));
+}
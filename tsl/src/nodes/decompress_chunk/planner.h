@@ -11,6 +11,8 @@
 
 extern Plan *decompress_chunk_plan_create(PlannerInfo *root, RelOptInfo *rel, CustomPath *path,
 										  List *tlist, List *clauses, List *custom_plans);
+extern void decompress_chunk_add_agg_pushdown_paths(PlannerInfo *root, RelOptInfo *input_rel,
+													RelOptInfo *output_rel);
 
 extern void _decompress_chunk_init(void);
 
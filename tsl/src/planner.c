@@ -22,6 +22,7 @@
 #include "hypertable.h"
 #include "nodes/compress_dml/compress_dml.h"
 #include "nodes/decompress_chunk/decompress_chunk.h"
+#include "nodes/decompress_chunk/planner.h"
 #include "nodes/gapfill/planner.h"
 #include "planner.h"
 
@@ -65,6 +66,11 @@ tsl_create_upper_paths_hook(PlannerInfo *root, UpperRelationKind stage, RelOptIn
 	switch (stage)
 	{
 		case UPPERREL_GROUP_AGG:
+			if (input_reltype == TS_REL_HYPERTABLE && !dist_ht &&
+				ts_guc_enable_transparent_decompression && ts_guc_enable_bulk_decompression &&
+				ts_guc_enable_compressed_aggregate_pushdown &&
+				TS_HYPERTABLE_HAS_COMPRESSION_TABLE(ht))
+				decompress_chunk_add_agg_pushdown_paths(root, input_rel, output_rel);
 			if (input_reltype != TS_REL_HYPERTABLE_CHILD)
 				plan_add_gapfill(root, output_rel);
 			break;
@@ -687,15 +687,15 @@ wait_to_consume_data(AsyncRequestSet *set, TimestampTz end_time)
 
 	Assert(list_length(set->requests) > 0);
 
+	/* If the end time has passed, we still check once, without waiting, if
+	 * there is data to consume. This allows polling for responses by passing
+	 * the current time as end time. */
 	if (end_time != TS_NO_TIMEOUT)
 	{
 		TimestampTz now = GetCurrentTimestamp();
 		long secs;
 		int microsecs;
 
-		if (now >= end_time)
-			return async_response_timeout_create();
-
 		TimestampDifference(now, end_time, &secs, &microsecs);
 		timeout_ms = secs * 1000 + (microsecs / 1000);
 	}
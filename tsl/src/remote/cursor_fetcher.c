@@ -291,7 +291,6 @@ cursor_fetcher_fetch_data_complete(CursorFetcher *cursor)
 	PG_TRY();
 	{
 		PGresult *res;
-		int i;
 
 		oldcontext = MemoryContextSwitchTo(cursor->state.req_mctx);
 
@@ -317,8 +316,7 @@ cursor_fetcher_fetch_data_complete(CursorFetcher *cursor)
 		 * it explicitly, otherwise same as batch_mctx */
 		MemoryContextSwitchTo(cursor->state.tuple_mctx);
 
-		for (i = 0; i < numrows; i++)
-			cursor->state.tuples[i] = tuplefactory_make_tuple(cursor->state.tf, res, i, format);
+		tuplefactory_make_tuples(cursor->state.tf, res, format, cursor->state.tuples);
 
 		tuplefactory_reset_mctx(cursor->state.tf);
 		MemoryContextSwitchTo(cursor->state.batch_mctx);
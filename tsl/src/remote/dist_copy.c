@@ -10,9 +10,12 @@
 #include <libpq-fe.h>
 #include <miscadmin.h>
 #include <parser/parse_type.h>
+#include <pgstat.h>
 #include <port/pg_bswap.h>
+#include <storage/latch.h>
 #include <utils/builtins.h>
 #include <utils/lsyscache.h>
+#include <utils/rel.h>
 
 #include "compat.h"
 #include "dist_copy.h"
@@ -25,6 +28,7 @@
 #include "chunk_data_node.h"
 #include "guc.h"
 #include "remote/connection_cache.h"
+#include "remote/data_format.h"
 #include "remote/dist_txn.h"
 #include "data_node.h"
 
@@ -33,8 +37,29 @@
 #define POSTGRES_BINARY_COPY_SIGNATURE "PGCOPY\n\377\r\n\0"
 #define POSTGRES_SIGNATURE_LENGTH 11
 
-/* This will maintain a list of connections associated with a given chunk so we don't have to keep
- * looking them up every time.
+/*
+ * COPY data is buffered per connection and handed to libpq in chunks of at
+ * least COPY_BUFFER_FLUSH_SIZE bytes instead of row by row. Connections are
+ * in non-blocking mode during the COPY, so a data node that does not keep up
+ * does not stall the others until its buffer reaches COPY_BUFFER_MAX_SIZE.
+ */
+#define COPY_BUFFER_FLUSH_SIZE (64 * 1024)
+#define COPY_BUFFER_MAX_SIZE (16 * COPY_BUFFER_FLUSH_SIZE)
+
+/* This contains the COPY data that is not yet handed to libpq for a connection as well as whether
+ * libpq still has data to send from a previous chunk, and the state of the end-of-copy message.
+ */
+typedef struct CopyConnection
+{
+	TSConnection *conn;
+	StringInfoData buffer;
+	bool send_pending;
+	bool end_requested; /* Send the end-of-copy message once the buffer is sent */
+	bool end_sent;
+} CopyConnection;
+
+/* This will maintain a list of connections (CopyConnection) associated with a given chunk so we
+ * don't have to keep looking them up every time.
  */
 typedef struct ChunkConnectionList
 {
@@ -61,7 +86,7 @@ typedef struct CopyDimensionInfo
 typedef struct CopyConnectionState
 {
 	List *cached_connections;
-	List *connections_in_use;
+	List *connections_in_use; /* CopyConnection */
 	bool using_binary;
 	const char *outgoing_copy_cmd;
 } CopyConnectionState;
@@ -228,66 +253,90 @@ calculate_hyperspace_point_from_fields(char **data, CopyDimensionInfo *dimension
 	return p;
 }
 
-static void
-send_binary_copy_header(PGconn *connection)
+/*
+ * Append the header of binary COPY data to a buffer.
+ */
+void
+remote_copy_append_binary_header(StringInfo buf)
 {
-	StringInfo header = makeStringInfo();
-	uint32 buf = 0;
-	int result;
+	uint32 zero = 0;
 
-	appendBinaryStringInfo(header,
+	appendBinaryStringInfo(buf,
 						   POSTGRES_BINARY_COPY_SIGNATURE,
-						   POSTGRES_SIGNATURE_LENGTH);			/* signature */
-	appendBinaryStringInfo(header, (char *) &buf, sizeof(buf)); /* flags */
-	appendBinaryStringInfo(header, (char *) &buf, sizeof(buf)); /* header extension length */
+						   POSTGRES_SIGNATURE_LENGTH);			  /* signature */
+	appendBinaryStringInfo(buf, (char *) &zero, sizeof(zero)); /* flags */
+	appendBinaryStringInfo(buf, (char *) &zero, sizeof(zero)); /* header extension length */
+}
 
-	result = PQputCopyData(connection, header->data, 19);
-	if (result != 1)
-		ereport(ERROR,
-				(errcode(ERRCODE_CONNECTION_FAILURE),
-				 errmsg("failed to send data to data data node %s", PQhost(connection))));
+/*
+ * Append the end-of-data marker of binary COPY data to a buffer.
+ */
+void
+remote_copy_append_binary_trailer(StringInfo buf)
+{
+	const uint16 trailer = pg_hton16((uint16) -1);
+
+	appendBinaryStringInfo(buf, (char *) &trailer, sizeof(trailer));
 }
 
-static void
+static CopyConnection *
 start_remote_copy_on_new_connection(CopyConnectionState *state, TSConnection *connection)
 {
 	PGconn *pg_conn = remote_connection_get_pg_conn(connection);
+	PGresult *volatile res = NULL;
+	CopyConnection *copyconn;
+	ListCell *lc;
+
+	foreach (lc, state->connections_in_use)
+	{
+		copyconn = lfirst(lc);
+
+		if (copyconn->conn == connection)
+			return copyconn;
+	}
 
 	if (PQisnonblocking(pg_conn))
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("distributed copy doesn't support non-blocking connections")));
 
-	if (!list_member_ptr(state->connections_in_use, connection))
+	PG_TRY();
 	{
-		PGresult *volatile res = NULL;
+		res = PQexec(pg_conn, state->outgoing_copy_cmd);
 
-		PG_TRY();
-		{
-			res = PQexec(pg_conn, state->outgoing_copy_cmd);
-
-			if (PQresultStatus(res) != PGRES_COPY_IN)
-				ereport(ERROR,
-						(errcode(ERRCODE_CONNECTION_FAILURE),
-						 errmsg("unable to start remote COPY on data node"),
-						 errdetail("Remote command error: %s", PQresultErrorMessage(res))));
+		if (PQresultStatus(res) != PGRES_COPY_IN)
+			ereport(ERROR,
+					(errcode(ERRCODE_CONNECTION_FAILURE),
+					 errmsg("unable to start remote COPY on data node"),
+					 errdetail("Remote command error: %s", PQresultErrorMessage(res))));
 
+		PQclear(res);
+	}
+	PG_CATCH();
+	{
+		if (NULL != res)
 			PQclear(res);
-		}
-		PG_CATCH();
-		{
-			if (NULL != res)
-				PQclear(res);
 
-			PG_RE_THROW();
-		}
-		PG_END_TRY();
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
 
-		if (state->using_binary)
-			send_binary_copy_header(pg_conn);
+	/* Data is only sent when the connection is ready for it, see
+	 * copy_connection_flush() */
+	if (PQsetnonblocking(pg_conn, 1) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_CONNECTION_EXCEPTION), errmsg("%s", PQerrorMessage(pg_conn))));
 
-		state->connections_in_use = lappend(state->connections_in_use, connection);
-	}
+	copyconn = palloc0(sizeof(CopyConnection));
+	copyconn->conn = connection;
+	initStringInfo(&copyconn->buffer);
+
+	if (state->using_binary)
+		remote_copy_append_binary_header(&copyconn->buffer);
+
+	state->connections_in_use = lappend(state->connections_in_use, copyconn);
+
+	return copyconn;
 }
 
 static ChunkConnectionList *
@@ -305,20 +354,169 @@ create_connection_list_for_chunk(CopyConnectionState *state, const Chunk *chunk)
 		ChunkDataNode *cdn = lfirst(lc);
 		TSConnection *connection =
 			data_node_get_connection(NameStr(cdn->fd.node_name), REMOTE_TXN_NO_PREP_STMT, true);
+		CopyConnection *copyconn = start_remote_copy_on_new_connection(state, connection);
 
-		start_remote_copy_on_new_connection(state, connection);
-		chunk_connections->connections = lappend(chunk_connections->connections, connection);
+		chunk_connections->connections = lappend(chunk_connections->connections, copyconn);
 	}
 	state->cached_connections = lappend(state->cached_connections, chunk_connections);
 
 	return chunk_connections;
 }
 
-static int
-send_end_binary_copy_data(PGconn *connection)
+/*
+ * Send the data queued in libpq without blocking. Returns true if some of it
+ * is still pending.
+ */
+static bool
+copy_connection_send(CopyConnection *copyconn)
+{
+	PGconn *pg_conn = remote_connection_get_pg_conn(copyconn->conn);
+	int result = PQflush(pg_conn);
+
+	if (result == -1)
+		ereport(ERROR,
+				(errcode(ERRCODE_CONNECTION_EXCEPTION), errmsg("%s", PQerrorMessage(pg_conn))));
+
+	copyconn->send_pending = (result == 1);
+
+	return copyconn->send_pending;
+}
+
+/*
+ * Send as much of the buffered COPY data of a connection, and the
+ * end-of-copy message if requested, as possible without blocking.
+ *
+ * The buffer is only handed to libpq once libpq has sent all data of the
+ * previous chunk. Otherwise, libpq would keep growing its own output buffer
+ * for a data node that does not keep up.
+ */
+static void
+copy_connection_flush(CopyConnection *copyconn)
 {
-	const uint16 buf = pg_hton16((uint16) -1);
-	return PQputCopyData(connection, (char *) &buf, sizeof(buf));
+	PGconn *pg_conn = remote_connection_get_pg_conn(copyconn->conn);
+	int result;
+
+	if (copyconn->send_pending && copy_connection_send(copyconn))
+		return;
+
+	if (copyconn->buffer.len > 0)
+	{
+		result = PQputCopyData(pg_conn, copyconn->buffer.data, copyconn->buffer.len);
+
+		if (result == -1)
+			ereport(ERROR,
+					(errcode(ERRCODE_CONNECTION_EXCEPTION),
+					 errmsg("%s", PQerrorMessage(pg_conn))));
+
+		/* The data could not be queued, so keep it in the buffer */
+		if (result == 0)
+		{
+			copyconn->send_pending = true;
+			return;
+		}
+
+		resetStringInfo(&copyconn->buffer);
+
+		if (copy_connection_send(copyconn))
+			return;
+	}
+
+	if (copyconn->end_requested && !copyconn->end_sent)
+	{
+		result = PQputCopyEnd(pg_conn, NULL);
+
+		if (result == -1)
+			ereport(ERROR,
+					(errcode(ERRCODE_CONNECTION_EXCEPTION),
+					 errmsg("%s", PQerrorMessage(pg_conn))));
+
+		/* The message could not be queued either, so try again later */
+		if (result == 0)
+		{
+			copyconn->send_pending = true;
+			return;
+		}
+
+		copyconn->end_sent = true;
+		copy_connection_send(copyconn);
+	}
+}
+
+static bool
+copy_connection_is_flushed(const CopyConnection *copyconn)
+{
+	return !copyconn->send_pending && copyconn->buffer.len == 0 &&
+		   copyconn->end_requested == copyconn->end_sent;
+}
+
+/*
+ * Wait until the given connection, or all connections in use if NULL, has
+ * sent all its buffered data.
+ *
+ * While waiting, data is sent on any connection that is ready for it, so
+ * that all data nodes keep receiving data while one of them is slow.
+ */
+static void
+wait_for_copy_connections(CopyConnectionState *state, CopyConnection *wait_for)
+{
+	while (true)
+	{
+		WaitEventSet *we_set;
+		WaitEvent event;
+		ListCell *lc;
+		int num_pending = 0;
+
+		foreach (lc, state->connections_in_use)
+		{
+			CopyConnection *copyconn = lfirst(lc);
+
+			copy_connection_flush(copyconn);
+
+			if (!copy_connection_is_flushed(copyconn))
+				num_pending++;
+		}
+
+		if (wait_for == NULL ? num_pending == 0 : copy_connection_is_flushed(wait_for))
+			break;
+
+		we_set = CreateWaitEventSet(CurrentMemoryContext, num_pending + 1);
+		AddWaitEventToSet(we_set, WL_LATCH_SET, PGINVALID_SOCKET, (Latch *) MyLatch, NULL);
+
+		foreach (lc, state->connections_in_use)
+		{
+			CopyConnection *copyconn = lfirst(lc);
+
+			if (!copy_connection_is_flushed(copyconn))
+				AddWaitEventToSet(we_set,
+								  WL_SOCKET_WRITEABLE,
+								  PQsocket(remote_connection_get_pg_conn(copyconn->conn)),
+								  NULL,
+								  copyconn);
+		}
+
+		WaitEventSetWait(we_set, -1L, &event, 1, PG_WAIT_EXTENSION);
+		FreeWaitEventSet(we_set);
+
+		if (event.events & WL_LATCH_SET)
+			ResetLatch(MyLatch);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Send a batch of COPY data followed by the end-of-copy message on a
+ * connection where a COPY FROM STDIN has started. The result of the COPY
+ * needs to be read from the connection afterwards.
+ */
+void
+remote_copy_send_data_and_end(TSConnection *conn, const StringInfo data)
+{
+	PGconn *pg_conn = remote_connection_get_pg_conn(conn);
+
+	if (PQputCopyData(pg_conn, data->data, data->len) != 1 || PQputCopyEnd(pg_conn, NULL) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_CONNECTION_EXCEPTION), errmsg("%s", PQerrorMessage(pg_conn))));
 }
 
 static char *
@@ -373,18 +571,27 @@ finish_outstanding_copies(CopyConnectionState *state)
 
 	PG_TRY();
 	{
+		/* Send the remaining data and the end-of-copy messages to all data
+		 * nodes in parallel */
 		foreach (lc, state->connections_in_use)
 		{
-			TSConnection *conn = lfirst(lc);
-			PGconn *pg_conn = remote_connection_get_pg_conn(conn);
+			CopyConnection *copyconn = lfirst(lc);
 
 			if (state->using_binary)
-				if (send_end_binary_copy_data(pg_conn) != 1)
-					ereport(ERROR,
-							(errcode(ERRCODE_CONNECTION_EXCEPTION),
-							 errmsg("%s", PQerrorMessage(pg_conn))));
+				remote_copy_append_binary_trailer(&copyconn->buffer);
 
-			if (PQputCopyEnd(pg_conn, NULL) == -1)
+			copyconn->end_requested = true;
+		}
+
+		wait_for_copy_connections(state, NULL);
+
+		foreach (lc, state->connections_in_use)
+		{
+			CopyConnection *copyconn = lfirst(lc);
+			PGconn *pg_conn = remote_connection_get_pg_conn(copyconn->conn);
+
+			/* All data is sent, so this does not need to flush */
+			if (PQsetnonblocking(pg_conn, 0) != 0)
 				ereport(ERROR,
 						(errcode(ERRCODE_CONNECTION_EXCEPTION),
 						 errmsg("%s", PQerrorMessage(pg_conn))));
@@ -416,6 +623,44 @@ finish_outstanding_copies(CopyConnectionState *state)
 	clear_results(results, true);
 }
 
+/*
+ * End the COPY on all connections after an error.
+ *
+ * Buffered data is dropped and the data nodes are told to abort the COPY,
+ * without waiting for them, so that an error or a cancellation is not held
+ * up by a data node that does not keep up. This must not raise an error,
+ * since it is called while handling one. The results of the COPY are read
+ * when the remote transactions are aborted.
+ *
+ * The connections are put back in blocking mode so that they can be used
+ * again. That requires libpq to have sent all its queued data. If that is
+ * not possible right away, the state of the connection is unknown, so it is
+ * marked as such and closed at the end of the transaction.
+ */
+static void
+abort_outstanding_copies(CopyConnectionState *state, const char *errormsg)
+{
+	ListCell *lc;
+
+	foreach (lc, state->connections_in_use)
+	{
+		CopyConnection *copyconn = lfirst(lc);
+		PGconn *pg_conn = remote_connection_get_pg_conn(copyconn->conn);
+
+		resetStringInfo(&copyconn->buffer);
+
+		if (!PQisnonblocking(pg_conn))
+			continue;
+
+		if (!copyconn->end_sent && PQputCopyEnd(pg_conn, errormsg) == 1)
+			copyconn->end_sent = true;
+
+		if ((!copyconn->end_sent || PQflush(pg_conn) != 0 || PQsetnonblocking(pg_conn, 0) != 0) &&
+			!remote_connection_xact_is_transitioning(copyconn->conn))
+			remote_connection_xact_transition_begin(copyconn->conn);
+	}
+}
+
 static List *
 get_connections_for_chunk(RemoteCopyContext *context, const Chunk *chunk)
 {
@@ -665,24 +910,96 @@ generate_text_copy_context(const CopyStmt *stmt, Hypertable *ht, List *attnums)
 static int
 get_copy_conversion_functions(Hypertable *ht, List *copy_attnums, FmgrInfo **functions)
 {
-	ListCell *lc;
 	Relation rel = relation_open(ht->main_table_relid, AccessShareLock);
 	TupleDesc tupDesc = RelationGetDescr(rel);
+	int natts = tupDesc->natts;
+
+	*functions = remote_copy_get_binary_out_functions(tupDesc, copy_attnums);
+	relation_close(rel, AccessShareLock);
 
-	*functions = palloc0(tupDesc->natts * sizeof(FmgrInfo));
-	foreach (lc, copy_attnums)
+	return natts;
+}
+
+/*
+ * Get the binary output functions for the given attributes. The returned
+ * array is indexed by attribute offset and sized to the number of attributes
+ * in the tuple descriptor, but only the functions for the given attributes are
+ * set.
+ */
+FmgrInfo *
+remote_copy_get_binary_out_functions(TupleDesc tupdesc, List *attnums)
+{
+	FmgrInfo *functions = palloc0(tupdesc->natts * sizeof(FmgrInfo));
+	ListCell *lc;
+
+	foreach (lc, attnums)
 	{
 		int offset = AttrNumberGetAttrOffset(lfirst_int(lc));
 		Oid out_func_oid;
 		bool isvarlena;
-		Form_pg_attribute attr = TupleDescAttr(tupDesc, offset);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, offset);
 
 		getTypeBinaryOutputInfo(attr->atttypid, &out_func_oid, &isvarlena);
-		fmgr_info(out_func_oid, &((*functions)[offset]));
+		fmgr_info(out_func_oid, &functions[offset]);
 	}
-	relation_close(rel, AccessShareLock);
 
-	return tupDesc->natts;
+	return functions;
+}
+
+/*
+ * Check if all the given attributes have binary output functions so that
+ * they can be sent with binary COPY.
+ */
+bool
+remote_copy_supports_binary(TupleDesc tupdesc, List *attnums)
+{
+	ListCell *lc;
+
+	foreach (lc, attnums)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(lfirst_int(lc)));
+		bool is_binary;
+
+		data_format_get_type_output_func(attr->atttypid, &is_binary, false);
+
+		if (!is_binary)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Generate a binary COPY command for the given attributes of a relation.
+ */
+const char *
+remote_copy_deparse_binary_cmd(Relation rel, List *attnums)
+{
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	StringInfo command = makeStringInfo();
+	ListCell *lc;
+	bool first = true;
+
+	appendStringInfo(command,
+					 "COPY %s (",
+					 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+												RelationGetRelationName(rel)));
+
+	foreach (lc, attnums)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, AttrNumberGetAttrOffset(lfirst_int(lc)));
+
+		if (!first)
+			appendStringInfo(command, ", ");
+		else
+			first = false;
+
+		appendStringInfo(command, "%s", quote_identifier(NameStr(attr->attname)));
+	}
+
+	appendStringInfo(command, ") FROM STDIN WITH (format binary)");
+
+	return command->data;
 }
 
 static BinaryCopyContext *
@@ -760,11 +1077,25 @@ static StringInfo
 generate_binary_copy_data(Datum *values, bool *nulls, List *attnums, FmgrInfo *out_functions)
 {
 	StringInfo row_data = makeStringInfo();
+
+	remote_copy_append_binary_row(row_data, values, nulls, attnums, out_functions);
+
+	return row_data;
+}
+
+/*
+ * Append a row in binary COPY format to a buffer. The values and nulls arrays
+ * are indexed by attribute offset, as are the output functions.
+ */
+void
+remote_copy_append_binary_row(StringInfo row_data, Datum *values, bool *nulls, List *attnums,
+							  FmgrInfo *out_functions)
+{
 	uint16 buf16;
 	uint32 buf32;
 	ListCell *lc;
 
-	buf16 = pg_hton16((uint16) attnums->length);
+	buf16 = pg_hton16((uint16) list_length(attnums));
 	appendBinaryStringInfo(row_data, (char *) &buf16, sizeof(buf16));
 
 	foreach (lc, attnums)
@@ -789,8 +1120,6 @@ generate_binary_copy_data(Datum *values, bool *nulls, List *attnums, FmgrInfo *o
 			appendBinaryStringInfo(row_data, VARDATA(outputbytes), output_length);
 		}
 	}
-
-	return row_data;
 }
 
 static StringInfo
@@ -859,7 +1188,18 @@ get_current_point_for_binary_copy(Hypertable *ht, BinaryCopyContext *ctx)
 static void
 reset_copy_connection_state(CopyConnectionState *state)
 {
+	ListCell *lc;
+
 	finish_outstanding_copies(state);
+
+	foreach (lc, state->connections_in_use)
+	{
+		CopyConnection *copyconn = lfirst(lc);
+
+		pfree(copyconn->buffer.data);
+		pfree(copyconn);
+	}
+
 	list_free(state->cached_connections);
 	list_free(state->connections_in_use);
 	state->cached_connections = NIL;
@@ -885,21 +1225,22 @@ get_target_chunk(Hypertable *ht, Point *p, CopyConnectionState *state)
 }
 
 static void
-send_copy_data(StringInfo row_data, List *connections)
+send_copy_data(CopyConnectionState *state, StringInfo row_data, List *connections)
 {
 	ListCell *lc;
 
 	foreach (lc, connections)
 	{
-		PGconn *pg_conn = remote_connection_get_pg_conn(lfirst(lc));
-		int result = PQputCopyData(pg_conn, row_data->data, row_data->len);
+		CopyConnection *copyconn = lfirst(lc);
 
-		if (result != 1)
-			ereport(ERROR,
-					(errcode(ERRCODE_CONNECTION_EXCEPTION),
-					 errmsg("%s",
-							result == -1 ? PQerrorMessage(pg_conn) :
-										   "unexpected response while sending copy data")));
+		appendBinaryStringInfo(&copyconn->buffer, row_data->data, row_data->len);
+
+		if (copyconn->buffer.len >= COPY_BUFFER_FLUSH_SIZE)
+			copy_connection_flush(copyconn);
+
+		/* Only block once the data node is too far behind */
+		if (copyconn->buffer.len >= COPY_BUFFER_MAX_SIZE)
+			wait_for_copy_connections(state, copyconn);
 	}
 }
 
@@ -918,7 +1259,7 @@ process_and_send_copy_data(RemoteCopyContext *context)
 
 	chunk = get_target_chunk(ht, point, &context->connection_state);
 	connections = get_connections_for_chunk(context, chunk);
-	send_copy_data(context->row_data, connections);
+	send_copy_data(&context->connection_state, context->row_data, connections);
 }
 
 static void
@@ -954,7 +1295,8 @@ remote_distributed_copy(const CopyStmt *stmt, CopyChunkState *ccstate, List *att
 	PG_CATCH();
 	{
 		/* If we hit an error, make sure we end our in-progress COPYs */
-		end_copy_operation(context);
+		abort_outstanding_copies(&context->connection_state, "COPY failed on the access node");
+		MemoryContextDelete(context->mctx);
 
 		PG_RE_THROW();
 	}
@@ -7,11 +7,27 @@
 #define TIMESCALEDB_TSL_REMOTE_DIST_COPY_H
 
 #include <postgres.h>
+#include <access/tupdesc.h>
 #include <commands/copy.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+#include <utils/relcache.h>
+
+#include "connection.h"
 
 typedef struct Hypertable Hypertable;
 typedef struct CopyChunkState CopyChunkState;
 
 extern uint64 remote_distributed_copy(const CopyStmt *stmt, CopyChunkState *ccstate, List *attnums);
 
+/* Building blocks for sending tuples to data nodes with binary COPY */
+extern const char *remote_copy_deparse_binary_cmd(Relation rel, List *attnums);
+extern bool remote_copy_supports_binary(TupleDesc tupdesc, List *attnums);
+extern FmgrInfo *remote_copy_get_binary_out_functions(TupleDesc tupdesc, List *attnums);
+extern void remote_copy_append_binary_header(StringInfo buf);
+extern void remote_copy_append_binary_row(StringInfo buf, Datum *values, bool *nulls,
+										  List *attnums, FmgrInfo *out_functions);
+extern void remote_copy_append_binary_trailer(StringInfo buf);
+extern void remote_copy_send_data_and_end(TSConnection *conn, const StringInfo data);
+
 #endif /* TIMESCALEDB_TSL_REMOTE_DIST_COPY_H */
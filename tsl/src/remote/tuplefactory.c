@@ -20,7 +20,11 @@
 #include <access/sysattr.h>
 #include <access/htup_details.h>
 #include <catalog/pg_type.h>
+#include <datatype/timestamp.h>
+#include <port/pg_bswap.h>
+#include <utils/date.h>
 #include <utils/syscache.h>
+#include <utils/timestamp.h>
 #include <miscadmin.h>
 #include <libpq-fe.h>
 
@@ -52,6 +56,28 @@ typedef struct ConversionLocation
 	ScanState *ss;
 } ConversionLocation;
 
+/*
+ * Decoders for the binary format of common fixed-size types.
+ *
+ * Going through the type's receive function costs a function call, a
+ * StringInfo and a number of checks for every value. For these types, the
+ * binary format is just the value in network byte order, so we decode it
+ * inline.
+ */
+typedef enum BinaryDecoder
+{
+	BINARY_DECODER_RECV = 0, /* use the type's receive function */
+	BINARY_DECODER_BOOL,
+	BINARY_DECODER_INT2,
+	BINARY_DECODER_INT4,
+	BINARY_DECODER_INT8,
+	BINARY_DECODER_OID,
+	BINARY_DECODER_FLOAT4,
+	BINARY_DECODER_FLOAT8,
+	BINARY_DECODER_DATE,
+	BINARY_DECODER_TIMESTAMP,
+} BinaryDecoder;
+
 typedef struct TupleFactory
 {
 	MemoryContext temp_mctx;
@@ -59,6 +85,9 @@ typedef struct TupleFactory
 	Datum *values;
 	bool *nulls;
 	List *retrieved_attrs;
+	int num_retrieved_attrs;
+	AttrNumber *retrieved_attnos; /* retrieved_attrs as an array */
+	BinaryDecoder *decoders;	  /* per attribute in tupdesc */
 	AttConvInMetadata *attconv;
 	ConversionLocation errpos;
 	ErrorContextCallback errcallback;
@@ -146,10 +175,44 @@ conversion_error_callback(void *arg)
 	}
 }
 
+static BinaryDecoder
+get_binary_decoder(Form_pg_attribute attr)
+{
+	switch (attr->atttypid)
+	{
+		case BOOLOID:
+			return BINARY_DECODER_BOOL;
+		case INT2OID:
+			return BINARY_DECODER_INT2;
+		case INT4OID:
+			return BINARY_DECODER_INT4;
+		case INT8OID:
+			return BINARY_DECODER_INT8;
+		case OIDOID:
+			return BINARY_DECODER_OID;
+		case FLOAT4OID:
+			return BINARY_DECODER_FLOAT4;
+		case FLOAT8OID:
+			return BINARY_DECODER_FLOAT8;
+		case DATEOID:
+			return BINARY_DECODER_DATE;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			/* A typmod requires rounding the value to the given precision */
+			if (attr->atttypmod < 0)
+				return BINARY_DECODER_TIMESTAMP;
+			return BINARY_DECODER_RECV;
+		default:
+			return BINARY_DECODER_RECV;
+	}
+}
+
 static TupleFactory *
 tuplefactory_create_common(TupleDesc tupdesc, List *retrieved_attrs, bool force_text)
 {
 	TupleFactory *tf = palloc0(sizeof(TupleFactory));
+	ListCell *lc;
+	int i;
 
 	tf->temp_mctx = AllocSetContextCreate(CurrentMemoryContext,
 										  "tuple factory temporary data",
@@ -164,6 +227,26 @@ tuplefactory_create_common(TupleDesc tupdesc, List *retrieved_attrs, bool force_
 	/* Initialize to nulls for any columns not present in result */
 	memset(tf->nulls, true, tf->tupdesc->natts * sizeof(bool));
 
+	tf->num_retrieved_attrs = list_length(retrieved_attrs);
+	tf->retrieved_attnos = palloc(Max(tf->num_retrieved_attrs, 1) * sizeof(AttrNumber));
+	i = 0;
+
+	foreach (lc, retrieved_attrs)
+		tf->retrieved_attnos[i++] = lfirst_int(lc);
+
+	tf->decoders = palloc0(Max(tf->tupdesc->natts, 1) * sizeof(BinaryDecoder));
+
+	if (tf->attconv->binary)
+	{
+		for (i = 0; i < tf->tupdesc->natts; i++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tf->tupdesc, i);
+
+			if (!attr->attisdropped)
+				tf->decoders[i] = get_binary_decoder(attr);
+		}
+	}
+
 	return tf;
 }
 
@@ -238,56 +321,153 @@ tuplefactory_reset_mctx(TupleFactory *tf)
 	MemoryContextReset(tf->temp_mctx);
 }
 
-HeapTuple
-tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format)
+static void
+check_binary_length(int len, int expected)
 {
-	HeapTuple tuple;
-	ItemPointer ctid = NULL;
-#if PG12_LT
-	Oid oid = InvalidOid;
-#endif
-	MemoryContext oldcontext;
-	ListCell *lc;
-	int j;
-	StringInfo buf;
+	if (len != expected)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("incorrect binary data format")));
+}
 
-	Assert(row < PQntuples(res));
+static uint32
+read_uint32(const char *data)
+{
+	uint32 value;
 
-	/*
-	 * Do the following work in a temp context that we reset after each tuple.
-	 * This cleans up not only the data we have direct access to, but any
-	 * cruft the I/O functions might leak.
-	 */
-	oldcontext = MemoryContextSwitchTo(tf->temp_mctx);
-	buf = makeStringInfo();
+	memcpy(&value, data, sizeof(value));
+	return pg_ntoh32(value);
+}
 
-	/* Install error callback */
-	if (tf->errcallback.callback != NULL)
+static uint64
+read_uint64(const char *data)
+{
+	uint64 value;
+
+	memcpy(&value, data, sizeof(value));
+	return pg_ntoh64(value);
+}
+
+/*
+ * Decode a value in the binary format of a type that has a decoder, see
+ * BinaryDecoder. The decoding matches the type's receive function.
+ */
+static Datum
+decode_binary_value(BinaryDecoder decoder, const char *data, int len)
+{
+	switch (decoder)
 	{
-		tf->errcallback.previous = error_context_stack;
-		error_context_stack = &tf->errcallback;
+		case BINARY_DECODER_BOOL:
+			check_binary_length(len, 1);
+			return BoolGetDatum(data[0] != 0);
+		case BINARY_DECODER_INT2:
+		{
+			uint16 value;
+
+			check_binary_length(len, sizeof(int16));
+			memcpy(&value, data, sizeof(value));
+			return Int16GetDatum((int16) pg_ntoh16(value));
+		}
+		case BINARY_DECODER_INT4:
+			check_binary_length(len, sizeof(int32));
+			return Int32GetDatum((int32) read_uint32(data));
+		case BINARY_DECODER_INT8:
+			check_binary_length(len, sizeof(int64));
+			return Int64GetDatum((int64) read_uint64(data));
+		case BINARY_DECODER_OID:
+			check_binary_length(len, sizeof(Oid));
+			return ObjectIdGetDatum((Oid) read_uint32(data));
+		case BINARY_DECODER_FLOAT4:
+		{
+			union
+			{
+				float4 f;
+				uint32 i;
+			} swap;
+
+			check_binary_length(len, sizeof(float4));
+			swap.i = read_uint32(data);
+			return Float4GetDatum(swap.f);
+		}
+		case BINARY_DECODER_FLOAT8:
+		{
+			union
+			{
+				float8 f;
+				uint64 i;
+			} swap;
+
+			check_binary_length(len, sizeof(float8));
+			swap.i = read_uint64(data);
+			return Float8GetDatum(swap.f);
+		}
+		case BINARY_DECODER_DATE:
+		{
+			DateADT date;
+
+			check_binary_length(len, sizeof(DateADT));
+			date = (DateADT) read_uint32(data);
+
+			if (!DATE_NOT_FINITE(date) && !IS_VALID_DATE(date))
+				ereport(ERROR,
+						(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+						 errmsg("date out of range")));
+
+			return DateADTGetDatum(date);
+		}
+		case BINARY_DECODER_TIMESTAMP:
+		{
+			Timestamp timestamp;
+
+			check_binary_length(len, sizeof(Timestamp));
+			timestamp = (Timestamp) read_uint64(data);
+
+			if (!TIMESTAMP_NOT_FINITE(timestamp) && !IS_VALID_TIMESTAMP(timestamp))
+				ereport(ERROR,
+						(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+						 errmsg("timestamp out of range")));
+
+			return TimestampGetDatum(timestamp);
+		}
+		case BINARY_DECODER_RECV:
+			break;
 	}
 
+	pg_unreachable();
+	return (Datum) 0;
+}
+
+/*
+ * Make a tuple from a row in a result. The error context callback must be
+ * installed and the temporary memory context must be current.
+ */
+static void
+make_tuple_values(TupleFactory *tf, PGresult *res, int row, int format, ItemPointer *ctid,
+				  Oid *oid)
+{
+	StringInfoData buf;
+	int j;
+
 	/*
 	 * i indexes columns in the relation, j indexes columns in the PGresult.
 	 */
-	j = 0;
-	foreach (lc, tf->retrieved_attrs)
+	for (j = 0; j < tf->num_retrieved_attrs; j++)
 	{
-		int i = lfirst_int(lc);
+		int i = tf->retrieved_attnos[j];
 		char *valstr;
+		int len = PQgetlength(res, row, j);
 
-		resetStringInfo(buf);
-
-		buf->len = PQgetlength(res, row, j);
 		/* we assume that value is NULL is length is 0 */
-		if (buf->len == 0)
+		if (len == 0)
 			valstr = NULL;
 		else
-		{
 			valstr = PQgetvalue(res, row, j);
-			buf->data = valstr;
-		}
+
+		/* The receive functions read the value directly from the result */
+		buf.data = valstr;
+		buf.len = len;
+		buf.maxlen = len;
+		buf.cursor = 0;
 
 		/*
 		 * convert value to internal representation
@@ -314,13 +494,15 @@ tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format)
 			else
 			{
 				Assert(tf->attconv->binary);
-				if (valstr != NULL)
+				if (valstr == NULL)
+					tf->values[i - 1] = PointerGetDatum(NULL);
+				else if (tf->decoders[i - 1] != BINARY_DECODER_RECV)
+					tf->values[i - 1] = decode_binary_value(tf->decoders[i - 1], valstr, len);
+				else
 					tf->values[i - 1] = ReceiveFunctionCall(&tf->attconv->conv_funcs[i - 1],
-															buf,
+															&buf,
 															tf->attconv->ioparams[i - 1],
 															tf->attconv->typmods[i - 1]);
-				else
-					tf->values[i - 1] = PointerGetDatum(NULL);
 			}
 		}
 		else if (i == SelfItemPointerAttributeNumber)
@@ -332,8 +514,8 @@ tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format)
 				if (format == FORMAT_TEXT)
 					datum = DirectFunctionCall1(tidin, CStringGetDatum(valstr));
 				else
-					datum = DirectFunctionCall1(tidrecv, PointerGetDatum(buf));
-				ctid = (ItemPointer) DatumGetPointer(datum);
+					datum = DirectFunctionCall1(tidrecv, PointerGetDatum(&buf));
+				*ctid = (ItemPointer) DatumGetPointer(datum);
 			}
 		}
 #if PG12_LT
@@ -346,32 +528,19 @@ tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format)
 				if (format == FORMAT_TEXT)
 					datum = DirectFunctionCall1(oidin, CStringGetDatum(valstr));
 				else
-					datum = DirectFunctionCall1(oidrecv, PointerGetDatum(buf));
-				oid = DatumGetObjectId(datum);
+					datum = DirectFunctionCall1(oidrecv, PointerGetDatum(&buf));
+				*oid = DatumGetObjectId(datum);
 			}
 		}
 #endif
 		tf->errpos.cur_attno = 0;
-		j++;
 	}
+}
 
-	/* Uninstall error context callback. */
-	if (tf->errcallback.callback != NULL)
-		error_context_stack = tf->errcallback.previous;
-
-	/*
-	 * Check we got the expected number of columns.  Note: j == 0 and
-	 * PQnfields == 1 is expected, since deparse emits a NULL if no columns.
-	 */
-	if (j > 0 && j != PQnfields(res))
-		elog(ERROR, "remote query result does not match the foreign table");
-
-	/*
-	 * Build the result tuple in caller's memory context.
-	 */
-	MemoryContextSwitchTo(oldcontext);
-
-	tuple = heap_form_tuple(tf->tupdesc, tf->values, tf->nulls);
+static HeapTuple
+form_tuple(TupleFactory *tf, ItemPointer ctid, Oid oid)
+{
+	HeapTuple tuple = heap_form_tuple(tf->tupdesc, tf->values, tf->nulls);
 
 	/*
 	 * If we have a CTID to return, install it in both t_self and t_ctid.
@@ -402,9 +571,103 @@ tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format)
 		HeapTupleSetOid(tuple, oid);
 #endif
 
+	return tuple;
+}
+
+static void
+check_result_columns(TupleFactory *tf, PGresult *res)
+{
+	/*
+	 * Check we got the expected number of columns.  Note: no retrieved
+	 * columns and PQnfields == 1 is expected, since deparse emits a NULL if
+	 * no columns.
+	 */
+	if (tf->num_retrieved_attrs > 0 && tf->num_retrieved_attrs != PQnfields(res))
+		elog(ERROR, "remote query result does not match the foreign table");
+}
+
+static void
+install_error_callback(TupleFactory *tf)
+{
+	if (tf->errcallback.callback != NULL)
+	{
+		tf->errcallback.previous = error_context_stack;
+		error_context_stack = &tf->errcallback;
+	}
+}
+
+static void
+uninstall_error_callback(TupleFactory *tf)
+{
+	if (tf->errcallback.callback != NULL)
+		error_context_stack = tf->errcallback.previous;
+}
+
+HeapTuple
+tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format)
+{
+	HeapTuple tuple;
+	ItemPointer ctid = NULL;
+	Oid oid = InvalidOid;
+	MemoryContext oldcontext;
+
+	Assert(row < PQntuples(res));
+	check_result_columns(tf, res);
+
+	/*
+	 * Do the following work in a temp context that we reset after each tuple.
+	 * This cleans up not only the data we have direct access to, but any
+	 * cruft the I/O functions might leak.
+	 */
+	oldcontext = MemoryContextSwitchTo(tf->temp_mctx);
+	install_error_callback(tf);
+	make_tuple_values(tf, res, row, format, &ctid, &oid);
+	uninstall_error_callback(tf);
+
+	/*
+	 * Build the result tuple in caller's memory context.
+	 */
+	MemoryContextSwitchTo(oldcontext);
+	tuple = form_tuple(tf, ctid, oid);
+
 	/* Clean up */
 	if (tf->per_tuple_mctx_reset)
 		MemoryContextReset(tf->temp_mctx);
 
 	return tuple;
 }
+
+/*
+ * Make tuples from all rows in a result.
+ *
+ * This is the same as calling tuplefactory_make_tuple() for each row, but
+ * the result is checked and the error context installed only once. As with
+ * tuplefactory_make_tuple(), the temporary memory context is reset after
+ * each tuple, unless per-tuple resets are turned off.
+ */
+void
+tuplefactory_make_tuples(TupleFactory *tf, PGresult *res, int format, HeapTuple *tuples)
+{
+	int num_rows = PQntuples(res);
+	MemoryContext oldcontext = CurrentMemoryContext;
+	int row;
+
+	check_result_columns(tf, res);
+	install_error_callback(tf);
+
+	for (row = 0; row < num_rows; row++)
+	{
+		ItemPointer ctid = NULL;
+		Oid oid = InvalidOid;
+
+		MemoryContextSwitchTo(tf->temp_mctx);
+		make_tuple_values(tf, res, row, format, &ctid, &oid);
+		MemoryContextSwitchTo(oldcontext);
+		tuples[row] = form_tuple(tf, ctid, oid);
+
+		if (tf->per_tuple_mctx_reset)
+			MemoryContextReset(tf->temp_mctx);
+	}
+
+	uninstall_error_callback(tf);
+}
@@ -27,6 +27,8 @@ extern TupleFactory *tuplefactory_create_for_tupdesc(TupleDesc tupdesc, bool for
 extern TupleFactory *tuplefactory_create_for_rel(Relation rel, List *retrieved_attrs);
 extern TupleFactory *tuplefactory_create_for_scan(ScanState *ss, List *retrieved_attrs);
 extern HeapTuple tuplefactory_make_tuple(TupleFactory *tf, PGresult *res, int row, int format);
+extern void tuplefactory_make_tuples(TupleFactory *tf, PGresult *res, int format,
+									 HeapTuple *tuples);
 extern bool tuplefactory_is_binary(TupleFactory *tf);
 extern void tuplefactory_set_per_tuple_mctx_reset(TupleFactory *tf, bool reset);
 extern void tuplefactory_reset_mctx(TupleFactory *tf);
@@ -0,0 +1,91 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Tests for the policy that creates chunks ahead of time
+
+-- Stop the scheduler so that the policies only run when called here
+\c :TEST_DBNAME :ROLE_SUPERUSER
+SELECT _timescaledb_internal.stop_background_workers();
+SET ROLE :ROLE_DEFAULT_PERM_USER;
+
+CREATE TABLE metrics(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics', 'time', 'device', 2, chunk_time_interval => 100);
+CREATE TABLE two_dims(time int NOT NULL, time2 int NOT NULL, value float);
+SELECT table_name FROM create_hypertable('two_dims', 'time', chunk_time_interval => 100);
+SELECT column_name FROM add_dimension('two_dims', 'time2', chunk_time_interval => 100);
+ALTER TABLE metrics SET (timescaledb.compress);
+
+-- the ranges of the chunks of metrics
+CREATE VIEW chunk_ranges AS
+SELECT c.table_name AS chunk,
+       max(s.range_start) FILTER (WHERE d.column_name = 'time') AS time_start,
+       max(s.range_end) FILTER (WHERE d.column_name = 'time') AS time_end,
+       max(s.range_start) FILTER (WHERE d.column_name = 'device') AS device_start
+FROM _timescaledb_catalog.chunk c
+JOIN _timescaledb_catalog.chunk_constraint cc ON cc.chunk_id = c.id
+JOIN _timescaledb_catalog.dimension_slice s ON s.id = cc.dimension_slice_id
+JOIN _timescaledb_catalog.dimension d ON d.id = s.dimension_id
+WHERE c.hypertable_id = 1
+GROUP BY c.id, c.table_name
+ORDER BY c.id;
+
+\set ON_ERROR_STOP 0
+SELECT add_chunk_precreate_policy('metrics', chunks_ahead => 0);
+SELECT add_chunk_precreate_policy('metrics');
+SELECT add_chunk_precreate_policy('two_dims');
+SELECT add_chunk_precreate_policy('_timescaledb_internal._compressed_hypertable_3');
+SELECT remove_chunk_precreate_policy('metrics');
+\set ON_ERROR_STOP 1
+SELECT remove_chunk_precreate_policy('metrics', if_exists => true);
+
+-- An integer time dimension needs a function that returns the current time
+CREATE TABLE fake_now(now int);
+INSERT INTO fake_now VALUES (150);
+CREATE FUNCTION metrics_now() RETURNS int LANGUAGE SQL STABLE AS 'SELECT now FROM fake_now';
+SELECT set_integer_now_func('metrics', 'metrics_now');
+SELECT add_chunk_precreate_policy('metrics', chunks_ahead => 2) AS job_id \gset
+SELECT application_name, schedule_interval, max_runtime, max_retries, retry_period, proc_schema,
+       proc_name, scheduled, hypertable_id, config
+FROM _timescaledb_config.bgw_job WHERE id = :job_id;
+
+-- There is only one policy per hypertable
+\set ON_ERROR_STOP 0
+SELECT add_chunk_precreate_policy('metrics', chunks_ahead => 2);
+\set ON_ERROR_STOP 1
+SELECT add_chunk_precreate_policy('metrics', chunks_ahead => 2, if_not_exists => true);
+SELECT add_chunk_precreate_policy('metrics', if_not_exists => true);
+
+-- The job creates the chunk for the current time and the next two chunk
+-- intervals, for both space partitions
+CALL run_job(:job_id);
+SELECT * FROM chunk_ranges;
+
+-- Running the job again or inserting into the time range of the chunks does
+-- not create any chunks
+CALL run_job(:job_id);
+INSERT INTO metrics SELECT t, t % 5, t FROM generate_series(150, 399) t;
+SELECT count(*) FROM show_chunks('metrics');
+
+-- the job creates the chunks for the new current time
+UPDATE fake_now SET now = 420;
+CALL run_job(:job_id);
+SELECT * FROM chunk_ranges WHERE time_start >= 400;
+
+-- A config with an invalid number of chunks is rejected
+\set ON_ERROR_STOP 0
+SELECT config FROM alter_job(:job_id, config => '{"hypertable_id": 1, "chunks_ahead": 0}');
+\set ON_ERROR_STOP 1
+
+-- For a time-based hypertable, the job runs every half chunk interval by
+-- default, and creates the chunk for now and the next one
+CREATE TABLE conditions(time timestamptz NOT NULL, value float);
+SELECT table_name FROM create_hypertable('conditions', 'time', chunk_time_interval => interval '1 day');
+SELECT add_chunk_precreate_policy('conditions') AS conditions_job_id \gset
+SELECT schedule_interval, config FROM _timescaledb_config.bgw_job WHERE id = :conditions_job_id;
+CALL run_job(:conditions_job_id);
+SELECT count(*) FROM show_chunks('conditions');
+
+SELECT remove_chunk_precreate_policy('metrics');
+SELECT id, hypertable_id FROM _timescaledb_config.bgw_job
+WHERE proc_name = 'policy_chunk_precreate' ORDER BY id;
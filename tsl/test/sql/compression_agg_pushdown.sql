@@ -0,0 +1,97 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+\set PREFIX 'EXPLAIN (costs off)'
+
+CREATE TABLE agg_pushdown(time timestamptz NOT NULL, device int, value float8, value4 float4,
+       ivalue int4, svalue int2, nullcol float8);
+SELECT table_name FROM create_hypertable('agg_pushdown', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO agg_pushdown
+SELECT '2020-01-01 00:00:00+00'::timestamptz + i * interval '10 minutes', i % 4,
+       CASE WHEN i % 7 = 0 THEN NULL ELSE (i % 50) * 0.5 END,
+       CASE WHEN i % 5 = 0 THEN NULL ELSE (i % 20) * 0.25 END,
+       i, CASE WHEN i % 11 = 0 THEN NULL ELSE i % 100 END, NULL
+FROM generate_series(0, 431) i;
+
+ALTER TABLE agg_pushdown SET (timescaledb.compress, timescaledb.compress_segmentby = 'device',
+      timescaledb.compress_orderby = 'time');
+
+-- compress two of the three chunks so that the plans have both kinds of chunks
+SELECT count(compress_chunk(c))
+FROM (SELECT c FROM show_chunks('agg_pushdown') c ORDER BY c LIMIT 2) s;
+
+SET timescaledb.enable_compressed_aggregate_pushdown TO on;
+
+-- count(*) from the count column, min and max of the orderby column from
+-- the segment metadata, the segmentby column from its value per batch and
+-- everything else from the decompressed values, including NULLs
+\set QUERY 'SELECT count(*), count(value), sum(value), sum(value4), sum(ivalue), sum(svalue), min(value4), max(value), min(svalue), max(ivalue), min(time), max(time), sum(device), max(device), sum(nullcol) FROM agg_pushdown'
+:PREFIX :QUERY;
+:QUERY;
+\ir include/compression_agg_pushdown_equal.sql
+
+-- quals that are evaluated on the decompressed values
+\set QUERY 'SELECT count(*), count(value), sum(value), sum(value4), sum(ivalue), sum(svalue), min(value4), max(value), min(svalue), max(ivalue), min(time), max(time), sum(device), max(device), sum(nullcol) FROM agg_pushdown WHERE ivalue > 100 AND value < 20'
+:PREFIX :QUERY;
+:QUERY;
+\ir include/compression_agg_pushdown_equal.sql
+
+-- quals on the segmentby column filter the batches in the scan of the
+-- compressed chunk
+\set QUERY 'SELECT count(*), sum(value), min(time), max(svalue) FROM agg_pushdown WHERE device = 1'
+\ir include/compression_agg_pushdown_equal.sql
+
+-- no rows pass the quals
+\set QUERY 'SELECT count(*), sum(value), min(time), max(svalue) FROM agg_pushdown WHERE ivalue > 100000'
+\ir include/compression_agg_pushdown_equal.sql
+
+-- Aggregates are not pushed down if a qual can't be evaluated on the
+-- decompressed values. The chunks are aggregated as usual then, so
+-- DecompressChunk never gets a qual it can't evaluate on the batches.
+\set QUERY 'SELECT count(*), sum(value) FROM agg_pushdown WHERE ivalue % 2 = 0'
+:PREFIX :QUERY;
+\ir include/compression_agg_pushdown_equal.sql
+\set QUERY 'SELECT count(*), sum(value) FROM agg_pushdown WHERE ivalue > 100 OR value < 20'
+\ir include/compression_agg_pushdown_equal.sql
+\set QUERY 'SELECT count(*), sum(value) FROM agg_pushdown WHERE value < ''NaN'''
+\ir include/compression_agg_pushdown_equal.sql
+\set QUERY 'SELECT count(*), sum(value) FROM agg_pushdown WHERE time < ''2020-01-02''::date'
+\ir include/compression_agg_pushdown_equal.sql
+\set QUERY 'SELECT count(*), sum(value) FROM agg_pushdown WHERE time < now()'
+\ir include/compression_agg_pushdown_equal.sql
+
+-- aggregates that are not pushed down
+\set QUERY 'SELECT count(*), avg(value) FROM agg_pushdown'
+\ir include/compression_agg_pushdown_equal.sql
+\set QUERY 'SELECT count(DISTINCT device), sum(value) FILTER (WHERE ivalue > 100) FROM agg_pushdown'
+\ir include/compression_agg_pushdown_equal.sql
+
+-- grouping, including by the segmentby column, is not pushed down
+\set QUERY 'SELECT device, count(*), sum(value), min(time), max(time) FROM agg_pushdown GROUP BY device'
+\ir include/compression_agg_pushdown_equal.sql
+
+-- overflow of float sums is reported like in the aggregate
+CREATE TABLE agg_overflow(time timestamptz NOT NULL, value4 float4, value float8);
+SELECT table_name FROM create_hypertable('agg_overflow', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO agg_overflow VALUES
+('2020-01-01 00:00:00+00', 3e38, 1e308),
+('2020-01-01 00:01:00+00', 3e38, 1e308),
+('2020-01-02 00:00:00+00', 1, 1);
+ALTER TABLE agg_overflow SET (timescaledb.compress);
+SELECT count(compress_chunk(c))
+FROM (SELECT c FROM show_chunks('agg_overflow') c ORDER BY c LIMIT 1) s;
+
+:PREFIX SELECT sum(value4) FROM agg_overflow;
+\set ON_ERROR_STOP 0
+SELECT sum(value4) FROM agg_overflow;
+SELECT sum(value) FROM agg_overflow;
+SET timescaledb.enable_compressed_aggregate_pushdown TO off;
+SELECT sum(value4) FROM agg_overflow;
+SELECT sum(value) FROM agg_overflow;
+\set ON_ERROR_STOP 1
+
+RESET timescaledb.enable_compressed_aggregate_pushdown;
+DROP TABLE agg_pushdown;
+DROP TABLE agg_overflow;
@@ -0,0 +1,62 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Tests for the timescaledb.compress_algorithms option, which overrides the
+-- compression algorithm of individual columns
+
+CREATE TABLE metrics(time int NOT NULL, device int, counter int, value float, label text,
+                     note text, "Flag" bool, reading numeric);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 1000);
+
+\set ON_ERROR_STOP 0
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'value:zstd');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_segmentby = 'device', timescaledb.compress_algorithms = 'device:for');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'value:alp, value:gorilla');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'value:for');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'label:gorilla');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'missing:alp');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'value');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_algorithms = 'value:alp:gorilla');
+ALTER TABLE metrics SET (timescaledb.compress = false, timescaledb.compress_algorithms = 'value:alp');
+\set ON_ERROR_STOP 1
+SELECT count(*) FROM _timescaledb_catalog.hypertable_compression;
+
+-- Algorithm names are case-insensitive and column names can be quoted. The
+-- orderby column can be overridden too, and "default" picks the algorithm
+-- from the type.
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_segmentby = 'device',
+      timescaledb.compress_algorithms = 'counter:AUTO, value:alp, label:auto, note:auto, "Flag":for, reading:default, time:for');
+SELECT hc.attname, a.description AS algorithm, hc.segmentby_column_index, hc.orderby_column_index
+FROM _timescaledb_catalog.hypertable_compression hc
+JOIN _timescaledb_catalog.compression_algorithm a ON a.id = hc.compression_algorithm_id
+ORDER BY hc.attname;
+
+-- The auto algorithm is only stored in the catalog. Every batch is compressed
+-- with a real algorithm that is recorded in the compressed data, and a column
+-- with only NULLs has no compressed data at all.
+CREATE FUNCTION algorithm(data _timescaledb_internal.compressed_data) RETURNS text LANGUAGE SQL AS
+$$
+  SELECT description FROM _timescaledb_catalog.compression_algorithm
+  WHERE id = get_byte(decode(data::text, 'base64'), 0)
+$$;
+
+INSERT INTO metrics
+SELECT t, t % 2, t, (t % 100) / 10.0, (ARRAY['low', 'mid', 'high'])[t % 3 + 1], NULL, t % 5 = 0, t / 7.0
+FROM generate_series(0, 1999) t;
+CREATE TABLE metrics_orig AS SELECT * FROM metrics;
+SELECT count(compress_chunk(c)) FROM show_chunks('metrics') c;
+
+SELECT DISTINCT device, algorithm(time) AS time, algorithm(counter) AS counter,
+       algorithm(value) AS value, algorithm(label) AS label, algorithm(note) AS note,
+       algorithm("Flag") AS "Flag", algorithm(reading) AS reading
+FROM (SELECT * FROM _timescaledb_internal.compress_hyper_2_3_chunk
+      UNION ALL SELECT * FROM _timescaledb_internal.compress_hyper_2_4_chunk) c
+ORDER BY device;
+
+-- the decompressed rows are the original ones
+SELECT count(*) FROM ((TABLE metrics EXCEPT ALL TABLE metrics_orig)
+                      UNION ALL (TABLE metrics_orig EXCEPT ALL TABLE metrics)) d;
+SELECT count(decompress_chunk(c)) FROM show_chunks('metrics') c;
+SELECT count(*) FROM ((TABLE metrics EXCEPT ALL TABLE metrics_orig)
+                      UNION ALL (TABLE metrics_orig EXCEPT ALL TABLE metrics)) d;
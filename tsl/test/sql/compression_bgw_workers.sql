@@ -0,0 +1,64 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Tests for compression policies that compress several chunks in parallel
+-- background workers with timescaledb.compression_policy_workers
+
+-- Stop the scheduler so that only the policies run here start workers. The
+-- workers run as the user of the policy, so they fail to connect for a role
+-- that cannot log in.
+\c :TEST_DBNAME :ROLE_SUPERUSER
+SELECT _timescaledb_internal.stop_background_workers();
+CREATE ROLE compress_workers_nologin NOLOGIN;
+GRANT :ROLE_DEFAULT_PERM_USER TO compress_workers_nologin;
+SET ROLE :ROLE_DEFAULT_PERM_USER;
+
+CREATE TABLE metrics(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 100);
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_segmentby = 'device');
+CREATE FUNCTION metrics_now() RETURNS int LANGUAGE SQL STABLE AS 'SELECT 10000';
+SELECT set_integer_now_func('metrics', 'metrics_now');
+SELECT add_compression_policy('metrics', 10) AS job_id \gset
+
+\set STATE 'SELECT id, compressed_chunk_id IS NOT NULL AS compressed FROM _timescaledb_catalog.chunk WHERE hypertable_id = 1 ORDER BY id'
+
+INSERT INTO metrics SELECT t, t % 3, t FROM generate_series(0, 199) t;
+SET timescaledb.compression_policy_workers TO 2;
+
+-- The policy commits before starting the workers, so it does not hold any
+-- locks that the workers wait for. When the workers fail, the policy fails.
+\set ON_ERROR_STOP 0
+RESET ROLE;
+SET ROLE compress_workers_nologin;
+CALL run_job(:job_id);
+RESET ROLE;
+SET ROLE :ROLE_DEFAULT_PERM_USER;
+\set ON_ERROR_STOP 1
+:STATE;
+
+-- Inside a transaction block, the policy cannot commit, so it compresses one
+-- chunk itself
+BEGIN;
+CALL run_job(:job_id);
+COMMIT;
+:STATE;
+
+-- the next run compresses the remaining chunk in a worker
+CALL run_job(:job_id);
+:STATE;
+CALL run_job(:job_id);
+
+-- With more chunks than background workers that can be started, the
+-- remaining chunks are compressed by the policy itself once the workers are
+-- done.
+SHOW timescaledb.max_background_workers;
+INSERT INTO metrics SELECT t, t % 3, t FROM generate_series(200, 1199) t;
+SET timescaledb.compression_policy_workers TO 10;
+CALL run_job(:job_id);
+:STATE;
+CALL run_job(:job_id);
+SELECT count(*), sum(value) FROM metrics;
+
+RESET ROLE;
+DROP ROLE compress_workers_nologin;
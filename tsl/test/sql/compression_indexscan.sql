@@ -0,0 +1,98 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+\c :TEST_DBNAME :ROLE_SUPERUSER
+CREATE OR REPLACE FUNCTION compression_index(chunk regclass) RETURNS regclass
+AS :TSL_MODULE_PATHNAME, 'ts_test_compression_index' LANGUAGE C STRICT;
+\c :TEST_DBNAME :ROLE_DEFAULT_PERM_USER
+
+-- Compressing a chunk through a matching index scan has to write the same
+-- batches in the same order as sorting the chunk
+
+CREATE TABLE source AS
+SELECT t AS time, d AS device, t * 10 + coalesce(d, 0)::float AS value
+FROM generate_series(1, 2000) t, (VALUES (1), (2), (NULL::int)) v(d);
+
+-- create a hypertable with an index that matches the compression settings
+-- and insert the rows in the given physical order
+CREATE FUNCTION create_metrics(tbl text, order_by text) RETURNS text LANGUAGE plpgsql AS
+$$
+BEGIN
+  EXECUTE format('CREATE TABLE %I(time int NOT NULL, device int, value float)', tbl);
+  PERFORM create_hypertable(tbl::regclass, 'time', chunk_time_interval => 10000);
+  EXECUTE format('CREATE INDEX ON %I(device, time DESC)', tbl);
+  EXECUTE format('ALTER TABLE %I SET (timescaledb.compress, '
+                 'timescaledb.compress_segmentby = ''device'', '
+                 'timescaledb.compress_orderby = ''time DESC'')', tbl);
+  EXECUTE format('INSERT INTO %I SELECT * FROM source ORDER BY %s', tbl, order_by);
+  RETURN tbl;
+END
+$$;
+
+-- the rows of the compressed chunks of a hypertable in physical order
+CREATE FUNCTION compressed_rows(ht regclass) RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+DECLARE
+  chunk regclass;
+BEGIN
+  FOR chunk IN
+    SELECT format('%I.%I', cc.schema_name, cc.table_name)::regclass
+    FROM _timescaledb_catalog.chunk c
+    JOIN _timescaledb_catalog.chunk cc ON cc.id = c.compressed_chunk_id
+    JOIN _timescaledb_catalog.hypertable h ON h.id = c.hypertable_id
+    WHERE format('%I.%I', h.schema_name, h.table_name)::regclass = ht
+    ORDER BY c.id
+  LOOP
+    RETURN QUERY EXECUTE format('SELECT c::text FROM %s c ORDER BY ctid', chunk);
+  END LOOP;
+END
+$$;
+
+-- the decompressed rows of a hypertable in the order they are returned
+CREATE FUNCTION decompressed_rows(ht regclass) RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+BEGIN
+  RETURN QUERY EXECUTE format('SELECT t::text FROM %s t', ht);
+END
+$$;
+
+-- The index is used if the chunk is stored in index order, or if the rows of
+-- every device are stored in time order. Rows in random order are sorted.
+SELECT create_metrics(tbl, order_by)
+FROM (VALUES ('device_order_on', 'device, time DESC'), ('device_order_off', 'device, time DESC'),
+             ('time_order_on', 'time'), ('time_order_off', 'time'),
+             ('random_order_on', '(time * 7919) % 2003, device')) v(tbl, order_by);
+
+ANALYZE device_order_on, time_order_on, random_order_on;
+SELECT tbl, compression_index(c) IS NOT NULL AS index_scan
+FROM (VALUES ('device_order_on'::regclass), ('time_order_on'), ('random_order_on')) v(tbl),
+     show_chunks(tbl) c;
+
+-- Without statistics, the chunk is assumed to be stored in time order
+BEGIN;
+SELECT create_metrics('unanalyzed', '(time * 7919) % 2003, device');
+SELECT compression_index(c) IS NOT NULL AS index_scan FROM show_chunks('unanalyzed') c;
+ROLLBACK;
+
+SET timescaledb.enable_compression_indexscan TO on;
+SELECT count(compress_chunk(c)) FROM show_chunks('device_order_on') c;
+SELECT count(compress_chunk(c)) FROM show_chunks('time_order_on') c;
+SELECT count(compress_chunk(c)) FROM show_chunks('random_order_on') c;
+SET timescaledb.enable_compression_indexscan TO off;
+SELECT count(compress_chunk(c)) FROM show_chunks('device_order_off') c;
+SELECT count(compress_chunk(c)) FROM show_chunks('time_order_off') c;
+RESET timescaledb.enable_compression_indexscan;
+
+SELECT tbl,
+       (SELECT count(*) FROM compressed_rows(tbl)) AS batches,
+       array(SELECT compressed_rows(tbl)) =
+       array(SELECT compressed_rows('device_order_off')) AS same_batches,
+       array(SELECT decompressed_rows(tbl)) =
+       array(SELECT decompressed_rows('device_order_off')) AS same_rows
+FROM (VALUES ('device_order_on'::regclass), ('device_order_off'),
+             ('time_order_on'), ('time_order_off'), ('random_order_on')) v(tbl);
+
+-- the decompressed rows are the source rows
+SELECT count(*) FROM (SELECT * FROM device_order_on EXCEPT ALL SELECT * FROM source) d;
+SELECT count(*) FROM (SELECT * FROM source EXCEPT ALL SELECT * FROM device_order_on) d;
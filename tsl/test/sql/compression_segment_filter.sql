@@ -0,0 +1,120 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Tests for partial decompression with decompress_chunk(segment_filter => ...)
+
+-- the rows stored in the uncompressed chunk itself
+CREATE FUNCTION uncompressed_rows(chunk regclass) RETURNS bigint LANGUAGE plpgsql
+SET timescaledb.enable_transparent_decompression TO off AS
+$$
+DECLARE
+  num_rows bigint;
+BEGIN
+  EXECUTE format('SELECT count(*) FROM %s', chunk) INTO num_rows;
+  RETURN num_rows;
+END
+$$;
+
+-- the scans of the chunk in the plan of a query
+CREATE FUNCTION chunk_scans(query text) RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (costs off) ' || query LOOP
+    IF line ~ 'DecompressChunk|Seq Scan on _hyper' THEN
+      RETURN NEXT regexp_replace(line, '^\s*(->\s*)?', '');
+    END IF;
+  END LOOP;
+END
+$$;
+
+CREATE TABLE metrics(time int NOT NULL, device int, value float);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => 10000);
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_segmentby = 'device',
+      timescaledb.compress_orderby = 'time');
+-- two batches per device, one for time 1..1000 and one for time 1001..1500
+INSERT INTO metrics SELECT t, d, t * d FROM generate_series(1, 1500) t, generate_series(1, 3) d;
+CREATE TABLE metrics_orig AS SELECT * FROM metrics;
+SELECT compress_chunk(c) AS chunk FROM show_chunks('metrics') c \gset
+
+\set STATE 'SELECT (SELECT count(*) FROM metrics) AS total_rows, uncompressed_rows(''_timescaledb_internal._hyper_1_1_chunk''), numrows_pre_compression, numrows_post_compression FROM _timescaledb_catalog.compression_chunk_size'
+\set DIFF 'SELECT count(*) AS differences FROM ((TABLE metrics EXCEPT ALL TABLE metrics_orig) UNION ALL (TABLE metrics_orig EXCEPT ALL TABLE metrics)) d'
+
+:STATE;
+SELECT * FROM chunk_scans('SELECT * FROM metrics');
+
+-- only segmentby and orderby columns can be used
+\set ON_ERROR_STOP 0
+SELECT decompress_chunk(:'chunk', segment_filter => '{"value": 1}');
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": {"~": 1}}');
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": [1, 2]}');
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": {}}');
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": {}, "time": {"<": 10}}');
+SELECT decompress_chunk(:'chunk', segment_filter => '[1]');
+SELECT decompress_chunk(:'chunk', segment_filter => '{}');
+\set ON_ERROR_STOP 1
+:STATE;
+
+-- decompress all batches of a segmentby value
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": 2}');
+:STATE;
+:DIFF;
+SELECT * FROM chunk_scans('SELECT * FROM metrics');
+SELECT * FROM chunk_scans('SELECT * FROM metrics ORDER BY time');
+SELECT device, count(*), sum(value) FROM metrics GROUP BY device ORDER BY device;
+SELECT time, device FROM metrics WHERE time BETWEEN 999 AND 1002 ORDER BY time, device;
+
+-- UPDATE and DELETE are allowed if their conditions rule out all batches
+-- that are still compressed
+UPDATE metrics SET value = 0 WHERE device = 2 AND time = 10;
+DELETE FROM metrics WHERE device = 2 AND time > 1400;
+DELETE FROM metrics WHERE device = 2 AND time < 5;
+SELECT value FROM metrics WHERE device = 2 AND time = 10;
+\set ON_ERROR_STOP 0
+UPDATE metrics SET value = 0 WHERE device = 1;
+DELETE FROM metrics WHERE value = 4;
+DELETE FROM metrics WHERE device >= 2;
+\set ON_ERROR_STOP 1
+:STATE;
+
+-- decompress the batches of an orderby range
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": {">=": 1}, "time": {">": 1000}}');
+:STATE;
+-- the remaining batches end at time 1000
+DELETE FROM metrics WHERE device = 1 AND time > 1000;
+\set ON_ERROR_STOP 0
+DELETE FROM metrics WHERE device = 3 AND time >= 1000;
+\set ON_ERROR_STOP 1
+:STATE;
+
+-- compressing the chunk again compresses the decompressed rows
+SELECT compress_chunk(:'chunk');
+:STATE;
+SELECT * FROM chunk_scans('SELECT * FROM metrics');
+SELECT device, count(*), sum(value) FROM metrics GROUP BY device ORDER BY device;
+SELECT compress_chunk(:'chunk', if_not_compressed => true);
+
+-- the chunk is no longer partial once the decompressed rows are deleted
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": 2}');
+SELECT * FROM chunk_scans('SELECT * FROM metrics');
+DELETE FROM metrics WHERE device = 2;
+SELECT * FROM chunk_scans('SELECT * FROM metrics');
+SELECT compress_chunk(:'chunk', if_not_compressed => true);
+
+-- the compression policy compresses partial chunks again
+CREATE FUNCTION metrics_now() RETURNS int LANGUAGE SQL STABLE AS 'SELECT 100000';
+SELECT set_integer_now_func('metrics', 'metrics_now');
+SELECT add_compression_policy('metrics', 10) AS job_id \gset
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": 1}');
+:STATE;
+CALL run_job(:job_id);
+:STATE;
+CALL run_job(:job_id);
+
+-- decompressing the last batches finishes the decompression
+SELECT decompress_chunk(:'chunk', segment_filter => '{"device": {"<=": 3}}');
+SELECT count(*) FROM _timescaledb_catalog.compression_chunk_size;
+SELECT compressed_chunk_id FROM _timescaledb_catalog.chunk WHERE id = 1;
+SELECT device, count(*), sum(value) FROM metrics GROUP BY device ORDER BY device;
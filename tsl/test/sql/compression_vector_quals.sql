@@ -0,0 +1,61 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Tests for quals that are evaluated on whole decompressed batches. Every
+-- query is run with timescaledb.enable_bulk_decompression on, which uses
+-- vector quals where possible, and off, which evaluates the quals on each
+-- row. Both have to return the same rows.
+
+-- The batches of device 2 have only NULLs in i8. The float columns have NaN
+-- and infinite values, and every device has its own range of i4 values, so
+-- some quals skip whole batches.
+CREATE TABLE metrics(time timestamptz NOT NULL, device int, i2 smallint, i4 int, i8 bigint,
+                     f4 float4, f8 float8, d date);
+SELECT table_name FROM create_hypertable('metrics', 'time', chunk_time_interval => interval '1 day');
+ALTER TABLE metrics SET (timescaledb.compress, timescaledb.compress_segmentby = 'device',
+                         timescaledb.compress_orderby = 'time');
+INSERT INTO metrics
+SELECT '2021-01-01 00:00+00'::timestamptz + t * interval '1 minute', t % 3,
+       CASE WHEN t % 17 = 0 THEN NULL ELSE t % 200 - 100 END,
+       t % 3 * 1000 + t % 500,
+       CASE WHEN t % 3 = 2 THEN NULL ELSE t * 10000000::bigint END,
+       CASE WHEN t % 101 = 0 THEN 'NaN'::float4 ELSE ((t % 8) / 8.0)::float4 END,
+       CASE WHEN t % 97 = 0 THEN NULL WHEN t % 89 = 0 THEN '-Infinity'::float8
+            WHEN t % 83 = 0 THEN 'NaN'::float8 ELSE (t % 11 - 5)::float8 END,
+       '2021-01-01'::date + t / 1000
+FROM generate_series(0, 4319) t;
+SELECT count(compress_chunk(c)) FROM show_chunks('metrics') c;
+
+-- the number of rows matching a qual, and whether they are the same with
+-- and without bulk decompression
+CREATE FUNCTION compare(qual text, OUT rows int, OUT same bool) LANGUAGE plpgsql AS
+$$
+DECLARE
+  stmt text := format('SELECT array_agg(m::text ORDER BY time) FROM metrics m WHERE %s', qual);
+  rows_on text[];
+  rows_off text[];
+BEGIN
+  PERFORM set_config('timescaledb.enable_bulk_decompression', 'on', true);
+  EXECUTE stmt INTO rows_on;
+  PERFORM set_config('timescaledb.enable_bulk_decompression', 'off', true);
+  EXECUTE stmt INTO rows_off;
+  rows := coalesce(cardinality(rows_on), 0);
+  same := rows_on IS NOT DISTINCT FROM rows_off;
+END
+$$;
+
+-- Comparisons of a column with a constant, also commuted and with constants
+-- of another type of the same operator family, are vector quals. The others
+-- are evaluated on each row, and so are comparisons with a NaN constant.
+SELECT q AS qual, c.rows, c.same
+FROM (VALUES ('i2 < 0'), ('i2 >= 50::smallint'), ('i2 = 7::bigint'), ('-3 > i2'),
+             ('i4 <= 1200'), ('i4 < 1000'), ('i4 = 2499'),
+             ('i8 > 40000000000'), ('i8 <> 50000000'),
+             ('f4 > 0.5::float4'), ('f4 < 0.5'),
+             ('f8 >= 0'), ('f8 <= -1'), ('f8 > ''-Infinity'''), ('f8 < ''NaN'''), ('f8 = 0'),
+             ('d = ''2021-01-02'''), ('d > ''2021-01-03'''),
+             ('time < ''2021-01-02 12:00+00'''),
+             ('i4 < 1000 AND f8 > 0'), ('i4 >= 1000 AND device = 1'),
+             ('i2 + 1 > 0'), ('i4 < 10 OR f8 > 4'), ('i8 IS NULL')) v(q),
+     LATERAL compare(q) c;
@@ -39,3 +39,45 @@ SET timescaledb.remote_data_fetcher = 'cursor';
 -- compare results
 :DIFF_CMD
 
+-- Compare the values that are decoded inline from binary results with
+-- the values from text results, which go through the input functions.
+-- This includes the limits of the date and timestamp ranges, and
+-- timestamps with a typmod, which use the receive function.
+\set ECHO all
+CREATE TABLE disttable_types(time timestamptz NOT NULL, device int, b bool, i2 int2, i8 int8,
+       o oid, f4 float4, f8 float8, d date, ts timestamp, tstz timestamptz,
+       ts_typmod timestamp(2), tstz_typmod timestamptz(3), n numeric);
+SELECT table_name FROM create_distributed_hypertable('disttable_types', 'time', 'device', 3);
+INSERT INTO disttable_types VALUES
+('2019-01-01 00:00:00', 1, true, 32767, 9223372036854775807, 4294967295, 'NaN', 'Infinity',
+ 'infinity', 'infinity', 'infinity', '2019-01-01 00:00:00.125', '2019-01-01 00:00:00.1235', 1.5),
+('2019-01-01 00:00:01', 2, false, -32768, -9223372036854775808, 0, '-Infinity', '-0',
+ '-infinity', '-infinity', '-infinity', '2019-01-01 00:00:00.115', '2019-01-01 00:00:00.1225', -1.5),
+('2019-01-01 00:00:02', 3, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL),
+('2019-01-01 00:00:03', 4, true, 0, 0, 1, 1.17549435e-38, 2.2250738585072014e-308,
+ '4714-11-24 BC', '4714-11-24 00:00:00 BC', '4713-01-01 00:00:00+00 BC',
+ '4714-11-24 00:00:00 BC', '4713-01-01 00:00:00+00 BC', 0),
+('2019-01-01 00:00:04', 5, false, 1, 1, 2, 3.40282347e+38, 1.7976931348623157e+308,
+ '5874897-12-31', '294276-12-31 23:59:59.999999', '294276-12-31 23:59:59.999999+00',
+ '294276-12-31 23:59:59.99', '294276-12-31 23:59:59.999+00', 1e100);
+SET timescaledb.remote_data_fetcher = 'rowbyrow';
+SET timescaledb.enable_connection_binary_data = true;
+CREATE TEMP TABLE types_rowbyrow_binary AS SELECT * FROM disttable_types;
+SET timescaledb.enable_connection_binary_data = false;
+CREATE TEMP TABLE types_rowbyrow_text AS SELECT * FROM disttable_types;
+SET timescaledb.remote_data_fetcher = 'cursor';
+SET timescaledb.enable_connection_binary_data = true;
+CREATE TEMP TABLE types_cursor_binary AS SELECT * FROM disttable_types;
+SET timescaledb.enable_connection_binary_data = false;
+CREATE TEMP TABLE types_cursor_text AS SELECT * FROM disttable_types;
+RESET timescaledb.enable_connection_binary_data;
+RESET timescaledb.remote_data_fetcher;
+-- Compare the text representation of the rows, which tells -0 from 0
+SELECT (SELECT count(*) FROM types_cursor_text) AS num_rows,
+       (SELECT count(*) FROM (SELECT t::text FROM types_rowbyrow_binary t
+                              EXCEPT SELECT t::text FROM types_rowbyrow_text t) d) AS rowbyrow_diff,
+       (SELECT count(*) FROM (SELECT t::text FROM types_cursor_binary t
+                              EXCEPT SELECT t::text FROM types_cursor_text t) d) AS cursor_diff,
+       (SELECT count(*) FROM (SELECT t::text FROM types_cursor_text t
+                              EXCEPT SELECT t::text FROM types_rowbyrow_binary t) d) AS text_diff;
+SELECT device, f8::text, ts_typmod, tstz_typmod FROM types_cursor_binary ORDER BY device;
@@ -0,0 +1,98 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+-- Test how DataNodeDispatch sends inserted tuples to data nodes. Tuples
+-- are sent with binary COPY, unless the statement needs something that
+-- only INSERT supports, like RETURNING or ON CONFLICT.
+\c :TEST_DBNAME :ROLE_CLUSTER_SUPERUSER
+\set DATA_NODE_1 :TEST_DBNAME _1
+\set DATA_NODE_2 :TEST_DBNAME _2
+\set DATA_NODE_3 :TEST_DBNAME _3
+
+SELECT * FROM add_data_node('data_node_1', host => 'localhost', database => :'DATA_NODE_1');
+SELECT * FROM add_data_node('data_node_2', host => 'localhost', database => :'DATA_NODE_2');
+SELECT * FROM add_data_node('data_node_3', host => 'localhost', database => :'DATA_NODE_3');
+GRANT USAGE ON FOREIGN SERVER data_node_1, data_node_2, data_node_3 TO PUBLIC;
+SET ROLE :ROLE_1;
+
+-- Show only the batch size and remote statement of DataNodeDispatch
+CREATE OR REPLACE FUNCTION dispatch_remote_sql(stmt text)
+RETURNS SETOF TEXT LANGUAGE plpgsql AS
+$BODY$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE format('EXPLAIN (VERBOSE, COSTS OFF) %s', stmt) LOOP
+        IF line ~ '(Batch size|Remote SQL):' THEN
+            RETURN NEXT trim(line);
+        END IF;
+    END LOOP;
+END
+$BODY$;
+
+CREATE TABLE disttable(time timestamptz NOT NULL, device int, temp float, PRIMARY KEY (time, device));
+SELECT * FROM create_distributed_hypertable('disttable', 'time', 'device');
+
+-- A plain INSERT uses binary COPY
+SELECT * FROM dispatch_remote_sql($$
+INSERT INTO disttable VALUES ('2017-01-01 06:01', 1, 1.1)
+$$);
+INSERT INTO disttable VALUES
+       ('2017-01-01 06:01', 1, 1.1),
+       ('2017-01-01 09:11', 3, 2.1),
+       ('2017-01-02 08:01', 2, 1.3),
+       ('2018-07-02 08:01', 87, 1.6);
+
+-- ON CONFLICT DO NOTHING falls back to INSERT on the data nodes
+SELECT * FROM dispatch_remote_sql($$
+INSERT INTO disttable VALUES ('2017-01-01 06:01', 1, 9.9) ON CONFLICT DO NOTHING
+$$);
+INSERT INTO disttable VALUES
+       ('2017-01-01 06:01', 1, 9.9),
+       ('2017-01-03 10:00', 4, 2.2)
+ON CONFLICT DO NOTHING;
+
+-- RETURNING also falls back to INSERT on the data nodes
+SELECT * FROM dispatch_remote_sql($$
+INSERT INTO disttable VALUES ('2017-01-04 11:00', 5, 3.3) RETURNING *
+$$);
+WITH result AS (
+     INSERT INTO disttable VALUES
+            ('2017-01-04 11:00', 5, 3.3),
+            ('2017-01-04 12:00', 6, 3.4)
+     RETURNING *
+) SELECT * FROM result ORDER BY time;
+
+-- Binary COPY is not used when binary data transfer is disabled
+SET timescaledb.enable_connection_binary_data TO false;
+SELECT * FROM dispatch_remote_sql($$
+INSERT INTO disttable VALUES ('2017-01-05 08:00', 7, 4.4)
+$$);
+INSERT INTO disttable VALUES ('2017-01-05 08:00', 7, 4.4);
+RESET timescaledb.enable_connection_binary_data;
+
+SELECT * FROM disttable ORDER BY time, device;
+
+-- Without RETURNING, each data node has its own batch in flight while
+-- tuples are read. With small batches, batches are in flight whenever the
+-- insert reaches a new chunk, so they are completed before the chunk is
+-- created on the data nodes.
+CREATE TABLE pipelined(time int NOT NULL, device int, temp float, PRIMARY KEY (time, device));
+SELECT * FROM create_distributed_hypertable('pipelined', 'time', 'device', chunk_time_interval => 10);
+SET timescaledb.max_insert_batch_size TO 2;
+SELECT * FROM dispatch_remote_sql($$
+INSERT INTO pipelined VALUES (0, 0, 0)
+$$);
+INSERT INTO pipelined SELECT t, t % 5, t FROM generate_series(0, 99) t;
+
+-- the same with prepared INSERT statements instead of COPY, and with
+-- batches that partly conflict with existing rows
+SET timescaledb.enable_connection_binary_data TO false;
+INSERT INTO pipelined SELECT t, t % 5, t FROM generate_series(100, 199) t;
+RESET timescaledb.enable_connection_binary_data;
+INSERT INTO pipelined SELECT t, t % 5, t FROM generate_series(150, 249) t ON CONFLICT DO NOTHING;
+RESET timescaledb.max_insert_batch_size;
+
+SELECT time / 50 AS part, count(*), count(DISTINCT time / 10) AS slices, sum(temp)
+FROM pipelined GROUP BY 1 ORDER BY 1;
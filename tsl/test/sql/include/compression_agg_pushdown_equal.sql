@@ -0,0 +1,16 @@
+-- This file and its contents are licensed under the Timescale License.
+-- Please see the included NOTICE for copyright information and
+-- LICENSE-TIMESCALE for a copy of the license.
+
+--expects QUERY to be set
+SET timescaledb.enable_compressed_aggregate_pushdown TO on;
+CREATE TEMP TABLE result_on AS SELECT q::text AS result FROM (:QUERY) q;
+SET timescaledb.enable_compressed_aggregate_pushdown TO off;
+CREATE TEMP TABLE result_off AS SELECT q::text AS result FROM (:QUERY) q;
+SET timescaledb.enable_compressed_aggregate_pushdown TO on;
+
+SELECT 'Number of rows different with and without pushdown (expect 0)', count(*)
+FROM ((TABLE result_on EXCEPT ALL TABLE result_off)
+      UNION ALL (TABLE result_off EXCEPT ALL TABLE result_on)) d;
+
+DROP TABLE result_on, result_off;
@@ -14,20 +14,28 @@
 #include <lib/stringinfo.h>
 #include <utils/array.h>
 #include <utils/builtins.h>
+#include <utils/datum.h>
 #include <utils/lsyscache.h>
 #include <utils/rel.h>
 #include <utils/syscache.h>
 #include <utils/typcache.h>
 #include <fmgr.h>
 
+#include <math.h>
+
 #include <catalog.h>
+#include <chunk.h>
 #include <export.h>
+#include <hypertable_compression.h>
 #include "test_utils.h"
 
+#include "compression/alp.h"
 #include "compression/array.h"
 #include "compression/dictionary.h"
 #include "compression/gorilla.h"
 #include "compression/deltadelta.h"
+#include "compression/for.h"
+#include "compression/simple8b_rle.h"
 #include "compression/utils.h"
 #include "compression/segment_meta.h"
 
@@ -418,6 +426,300 @@ test_delta2()
 	TestAssertInt64Eq(i, 1015);
 }
 
+static void check_decompress_all(Datum compressed, Oid element_type);
+
+static void
+test_for()
+{
+	ForCompressor *compressor = for_compressor_alloc();
+	Datum compressed;
+	DecompressionIterator *iter;
+	int i;
+
+	/* a small range of values with no correlation between rows, offset from 0 */
+	for (i = 0; i < 1015; i++)
+		for_compressor_append_value(compressor, -1000 + (i * 5) % 7);
+
+	compressed = PointerGetDatum(for_compressor_finish(compressor));
+	TestAssertTrue(DatumGetPointer(compressed) != NULL);
+	/* 3 bits per value, 21 values per block */
+	TestAssertInt64Eq(VARSIZE(DatumGetPointer(compressed)), 24 + 49 * 8);
+
+	i = 0;
+	iter = for_decompression_iterator_from_datum_forward(compressed, INT8OID);
+	for (DecompressResult r = for_decompression_iterator_try_next_forward(iter); !r.is_done;
+		 r = for_decompression_iterator_try_next_forward(iter))
+	{
+		TestAssertTrue(!r.is_null);
+		TestAssertInt64Eq(DatumGetInt64(r.val), -1000 + (i * 5) % 7);
+		i += 1;
+	}
+	TestAssertInt64Eq(i, 1015);
+
+	iter = for_decompression_iterator_from_datum_reverse(compressed, INT8OID);
+	for (DecompressResult r = for_decompression_iterator_try_next_reverse(iter); !r.is_done;
+		 r = for_decompression_iterator_try_next_reverse(iter))
+	{
+		i -= 1;
+		TestAssertTrue(!r.is_null);
+		TestAssertInt64Eq(DatumGetInt64(r.val), -1000 + (i * 5) % 7);
+	}
+	TestAssertInt64Eq(i, 0);
+
+	/* equal values need no blocks at all */
+	compressor = for_compressor_alloc();
+	for (i = 0; i < 1000; i++)
+		for_compressor_append_value(compressor, 42);
+	compressed = PointerGetDatum(for_compressor_finish(compressor));
+	TestAssertInt64Eq(VARSIZE(DatumGetPointer(compressed)), 24);
+	check_decompress_all(compressed, INT4OID);
+
+	/* the full range of int64 uses 64 bits per value */
+	compressor = for_compressor_alloc();
+	for (i = 0; i < 100; i++)
+		for_compressor_append_value(compressor, i % 2 ? PG_INT64_MAX : PG_INT64_MIN + i);
+	compressed = PointerGetDatum(for_compressor_finish(compressor));
+	TestAssertInt64Eq(VARSIZE(DatumGetPointer(compressed)), 24 + 100 * 8);
+	check_decompress_all(compressed, INT8OID);
+}
+
+static void
+test_alp()
+{
+	AlpCompressor *compressor = alp_compressor_alloc(FLOAT8OID);
+	GorillaCompressor *gorilla = gorilla_compressor_alloc();
+	Datum compressed;
+	Datum gorilla_compressed;
+	DecompressionIterator *iter;
+	int i;
+
+	/* readings with two decimal places */
+	for (i = 0; i < 1000; i++)
+	{
+		double value = 20.0 + ((i * 37) % 1000) / 100.0;
+
+		alp_compressor_append_value(compressor, double_get_bits(value));
+		gorilla_compressor_append_value(gorilla, double_get_bits(value));
+	}
+
+	compressed = PointerGetDatum(alp_compressor_finish(compressor));
+	gorilla_compressed = PointerGetDatum(gorilla_compressor_finish(gorilla));
+	TestAssertInt64Eq(((CompressedDataHeader *) DatumGetPointer(compressed))->compression_algorithm,
+					  COMPRESSION_ALGORITHM_ALP);
+	TestAssertTrue(VARSIZE(DatumGetPointer(compressed)) * 2 <
+				   VARSIZE(DatumGetPointer(gorilla_compressed)));
+
+	i = 0;
+	iter = alp_decompression_iterator_from_datum_forward(compressed, FLOAT8OID);
+	for (DecompressResult r = alp_decompression_iterator_try_next_forward(iter); !r.is_done;
+		 r = alp_decompression_iterator_try_next_forward(iter))
+	{
+		TestAssertTrue(!r.is_null);
+		TestAssertDoubleEq(DatumGetFloat8(r.val), 20.0 + ((i * 37) % 1000) / 100.0);
+		i += 1;
+	}
+	TestAssertInt64Eq(i, 1000);
+
+	iter = alp_decompression_iterator_from_datum_reverse(compressed, FLOAT8OID);
+	for (DecompressResult r = alp_decompression_iterator_try_next_reverse(iter); !r.is_done;
+		 r = alp_decompression_iterator_try_next_reverse(iter))
+	{
+		i -= 1;
+		TestAssertTrue(!r.is_null);
+		TestAssertDoubleEq(DatumGetFloat8(r.val), 20.0 + ((i * 37) % 1000) / 100.0);
+	}
+	TestAssertInt64Eq(i, 0);
+
+	/* values that do not round-trip are stored as exceptions */
+	compressor = alp_compressor_alloc(FLOAT8OID);
+	for (i = 0; i < 1000; i++)
+	{
+		if (i % 7 == 0)
+			alp_compressor_append_null(compressor);
+		else if (i == 100)
+			alp_compressor_append_value(compressor, double_get_bits(NAN));
+		else if (i == 200)
+			alp_compressor_append_value(compressor, double_get_bits(-0.0));
+		else if (i == 300)
+			alp_compressor_append_value(compressor, double_get_bits(1.0 / 3.0));
+		else
+			alp_compressor_append_value(compressor, double_get_bits(i / 10.0));
+	}
+	compressed = PointerGetDatum(alp_compressor_finish(compressor));
+	TestAssertInt64Eq(((CompressedDataHeader *) DatumGetPointer(compressed))->compression_algorithm,
+					  COMPRESSION_ALGORITHM_ALP);
+	check_decompress_all(compressed, FLOAT8OID);
+
+	compressor = alp_compressor_alloc(FLOAT4OID);
+	for (i = 0; i < 1000; i++)
+		alp_compressor_append_value(compressor, float_get_bits(i / 100.0f));
+	compressed = PointerGetDatum(alp_compressor_finish(compressor));
+	TestAssertInt64Eq(((CompressedDataHeader *) DatumGetPointer(compressed))->compression_algorithm,
+					  COMPRESSION_ALGORITHM_ALP);
+	check_decompress_all(compressed, FLOAT4OID);
+
+	/* values that are not decimals fall back to gorilla */
+	compressor = alp_compressor_alloc(FLOAT8OID);
+	for (i = 0; i < 1000; i++)
+		alp_compressor_append_value(compressor, double_get_bits(sqrt(i + 2)));
+	compressed = PointerGetDatum(alp_compressor_finish(compressor));
+	TestAssertInt64Eq(((CompressedDataHeader *) DatumGetPointer(compressed))->compression_algorithm,
+					  COMPRESSION_ALGORITHM_GORILLA);
+	check_decompress_all(compressed, FLOAT8OID);
+}
+
+/*
+ * Check that the bulk simple8b decoder agrees with the iterator on data
+ * covering every selector: runs of values of each bit width, both short enough
+ * to be bit-packed and long enough to be run-length encoded.
+ */
+static void
+test_simple8brle_decompress_all()
+{
+	Simple8bRleCompressor compressor;
+	Simple8bRleSerialized *compressed;
+	Simple8bRleDecompressionIterator iter;
+	uint64 *values;
+	uint32 num_values;
+	uint32 i;
+	int bits;
+
+	simple8brle_compressor_init(&compressor);
+	for (bits = 0; bits <= 64; bits++)
+	{
+		uint64 max = bits == 64 ? PG_UINT64_MAX : (UINT64CONST(1) << bits) - 1;
+
+		for (i = 0; i < 100; i++)
+			simple8brle_compressor_append(&compressor, max >> (i % 4));
+		for (i = 0; i < 100; i++)
+			simple8brle_compressor_append(&compressor, max);
+	}
+	compressed = simple8brle_compressor_finish(&compressor);
+
+	values = simple8brle_decompress_all(compressed, &num_values);
+	TestAssertInt64Eq(num_values, 65 * 200);
+
+	simple8brle_decompression_iterator_init_forward(&iter, compressed);
+	for (i = 0; i < num_values; i++)
+	{
+		Simple8bRleDecompressResult r = simple8brle_decompression_iterator_try_next_forward(&iter);
+		TestAssertTrue(!r.is_done);
+		TestAssertTrue(values[i] == r.val);
+	}
+	TestAssertTrue(simple8brle_decompression_iterator_try_next_forward(&iter).is_done);
+}
+
+/*
+ * Check that bulk decompression returns the same values as the forward
+ * iterator for the given compressed datum.
+ */
+static void
+check_decompress_all(Datum compressed, Oid element_type)
+{
+	CompressedDataHeader *header = (CompressedDataHeader *) DatumGetPointer(compressed);
+	DecompressAllResult *result = tsl_decompress_all(compressed, element_type);
+	DecompressionIterator *iter =
+		tsl_get_decompression_iterator_init(header->compression_algorithm,
+											false)(compressed, element_type);
+	int16 typlen;
+	bool typbyval;
+	int32 row = 0;
+
+	get_typlenbyval(element_type, &typlen, &typbyval);
+
+	for (DecompressResult r = iter->try_next(iter); !r.is_done; r = iter->try_next(iter))
+	{
+		TestAssertTrue(row < result->num_values);
+		TestAssertInt64Eq(decompress_all_result_is_null(result, row), r.is_null);
+		if (!r.is_null)
+			TestAssertTrue(datumIsEqual(decompress_all_result_get_datum(result, row),
+										r.val,
+										typbyval,
+										typlen));
+		row++;
+	}
+	TestAssertInt64Eq(row, result->num_values);
+}
+
+static void
+test_decompress_all()
+{
+	DeltaDeltaCompressor *deltadelta = delta_delta_compressor_alloc();
+	ForCompressor *frame_of_reference = for_compressor_alloc();
+	GorillaCompressor *gorilla = gorilla_compressor_alloc();
+	ArrayCompressor *array = array_compressor_alloc(TEXTOID);
+	DictionaryCompressor *int_dictionary = dictionary_compressor_alloc(INT4OID);
+	DictionaryCompressor *text_dictionary = dictionary_compressor_alloc(TEXTOID);
+	Datum compressed;
+	DecompressAllResult *result;
+	int i;
+
+	for (i = 0; i < 1000; i++)
+	{
+		if (i % 7 == 0)
+		{
+			delta_delta_compressor_append_null(deltadelta);
+			for_compressor_append_null(frame_of_reference);
+			gorilla_compressor_append_null(gorilla);
+			array_compressor_append_null(array);
+			dictionary_compressor_append_null(int_dictionary);
+			dictionary_compressor_append_null(text_dictionary);
+		}
+		else
+		{
+			delta_delta_compressor_append_value(deltadelta, i * (i % 3));
+			for_compressor_append_value(frame_of_reference, i % 5);
+			gorilla_compressor_append_value(gorilla, double_get_bits(i / 4.0));
+			array_compressor_append(array, CStringGetTextDatum(i % 2 ? "odd" : "even"));
+			dictionary_compressor_append(int_dictionary, Int32GetDatum(i % 5));
+			dictionary_compressor_append(text_dictionary,
+										 CStringGetTextDatum(i % 2 ? "odd" : "even"));
+		}
+	}
+
+	compressed = DirectFunctionCall1(tsl_deltadelta_compressor_finish, PointerGetDatum(deltadelta));
+	check_decompress_all(compressed, INT4OID);
+	check_decompress_all(compressed, INT8OID);
+	result = tsl_decompress_all(compressed, INT4OID);
+	TestAssertInt64Eq(result->num_values, 1000);
+	TestAssertInt64Eq(result->value_bytes, sizeof(int32));
+	TestAssertTrue(decompress_all_result_is_null(result, 7));
+	TestAssertInt64Eq(((int32 *) result->values)[8], 16);
+
+	compressed = PointerGetDatum(for_compressor_finish(frame_of_reference));
+	check_decompress_all(compressed, INT2OID);
+	check_decompress_all(compressed, INT8OID);
+	result = tsl_decompress_all(compressed, INT2OID);
+	TestAssertInt64Eq(result->num_values, 1000);
+	TestAssertInt64Eq(result->value_bytes, sizeof(int16));
+	TestAssertTrue(decompress_all_result_is_null(result, 0));
+	TestAssertInt64Eq(((int16 *) result->values)[999], 4);
+
+	compressed = PointerGetDatum(gorilla_compressor_finish(gorilla));
+	check_decompress_all(compressed, FLOAT8OID);
+	result = tsl_decompress_all(compressed, FLOAT8OID);
+	TestAssertInt64Eq(result->num_values, 1000);
+	TestAssertTrue(decompress_all_result_is_null(result, 0));
+	TestAssertDoubleEq(((float8 *) result->values)[999], 999 / 4.0);
+
+	compressed = PointerGetDatum(dictionary_compressor_finish(int_dictionary));
+	check_decompress_all(compressed, INT4OID);
+	result = tsl_decompress_all(compressed, INT4OID);
+	TestAssertInt64Eq(result->num_values, 1000);
+	TestAssertTrue(decompress_all_result_is_null(result, 14));
+	TestAssertInt64Eq(((int32 *) result->values)[13], 3);
+
+	compressed = PointerGetDatum(dictionary_compressor_finish(text_dictionary));
+	check_decompress_all(compressed, TEXTOID);
+
+	/* array has no specialized bulk decompression and falls back to the iterator */
+	compressed = PointerGetDatum(array_compressor_finish(array));
+	check_decompress_all(compressed, TEXTOID);
+	result = tsl_decompress_all(compressed, TEXTOID);
+	TestAssertInt64Eq(result->value_bytes, 0);
+	TestAssertInt64Eq(result->num_values, 1000);
+}
+
 Datum
 ts_test_compression(PG_FUNCTION_ARGS)
 {
@@ -430,6 +732,10 @@ ts_test_compression(PG_FUNCTION_ARGS)
 	test_gorilla_double();
 	test_delta();
 	test_delta2();
+	test_for();
+	test_alp();
+	test_simple8brle_decompress_all();
+	test_decompress_all();
 	PG_RETURN_VOID();
 }
 
@@ -504,6 +810,34 @@ ts_decompress_table(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+TS_FUNCTION_INFO_V1(ts_test_compression_index);
+
+/*
+ * Get the index that compressing the chunk would scan with the compression
+ * settings of its hypertable, or NULL if the chunk would be sorted.
+ */
+Datum
+ts_test_compression_index(PG_FUNCTION_ARGS)
+{
+	Chunk *chunk = ts_chunk_get_by_relid(PG_GETARG_OID(0), true);
+	List *compression_info = ts_hypertable_compression_get(chunk->fd.hypertable_id);
+	const ColumnCompressionInfo **columns =
+		palloc(sizeof(*columns) * list_length(compression_info));
+	ListCell *lc;
+	int n = 0;
+	Oid index_oid;
+
+	foreach (lc, compression_info)
+		columns[n++] = lfirst(lc);
+
+	index_oid = compress_chunk_get_index(chunk->table_id, columns, n);
+
+	if (!OidIsValid(index_oid))
+		PG_RETURN_NULL();
+
+	PG_RETURN_OID(index_oid);
+}
+
 TS_FUNCTION_INFO_V1(ts_segment_meta_min_max_append);
 
 Datum